@@ -52,7 +52,7 @@
 /* needed for writern and readn socket operations */
 #include "../Util/unp.h"
 
-/* needed for function getXMLMessageLen */
+/* needed for function getXMLMessageLen and the XML message header */
 #include "../XML/xml.h"
 
 /* needed for malloc and free */
@@ -441,7 +441,7 @@ manageConnection ( Chain_structp chain )
 							readn( chain->Rsocket, buf, 5 );
 						RfirstRead =FALSE;
 					}
-					if ( readMessage(chain, RIB_STREAM_CHAIN) )	
+					if ( readMessages(chain, RIB_STREAM_CHAIN) )	
 					{
 						//some sort of read error, close connection
 						log_err("Socket read from RIB chain %d at %s port %d failed", chain->chainID, chain->addr, chain->Rport);
@@ -461,7 +461,7 @@ manageConnection ( Chain_structp chain )
 							readn( chain->Usocket, buf, 5 );
 						UfirstRead =FALSE;
 					}
-					if ( readMessage(chain, UPDATE_STREAM_CHAIN) )	
+					if ( readMessages(chain, UPDATE_STREAM_CHAIN) )	
 					{
 						//some sort of read error, close connection
 						log_err("Socket read from Update chain %d at %s port %d failed", chain->chainID, chain->addr, chain->Uport);
@@ -480,14 +480,43 @@ manageConnection ( Chain_structp chain )
 }
 
 /*-------------------------------------------------------------------------------------- 
- * Purpose: read a message from the remote chain
+ * Purpose: read the messages already received from the remote chain, up to a batch,
+ *          and write them to the XML queue of the stream together
  * Input:  the chain structure, Update or RIB const from manageConnection function
+ * Output: returns 0 if the messages were read
+ *         returns -1 on error
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int
+readMessages ( Chain_structp chain, int chain_stream ) 
+{
+	char header[XML_MSG_HEADER_SIZE];
+	QueueBatch batch;
+	int i, error = 0;
+	int socket = (chain_stream == UPDATE_STREAM_CHAIN) ? chain->Usocket : chain->Rsocket;
+
+	initQueueBatch(&batch, (chain_stream == UPDATE_STREAM_CHAIN) ? chain->UxmlQueueWriter : chain->RxmlQueueWriter);
+	for ( i = 0; i < QUEUE_WRITE_BATCH && error == 0; i++ )
+	{
+		// after the first message, only read the ones whose header is already here
+		if ( i > 0 && recv(socket, header, XML_MSG_HEADER_SIZE, MSG_PEEK | MSG_DONTWAIT) < XML_MSG_HEADER_SIZE )
+			break;
+		error = readMessage(chain, chain_stream, &batch);
+	}
+	flushQueueBatch(&batch);
+	return error;
+}
+
+/*-------------------------------------------------------------------------------------- 
+ * Purpose: read a message from the remote chain
+ * Input:  the chain structure, Update or RIB const from manageConnection function,
+ *         the batch the message is added to
  * Output: returns 0 if the message was read
  *         returns -1 on error
  * He Yan @ July 22, 2008 
  * -------------------------------------------------------------------------------------*/
 int
-readMessage ( Chain_structp chain, int chain_stream ) 
+readMessage ( Chain_structp chain, int chain_stream, QueueBatch *batch ) 
 {
 
 	if (chain_stream == UPDATE_STREAM_CHAIN)
@@ -514,36 +543,36 @@ readMessage ( Chain_structp chain, int chain_stream )
 		}
 
 		// get the total length of the message
-		int msgLen = getXMLMessageLen(chain->UmsgHeaderBuf);
-		char *msg = malloc(msgLen);
-		if (msg == NULL)
-		{
-			log_err("Read Update chain %d at %s port %d realloc failed", chain->chainID, chain->addr, chain->Uport);
-			return -1;
-		}	
+		int msgLen = getXMLMessageLen(chain->UmsgHeaderBuf, XML_MSG_HEADER_SIZE);
+		XMLMessage msg = createXMLMessage(NULL, msgLen, XML_MSG_TYPE_RELAYED, 0);
 
 		// read the the message from socket.
-		len = readn(chain->Usocket, msg, msgLen); 
+		len = readn(chain->Usocket, msg->text, msgLen); 
 		// check something was read
 		if (len !=  msgLen )
 		{
 			log_err("Read Update chain %d at %s port %d expected %d bytes but read %d", chain->chainID, chain->addr, chain->Uport, msgLen, len);
+			free(msg);
 			return -1;
 		}
 
 		//get BGPmon ID and sequence number of new message
 		u_int32_t msgID = -1;
 		u_int32_t msgSeq = -1;
-		if(getMsgIdSeq(msg,msgLen,&msgID,&msgSeq)){
-			if(msgLen > 0) writeQueue(chain->UxmlQueueWriter,msg);
-			else log_err("Chain %d attempted to parse an invalid/old message.", chain->chainID);
+		if(getMsgIdSeq(msg->text,msgLen,&msgID,&msgSeq)){
+			if(msgLen > 0) addQueueBatch(batch,msg);
+			else {
+				log_err("Chain %d attempted to parse an invalid/old message.", chain->chainID);
+				free(msg);
+			}
 			return 0;
 		}
+		msg->seq = msgSeq;
 
 		chainOwnerCachep entry = getCacheEntry(msgID);
 		if(entry == NULL){	//if we found no entry, create one and forward the message
 			addCacheEntry(msgID,chain->chainID,msgSeq);
-			writeQueue(chain->UxmlQueueWriter,msg);
+			addQueueBatch(batch,msg);
 		}
 		else{
 			//if this chain owns the ID, update the entry and forward the message
@@ -552,14 +581,14 @@ readMessage ( Chain_structp chain, int chain_stream )
 				entry->timestamp = time(NULL);
 				entry->seq = msgSeq;
 				pthread_mutex_unlock(&entry->cache_mutex);
-				writeQueue(chain->UxmlQueueWriter,msg);
+				addQueueBatch(batch,msg);
 			}
 			//otherwise drop the message
 			else free(msg);
 		}
 
 #ifdef DEBUG
-		debug(__FUNCTION__, "Update Message from %d: %s\n", chain->chainID, msg );	
+		debug(__FUNCTION__, "Update Message from %d: %.*s\n", chain->chainID, msgLen, msg->text );	
 #endif 
 
 		return 0;
@@ -589,36 +618,36 @@ readMessage ( Chain_structp chain, int chain_stream )
 		}
 
 		// get the total length of the message
-		int msgLen = getXMLMessageLen(chain->RmsgHeaderBuf);
-		char *msg = malloc(msgLen);
-		if (msg == NULL)
-		{
-			log_err("Read RIB chain %d at %s port %d realloc failed", chain->chainID, chain->addr, chain->Rport);
-			return -1;
-		}	
+		int msgLen = getXMLMessageLen(chain->RmsgHeaderBuf, XML_MSG_HEADER_SIZE);
+		XMLMessage msg = createXMLMessage(NULL, msgLen, XML_MSG_TYPE_RELAYED, 0);
 
 		// read the the message from socket.
-		len = readn(chain->Rsocket, msg, msgLen); 
+		len = readn(chain->Rsocket, msg->text, msgLen); 
 		// check something was read
 		if (len !=  msgLen )
 		{
 			log_err("Read RIB chain %d at %s port %d expected %d bytes but read %d", chain->chainID, chain->addr, chain->Uport, msgLen, len);
+			free(msg);
 			return -1;
 		}
 
 		//get BGPmon ID and sequence number of new message
 		u_int32_t msgID = -1;
 		u_int32_t msgSeq = -1;
-		if(getMsgIdSeq(msg,msgLen,&msgID,&msgSeq)){
-			if(msgLen > 0) writeQueue(chain->RxmlQueueWriter,msg);
-			else log_err("Chain %d attempted to parse an invalid/old message.", chain->chainID);
+		if(getMsgIdSeq(msg->text,msgLen,&msgID,&msgSeq)){
+			if(msgLen > 0) addQueueBatch(batch,msg);
+			else {
+				log_err("Chain %d attempted to parse an invalid/old message.", chain->chainID);
+				free(msg);
+			}
 			return 0;
 		}
+		msg->seq = msgSeq;
 
 		chainOwnerCachep entry = getCacheEntry(msgID);
 		if(entry == NULL){	//if we found no entry, create one and forward the message
 			addCacheEntry(msgID,chain->chainID,msgSeq);
-			writeQueue(chain->RxmlQueueWriter,msg);
+			addQueueBatch(batch,msg);
 		}
 		else{
 			//if this chain owns the ID, update the entry and forward the message
@@ -627,7 +656,7 @@ readMessage ( Chain_structp chain, int chain_stream )
 				entry->timestamp = time(NULL);
 				entry->seq = msgSeq;
 				pthread_mutex_unlock(&entry->cache_mutex);
-				writeQueue(chain->RxmlQueueWriter,msg);
+				addQueueBatch(batch,msg);
 			}
 			//otherwise drop the message
 			else free(msg);
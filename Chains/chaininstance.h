@@ -145,13 +145,24 @@ int establishConnection ( Chain_structp chain );
 int manageConnection ( Chain_structp chain );
 
 /*-------------------------------------------------------------------------------------- 
- * Purpose: read a message from the remote chain
+ * Purpose: read the messages already received from the remote chain, up to a batch,
+ *          and write them to the XML queue of the stream together
  * Input:  the chain structure, Update or RIB const from manageConnection function
+ * Output: returns 0 if the messages were read
+ *         returns -1 on error
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int readMessages ( Chain_structp chain, int chain_stream );
+
+/*-------------------------------------------------------------------------------------- 
+ * Purpose: read a message from the remote chain
+ * Input:  the chain structure, Update or RIB const from manageConnection function,
+ *         the batch the message is added to
  * Output: returns 0 if the message was read
  *         returns -1 on error
  * He Yan @ July 22, 2008 
  * -------------------------------------------------------------------------------------*/
-int readMessage ( Chain_structp chain, int chain_stream );
+int readMessage ( Chain_structp chain, int chain_stream, QueueBatch *batch );
 
 /*-------------------------------------------------------------------------------------
  * Purpose:	Get the location in the cache of the msgCache for a given ID
@@ -0,0 +1,608 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: clientengine.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+/* 
+ * Write the XML streams to the update and RIB clients from a few output loop threads
+ */
+
+#include "../config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#include "clients.h"
+#include "clientscontrol.h"
+#include "clientinstance.h"
+#include "clientengine.h"
+#include "clientfilter.h"
+#include "../Queues/queue.h"
+#include "../XML/xml.h"
+#include "../Util/log.h"
+#include "../Util/bgpmon_defaults.h"
+
+//#define DEBUG
+
+#ifdef HAVE_SYS_EPOLL_H
+
+/* max batches written to one client in a turn of its output loop, so a client with a 
+   large backlog can't starve the others */
+#define CLIENT_BATCHES_PER_TURN	8
+/* max time an output loop sleeps, it bounds how late a deleted client is closed */
+#define CLIENT_MAX_WAIT_MS		1000
+/* max socket events taken by one wait */
+#define CLIENT_MAX_EVENTS		256
+
+/* the tag opening the XML stream of each client */
+#define CLIENT_OPEN_TAG		"<xml>"
+#define CLIENT_OPEN_TAG_LEN	5
+
+/* some systems can't keep a lost client from raising SIGPIPE */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* a client served by an output loop */
+struct ClientTaskStruct
+{
+	ClientNode		*cn;
+	int			listener;	// CLIENT_LISTENER_UPDATA or CLIENT_LISTENER_RIB
+	u_int32_t		events;		// events registered for the socket
+	int			writable;	// the socket is not known to be full
+	int			readClosed;	// the client won't send anything more
+	int			hangup;		// the connection was lost
+	int			tagWritten;	// bytes of the opening tag written
+	// messages read from the queue and not released yet, shared with other clients
+	const struct XMLMessageStruct *msgs[QUEUE_READ_BATCH];
+	long			count;		// number of messages held
+	long			first;		// first message not written completely
+	u_int32_t		offset;		// bytes of the first message written
+	struct ClientTaskStruct	*next;
+};
+typedef struct ClientTaskStruct ClientTask;
+
+/* an output loop thread and the clients it serves */
+struct ClientLoopStruct
+{
+	int			epfd;
+	int			wakeup[2];	// pipe fired by the XML queues when messages are written
+	int			notifyU;	// notifier id of the pipe on the update queue
+	int			notifyR;	// notifier id of the pipe on the RIB queue
+	int			clientsU;	// number of update clients served by the loop
+	int			clientsR;	// number of RIB clients served by the loop
+	pthread_t		thread;
+	int			started;
+	pthread_mutex_t		lock;		// protects newTasks
+	ClientTask		*newTasks;	// clients handed over by addClientToEngine
+	ClientTask		*tasks;		// clients owned by the loop thread
+};
+typedef struct ClientLoopStruct ClientLoop;
+
+static ClientLoop ClientLoops[CLIENT_MAX_OUTPUT_THREADS];
+static int ClientLoopNext = 0;
+static int ClientEngineShutdown = FALSE;
+static pthread_mutex_t ClientEngineLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Make a descriptor non-blocking
+ * Input:  the descriptor
+ * Output: 0 on success, -1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+setNonBlocking( int fd )
+{
+	int flags = fcntl( fd, F_GETFL, 0 );
+	if ( flags < 0 || fcntl( fd, F_SETFL, flags | O_NONBLOCK ) < 0 )
+		return -1;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Register the events a client waits for with the epoll set of its loop
+ * Input:  the loop and the client task
+ * Output: 0 on success, -1 on failure
+ * Note: Input is only watched to notice the client closing the connection, output
+ *       only while the socket is full.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+syncClientTask( ClientLoop *loop, ClientTask *t )
+{
+	u_int32_t events = 0;
+	struct epoll_event ev;
+
+	if ( t->readClosed == FALSE )
+		events |= EPOLLIN;
+	if ( t->writable == FALSE )
+		events |= EPOLLOUT;
+	if ( events == t->events )
+		return 0;
+
+	memset( &ev, 0, sizeof(ev) );
+	ev.events = events;
+	ev.data.ptr = t;
+	if ( epoll_ctl( loop->epfd, EPOLL_CTL_MOD, t->cn->socket, &ev ) < 0 )
+	{
+		log_err("client %d: failed to modify socket events: %s", t->cn->id, strerror(errno));
+		return -1;
+	}
+	t->events = events;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write as much of the pending output of a client as its socket takes
+ * Input:  the client task
+ * Output: 1 if everything was written, 0 if the socket is full 
+ *         or -1 if the socket connection was lost
+ * Note: The opening tag and the held messages go out together with a single call
+ *       per batch, the position inside a partly written message is kept.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+writeClientTask( ClientTask *t )
+{
+	struct iovec iov[QUEUE_READ_BATCH + 1];
+	struct msghdr msg;
+	ssize_t n;
+	long i, left;
+	int cnt, tag;
+
+	while ( t->tagWritten < CLIENT_OPEN_TAG_LEN || t->first < t->count )
+	{
+		cnt = 0;
+		if ( t->tagWritten < CLIENT_OPEN_TAG_LEN )
+		{
+			iov[cnt].iov_base = (void *)(CLIENT_OPEN_TAG + t->tagWritten);
+			iov[cnt].iov_len = CLIENT_OPEN_TAG_LEN - t->tagWritten;
+			cnt++;
+		}
+		for ( i = t->first; i < t->count; i++ )
+		{
+			u_int32_t skip = (i == t->first) ? t->offset : 0;
+			iov[cnt].iov_base = (void *)(t->msgs[i]->text + skip);
+			iov[cnt].iov_len = t->msgs[i]->length - skip;
+			cnt++;
+		}
+
+		memset( &msg, 0, sizeof(msg) );
+		msg.msg_iov = iov;
+		msg.msg_iovlen = cnt;
+		n = sendmsg( t->cn->socket, &msg, MSG_NOSIGNAL );
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			if ( errno == EAGAIN || errno == EWOULDBLOCK )
+				return 0;
+			return -1;
+		}
+
+		// move past what the socket took
+		if ( t->tagWritten < CLIENT_OPEN_TAG_LEN )
+		{
+			tag = CLIENT_OPEN_TAG_LEN - t->tagWritten;
+			if ( n < tag )
+				tag = n;
+			t->tagWritten += tag;
+			n -= tag;
+		}
+		while ( t->first < t->count )
+		{
+			left = t->msgs[t->first]->length - t->offset;
+			if ( n < left )
+			{
+				t->offset += n;
+				break;
+			}
+			n -= left;
+			t->first++;
+			t->offset = 0;
+		}
+	}
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release the messages a client holds
+ * Input:  the client task
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+releaseClientTaskMessages( ClientTask *t )
+{
+	long i;
+	for ( i = 0; i < t->count; i++ )
+	{
+		releaseQueueItem( t->cn->qReader, t->msgs[i] );
+		t->msgs[i] = NULL;
+	}
+	t->count = 0;
+	t->first = 0;
+	t->offset = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write the messages waiting in the queue to a client until its socket is
+ *          full or it has caught up
+ * Input:  the client task
+ * Output: TRUE if the client may still have messages waiting, FALSE otherwise
+ *         or -1 if the client must be closed
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+serveClientTask( ClientTask *t )
+{
+	long n;
+	int batches;
+
+	// a full socket is served again once it reports it has room
+	if ( t->writable == FALSE )
+		return FALSE;
+
+	// update the last action time
+	t->cn->lastAction = time(NULL);
+	for ( batches = 0; batches < CLIENT_BATCHES_PER_TURN; batches++ )
+	{
+		// read the next messages once the held ones are written
+		if ( t->count == 0 )
+		{
+			n = tryReadQueueSharedBatch( t->cn->qReader, (const void **)t->msgs, QUEUE_READ_BATCH );
+			// if reader has been canceled or ceased, close client
+			if ( n == READER_SLOT_AVAILABLE )
+				return -1;
+			// keep the messages the client's filter matches
+			t->count = filterClientMessages( t->cn, t->msgs, n );
+			if ( t->count == 0 && n > 0 && t->tagWritten == CLIENT_OPEN_TAG_LEN )
+				continue;
+		}
+		if ( t->count == 0 && t->tagWritten == CLIENT_OPEN_TAG_LEN )
+			return FALSE;
+
+		switch ( writeClientTask( t ) )
+		{
+			case -1:
+				return -1;
+			case 0:
+				t->writable = FALSE;
+				return FALSE;
+		}
+		releaseClientTaskMessages( t );
+	}
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Close a client served by an output loop and free its task
+ * Input:  the loop and the client task
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+closeClientTask( ClientLoop *loop, ClientTask *t )
+{
+	// the socket is closed by destroyClient, take it out of the set first
+	epoll_ctl( loop->epfd, EPOLL_CTL_DEL, t->cn->socket, NULL );
+	if ( t->listener == CLIENT_LISTENER_UPDATA )
+		loop->clientsU--;
+	else
+		loop->clientsR--;
+	releaseClientTaskMessages( t );
+	destroyClient( t->cn->id, t->listener );
+	free( t );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Empty the wakeup pipe of an output loop
+ * Input:  the loop
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+drainClientLoopWakeup( ClientLoop *loop )
+{
+	char buf[64];
+	while ( read( loop->wakeup[0], buf, sizeof(buf) ) > 0 )
+		;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: the main function of an output loop thread
+ * Input:	the output loop
+ * Output: 
+ * Note: Each turn adopts the clients handed over, waits for socket events or for the
+ *       queues to report new messages and then writes to the clients that have room.
+ *       The queue notifiers are armed before the clients poll the queues, so a message
+ *       written after a client found nothing always wakes the loop again.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static void *
+clientLoopThread( void *arg )
+{
+	ClientLoop *loop = arg;
+	struct epoll_event events[CLIENT_MAX_EVENTS];
+	struct epoll_event ev;
+	ClientTask *t, *prev, *next, *adopted;
+	int i, n, result;
+	int busy = FALSE;	// a client may have messages waiting without waiting
+
+	debug(__FUNCTION__, "Client output loop starting!");
+	while ( TRUE )
+	{
+		// adopt the clients handed over since the last turn
+		pthread_mutex_lock( &loop->lock );
+		adopted = loop->newTasks;
+		loop->newTasks = NULL;
+		pthread_mutex_unlock( &loop->lock );
+		while ( adopted != NULL )
+		{
+			t = adopted;
+			adopted = adopted->next;
+			memset( &ev, 0, sizeof(ev) );
+			ev.events = t->events;
+			ev.data.ptr = t;
+			if ( setNonBlocking( t->cn->socket ) < 0 
+				|| epoll_ctl( loop->epfd, EPOLL_CTL_ADD, t->cn->socket, &ev ) < 0 )
+			{
+				log_err("client %d: failed to add socket to output loop: %s", t->cn->id, strerror(errno));
+				destroyClient( t->cn->id, t->listener );
+				free( t );
+				continue;
+			}
+			t->next = loop->tasks;
+			loop->tasks = t;
+			if ( t->listener == CLIENT_LISTENER_UPDATA )
+				loop->clientsU++;
+			else
+				loop->clientsR++;
+			busy = TRUE;
+		}
+
+		if ( ClientEngineShutdown == TRUE && loop->tasks == NULL )
+			break;
+
+		n = epoll_wait( loop->epfd, events, CLIENT_MAX_EVENTS, busy ? 0 : CLIENT_MAX_WAIT_MS );
+		if ( n < 0 )
+		{
+			if ( errno != EINTR )
+				log_fatal("client output loop: epoll_wait error: %s", strerror(errno));
+			n = 0;
+		}
+		busy = FALSE;
+		for ( i = 0; i < n; i++ )
+		{
+			t = events[i].data.ptr;
+			if ( t == NULL )
+			{
+				drainClientLoopWakeup( loop );
+				continue;
+			}
+			if ( events[i].events & (EPOLLERR | EPOLLHUP) )
+				t->hangup = TRUE;
+			if ( events[i].events & EPOLLIN )
+			{
+				// apply the filter lines the client sent
+				switch ( readClientInput( t->cn ) )
+				{
+					case CLIENT_INPUT_CLOSED:
+						t->readClosed = TRUE;
+						break;
+					case CLIENT_INPUT_ERROR:
+						t->hangup = TRUE;
+						break;
+				}
+			}
+			if ( events[i].events & EPOLLOUT )
+				t->writable = TRUE;
+		}
+
+		// any message written from now on for our clients fires the wakeup pipe
+		if ( loop->notifyU >= 0 && loop->clientsU > 0 )
+			armQueueNotifier( xmlUQueue, loop->notifyU );
+		if ( loop->notifyR >= 0 && loop->clientsR > 0 )
+			armQueueNotifier( xmlRQueue, loop->notifyR );
+
+		// write to the clients that have room
+		prev = NULL;
+		for ( t = loop->tasks; t != NULL; t = next )
+		{
+			next = t->next;
+			result = -1;
+			if ( t->cn->deleteClient == FALSE && ClientControls.shutdown == FALSE && t->hangup == FALSE )
+			{
+				result = serveClientTask( t );
+				if ( result >= 0 && syncClientTask( loop, t ) < 0 )
+					result = -1;
+			}
+			if ( result >= 0 )
+			{
+				if ( result == TRUE )
+					busy = TRUE;
+				prev = t;
+				continue;
+			}
+
+			// the client is deleted or lost, close it
+			if ( prev == NULL )
+				loop->tasks = next;
+			else
+				prev->next = next;
+			closeClientTask( loop, t );
+		}
+	}
+
+	// the wakeup pipe stays open, the queues may still fire it
+	debug(__FUNCTION__, "Client output loop exiting!");
+	pthread_exit( NULL );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Set up an output loop and start its thread
+ * Input:  the loop
+ * Output: none, exits on fatal error
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+startClientLoop( ClientLoop *loop )
+{
+	struct epoll_event ev;
+	int error;
+
+	if ( (loop->epfd = epoll_create( MAX_CLIENT_IDS )) < 0 )
+		log_fatal("Failed to create client output loop: %s\n", strerror(errno));
+	if ( pipe( loop->wakeup ) < 0 
+		|| setNonBlocking( loop->wakeup[0] ) < 0 || setNonBlocking( loop->wakeup[1] ) < 0 )
+		log_fatal("Failed to create client output loop wakeup pipe: %s\n", strerror(errno));
+	memset( &ev, 0, sizeof(ev) );
+	ev.events = EPOLLIN;
+	ev.data.ptr = NULL;
+	if ( epoll_ctl( loop->epfd, EPOLL_CTL_ADD, loop->wakeup[0], &ev ) < 0 )
+		log_fatal("Failed to add wakeup pipe to client output loop: %s\n", strerror(errno));
+
+	// without a notifier the loop still finds new messages within CLIENT_MAX_WAIT_MS
+	loop->notifyU = addQueueNotifier( xmlUQueue, loop->wakeup[1] );
+	loop->notifyR = addQueueNotifier( xmlRQueue, loop->wakeup[1] );
+
+	if ((error = pthread_mutex_init(&loop->lock, NULL)) > 0 )
+		log_fatal("Failed to init client output loop lock: %s\n", strerror(error));
+	loop->newTasks = NULL;
+	loop->tasks = NULL;
+	loop->clientsU = 0;
+	loop->clientsR = 0;
+	if ((error = pthread_create(&loop->thread, NULL, clientLoopThread, loop)) > 0 )
+		log_fatal("Failed to create client output loop thread: %s\n", strerror(error));
+	loop->started = TRUE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand a client to the output engine, the output loops are started with the
+ *          first client
+ * Input:  the client node structure and UPDATA or RIB client trigger
+ * Output: 0 on success, -1 if the client could not be handed over
+ * Note: The clients are spread over the loops in turn. The client is destroyed by 
+ *       its output loop once it is deleted or lost.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int addClientToEngine( ClientNode *cn, int client_listener )
+{
+	ClientLoop *loop;
+	ClientTask *t;
+	int index;
+
+	t = malloc( sizeof(ClientTask) );
+	if ( t == NULL )
+	{
+		log_warning("Failed to allocate memory for client %d's output task", cn->id);
+		return -1;
+	}
+	memset( t, 0, sizeof(ClientTask) );
+	t->cn = cn;
+	t->listener = client_listener;
+	t->events = EPOLLIN;
+	t->writable = TRUE;
+
+	pthread_mutex_lock( &ClientEngineLock );
+	if ( ClientEngineShutdown == TRUE )
+	{
+		pthread_mutex_unlock( &ClientEngineLock );
+		free( t );
+		return -1;
+	}
+
+	index = ClientLoopNext;
+	ClientLoopNext = (ClientLoopNext + 1) % ClientControls.outputThreads;
+	loop = &ClientLoops[index];
+	if ( loop->started == FALSE )
+		startClientLoop( loop );
+
+	pthread_mutex_lock( &loop->lock );
+	t->next = loop->newTasks;
+	loop->newTasks = t;
+	pthread_mutex_unlock( &loop->lock );
+	pthread_mutex_unlock( &ClientEngineLock );
+
+	// wake the loop up to adopt the client
+	if ( write( loop->wakeup[1], "", 1 ) < 0 && errno != EAGAIN && errno != EWOULDBLOCK )
+		log_err("Failed to wake up client output loop %d: %s", index, strerror(errno));
+
+#ifdef DEBUG
+	debug(__FUNCTION__, "Handed client %d to output loop %d", cn->id, index);
+#endif
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Wait until the output loops have destroyed their clients and stopped
+ * Input:  none
+ * Output: none
+ * Note: The loops close their clients once signalClientsShutdown was called.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void waitForClientEngineShutdown()
+{
+	int i;
+
+	pthread_mutex_lock( &ClientEngineLock );
+	ClientEngineShutdown = TRUE;
+	pthread_mutex_unlock( &ClientEngineLock );
+
+	for ( i = 0; i < CLIENT_MAX_OUTPUT_THREADS; i++ )
+	{
+		if ( ClientLoops[i].started == TRUE )
+			pthread_join( ClientLoops[i].thread, NULL );
+	}
+}
+
+#else /* HAVE_SYS_EPOLL_H */
+
+/* without epoll the settings fall back to one thread per client and these are never called */
+int addClientToEngine( ClientNode *cn, int client_listener )
+{
+	log_err("addClientToEngine: the event client engine is not supported on this system");
+	return -1;
+}
+
+void waitForClientEngineShutdown()
+{
+}
+
+#endif /* HAVE_SYS_EPOLL_H */
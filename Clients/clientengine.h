@@ -0,0 +1,62 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: clientengine.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef CLIENTENGINE_H_
+#define CLIENTENGINE_H_
+
+// needed for ClientNode
+#include "clientinstance.h"
+
+/* engines writing the XML streams to the update and RIB clients */
+#define CLIENT_ENGINE_THREADS	0	// one thread per client
+#define CLIENT_ENGINE_EVENTS	1	// output loop threads shared by the clients
+
+/* max number of output loop threads */
+#define CLIENT_MAX_OUTPUT_THREADS 64
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand a client to the output engine, the output loops are started with the
+ *          first client
+ * Input:  the client node structure and UPDATA or RIB client trigger
+ * Output: 0 on success, -1 if the client could not be handed over
+ * Note: The client is destroyed by its output loop once it is deleted or lost.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int addClientToEngine( ClientNode *cn, int client_listener );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Wait until the output loops have destroyed their clients and stopped
+ * Input:  none
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void waitForClientEngineShutdown();
+
+#endif /*CLIENTENGINE_H_*/
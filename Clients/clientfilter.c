@@ -0,0 +1,981 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: clientfilter.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+/* 
+ * Server side filters of the update and RIB clients.  Clients sending the same
+ * filter share a filter group, each group is evaluated once per message when the
+ * message is converted to XML and the result is kept as one bit of the message,
+ * so serving a client only tests that bit.
+ */
+
+/* externally visible structures and functions for clients */
+#include "clients.h"
+/* internal structures and functions for this module */
+#include "clientinstance.h"
+#include "clientfilter.h"
+
+/* required for logging functions */
+#include "../Util/log.h"
+
+/* required for TRUE/FALSE defines  */
+#include "../Util/bgpmon_defaults.h"
+
+/* needed for the sessions and the BGP messages */
+#include "../Peering/peersession.h"
+#include "../Peering/bgppacket.h"
+#include "../Peering/bgpmessagetypes.h"
+
+/* needed for the prefixes and the labels */
+#include "../Labeling/prefixtrie.h"
+#include "../Labeling/label.h"
+
+/* needed for site defaults */
+#include "../site_defaults.h"
+
+/* needed for malloc and free */
+#include <stdlib.h>
+/* needed for string functions */
+#include <string.h>
+#include <strings.h>
+/* needed for system error codes */
+#include <errno.h>
+/* needed for system types */
+#include <sys/types.h>
+/* needed for socket operations */
+#include <sys/socket.h>
+/* needed for inet_pton and inet_ntop */
+#include <arpa/inet.h>
+/* needed for pthread related functions */
+#include <pthread.h>
+
+//#define DEBUG
+
+/* kinds of filter terms, in the order of the filter text */
+#define FILTER_PEER		0
+#define FILTER_SESSION		1
+#define FILTER_TYPE		2
+#define FILTER_ORIGIN		3
+#define FILTER_AFI		4
+#define FILTER_SAFI		5
+#define FILTER_PREFIX		6
+#define FILTER_LABEL		7
+#define FILTER_KINDS		8
+
+/* the kinds tested on each prefix of a message */
+#define FILTER_PREFIX_KINDS	((1<<FILTER_AFI) | (1<<FILTER_SAFI) | (1<<FILTER_PREFIX) | (1<<FILTER_LABEL))
+
+static const char *FilterKindNames[FILTER_KINDS] = 
+	{ "peer", "session", "type", "origin", "afi", "safi", "prefix", "label" };
+
+/* message types a filter selects */
+#define FILTER_TYPE_OPEN		0
+#define FILTER_TYPE_UPDATE		1
+#define FILTER_TYPE_NOTIFICATION	2
+#define FILTER_TYPE_KEEPALIVE		3
+#define FILTER_TYPE_REFRESH		4
+#define FILTER_TYPE_TABLE		5
+#define FILTER_TYPE_STATUS		6
+#define FILTER_TYPES			7
+
+static const char *FilterTypeNames[FILTER_TYPES] = 
+	{ "open", "update", "notification", "keepalive", "refresh", "table", "status" };
+
+/* labels as written in the XML, indexed by BGPMON_LABEL_* */
+#define FILTER_LABELS			7
+
+static const char *FilterLabelNames[FILTER_LABELS] = 
+	{ "NULL", "WITH", "DUPW", "NANN", "DANN", "DPATH", "SPATH" };
+
+/* a prefix term, addr is the storage of prefix.addr.paddr */
+struct FilterPrefixStruct
+{
+	Prefix		prefix;
+	u_char		addr[PREFIX_MAX_BYTES];
+};
+
+/* a peer term */
+struct FilterPeerStruct
+{
+	int		afi;
+	u_char		addr[16];
+};
+
+/* a compiled filter */
+struct ClientFilterStruct
+{
+	int		refs;					// clients using the filter group
+	u_int64_t	generation;				// FilterGeneration when the group got the filter
+	int		kinds;					// bit k set if terms of kind k are used
+	char		text[CLIENTS_FILTER_MAX_LINE];		// canonical filter text
+	int		count[FILTER_KINDS];			// number of values of each kind
+	u_int32_t	values[FILTER_KINDS][CLIENT_FILTER_MAX_VALUES];	// numeric values
+	struct FilterPeerStruct		peers[CLIENT_FILTER_MAX_VALUES];
+	struct FilterPrefixStruct	prefixes[CLIENT_FILTER_MAX_VALUES];
+};
+typedef struct ClientFilterStruct ClientFilter;
+
+/* what the filters may test in a message, collected once per message */
+struct FilterMessageStruct
+{
+	int		type;			// FILTER_TYPE_*
+	int		hasSession;		// the message belongs to a session
+	u_int32_t	sessionID;
+	int		peerAfi;		// afi of the session's peer or 0 if unknown
+	u_char		peerAddr[16];
+	int		hasOrigin;		// an origin AS was found
+	u_int32_t	origin;
+	u_char		*update;		// body of a BGP UPDATE or NULL
+	int		wlen;			// withdrawn routes length
+	int		alen;			// path attributes length
+	int		nlen;			// NLRI length
+	u_char		*labels;		// labels of the prefixes or NULL
+	int		asnLen;			// length of the AS numbers in AS_PATH
+};
+typedef struct FilterMessageStruct FilterMessage;
+
+/* the filter groups, protected by FilterLock */
+static ClientFilter FilterGroups[CLIENT_MAX_FILTER_GROUPS];
+/* bit g set if filter group g is used, read without the lock to skip unused filters */
+static u_int64_t FilterGroupMask = 0;
+/* the kinds of terms used by any filter group */
+static int FilterKinds = 0;
+/* next group tried for a new filter, a released group is reused as late as possible */
+static int FilterGroupNext = 0;
+/* incremented each time a group gets a new filter, the messages record the value they 
+ * were matched with so a reused group ignores the bit set for its previous filter */
+static u_int64_t FilterGeneration = 0;
+static pthread_rwlock_t FilterLock = PTHREAD_RWLOCK_INITIALIZER;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find a name in a table of names
+ * Input:  the name, the table and its size
+ * Output: the index of the name or -1 if the name is unknown
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+findFilterName( const char *name, const char **names, int n )
+{
+	int i;
+
+	for ( i = 0; i < n; i++ )
+	{
+		if ( strcasecmp( name, names[i] ) == 0 )
+			return i;
+	}
+	return -1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Parse an unsigned number of a filter term
+ * Input:  the value string, the largest allowed number and where to store it
+ * Output: 0 for success or -1 for a malformed number
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+parseFilterNumber( const char *str, unsigned long max, u_int32_t *value )
+{
+	char *end;
+	unsigned long n;
+
+	if ( *str < '0' || *str > '9' )
+		return -1;
+	errno = 0;
+	n = strtoul( str, &end, 10 );
+	if ( *end != '\0' || errno != 0 || n > max )
+		return -1;
+	*value = n;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Parse one term of a filter line
+ * Input:  the filter being compiled and the term like kind=value
+ * Output: 0 for success or -1 for a malformed term
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+parseFilterTerm( ClientFilter *f, char *term )
+{
+	char *value;
+	int kind, n, i;
+
+	value = strchr( term, '=' );
+	if ( value == NULL )
+		return -1;
+	*value++ = '\0';
+	kind = findFilterName( term, FilterKindNames, FILTER_KINDS );
+	if ( kind < 0 || f->count[kind] == CLIENT_FILTER_MAX_VALUES )
+		return -1;
+	n = f->count[kind];
+
+	switch ( kind )
+	{
+		case FILTER_PEER:
+			memset( f->peers[n].addr, 0, sizeof(f->peers[n].addr) );
+			if ( inet_pton( AF_INET, value, f->peers[n].addr ) == 1 )
+				f->peers[n].afi = 1;
+			else if ( inet_pton( AF_INET6, value, f->peers[n].addr ) == 1 )
+				f->peers[n].afi = 2;
+			else
+				return -1;
+			break;
+		case FILTER_SESSION:
+			if ( parseFilterNumber( value, MAX_SESSION_IDS - 1, &f->values[kind][n] ) )
+				return -1;
+			break;
+		case FILTER_TYPE:
+			i = findFilterName( value, FilterTypeNames, FILTER_TYPES );
+			if ( i < 0 )
+				return -1;
+			f->values[kind][n] = i;
+			break;
+		case FILTER_ORIGIN:
+			if ( parseFilterNumber( value, 0xFFFFFFFFUL, &f->values[kind][n] ) )
+				return -1;
+			break;
+		case FILTER_AFI:
+			if ( parseFilterNumber( value, 0xFFFF, &f->values[kind][n] ) )
+				return -1;
+			break;
+		case FILTER_SAFI:
+			if ( parseFilterNumber( value, 0xFF, &f->values[kind][n] ) )
+				return -1;
+			break;
+		case FILTER_PREFIX:
+			if ( parsePrefix( value, &f->prefixes[n].prefix ) )
+				return -1;
+			break;
+		case FILTER_LABEL:
+			i = findFilterName( value, FilterLabelNames, FILTER_LABELS );
+			if ( i < 0 )
+				return -1;
+			f->values[kind][n] = i;
+			break;
+	}
+	f->count[kind]++;
+	f->kinds |= 1 << kind;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write the canonical text of a filter, equal filters have the same text
+ * Input:  the compiled filter
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+formatClientFilter( ClientFilter *f )
+{
+	char value[INET6_ADDRSTRLEN + 8];
+	int kind, i, used = 0;
+
+	f->text[0] = '\0';
+	for ( kind = 0; kind < FILTER_KINDS; kind++ )
+	{
+		for ( i = 0; i < f->count[kind]; i++ )
+		{
+			switch ( kind )
+			{
+				case FILTER_PEER:
+					inet_ntop( f->peers[i].afi == 1 ? AF_INET : AF_INET6, 
+						f->peers[i].addr, value, sizeof(value) );
+					break;
+				case FILTER_TYPE:
+					snprintf( value, sizeof(value), "%s", FilterTypeNames[f->values[kind][i]] );
+					break;
+				case FILTER_PREFIX:
+					formatPrefix( &f->prefixes[i].prefix, value, sizeof(value) );
+					break;
+				case FILTER_LABEL:
+					snprintf( value, sizeof(value), "%s", FilterLabelNames[f->values[kind][i]] );
+					break;
+				default:
+					snprintf( value, sizeof(value), "%u", f->values[kind][i] );
+					break;
+			}
+			used += snprintf( f->text + used, sizeof(f->text) - used, "%s%s=%s", 
+				used > 0 ? " " : "", FilterKindNames[kind], value );
+			if ( used >= sizeof(f->text) )
+				used = sizeof(f->text) - 1;
+		}
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Drop a reference to a filter group
+ * Input:  the filter group
+ * Output: none
+ * Note: Called with FilterLock write locked.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+unrefFilterGroup( int g )
+{
+	int i;
+
+	if ( --FilterGroups[g].refs > 0 )
+		return;
+	__atomic_store_n( &FilterGroupMask, FilterGroupMask & ~(1ULL << g), __ATOMIC_RELEASE );
+	FilterKinds = 0;
+	for ( i = 0; i < CLIENT_MAX_FILTER_GROUPS; i++ )
+	{
+		if ( FilterGroupMask & (1ULL << i) )
+			FilterKinds |= FilterGroups[i].kinds;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Move a client to the filter group of a compiled filter
+ * Input:  the client node structure and the filter, a filter without terms
+ *         lets every message through
+ * Output: 0 on success or -1 if every filter group is used by another filter
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+setClientFilter( ClientNode *cn, ClientFilter *f )
+{
+	int g = -1, i;
+
+	formatClientFilter( f );
+	if ( pthread_rwlock_wrlock( &FilterLock ) )
+		log_fatal( "lock client filters failed" );
+
+	if ( f->kinds != 0 )
+	{
+		// share the group of an equal filter
+		for ( i = 0; i < CLIENT_MAX_FILTER_GROUPS && g < 0; i++ )
+		{
+			if ( (FilterGroupMask & (1ULL << i)) && strcmp( FilterGroups[i].text, f->text ) == 0 )
+				g = i;
+		}
+		if ( g >= 0 )
+			FilterGroups[g].refs++;
+		else
+		{
+			for ( i = 0; i < CLIENT_MAX_FILTER_GROUPS && g < 0; i++ )
+			{
+				if ( (FilterGroupMask & (1ULL << FilterGroupNext)) == 0 )
+					g = FilterGroupNext;
+				FilterGroupNext = (FilterGroupNext + 1) % CLIENT_MAX_FILTER_GROUPS;
+			}
+			if ( g < 0 )
+			{
+				if ( pthread_rwlock_unlock( &FilterLock ) )
+					log_fatal( "unlock client filters failed" );
+				log_err("client %d: more than %d distinct filters, closing the client", 
+					cn->id, CLIENT_MAX_FILTER_GROUPS);
+				return -1;
+			}
+			FilterGroups[g] = *f;
+			FilterGroups[g].refs = 1;
+			FilterGroups[g].generation = __atomic_add_fetch( &FilterGeneration, 1, __ATOMIC_RELEASE );
+			FilterKinds |= f->kinds;
+			__atomic_store_n( &FilterGroupMask, FilterGroupMask | (1ULL << g), __ATOMIC_RELEASE );
+		}
+		cn->filterGeneration = FilterGroups[g].generation;
+	}
+	if ( cn->filterGroup >= 0 )
+		unrefFilterGroup( cn->filterGroup );
+	cn->filterGroup = g;
+
+	if ( pthread_rwlock_unlock( &FilterLock ) )
+		log_fatal( "unlock client filters failed" );
+
+	if ( g >= 0 )
+		log_msg("client %d: filter group %d: %s", cn->id, g, f->text);
+	else
+		log_msg("client %d: filter removed", cn->id);
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Let a RIB client take the delta rib transfers
+ * Input:  the client node structure and the version sent by the client
+ * Output: none
+ * Note: A malformed version is logged and leaves the client as it is.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+setClientRibSince( ClientNode *cn, const char *value )
+{
+	unsigned long long since;
+	char *end;
+
+	if ( value == NULL )
+	{
+		log_warning("client %d: SINCE without a version", cn->id);
+		return;
+	}
+	errno = 0;
+	since = strtoull( value, &end, 10 );
+	if ( *value < '0' || *value > '9' || errno != 0 || *end != '\0' )
+	{
+		log_warning("client %d: malformed SINCE version %s", cn->id, value);
+		return;
+	}
+	cn->ribSince = since;
+	cn->ribDeltas = TRUE;
+	log_msg("client %d: delta rib transfers since version %llu", cn->id, since);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Apply a line sent by a client
+ * Input:  the client node structure and the line
+ * Output: 0 or -1 if the client must be closed
+ * Note: A malformed filter is logged and leaves the current filter in place.  A filter
+ *       that can't get a group closes the client, it would get messages it didn't ask for.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+applyClientLine( ClientNode *cn, char *line )
+{
+	ClientFilter f;
+	char *word, *last;
+
+	word = strtok_r( line, " \t", &last );
+	if ( word == NULL )
+		return 0;
+	if ( strcasecmp( word, "SINCE" ) == 0 )
+	{
+		setClientRibSince( cn, strtok_r( NULL, " \t", &last ) );
+		return 0;
+	}
+	if ( strcasecmp( word, "FILTER" ) != 0 )
+	{
+		log_warning("client %d: unknown command %s", cn->id, word);
+		return 0;
+	}
+	memset( &f, 0, sizeof(f) );
+	while ( (word = strtok_r( NULL, " \t", &last )) != NULL )
+	{
+		if ( parseFilterTerm( &f, word ) )
+		{
+			log_warning("client %d: malformed filter term %s, filter unchanged", cn->id, word);
+			return 0;
+		}
+	}
+	return setClientFilter( cn, &f );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read what a client sent without blocking and apply its filter lines
+ * Input:  the client node structure
+ * Output: CLIENT_INPUT_OPEN, CLIENT_INPUT_CLOSED or CLIENT_INPUT_ERROR
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int 
+readClientInput( ClientNode *cn )
+{
+	ssize_t n;
+	int i, start;
+
+	if ( cn->inputClosed == TRUE )
+		return CLIENT_INPUT_CLOSED;
+
+	while ( TRUE )
+	{
+		n = recv( cn->socket, cn->input + cn->inputLen, CLIENTS_FILTER_MAX_LINE - cn->inputLen, MSG_DONTWAIT );
+		if ( n == 0 )
+		{
+			cn->inputClosed = TRUE;
+			return CLIENT_INPUT_CLOSED;
+		}
+		if ( n < 0 )
+		{
+			if ( errno == EINTR )
+				continue;
+			if ( errno == EAGAIN || errno == EWOULDBLOCK )
+				return CLIENT_INPUT_OPEN;
+			return CLIENT_INPUT_ERROR;
+		}
+		cn->inputLen += n;
+
+		// apply each complete line
+		start = 0;
+		for ( i = 0; i < cn->inputLen; i++ )
+		{
+			if ( cn->input[i] != '\n' )
+				continue;
+			cn->input[i] = '\0';
+			if ( i > start && cn->input[i-1] == '\r' )
+				cn->input[i-1] = '\0';
+			if ( applyClientLine( cn, cn->input + start ) )
+				return CLIENT_INPUT_ERROR;
+			start = i + 1;
+		}
+		memmove( cn->input, cn->input + start, cn->inputLen - start );
+		cn->inputLen -= start;
+
+		if ( cn->inputLen == CLIENTS_FILTER_MAX_LINE )
+		{
+			log_warning("client %d sent a line longer than %d bytes", cn->id, CLIENTS_FILTER_MAX_LINE);
+			cn->inputLen = 0;
+		}
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Drop the messages a client's filter doesn't match, and the delta rib 
+ *          transfers the client didn't ask for
+ * Input:  the client node structure, the messages read from its queue and their number
+ * Output: the number of messages left at the start of the array
+ * Note: The dropped messages are released.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long 
+filterClientMessages( ClientNode *cn, const struct XMLMessageStruct **msgs, long n )
+{
+	u_int64_t bit = 0;
+	long i, kept = 0;
+
+	if ( cn->filterGroup >= 0 )
+		bit = 1ULL << cn->filterGroup;
+	for ( i = 0; i < n; i++ )
+	{
+		// a message matched before the group got the client's filter is dropped, 
+		// its bit is the one of the previous filter of the group
+		if ( bit != 0 && ((msgs[i]->filters & bit) == 0 || msgs[i]->filterGeneration < cn->filterGeneration) )
+			releaseQueueItem( cn->qReader, msgs[i] );
+		// a delta only applies to the table of the transfer it starts from
+		else if ( msgs[i]->ribSince != 0 && (cn->ribDeltas == FALSE || msgs[i]->ribSince < cn->ribSince) )
+			releaseQueueItem( cn->qReader, msgs[i] );
+		else
+			msgs[kept++] = msgs[i];
+	}
+	return kept;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release the filter group of a client that is destroyed
+ * Input:  the client node structure
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+releaseClientFilter( ClientNode *cn )
+{
+	if ( cn->filterGroup < 0 )
+		return;
+	if ( pthread_rwlock_wrlock( &FilterLock ) )
+		log_fatal( "lock client filters failed" );
+	unrefFilterGroup( cn->filterGroup );
+	cn->filterGroup = -1;
+	if ( pthread_rwlock_unlock( &FilterLock ) )
+		log_fatal( "unlock client filters failed" );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Test if a value is one of the values of a filter term
+ * Input:  the filter, the kind of term and the value
+ * Output: TRUE or FALSE
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+matchFilterValue( ClientFilter *f, int kind, u_int32_t value )
+{
+	int i;
+
+	for ( i = 0; i < f->count[kind]; i++ )
+	{
+		if ( f->values[kind][i] == value )
+			return TRUE;
+	}
+	return FALSE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find the origin AS of the path attributes of an UPDATE
+ * Input:  the message description with the attributes to search
+ * Output: none, sets hasOrigin and origin
+ * Note: The origin is the last AS of the path if the path ends with an AS_SEQUENCE,
+ *       AS4_PATH is used if it has one since AS_PATH then holds AS_TRANS.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+findFilterOrigin( FilterMessage *m )
+{
+	u_char *attr = m->update + 4 + m->wlen;
+	u_char *value;
+	int i, j, hl, l, type, asnLen, count, found;
+	u_int32_t origin, as4Origin = 0;
+	int hasAs4Origin = FALSE;
+
+	for ( i = 0; i + 3 <= m->alen; i = i + 2 + hl + l )
+	{
+		type = attr[i+1];
+		if ( attr[i] & 0x10 )
+		{
+			hl = 2;
+			if ( i + 4 > m->alen )
+				break;
+			l = ntohs( *((u_int16_t *) (attr+i+2)) );
+		}
+		else
+		{
+			hl = 1;
+			l = attr[i+2];
+		}
+		if ( i + 2 + hl + l > m->alen )
+			break;
+		if ( type != BGP_ATTR_AS_PATH && type != BGP_ATTR_AS4_PATH )
+			continue;
+		value = attr + i + 2 + hl;
+		asnLen = type == BGP_ATTR_AS4_PATH ? 4 : m->asnLen;
+
+		// the last segment decides the origin
+		found = FALSE;
+		origin = 0;
+		for ( j = 0; j + 2 <= l; j = j + 2 + count * asnLen )
+		{
+			count = value[j+1];
+			if ( j + 2 + count * asnLen > l )
+				break;
+			found = FALSE;
+			if ( value[j] == 2 && count > 0 )
+			{
+				u_char *as = value + j + 2 + (count - 1) * asnLen;
+				origin = asnLen == 4 ? ntohl( *((u_int32_t *) as) ) : ntohs( *((u_int16_t *) as) );
+				found = TRUE;
+			}
+		}
+		if ( type == BGP_ATTR_AS_PATH )
+		{
+			m->hasOrigin = found;
+			m->origin = origin;
+		}
+		else if ( found )
+		{
+			hasAs4Origin = TRUE;
+			as4Origin = origin;
+		}
+	}
+	if ( hasAs4Origin )
+	{
+		m->hasOrigin = TRUE;
+		m->origin = as4Origin;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Collect what the filters may test in a message
+ * Input:  the message and the description to fill in
+ * Output: none
+ * Note: The UPDATE lengths are clipped the way the XML conversion does it for
+ *       truncated prefixes.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+describeFilterMessage( BMF bmf, FilterMessage *m )
+{
+	PBgpHeader hdr = (PBgpHeader)(bmf->message);
+	int isBgp = FALSE;
+
+	memset( m, 0, sizeof(*m) );
+	m->type = FILTER_TYPE_STATUS;
+	switch ( bmf->type )
+	{
+		case BMF_TYPE_MSG_TO_PEER:
+		case BMF_TYPE_MSG_FROM_PEER:
+		case BMF_TYPE_MSG_LABELED:
+			m->hasSession = TRUE;
+			if ( bmf->length < BGP_HEADER_LEN )
+				break;
+			isBgp = TRUE;
+			switch ( hdr->type )
+			{
+				case typeOpen:		m->type = FILTER_TYPE_OPEN;		break;
+				case typeUpdate:	m->type = FILTER_TYPE_UPDATE;		break;
+				case typeNotification:	m->type = FILTER_TYPE_NOTIFICATION;	break;
+				case typeKeepalive:	m->type = FILTER_TYPE_KEEPALIVE;	break;
+				case typeRouteRefresh:
+				case typeRouteRefreshCisco:	m->type = FILTER_TYPE_REFRESH;	break;
+			}
+			break;
+		case BMF_TYPE_TABLE_TRANSFER:
+			isBgp = bmf->length >= BGP_HEADER_LEN;
+			// fall through
+		case BMF_TYPE_TABLE_START:
+		case BMF_TYPE_TABLE_STOP:
+			m->hasSession = TRUE;
+			m->type = FILTER_TYPE_TABLE;
+			break;
+		case BMF_TYPE_FSM_STATE_CHANGE:
+		case BMF_TYPE_SESSION_STATUS:
+			m->hasSession = TRUE;
+			break;
+	}
+	m->sessionID = bmf->sessionID;
+
+	// the session's peer and AS number length
+	if ( m->hasSession && (FilterKinds & ((1<<FILTER_PEER) | (1<<FILTER_ORIGIN))) )
+	{
+		Session_structp sp = getSessionByID( bmf->sessionID );
+		if ( sp != NULL )
+		{
+			if ( inet_pton( AF_INET, sp->configInUse.remoteAddr, m->peerAddr ) == 1 )
+				m->peerAfi = 1;
+			else if ( inet_pton( AF_INET6, sp->configInUse.remoteAddr, m->peerAddr ) == 1 )
+				m->peerAfi = 2;
+			m->asnLen = sp->fsm.ASNumlen;
+		}
+	}
+
+	// the parts of an UPDATE
+	if ( isBgp && hdr->type == typeUpdate )
+	{
+		int len = getBGPHeaderLength( hdr ) - BGP_HEADER_LEN;
+		int real_len = bmf->length - BGP_HEADER_LEN;	/* In case of prefixes have been truncated */
+		if ( real_len < 4 || len < 4 )
+			return;
+		m->update = bmf->message + BGP_HEADER_LEN;
+		if ( bmf->type == BMF_TYPE_MSG_LABELED )
+			m->labels = bmf->message + getBGPHeaderLength( hdr );
+		m->wlen = ntohs( *((u_int16_t *) m->update) );
+		if ( m->wlen > real_len - 4 ) 
+			m->wlen = real_len - 4;
+		m->alen = ntohs( *((u_int16_t *) (m->update+2+m->wlen)) );
+		if ( m->alen > real_len - 4 - m->wlen )
+			m->alen = real_len - 4 - m->wlen;
+		m->nlen = len - m->alen - m->wlen - 4;
+		if ( m->nlen > real_len - 4 - m->wlen - m->alen )
+			m->nlen = real_len - 4 - m->wlen - m->alen;
+		if ( m->nlen < 0 )
+			m->nlen = 0;
+		if ( (FilterKinds & (1<<FILTER_ORIGIN)) && m->asnLen > 0 )
+			findFilterOrigin( m );
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Test the terms of a filter that apply to the whole message
+ * Input:  the filter and the message description
+ * Output: TRUE or FALSE
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+matchFilterMessage( ClientFilter *f, FilterMessage *m )
+{
+	int i;
+
+	if ( f->count[FILTER_TYPE] > 0 && !matchFilterValue( f, FILTER_TYPE, m->type ) )
+		return FALSE;
+	if ( f->count[FILTER_SESSION] > 0 
+		&& (m->hasSession == FALSE || !matchFilterValue( f, FILTER_SESSION, m->sessionID )) )
+		return FALSE;
+	if ( f->count[FILTER_ORIGIN] > 0 
+		&& (m->hasOrigin == FALSE || !matchFilterValue( f, FILTER_ORIGIN, m->origin )) )
+		return FALSE;
+	if ( f->count[FILTER_PEER] > 0 )
+	{
+		for ( i = 0; i < f->count[FILTER_PEER]; i++ )
+		{
+			if ( f->peers[i].afi == m->peerAfi 
+				&& memcmp( f->peers[i].addr, m->peerAddr, m->peerAfi == 1 ? 4 : 16 ) == 0 )
+				break;
+		}
+		if ( i == f->count[FILTER_PEER] )
+			return FALSE;
+	}
+	if ( (f->kinds & FILTER_PREFIX_KINDS) && m->update == NULL )
+		return FALSE;
+	return TRUE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Test the terms of a filter that apply to one prefix
+ * Input:  the filter, the prefix bytes and length, its afi, safi and label (-1 if none)
+ * Output: TRUE or FALSE
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+matchFilterPrefix( ClientFilter *f, u_char *addr, int bits, int afi, int safi, int label )
+{
+	int i, full, rest;
+	Prefix *p;
+	u_char *paddr;
+
+	if ( f->count[FILTER_AFI] > 0 && !matchFilterValue( f, FILTER_AFI, afi ) )
+		return FALSE;
+	if ( f->count[FILTER_SAFI] > 0 && !matchFilterValue( f, FILTER_SAFI, safi ) )
+		return FALSE;
+	if ( f->count[FILTER_LABEL] > 0 && (label < 0 || !matchFilterValue( f, FILTER_LABEL, label )) )
+		return FALSE;
+	if ( f->count[FILTER_PREFIX] == 0 )
+		return TRUE;
+
+	// the prefix or a more specific one
+	for ( i = 0; i < f->count[FILTER_PREFIX]; i++ )
+	{
+		p = &f->prefixes[i].prefix;
+		paddr = f->prefixes[i].addr;
+		if ( p->afi != afi || bits < p->addr.p_len )
+			continue;
+		full = p->addr.p_len / 8;
+		rest = p->addr.p_len % 8;
+		if ( memcmp( addr, paddr, full ) != 0 )
+			continue;
+		if ( rest > 0 && ((addr[full] ^ paddr[full]) & (0xFF << (8 - rest))) )
+			continue;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find the filter groups matching a prefix of a list
+ * Input:  the groups to test, the prefix list, its length, afi and safi and the
+ *         pointer to the labels of the prefixes (NULL if there are none)
+ * Output: the groups matching a prefix of the list
+ * Note: The labels are consumed in the order of the XML conversion.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static u_int64_t
+matchFilterPrefixes( u_int64_t groups, u_char *prefix, int len, int afi, int safi, u_char **lt )
+{
+	u_int64_t matched = 0;
+	int i, l, g, bits, label;
+
+	for ( i = 0; i < len && matched != groups; i = i + 1 + l )
+	{
+		bits = prefix[i];
+		l = (bits + 7) / 8;
+		label = -1;
+		if ( *lt != NULL )
+		{
+			label = **lt;
+			*lt = *lt + 1;
+		}
+		if ( i + 1 + l > len )
+			break;
+		for ( g = 0; g < CLIENT_MAX_FILTER_GROUPS; g++ )
+		{
+			if ( ((groups & ~matched) & (1ULL << g)) 
+				&& matchFilterPrefix( &FilterGroups[g], prefix + i + 1, bits, afi, safi, label ) )
+				matched |= 1ULL << g;
+		}
+	}
+	return matched;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find the filter groups matching a prefix of an UPDATE
+ * Input:  the groups to test and the message description
+ * Output: the groups matching a prefix of the message
+ * Note: The prefixes are visited like the XML conversion does: the withdrawn routes,
+ *       the MP_REACH_NLRI and MP_UNREACH_NLRI attributes and then the NLRI.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static u_int64_t
+matchFilterUpdate( u_int64_t groups, FilterMessage *m )
+{
+	u_char *lt = m->labels;
+	u_char *attr = m->update + 4 + m->wlen;
+	u_char *value;
+	u_int64_t matched;
+	int i, hl, l, type, nhlen;
+
+	matched = matchFilterPrefixes( groups, m->update + 2, m->wlen, 1, 1, &lt );
+	for ( i = 0; i + 3 <= m->alen && matched != groups; i = i + 2 + hl + l )
+	{
+		type = attr[i+1];
+		if ( attr[i] & 0x10 )
+		{
+			hl = 2;
+			if ( i + 4 > m->alen )
+				break;
+			l = ntohs( *((u_int16_t *) (attr+i+2)) );
+		}
+		else
+		{
+			hl = 1;
+			l = attr[i+2];
+		}
+		if ( i + 2 + hl + l > m->alen )
+			break;
+		value = attr + i + 2 + hl;
+		if ( type == BGP_ATTR_MP_REACH_NLRI && l >= 5 )
+		{
+			nhlen = value[3];
+			if ( 5 + nhlen <= l )
+				matched |= matchFilterPrefixes( groups & ~matched, value + 5 + nhlen, l - 5 - nhlen, 
+					ntohs( *((u_int16_t *) value) ), value[2], &lt );
+		}
+		else if ( type == BGP_ATTR_MP_UNREACH_NLRI && l >= 3 )
+		{
+			matched |= matchFilterPrefixes( groups & ~matched, value + 3, l - 3, 
+				ntohs( *((u_int16_t *) value) ), value[2], &lt );
+		}
+	}
+	if ( matched != groups )
+		matched |= matchFilterPrefixes( groups & ~matched, m->update + 4 + m->wlen + m->alen, m->nlen, 1, 1, &lt );
+	return matched;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find the filter groups a message matches
+ * Input:  the message and where to store the filter generation the groups had
+ * Output: a mask with bit g set if filter group g matches the message
+ * Note: Called once per message before it is written to the XML queues, the session
+ *       of the message must still exist.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+u_int64_t 
+matchClientFilters( BMF bmf, u_int64_t *generation )
+{
+	FilterMessage m;
+	u_int64_t groups, matched = 0, prefixGroups = 0;
+	int g;
+
+	// no client has a filter, a group added after the load has a newer generation
+	*generation = __atomic_load_n( &FilterGeneration, __ATOMIC_ACQUIRE );
+	if ( __atomic_load_n( &FilterGroupMask, __ATOMIC_ACQUIRE ) == 0 )
+		return 0;
+
+	if ( pthread_rwlock_rdlock( &FilterLock ) )
+		log_fatal( "lock client filters failed" );
+	*generation = FilterGeneration;
+	groups = FilterGroupMask;
+	describeFilterMessage( bmf, &m );
+	for ( g = 0; g < CLIENT_MAX_FILTER_GROUPS; g++ )
+	{
+		if ( (groups & (1ULL << g)) == 0 || !matchFilterMessage( &FilterGroups[g], &m ) )
+			continue;
+		if ( FilterGroups[g].kinds & FILTER_PREFIX_KINDS )
+			prefixGroups |= 1ULL << g;
+		else
+			matched |= 1ULL << g;
+	}
+	// one walk over the prefixes for all the groups testing them
+	if ( prefixGroups != 0 )
+		matched |= matchFilterUpdate( prefixGroups, &m );
+	if ( pthread_rwlock_unlock( &FilterLock ) )
+		log_fatal( "unlock client filters failed" );
+	return matched;
+}
@@ -0,0 +1,107 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: clientfilter.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef CLIENTFILTER_H_
+#define CLIENTFILTER_H_
+
+/* An update or RIB client may send filter lines at any time:
+ *   FILTER <term> ...
+ * and only gets the messages matching the last filter from then on, a FILTER line
+ * without terms lets every message through again.  The terms are:
+ *   peer=<address> session=<id> type=<open|update|notification|keepalive|refresh|table|status>
+ *   origin=<AS> afi=<value> safi=<value> prefix=<prefix> label=<NULL|WITH|DUPW|NANN|DANN|DPATH|SPATH>
+ * A message matches when each kind of term used matches one of its values.  The afi,
+ * safi, prefix and label terms must all match the same prefix of the message, a prefix
+ * term matches that prefix and the more specific ones.
+ *
+ * A RIB client holding the tables of a previous transfer may send
+ *   SINCE <version>
+ * to get the delta transfers starting from that version or a later one, the since
+ * attribute of their TABLE_START tells which table a delta applies to.  The other
+ * RIB clients only get the full transfers.
+ */
+
+// needed for ClientNode
+#include "clientinstance.h"
+
+// needed for BMF
+#include "../Util/bgpmon_formats.h"
+
+// needed for struct XMLMessageStruct
+#include "../XML/xml.h"
+
+/* max number of distinct filters, clients sending the same filter share its group */
+#define CLIENT_MAX_FILTER_GROUPS	64
+
+/* max number of values of one kind of term in a filter */
+#define CLIENT_FILTER_MAX_VALUES	16
+
+/* results of readClientInput */
+#define CLIENT_INPUT_OPEN	0	// the client may send more
+#define CLIENT_INPUT_CLOSED	1	// the client won't send anything more
+#define CLIENT_INPUT_ERROR	-1	// the connection was lost or the client must be closed
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read what a client sent without blocking and apply its filter lines
+ * Input:  the client node structure
+ * Output: CLIENT_INPUT_OPEN, CLIENT_INPUT_CLOSED or CLIENT_INPUT_ERROR
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int readClientInput( ClientNode *cn );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Drop the messages a client's filter doesn't match
+ * Input:  the client node structure, the messages read from its queue and their number
+ * Output: the number of messages left at the start of the array
+ * Note: The dropped messages are released.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long filterClientMessages( ClientNode *cn, const struct XMLMessageStruct **msgs, long n );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release the filter group of a client that is destroyed
+ * Input:  the client node structure
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void releaseClientFilter( ClientNode *cn );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find the filter groups a message matches
+ * Input:  the message and where to store the filter generation the groups had
+ * Output: a mask with bit g set if filter group g matches the message
+ * Note: Called once per message before it is written to the XML queues, the session
+ *       of the message must still exist.  The generation is kept with the mask, a 
+ *       group reused for another filter only trusts the bits of newer generations.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+u_int64_t matchClientFilters( BMF bmf, u_int64_t *generation );
+
+#endif /*CLIENTFILTER_H_*/
@@ -46,12 +46,15 @@
 /* needed for address management  */
 #include "../Util/address.h"
 
-/* needed for writen function  */
+/* needed for writen and writevn functions  */
 #include "../Util/unp.h"
 
-/* needed for function getXMLMessageLen */
+/* needed for the XML message header */
 #include "../XML/xml.h"
 
+/* needed for the client filters */
+#include "clientfilter.h"
+
 /* needed for malloc and free */
 #include <stdlib.h>
 /* needed for strncpy */
@@ -597,6 +600,7 @@ destroyClient(long id, int client_listener)
 					prev->next = cn->next;
 				// clean up the memory
 				destroyQueueReader( cn->qReader );
+				releaseClientFilter( cn );
 				free(cn);
 				// unlock the client list
 				if ( pthread_mutex_unlock( &(ClientControls.clientULock ) ) )
@@ -643,6 +647,7 @@ destroyClient(long id, int client_listener)
 					prev->next = cn->next;
 				// clean up the memory
 				destroyQueueReader( cn->qReader );
+				releaseClientFilter( cn );
 				free(cn);
 				// unlock the client list
 				if ( pthread_mutex_unlock( &(ClientControls.clientRLock ) ) )
@@ -689,6 +694,12 @@ createClientUNode( long ID, char *addr, int port, int socket )
 	cn->lastAction = time(NULL);
 	cn->qReader = createQueueReader( xmlUQueue );
 	cn->deleteClient = FALSE;		
+	cn->filterGroup = -1;
+	cn->filterGeneration = 0;
+	cn->ribDeltas = FALSE;
+	cn->ribSince = 0;
+	cn->inputClosed = FALSE;
+	cn->inputLen = 0;
 	cn->next = NULL;
 	return cn;
 }
@@ -717,10 +728,42 @@ createClientRNode( long ID, char *addr, int port, int socket )
 	cn->lastAction = time(NULL);
 	cn->qReader = createQueueReader( xmlRQueue );
 	cn->deleteClient = FALSE;		
+	cn->filterGroup = -1;
+	cn->filterGeneration = 0;
+	cn->ribDeltas = FALSE;
+	cn->ribSince = 0;
+	cn->inputClosed = FALSE;
+	cn->inputLen = 0;
 	cn->next = NULL;
 	return cn;
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write the messages read from the queue to a client
+ * Input:  the client node structure, the messages and their number
+ * Output: 0 on success or -1 if the socket connection was lost
+ * Note: The messages are written together with a single writev call when the
+ *       socket accepts them, rather than one write per message.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+writeClientMessages( ClientNode *cn, const struct XMLMessageStruct **msgs, long n )
+{
+	struct iovec iov[QUEUE_READ_BATCH];
+	ssize_t total = 0;
+	long i;
+
+	for ( i = 0; i < n; i++ )
+	{
+		iov[i].iov_base = (void *)msgs[i]->text;
+		iov[i].iov_len = msgs[i]->length;
+		total += msgs[i]->length;
+	}
+	if ( n > 0 && writevn( cn->socket, iov, n ) != total )
+		return -1;
+	return 0;
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: The main function of a thread handling one client
  * Input:  the client node structure for this client
@@ -731,16 +774,15 @@ void *
 clientUThread( void *arg  )
 {
 	ClientNode *cn = arg;	// the client node structure
-	int readresult;		// result of reading from queue
-	u_char *xmlDataOut;	// the data read in from the queue
-	int readlength;		// the length of data read from queue
-	int wrotelength;	// the length of data written to client
+	long readresult;	// result of reading from queue
+	const struct XMLMessageStruct *xmlDataOut[QUEUE_READ_BATCH];	// the data read in from the queue, shared with other clients
+	long i;
 			
 	// detach the thread so the resources may be returned when the thread exits
 	//pthread_detach(pthread_self());
 
 	// write a open tag <xml> when connection starts
-	wrotelength = writen(cn->socket,"<xml>",5);
+	writen(cn->socket,"<xml>",5);
 	
 	// get the xml queue reader
 	QueueReader xmlQueueReader = cn->qReader;
@@ -750,8 +792,8 @@ clientUThread( void *arg  )
 	{
 		// update the last action time
 		cn->lastAction = time(NULL);
-		// read from the queue
-		readresult = readQueue( xmlQueueReader, (void **)&xmlDataOut );
+		// read the available messages from the queue
+		readresult = readQueueSharedBatch( xmlQueueReader, (const void **)xmlDataOut, QUEUE_READ_BATCH );
 		// if reader has been canceled or ceased, close client
 		if ( readresult == READER_SLOT_AVAILABLE ) 
 		{
@@ -760,28 +802,29 @@ clientUThread( void *arg  )
 		// otherwise write data to client
 		else 
 		{
-			// readlength = strlen((const char *)xmlDataOut);
-			readlength = getXMLMessageLen((char *)xmlDataOut);
-			//wrotelength = writen(cn->socket,xmlDataOut,readlength+1);
-			wrotelength = writen(cn->socket,xmlDataOut,readlength);
+			// apply the filter lines the client sent meanwhile
+			if ( readClientInput( cn ) == CLIENT_INPUT_ERROR )
+			{
+				cn->deleteClient = TRUE;
+			}
+			// keep the messages the client's filter matches
+			readresult = filterClientMessages( cn, xmlDataOut, readresult );
 			// if write fails, close client
-			//if ( wrotelength != readlength+1 ) // socket connection lost
-			if ( wrotelength != readlength ) // socket connection lost
+			if ( writeClientMessages( cn, xmlDataOut, readresult ) )
 			{
 				cn->deleteClient = TRUE;
 			}
-			// free the message we just wrote and get next msg
-			free(xmlDataOut);
-			xmlDataOut = NULL;
+			// release the messages we just wrote and get next msgs
+			for ( i = 0; i < readresult; i++ )
+			{
+				releaseQueueItem( xmlQueueReader, xmlDataOut[i] );
+				xmlDataOut[i] = NULL;
+			}
 		}
 	}
 
-	// destroy the client  
+	// destroy the client, the queue reader releases any message still held
 	destroyClient(cn->id, CLIENT_LISTENER_UPDATA);
-	
-	// free any messages that haven't been written to the queue	
-	if (xmlDataOut != NULL) 
-		free(xmlDataOut);
 
 	pthread_exit( (void *) 1 ); 
 }
@@ -797,16 +840,15 @@ void *
 clientRThread( void *arg  )
 {
 	ClientNode *cn = arg;	// the client node structure
-	int readresult;		// result of reading from queue
-	u_char *xmlDataOut;	// the data read in from the queue
-	int readlength;		// the length of data read from queue
-	int wrotelength;	// the length of data written to client
+	long readresult;	// result of reading from queue
+	const struct XMLMessageStruct *xmlDataOut[QUEUE_READ_BATCH];	// the data read in from the queue, shared with other clients
+	long i;
 			
 	// detach the thread so the resources may be returned when the thread exits
 	//pthread_detach(pthread_self());
 
 	// write a open tag <xml> when connection starts
-	wrotelength = writen(cn->socket,"<xml>",5);
+	writen(cn->socket,"<xml>",5);
 	
 	// get the xml queue reader
 	QueueReader xmlQueueReader = cn->qReader;
@@ -816,8 +858,8 @@ clientRThread( void *arg  )
 	{
 		// update the last action time
 		cn->lastAction = time(NULL);
-		// read from the queue
-		readresult = readQueue( xmlQueueReader, (void **)&xmlDataOut );
+		// read the available messages from the queue
+		readresult = readQueueSharedBatch( xmlQueueReader, (const void **)xmlDataOut, QUEUE_READ_BATCH );
 		// if reader has been canceled or ceased, close client
 		if ( readresult == READER_SLOT_AVAILABLE ) 
 		{
@@ -826,29 +868,29 @@ clientRThread( void *arg  )
 		// otherwise write data to client
 		else 
 		{
-			// readlength = strlen((const char *)xmlDataOut);
-			readlength = getXMLMessageLen((char *)xmlDataOut);
-			//wrotelength = writen(cn->socket,xmlDataOut,readlength+1);
-			wrotelength = writen(cn->socket,xmlDataOut,readlength);
+			// apply the filter lines the client sent meanwhile
+			if ( readClientInput( cn ) == CLIENT_INPUT_ERROR )
+			{
+				cn->deleteClient = TRUE;
+			}
+			// keep the messages the client's filter matches
+			readresult = filterClientMessages( cn, xmlDataOut, readresult );
 			// if write fails, close client
-			//if ( wrotelength != readlength+1 ) // socket connection lost
-			if ( wrotelength != readlength ) // socket connection lost
+			if ( writeClientMessages( cn, xmlDataOut, readresult ) )
 			{
 				cn->deleteClient = TRUE;
 			}
-			// free the message we just wrote and get next msg
-			free(xmlDataOut);
-			xmlDataOut = NULL;
+			// release the messages we just wrote and get next msgs
+			for ( i = 0; i < readresult; i++ )
+			{
+				releaseQueueItem( xmlQueueReader, xmlDataOut[i] );
+				xmlDataOut[i] = NULL;
+			}
 		}
 	}
 
-	// destroy the client  
+	// destroy the client, the queue reader releases any message still held
 	destroyClient(cn->id, CLIENT_LISTENER_RIB);
 
-	
-	// free any messages that haven't been written to the queue	
-	if (xmlDataOut != NULL) 
-		free(xmlDataOut);
-
 	pthread_exit( (void *) 1 ); 
 }
@@ -37,6 +37,9 @@
 // needed for QueueReader
 #include "../Queues/queue.h"
 
+// needed for CLIENTS_FILTER_MAX_LINE
+#include "../site_defaults.h"
+
 /* structure holding client information  */
 struct ClientStruct
 {
@@ -48,6 +51,13 @@ struct ClientStruct
 	time_t		lastAction;		// client's last action time
 	QueueReader 	qReader;		// client's XML queue reader 
 	int		deleteClient;		// flag to indicate delete
+	int		filterGroup;		// client's filter group or -1 to get every message
+	u_int64_t	filterGeneration;	// generation of the filter of the client's group
+	int		ribDeltas;		// flag to indicate the client takes delta rib transfers
+	u_int64_t	ribSince;		// the oldest version a delta it takes may start from
+	int		inputClosed;		// flag to indicate the client won't send more
+	int		inputLen;		// length of the partial line in input
+	char		input[CLIENTS_FILTER_MAX_LINE];	// partial line sent by the client
 	pthread_t	clientThread;
 	struct ClientStruct *	next;		// pointer to next client node
 };
@@ -0,0 +1,377 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ * 
+ *  File: clientquery.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+/* 
+ * Answer prefix queries of BGPmon clients from the rib tables of the sessions
+ */
+
+/* externally visible structures and functions for clients */
+#include "clients.h"
+/* internal structures and functions for this module */
+#include "clientscontrol.h"
+#include "clientquery.h"
+
+/* required for logging functions */
+#include "../Util/log.h"
+
+/* required for TRUE/FALSE defines  */
+#include "../Util/bgpmon_defaults.h"
+
+/* needed for address management  */
+#include "../Util/address.h"
+
+/* needed for checkACL */
+#include "../Util/acl.h"
+
+/* needed for writen */
+#include "../Util/unp.h"
+
+/* needed for the XML output */
+#include "../XML/xfbwriter.h"
+
+/* needed for the sessions and their rib tables */
+#include "../Peering/peersession.h"
+#include "../Labeling/prefixtrie.h"
+
+/* needed for site defaults */
+#include "../site_defaults.h"
+
+/* needed for malloc and free */
+#include <stdlib.h>
+/* needed for strncpy */
+#include <string.h>
+/* needed for system error codes */
+#include <errno.h>
+/* needed for system types such as time_t */
+#include <sys/types.h>
+/* needed for socket operations */
+#include <sys/socket.h>
+/* needed for select */
+#include <sys/select.h>
+/* needed for pthread related functions */
+#include <pthread.h>
+/* needed for close */
+#include <unistd.h>
+/* needed for INET6_ADDRSTRLEN */
+#include <netinet/in.h>
+
+//#define DEBUG
+
+/* the length of a query result without the routes */
+#define QUERY_RESULT_HEADER_LEN	(CLIENTS_QUERY_MAX_LINE + 128)
+/* the length of a route in a query result without its AS path */
+#define QUERY_ROUTE_LEN		(ADDR_MAX_CHARS + 2*INET6_ADDRSTRLEN + 96)
+
+/* the routes one session returned for a query */
+typedef struct QueryAnswerStruct {
+	char		peer[ADDR_MAX_CHARS];
+	PrefixRoute	*routes;
+	int		count;
+} QueryAnswer;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Accept a new prefix query client and spawn a thread for it
+ *          if more clients are allowed and it passes the ACL check.
+ * Input:  the socket used for listening
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+startQueryClient( int listenSocket )
+{
+	// structure to store the client addrress from accept
+	struct sockaddr_storage clientaddr;
+	socklen_t addrlen = sizeof (clientaddr);
+	pthread_attr_t attr;
+	pthread_t clientQThreadID;
+	int *sock;
+	int error;
+	
+	// accept connection
+	int clientSocket = accept( listenSocket, (struct sockaddr *) &clientaddr, &addrlen);
+	if( clientSocket == -1 ) {
+		log_err( "Failed to accept new query client" );
+		return;
+	}
+
+	// convert address into address string and port
+	char *addr;
+	int port;
+	if( getAddressFromSockAddr((struct sockaddr *)&clientaddr, &addr, &port) )
+	{
+		log_warning( "Unable to get address and port for new connection." );
+		close(clientSocket);
+		return;
+	}
+
+	// too many query clients, close this one	
+	if ( ClientControls.activeQClients >= ClientControls.maxQClients )
+	{
+		log_warning( "At maximum number of connected query clients: connection from %s port %d rejected.", addr, port );
+		close(clientSocket);
+		free(addr);
+		return;
+	}
+
+	// the queries read the rib tables, so they are allowed to the rib clients
+	if ( checkACL((struct sockaddr *) &clientaddr, CLIENT_RIB_ACL) == FALSE )
+	{
+		log_msg("query client connection from %s port %d rejected by access control list",addr, port);
+		close(clientSocket);
+		free(addr);
+		return;
+	}
+
+	sock = malloc(sizeof(int));
+	if( sock == NULL )
+	{
+		log_warning( "Failed to allocate memory. Closing connection from %s port %d.", addr, port );
+		close(clientSocket);
+		free(addr);
+		return;
+	}
+	*sock = clientSocket;
+
+	if ( pthread_mutex_lock( &(ClientControls.clientQLock) ) )
+		log_fatal( "lock client query count failed" );
+	ClientControls.activeQClients++;
+	if ( pthread_mutex_unlock( &(ClientControls.clientQLock) ) )
+		log_fatal( "unlock client query count failed" );
+
+	// the thread cleans up after itself, nobody joins it
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if ((error = pthread_create( &clientQThreadID, &attr, &clientQThread, sock)) > 0) 
+	{
+		log_warning("Failed to create query client thread: %s", strerror(error));
+		close(clientSocket);
+		free(sock);
+		if ( pthread_mutex_lock( &(ClientControls.clientQLock) ) )
+			log_fatal( "lock client query count failed" );
+		ClientControls.activeQClients--;
+		if ( pthread_mutex_unlock( &(ClientControls.clientQLock) ) )
+			log_fatal( "unlock client query count failed" );
+	}
+	pthread_attr_destroy(&attr);
+
+#ifdef DEBUG
+	debug(__FUNCTION__, "query client accepted from: %s, port: %d ", addr, port);
+#endif
+	free(addr);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Answer one query line of a client
+ * Input:  socket - the client socket
+ *         line - the query line
+ * Output: 0 for success or -1 if the answer could not be sent
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+answerPrefixQuery( int socket, char *line )
+{
+	struct XFBWriterStruct writer;
+	struct {
+		Prefix	prefix;
+		u_char	addr[PREFIX_MAX_BYTES];
+	} key;
+	QueryAnswer *answers = NULL;
+	PrefixRoute *routes;
+	char prefixstr[INET6_ADDRSTRLEN+5];
+	char *name, *prefix, *save, *buf, *peer;
+	Session_structp session;
+	int type, i, j, count, sessions = 0, total = 0, len, result;
+
+	name = strtok_r(line, " \t", &save);
+	prefix = strtok_r(NULL, " \t", &save);
+	if( name == NULL )
+		return 0;
+
+	len = QUERY_RESULT_HEADER_LEN;
+	type = getPrefixQueryType(name);
+	if( type < 0 || prefix == NULL || parsePrefix(prefix, &key.prefix) )
+	{
+		// tell the client what was wrong with the query
+		buf = malloc(len);
+		if( buf == NULL )
+			return -1;
+		xfbInitWriter(&writer, buf, len);
+		xfbStartElement(&writer, "QUERY_RESULT");
+		xfbAttrString(&writer, "QUERY", name);
+		xfbAttrString(&writer, "ERROR", type < 0 ? "unknown query type" : "malformed prefix");
+		xfbEndElement(&writer);
+	}
+	else
+	{
+		// collect the routes of all established sessions
+		for( i = 0; i < MAX_SESSION_IDS; i++ )
+		{
+			// the session is not destroyed while it is queried
+			session = lockSession(i);
+			if( session == NULL )
+				continue;
+			if( isSessionEstablished(i) != TRUE )
+			{
+				unlockSession();
+				continue;
+			}
+			count = queryPrefixTable(session, type, &key.prefix, &routes);
+			if( count == 0 )
+			{
+				unlockSession();
+				continue;
+			}
+			answers = realloc(answers, (sessions+1)*sizeof(QueryAnswer));
+			if( answers == NULL )
+				log_fatal( "answerPrefixQuery: realloc failed" );
+			// the address is copied, the session may be gone when the answer is written
+			peer = getSessionRemoteAddr(i);
+			strncpy(answers[sessions].peer, peer != NULL ? peer : "", ADDR_MAX_CHARS-1);
+			answers[sessions].peer[ADDR_MAX_CHARS-1] = '\0';
+			unlockSession();
+			answers[sessions].routes = routes;
+			answers[sessions].count = count;
+			sessions++;
+			for( j = 0; j < count; j++ )
+				len += QUERY_ROUTE_LEN + strlen(routes[j].asPath);
+			total += count;
+		}
+
+		buf = malloc(len);
+		if( buf != NULL )
+		{
+			xfbInitWriter(&writer, buf, len);
+			xfbStartElement(&writer, "QUERY_RESULT");
+			xfbAttrString(&writer, "QUERY", name);
+			xfbAttrString(&writer, "PREFIX", formatPrefix(&key.prefix, prefixstr, sizeof(prefixstr)));
+			xfbAttrInt(&writer, "COUNT", total);
+			for( i = 0; i < sessions; i++ )
+			{
+				routes = answers[i].routes;
+				for( j = 0; j < answers[i].count; j++ )
+				{
+					xfbStartElement(&writer, "ROUTE");
+					xfbAttrString(&writer, "PEER", answers[i].peer);
+					xfbAttrString(&writer, "PREFIX", formatPrefix(&routes[j].keyPrefix, prefixstr, sizeof(prefixstr)));
+					xfbAttrString(&writer, "AS_PATH", routes[j].asPath);
+					xfbAttrUnsignedInt(&writer, "TIMESTAMP", routes[j].originatedTS);
+					xfbEndElement(&writer);
+				}
+			}
+			xfbEndElement(&writer);
+		}
+		for( i = 0; i < sessions; i++ )
+			freePrefixRoutes(answers[i].routes, answers[i].count);
+		free(answers);
+		if( buf == NULL )
+			return -1;
+	}
+
+	len = xfbLength(&writer);
+	if( len < 0 )
+	{
+		log_err("answerPrefixQuery: query result does not fit in %d bytes", (int)(writer.end - writer.buf) + 1);
+		free(buf);
+		return -1;
+	}
+	buf[len++] = '\n';
+	result = writen(socket, buf, len) == len ? 0 : -1;
+	free(buf);
+	return result;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: The main function of a thread answering the queries of one client
+ * Input:  the client socket
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *
+clientQThread( void *arg )
+{
+	int socket = *(int *)arg;
+	char line[CLIENTS_QUERY_MAX_LINE+1];
+	int used = 0, n, start, i;
+	fd_set read_fds;
+	struct timeval timeout;
+
+	free(arg);
+	while( ClientControls.shutdown == FALSE )
+	{
+		// wake up now and then to check for shutdown
+		FD_ZERO(&read_fds);
+		FD_SET(socket, &read_fds);
+		timeout.tv_sec = THREAD_CHECK_INTERVAL;
+		timeout.tv_usec = 0;
+		n = select(socket+1, &read_fds, NULL, NULL, &timeout);
+		if( n < 0 && errno != EINTR )
+			break;
+		if( n <= 0 )
+			continue;
+
+		n = recv(socket, line+used, CLIENTS_QUERY_MAX_LINE-used, 0);
+		if( n <= 0 )
+			break;
+		used += n;
+
+		// answer each complete line
+		start = 0;
+		for( i = 0; i < used; i++ )
+		{
+			if( line[i] != '\n' )
+				continue;
+			line[i] = '\0';
+			if( i > start && line[i-1] == '\r' )
+				line[i-1] = '\0';
+			if( answerPrefixQuery(socket, line+start) )
+				break;
+			start = i+1;
+		}
+		if( i < used && start <= i )
+			break;
+		memmove(line, line+start, used-start);
+		used -= start;
+
+		if( used == CLIENTS_QUERY_MAX_LINE )
+		{
+			log_warning("query client sent a line longer than %d bytes", CLIENTS_QUERY_MAX_LINE);
+			break;
+		}
+	}
+
+	close(socket);
+	if ( pthread_mutex_lock( &(ClientControls.clientQLock) ) )
+		log_fatal( "lock client query count failed" );
+	ClientControls.activeQClients--;
+	if ( pthread_mutex_unlock( &(ClientControls.clientQLock) ) )
+		log_fatal( "unlock client query count failed" );
+	return NULL;
+}
@@ -0,0 +1,58 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ * 
+ *  File: clientquery.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef CLIENTQUERY_H_
+#define CLIENTQUERY_H_
+
+/* A prefix query client sends one query per line:
+ *   <exact|longest-match|covering|more-specifics> <prefix>
+ * and gets back the matching routes of all established sessions:
+ *   <QUERY_RESULT QUERY=".." PREFIX=".." COUNT=".."><ROUTE PEER=".." PREFIX=".." AS_PATH=".." TIMESTAMP=".."/>...</QUERY_RESULT>
+ */
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Accept a new prefix query client and spawn a thread for it
+ *          if more clients are allowed and it passes the ACL check.
+ * Input:  the socket used for listening
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void startQueryClient( int listenSocket );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: The main function of a thread answering the queries of one client
+ * Input:  the client socket
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *clientQThread( void *arg );
+
+#endif /*CLIENTQUERY_H_*/
@@ -37,6 +37,7 @@
 /* RIB and UPDATA constants */
 #define CLIENT_LISTENER_UPDATA 1
 #define CLIENT_LISTENER_RIB 2
+#define CLIENT_LISTENER_QUERY 3
 
 // functions related to accepting and managing client connections
 // see clientscontrol.c for corresponding functions
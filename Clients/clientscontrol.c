@@ -33,12 +33,19 @@
  * Control and manage the BGPmon clients
  */
 
+/* needed for HAVE_SYS_EPOLL_H */
+#include "../config.h"
+
 /* externally visible structures and functions for clients */
 #include "clients.h"
 /* internal structures and functions for this module */
 #include "clientscontrol.h"
 /* internal structures and functions for launching clients */
 #include "clientinstance.h"
+/* internal functions for prefix query clients */
+#include "clientquery.h"
+/* the event engine writing to the clients */
+#include "clientengine.h"
 
 /* required for logging functions */
 #include "../Util/log.h"
@@ -77,6 +84,9 @@
 /* needed for checkACL */
 #include "../Peering/peers.h"
 
+/* needed for requestFullRibTransfers */
+#include "../PeriodicEvents/periodic.h"
+
 //#define DEBUG
 
 /*--------------------------------------------------------------------------------------
@@ -148,6 +158,35 @@ initClientsControlSettings()
 		else
 			ClientControls.maxRClients = MAX_CLIENT_IDS;
 
+	// QUERY SETTINGS
+		// address used to listen for prefix query client connections
+		result = checkAddress(CLIENTS_QUERY_LISTEN_ADDR, ADDR_PASSIVE);
+		if(result != ADDR_VALID)
+		{
+			err = 1;
+			strncpy(ClientControls.listenQAddr, IPv4_LOOPBACK, ADDR_MAX_CHARS);
+		}
+		else
+			strncpy(ClientControls.listenQAddr, CLIENTS_QUERY_LISTEN_ADDR, ADDR_MAX_CHARS);
+
+		// port used to listen for prefix query client connections
+		if ( (CLIENTS_QUERY_LISTEN_PORT < 1) || (CLIENTS_QUERY_LISTEN_PORT > 65536) ) {
+			err = 1;
+			log_warning("Invalid site default for client query listen port.");
+			ClientControls.listenQPort = 50004;
+		}
+		else
+			ClientControls.listenQPort = CLIENTS_QUERY_LISTEN_PORT;
+
+		// Maximum number of prefix query clients allowed
+		if (MAX_CLIENT_IDS < 0)  {
+			err = 1;
+			log_warning("Invalid site default for max allowed clients.");
+			ClientControls.maxQClients = 1;
+		}
+		else
+			ClientControls.maxQClients = MAX_CLIENT_IDS;
+
 	// client connections enabled
 	if ( (CLIENTS_LISTEN_ENABLED != TRUE) && (CLIENTS_LISTEN_ENABLED != FALSE) ) {
                 err = 1;
@@ -157,6 +196,31 @@ initClientsControlSettings()
         else
 		ClientControls.enabled= CLIENTS_LISTEN_ENABLED;
 
+	// client output engine
+	if ( (CLIENTS_OUTPUT_ENGINE != CLIENT_ENGINE_THREADS) && (CLIENTS_OUTPUT_ENGINE != CLIENT_ENGINE_EVENTS) ) {
+		err = 1;
+		log_warning("Invalid site default for client output engine.");
+		ClientControls.outputEngine = CLIENT_ENGINE_THREADS;
+	}
+	else
+		ClientControls.outputEngine = CLIENTS_OUTPUT_ENGINE;
+
+	// number of output loop threads
+	if ( (CLIENTS_OUTPUT_THREADS < 1) || (CLIENTS_OUTPUT_THREADS > CLIENT_MAX_OUTPUT_THREADS) ) {
+		err = 1;
+		log_warning("Invalid site default for client output threads.");
+		ClientControls.outputThreads = 1;
+	}
+	else
+		ClientControls.outputThreads = CLIENTS_OUTPUT_THREADS;
+
+#ifndef HAVE_SYS_EPOLL_H
+	if ( ClientControls.outputEngine == CLIENT_ENGINE_EVENTS ) {
+		log_warning("Event client engine is not supported on this system, using one thread per client.");
+		ClientControls.outputEngine = CLIENT_ENGINE_THREADS;
+	}
+#endif
+
 	// initial bookkeeping figures
 	ClientControls.activeUClients = 0;
 	ClientControls.nextUClientID = 1;
@@ -164,6 +228,8 @@ initClientsControlSettings()
 	ClientControls.activeRClients = 0;
 	ClientControls.nextRClientID = 1;
 	ClientControls.rebindRFlag = FALSE;	
+	ClientControls.activeQClients = 0;
+	ClientControls.rebindQFlag = FALSE;
 	
 	ClientControls.shutdown = FALSE;
 	ClientControls.lastAction = time(NULL);
@@ -179,6 +245,8 @@ initClientsControlSettings()
                 log_fatal( "unable to init mutex lock for clients updates");
         if (pthread_mutex_init( &(ClientControls.clientRLock), NULL ) )
                 log_fatal( "unable to init mutex lock for clients rib");
+        if (pthread_mutex_init( &(ClientControls.clientQLock), NULL ) )
+                log_fatal( "unable to init mutex lock for clients query");
 
 	return err;
 }
@@ -313,6 +381,65 @@ readClientsControlSettings()
 		debug(__FUNCTION__, "Maximum RIB clients allowed is %d", ClientControls.maxRClients);
 #endif
 
+	// QUERY LISTENER
+		// get listen addr
+		result = getConfigValueAsAddr(&addr, XML_CLIENTS_CTR_QUERY_LISTEN_ADDR_PATH, ADDR_PASSIVE);
+		if (result == CONFIG_VALID_ENTRY) 
+		{
+			result = checkAddress(addr, ADDR_PASSIVE);
+			if(result != ADDR_VALID)
+			{
+				err = 1;
+				log_warning("Invalid configuration of client query listener address.");
+			}
+			else 
+			{
+				strncpy(ClientControls.listenQAddr,addr,ADDR_MAX_CHARS-1);
+				ClientControls.listenQAddr[ADDR_MAX_CHARS-1] = '\0';
+				free(addr);
+			}
+		}
+		else if ( result == CONFIG_INVALID_ENTRY ) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of client query listener address.");
+		}
+		else
+			log_msg("No configuration of client query listener address, using default.");
+#ifdef DEBUG
+		debug(__FUNCTION__, "Client Query Listener Addr: %s", ClientControls.listenQAddr);
+#endif
+
+		// get listen port
+		result = getConfigValueAsInt(&num, XML_CLIENTS_CTR_QUERY_LISTEN_PORT_PATH,1,65536);
+		if (result == CONFIG_VALID_ENTRY) 
+			ClientControls.listenQPort = num;
+		else if( result == CONFIG_INVALID_ENTRY ) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of client query listener port.");
+		}
+		else
+			log_msg("No configuration of client query listener port, using default.");
+#ifdef DEBUG
+		debug(__FUNCTION__, "Clients Query Listener Port: %d", ClientControls.listenQPort);
+#endif
+
+		// get the max number of clients
+		result = getConfigValueAsInt(&num, XML_CLIENTS_CTR_QUERY_MAX_CLIENTS_PATH, 0, 65536);
+		if (result == CONFIG_VALID_ENTRY) 
+			ClientControls.maxQClients = num;
+		else if ( result == CONFIG_INVALID_ENTRY ) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of max query clients.");
+		}
+		else
+			log_msg("No configuration of max query clients, using default.");
+#ifdef DEBUG
+		debug(__FUNCTION__, "Maximum query clients allowed is %d", ClientControls.maxQClients);
+#endif
+
 	// get enabled status of clients control module
 	result = getConfigValueAsInt(&num, XML_CLIENTS_CTR_ENABLED_PATH, 0, 1);
 	if (result == CONFIG_VALID_ENTRY) 
@@ -344,6 +471,37 @@ debug(__FUNCTION__,"Result of fetching BGPmon ID: %i. BGPmonID: %u",result,(u_in
 		}
 	}
 
+	// get the client output engine
+	result = getConfigValueAsInt(&num, XML_CLIENTS_CTR_OUTPUT_ENGINE_PATH, CLIENT_ENGINE_THREADS, CLIENT_ENGINE_EVENTS);
+	if (result == CONFIG_VALID_ENTRY) 
+		ClientControls.outputEngine = num;
+	else if ( result == CONFIG_INVALID_ENTRY ) 
+	{
+		err = 1;
+		log_warning("Invalid configuration of client output engine.");
+	}
+	else
+		log_msg("No configuration of client output engine, using default.");
+
+	// get the number of output loop threads
+	result = getConfigValueAsInt(&num, XML_CLIENTS_CTR_OUTPUT_THREADS_PATH, 1, CLIENT_MAX_OUTPUT_THREADS);
+	if (result == CONFIG_VALID_ENTRY) 
+		ClientControls.outputThreads = num;
+	else if ( result == CONFIG_INVALID_ENTRY ) 
+	{
+		err = 1;
+		log_warning("Invalid configuration of client output threads.");
+	}
+	else
+		log_msg("No configuration of client output threads, using default.");
+
+#ifndef HAVE_SYS_EPOLL_H
+	if ( ClientControls.outputEngine == CLIENT_ENGINE_EVENTS ) {
+		log_warning("Event client engine is not supported on this system, using one thread per client.");
+		ClientControls.outputEngine = CLIENT_ENGINE_THREADS;
+	}
+#endif
+
 #ifdef DEBUG
 	if (num == TRUE) 
 		debug(__FUNCTION__, "Clients listen enabled");
@@ -415,6 +573,28 @@ saveClientsControlSettings()
 			err = 1;
 			log_warning("Failed to save max rib clients to config file.");
 		}
+
+	// QUERY LISTENER
+		// save query listener addr
+		if ( setConfigValueAsString(XML_CLIENTS_CTR_QUERY_LISTEN_ADDR, ClientControls.listenQAddr) ) 
+		{
+			err = 1;
+			log_warning("Failed to save client query listener address to config file.");
+		}
+
+		// save query listener port
+		if ( setConfigValueAsInt(XML_CLIENTS_CTR_QUERY_LISTEN_PORT, ClientControls.listenQPort) ) 
+		{
+			err = 1;
+			log_warning("Failed to save client query listener port to config file.");
+		}
+
+		// save the max number of query clients
+		if (setConfigValueAsInt(XML_CLIENTS_CTR_QUERY_MAX_CLIENTS, ClientControls.maxQClients) ) 
+		{
+			err = 1;
+			log_warning("Failed to save max query clients to config file.");
+		}
 	
 	// save the status of clients control module
 	if (setConfigValueAsInt(XML_CLIENTS_CTR_ENABLED, ClientControls.enabled) ) 
@@ -428,6 +608,18 @@ saveClientsControlSettings()
 		err = 1;
 		log_warning("Failed to save BGPmon ID to config file.");
 	}
+	// save the client output engine
+	if (setConfigValueAsInt(XML_CLIENTS_CTR_OUTPUT_ENGINE, ClientControls.outputEngine) ) 
+	{
+		err = 1;
+		log_warning("Failed to save client output engine to config file.");
+	}
+	// save the number of output loop threads
+	if (setConfigValueAsInt(XML_CLIENTS_CTR_OUTPUT_THREADS, ClientControls.outputThreads) ) 
+	{
+		err = 1;
+		log_warning("Failed to save client output threads to config file.");
+	}
 
 	// save client tag
 	if ( closeConfigElement() )
@@ -524,6 +716,10 @@ getClientsControlListenPort(int client_listener)
 	{
 		return ClientControls.listenRPort;
 	}	
+	if (client_listener == CLIENT_LISTENER_QUERY)
+	{
+		return ClientControls.listenQPort;
+	}	
 	return err;
 }
 
@@ -553,6 +749,14 @@ setClientsControlListenPort( int port, int client_listener)
 			ClientControls.listenRPort = port;
 		}
 	}	
+	if (client_listener == CLIENT_LISTENER_QUERY)
+	{
+		if( ClientControls.listenQPort != port && port > 0)
+		{
+			ClientControls.rebindQFlag = TRUE;
+			ClientControls.listenQPort = port;
+		}
+	}	
 }
 
 /*--------------------------------------------------------------------------------------
@@ -596,6 +800,19 @@ getClientsControlListenAddr(int client_listener)
 	memcpy(Rans, ClientControls.listenRAddr, sizeof(ClientControls.listenRAddr));
         return Rans;
 	}	
+	if (client_listener == CLIENT_LISTENER_QUERY)
+	{
+		// allocate memory for the result
+		char *Qans = malloc(sizeof(ClientControls.listenQAddr));
+		if (Qans == NULL)
+		{
+			log_err("getClientsControlListenAddr: couldn't allocate string memory");
+			return NULL;
+		}
+		// copy the string and return result
+		memcpy(Qans, ClientControls.listenQAddr, sizeof(ClientControls.listenQAddr));
+		return Qans;
+	}	
 	return NULL;
 }
 
@@ -641,6 +858,22 @@ setClientsControlListenAddr( char *addr, int client_listener )
 		}
 		return result;
 	}	
+
+	if (client_listener == CLIENT_LISTENER_QUERY)
+	{
+		
+		int result = checkAddress(addr, ADDR_PASSIVE);
+		if(result == ADDR_VALID)
+		{
+			if( strcmp(ClientControls.listenQAddr, addr) != 0 )
+			{
+				ClientControls.rebindQFlag = TRUE;
+				strncpy(ClientControls.listenQAddr, addr, ADDR_MAX_CHARS-1);
+				ClientControls.listenQAddr[ADDR_MAX_CHARS-1] = '\0';
+			}
+		}
+		return result;
+	}	
 	return err;
 }
 
@@ -671,6 +904,7 @@ clientsControlThread( void *arg )
 	int fdmax = 0;		// maximum file descriptor number
 	int listenUSocket = -1;	// socket to listen for UPDATA connections
 	int listenRSocket = -1;  // socket to listen for RIB connections
+	int listenQSocket = -1;  // socket to listen for prefix query connections
 
 	// timer to periodically check thread status
 	struct timeval timeout; 
@@ -710,6 +944,17 @@ clientsControlThread( void *arg )
 				fdmax = 0;
 				listenRSocket = -1;			
 			}			
+			// close the query listening socket if active			
+			if( listenQSocket >= 0 )
+			{
+#ifdef DEBUG
+				debug( __FUNCTION__, "Close the query listening socket(%d)!! ", listenQSocket );
+#endif
+				close( listenQSocket );
+				FD_ZERO( &read_fds );
+				fdmax = 0;
+				listenQSocket = -1;			
+			}			
 			
 #ifdef DEBUG
 			debug( __FUNCTION__, "clients control thread is disabled");
@@ -743,6 +988,18 @@ clientsControlThread( void *arg )
 #endif
 			}
 			
+			if( (listenQSocket != -1) && (ClientControls.rebindQFlag == TRUE) )
+			{
+				close( listenQSocket );
+				FD_ZERO( &read_fds );
+				fdmax = 0;
+				listenQSocket = -1;			
+				ClientControls.rebindQFlag = FALSE;
+#ifdef DEBUG
+				debug( __FUNCTION__, "Close the query listening socket(%d)!! ", listenQSocket );
+#endif
+			}
+			
 			// if socket is down, reopen
 			if (listenUSocket == - 1) 
 			{
@@ -788,6 +1045,21 @@ clientsControlThread( void *arg )
 				fdmax = listenRSocket+1;
 			}			
 			
+			if (listenQSocket == - 1) 
+			{
+				listenQSocket = startListener(ClientControls.listenQAddr, ClientControls.listenQPort);
+#ifdef DEBUG
+				if (listenQSocket != - 1) 
+					debug( __FUNCTION__, "Opened the query listening socket(%d)!! ", listenQSocket );
+#endif
+			}
+			if (listenQSocket != - 1) 
+			{
+				FD_SET(listenQSocket, &read_fds);
+				if( listenQSocket+1 > fdmax )
+					fdmax = listenQSocket+1;
+			}
+			
 #ifdef DEBUG
 			debug( __FUNCTION__, "clients control thread is enabled" );
 #endif
@@ -824,6 +1096,17 @@ clientsControlThread( void *arg )
 			}
 		}		
 		
+		if( listenQSocket >= 0)
+		{
+			if( FD_ISSET(listenQSocket, &read_fds) )//new prefix query client
+			{
+#ifdef DEBUG
+				debug( __FUNCTION__, "new query client attempting to start." );
+#endif
+				startQueryClient( listenQSocket );
+			}
+		}		
+		
 	}
 	
 	log_warning( "Clients control thread exiting" );	 
@@ -852,6 +1135,18 @@ clientsControlThread( void *arg )
 #endif
 	}	
 
+	// close query socket if open
+	if( listenQSocket != -1) 
+	{
+		close(listenQSocket);
+		FD_ZERO( &read_fds );
+		fdmax = 0;
+		listenQSocket = -1;			
+#ifdef DEBUG
+		debug( __FUNCTION__, "Close the query listening socket(%d)!! ", listenQSocket );
+#endif
+	}	
+
 	return NULL;
 }
 
@@ -1030,14 +1325,26 @@ startClient( int listenSocket, int client_listener)
 		if ( pthread_mutex_unlock( &(ClientControls.clientULock ) ) )
 			log_fatal( "unlock client update list failed");
 	
-		// spawn a new thread for this client
-		pthread_t clientUThreadID;
-		int error;
-		Ucn->clientThread = clientUThreadID;
-		if ((error = pthread_create( &clientUThreadID, NULL, &clientUThread, Ucn)) > 0) 
+		// hand the client to an output loop of the event engine
+		if ( ClientControls.outputEngine == CLIENT_ENGINE_EVENTS )
 		{
-			log_warning("Failed to create UPDATA client thread: %s", strerror(error));
-			destroyClient(Ucn->id, CLIENT_LISTENER_UPDATA);
+			if ( addClientToEngine( Ucn, CLIENT_LISTENER_UPDATA ) )
+			{
+				log_warning("Failed to hand UPDATA client to the output engine");
+				destroyClient(Ucn->id, CLIENT_LISTENER_UPDATA);
+			}
+		}
+		else
+		{
+			// spawn a new thread for this client
+			pthread_t clientUThreadID;
+			int error;
+			Ucn->clientThread = clientUThreadID;
+			if ((error = pthread_create( &clientUThreadID, NULL, &clientUThread, Ucn)) > 0) 
+			{
+				log_warning("Failed to create UPDATA client thread: %s", strerror(error));
+				destroyClient(Ucn->id, CLIENT_LISTENER_UPDATA);
+			}
 		}
 	}
 	
@@ -1068,15 +1375,30 @@ startClient( int listenSocket, int client_listener)
 		// unlock the client list
 		if ( pthread_mutex_unlock( &(ClientControls.clientRLock ) ) )
 			log_fatal( "unlock client rib list failed");
+
+		// the client holds no table yet, the next transfers send the full ones
+		requestFullRibTransfers();
 	
-		// spawn a new thread for this client
-		pthread_t clientRThreadID;
-		Rcn->clientThread = clientRThreadID;
-		int error;
-		if ((error = pthread_create( &clientRThreadID, NULL, &clientRThread, Rcn)) > 0) 
+		// hand the client to an output loop of the event engine
+		if ( ClientControls.outputEngine == CLIENT_ENGINE_EVENTS )
 		{
-			log_warning("Failed to create RIB client thread: %s", strerror(error));
-			destroyClient(Rcn->id, CLIENT_LISTENER_RIB);
+			if ( addClientToEngine( Rcn, CLIENT_LISTENER_RIB ) )
+			{
+				log_warning("Failed to hand RIB client to the output engine");
+				destroyClient(Rcn->id, CLIENT_LISTENER_RIB);
+			}
+		}
+		else
+		{
+			// spawn a new thread for this client
+			pthread_t clientRThreadID;
+			Rcn->clientThread = clientRThreadID;
+			int error;
+			if ((error = pthread_create( &clientRThreadID, NULL, &clientRThread, Rcn)) > 0) 
+			{
+				log_warning("Failed to create RIB client thread: %s", strerror(error));
+				destroyClient(Rcn->id, CLIENT_LISTENER_RIB);
+			}
 		}
 	}	
 	
@@ -1188,6 +1510,13 @@ void waitForClientsShutdown() {
 	// wait for client listener control thread to exit
 	pthread_join(ClientControls.clientsListenerThread, status);
 
+	// the output loops close their clients themselves
+	if ( ClientControls.outputEngine == CLIENT_ENGINE_EVENTS )
+	{
+		waitForClientEngineShutdown();
+		return;
+	}
+
 	// wait for each update client connection thread to exit
 	ClientNode * cn = ClientControls.firstUNode;
 	while(cn!=NULL) {
@@ -68,12 +68,22 @@ struct ClientControls_struct_st
 	ClientNode *firstRNode; 	// first node in list of active clients
 	pthread_mutex_t clientRLock; 	// lock client changes 
 
+/* for prefix queries */
+	char listenQAddr[ADDR_MAX_CHARS];
+	int listenQPort;
+	int maxQClients; 		// the max number of clients
+	int activeQClients; 		// the number of active clients
+	int rebindQFlag; 		// indicates whether to reopen socket
+	pthread_mutex_t clientQLock; 	// lock client count changes 
+
 /* for both UPDATA and RIB */
 	int enabled; 			// TRUE: enabled or FALSE: disabled
 	int shutdown; 			// indicates whether to stop the thread
 	time_t lastAction; 		// last time the thread was active
 	u_int32_t seq_num;		// sequence number to detect message looping
 	u_int32_t bgpmon_id;	// id number to detect message looping
+	int outputEngine;		// CLIENT_ENGINE_THREADS or CLIENT_ENGINE_EVENTS
+	int outputThreads;		// number of output loop threads of the event engine
 	pthread_t clientsListenerThread;
 };
 typedef struct ClientControls_struct_st ClientsControls_struct;
@@ -69,6 +69,20 @@
 #define XML_QUEUE_MIN_WRITES_LIMIT "QUEUE_MIN_WRITES"
 #define XML_QUEUE_PACING_INTERVAL "QUEUE_PACING_INTERVAL"
 #define XML_QUEUE_LOG_INTERVAL "QUEUE_LOG_INTERVAL"
+#define XML_QUEUE_ENGINE "QUEUE_ENGINE"
+
+// XML conversion Tags
+#define XML_CONVERTER_TAG "XML"
+#define XML_CONVERTER_WORKERS "XML_WORKERS"
+
+// Labeling module Tags
+#define XML_LABELING_TAG "LABELING"
+#define XML_LABELING_WORKERS "LABEL_WORKERS"
+
+// Peering engine Tags
+#define XML_PEERING_TAG "PEERING"
+#define XML_PEERING_ENGINE "PEERING_ENGINE"
+#define XML_PEERING_THREADS "PEERING_THREADS"
 
 // Clients Control Tags
 #define XML_CLIENTS_CTR_TAG "CLIENTS"
@@ -78,8 +92,13 @@
 #define XML_CLIENTS_CTR_UPDATES_LISTEN_ADDR "UPDATES_LISTEN_ADDR"
 #define XML_CLIENTS_CTR_UPDATES_LISTEN_PORT "UPDATES_LISTEN_PORT"
 #define XML_CLIENTS_CTR_UPDATES_MAX_CLIENTS "UPDATES_MAX_CLIENTS"
+#define XML_CLIENTS_CTR_QUERY_LISTEN_ADDR "QUERY_LISTEN_ADDR"
+#define XML_CLIENTS_CTR_QUERY_LISTEN_PORT "QUERY_LISTEN_PORT"
+#define XML_CLIENTS_CTR_QUERY_MAX_CLIENTS "QUERY_MAX_CLIENTS"
 #define XML_CLIENTS_CTR_ENABLED "ENABLED"
 #define XML_CLIENTS_CTR_BGPMON_ID "BGPMON_ID"
+#define XML_CLIENTS_CTR_OUTPUT_ENGINE "OUTPUT_ENGINE"
+#define XML_CLIENTS_CTR_OUTPUT_THREADS "OUTPUT_THREADS"
 
 // Mrts Control Tags
 #define XML_MRTS_CTR_TAG "MRTS"
@@ -142,6 +161,9 @@
 #define XML_STATUS_MSG_INTERVAL "PEER_STATUS_INTERVAL"
 #define XML_ROUTE_REFRESH_INTERVAL "RIB_REFRESH_INTERVAL"
 #define XML_SEND_ROUTE_REFRESH "SEND_ROUTE_REFRESH"
+#define XML_RIB_TRANSFER_WORKERS "RIB_TRANSFER_WORKERS"
+#define XML_RIB_TRANSFER_RATE "RIB_TRANSFER_RATE"
+#define XML_RIB_DELTA_TRANSFERS "RIB_DELTA_TRANSFERS"
 
 
 // XML Paths to various tags
@@ -166,6 +188,20 @@
 #define XML_QUEUE_MIN_WRITES_LIMIT_PATH XML_QUEUE_PATH "/" XML_QUEUE_MIN_WRITES_LIMIT
 #define XML_QUEUE_PACING_INTERVAL_PATH XML_QUEUE_PATH "/" XML_QUEUE_PACING_INTERVAL
 #define XML_QUEUE_LOG_INTERVAL_PATH XML_QUEUE_PATH "/" XML_QUEUE_LOG_INTERVAL
+#define XML_QUEUE_ENGINE_PATH XML_QUEUE_PATH "/" XML_QUEUE_ENGINE
+
+// XML conversion related XML Paths
+#define XML_CONVERTER_PATH XML_ROOT_PATH "/" XML_CONVERTER_TAG
+#define XML_CONVERTER_WORKERS_PATH XML_CONVERTER_PATH "/" XML_CONVERTER_WORKERS
+
+// Labeling module related XML Paths
+#define XML_LABELING_PATH XML_ROOT_PATH "/" XML_LABELING_TAG
+#define XML_LABELING_WORKERS_PATH XML_LABELING_PATH "/" XML_LABELING_WORKERS
+
+// Peering engine related XML Paths
+#define XML_PEERING_PATH XML_ROOT_PATH "/" XML_PEERING_TAG
+#define XML_PEERING_ENGINE_PATH XML_PEERING_PATH "/" XML_PEERING_ENGINE
+#define XML_PEERING_THREADS_PATH XML_PEERING_PATH "/" XML_PEERING_THREADS
 
 // Clients Control related XML Paths
 #define XML_CLIENTS_CTR_PATH XML_ROOT_PATH "/" XML_CLIENTS_CTR_TAG
@@ -175,8 +211,13 @@
 #define XML_CLIENTS_CTR_RIB_LISTEN_ADDR_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_RIB_LISTEN_ADDR
 #define XML_CLIENTS_CTR_RIB_LISTEN_PORT_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_RIB_LISTEN_PORT
 #define XML_CLIENTS_CTR_RIB_MAX_CLIENTS_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_RIB_MAX_CLIENTS
+#define XML_CLIENTS_CTR_QUERY_LISTEN_ADDR_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_QUERY_LISTEN_ADDR
+#define XML_CLIENTS_CTR_QUERY_LISTEN_PORT_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_QUERY_LISTEN_PORT
+#define XML_CLIENTS_CTR_QUERY_MAX_CLIENTS_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_QUERY_MAX_CLIENTS
 #define XML_CLIENTS_CTR_ENABLED_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_ENABLED
 #define XML_CLIENTS_CTR_BGPMON_ID_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_BGPMON_ID
+#define XML_CLIENTS_CTR_OUTPUT_ENGINE_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_OUTPUT_ENGINE
+#define XML_CLIENTS_CTR_OUTPUT_THREADS_PATH XML_CLIENTS_CTR_PATH "/" XML_CLIENTS_CTR_OUTPUT_THREADS
 
 // Mrts Control related XML Paths
 #define XML_MRTS_CTR_PATH XML_ROOT_PATH "/" XML_MRTS_CTR_TAG
@@ -200,5 +241,8 @@
 #define XML_PERIODIC_STATUS_INTERVAL_PATH XML_PERIODIC_PATH "/" XML_STATUS_MSG_INTERVAL
 #define XML_PERIODIC_RR_INTERVAL_PATH XML_PERIODIC_PATH "/" XML_ROUTE_REFRESH_INTERVAL
 #define XML_PERIODIC_SEND_ROUTE_REFRESH_PATH XML_PERIODIC_PATH "/" XML_SEND_ROUTE_REFRESH 
+#define XML_PERIODIC_RIB_TRANSFER_WORKERS_PATH XML_PERIODIC_PATH "/" XML_RIB_TRANSFER_WORKERS
+#define XML_PERIODIC_RIB_TRANSFER_RATE_PATH XML_PERIODIC_PATH "/" XML_RIB_TRANSFER_RATE
+#define XML_PERIODIC_RIB_DELTA_TRANSFERS_PATH XML_PERIODIC_PATH "/" XML_RIB_DELTA_TRANSFERS
 
 #endif	// CONFIGDEFAULTS_H_
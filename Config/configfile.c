@@ -45,6 +45,9 @@
 #include "XMLUtils.h"
 #include "../Login/login.h"
 #include "../Queues/queue.h"
+#include "../XML/xml.h"
+#include "../Labeling/label.h"
+#include "../Peering/peerengine.h"
 #include "../Util/bgpmon_defaults.h"
 #include "../Util/log.h"
 #include "../Peering/peers.h"
@@ -143,6 +146,27 @@ int readConfigFile (char *configfile)
 		return 1;
 	}
 
+	// parse the XML conversion information
+	if (readXMLSettings()) {
+		xmlFreeDoc(xmlConfigFilePtr);
+		log_err("Invalid XML configuration in file %s.", configfile);
+		return 1;
+	}
+
+	// parse the labeling information
+	if (readLabelingSettings()) {
+		xmlFreeDoc(xmlConfigFilePtr);
+		log_err("Invalid labeling configuration in file %s.", configfile);
+		return 1;
+	}
+
+	// parse the peering engine information
+	if (readPeeringSettings()) {
+		xmlFreeDoc(xmlConfigFilePtr);
+		log_err("Invalid peering configuration in file %s.", configfile);
+		return 1;
+	}
+
 	// parse the Periodic information
 	if (readPeriodicSettings()) {
 		xmlFreeDoc(xmlConfigFilePtr);
@@ -298,6 +322,24 @@ int saveConfigFile(char * configFile) {
 		log_warning("Unable to save Queue settings in file %s.", configFile);
 	}
 
+	// save the XML settings
+	if(saveXMLSettings()) {
+		err = 1;
+		log_warning("Unable to save XML settings in file %s.", configFile);
+	}
+
+	// save the Labeling settings
+	if(saveLabelingSettings()) {
+		err = 1;
+		log_warning("Unable to save Labeling settings in file %s.", configFile);
+	}
+
+	// save the Peering settings
+	if(savePeeringSettings()) {
+		err = 1;
+		log_warning("Unable to save Peering settings in file %s.", configFile);
+	}
+
 	// save the Chain settings
 	if(saveChainsSettings()) {
 		err = 1;
@@ -43,6 +43,9 @@
 #include "label.h"
 #include "labelinternal.h"
 #include "rtable.h"
+#include "ribarena.h"
+#include "ribepoch.h"
+#include "ribsnapshot.h"
 
 // needed to parse/save XML
 #include "../Config/configdefaults.h"
@@ -65,16 +68,75 @@
 
 //#define DEBUG
 
+/* states of a job in the reorder ring */
+#define LABEL_JOB_PENDING	0	/* waiting for its worker or being processed */
+#define LABEL_JOB_PROCESSED	1	/* processed, waiting to be written in order */
+
+/* a message read from the peer queue on its way to the labeled queue */
+struct LabelJobStruct
+{
+	// the message, NULL once processed if it is not written to the labeled queue
+	BMF		bmf;
+	int		state;
+};
+
+/* a labeling worker, sessions are assigned to workers by session ID */
+struct LabelWorkerStruct
+{
+	pthread_t	thread;
+	// ring positions of the jobs of the worker's sessions, in peer queue order
+	u_int64_t	*jobs;
+	u_int64_t	head;
+	u_int64_t	tail;
+	// a job was added, or done was set
+	pthread_cond_t	jobAdded;
+};
+typedef struct LabelWorkerStruct *LabelWorker;
+
+/*----------------------------------------------------------------------------------------
+ * Jobs are kept in peer queue order in a ring: the labeling thread adds them at head
+ * and hands them to the worker of their session, workers process their own jobs in
+ * order, and the output thread writes them from tail once processed.  The counters
+ * only grow, a job's slot is its counter modulo LABEL_REORDER_WINDOW.
+ * -------------------------------------------------------------------------------------*/
+static struct
+{
+	struct LabelJobStruct	jobs[LABEL_REORDER_WINDOW];
+	u_int64_t		head;
+	u_int64_t		tail;
+	// set once the labeling thread stops adding jobs
+	int			done;
+	LabelWorker		workers;
+	pthread_mutex_t		lock;
+	// the job at tail was processed, or done was set
+	pthread_cond_t		jobProcessed;
+	// the job at tail was written
+	pthread_cond_t		jobWritten;
+} LabelReorder;
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Initialize the default Labeling configuration.
  * Input: none
  * Output: returns 0 on success, 1 on failure
  * He Yan @ July 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 int initLabelingSettings()
 {
+	int err = 0;
+
 	LabelControls.shutdown = FALSE;
-	return 0;
+
+	// number of labeling threads
+	if ( (LABEL_WORKERS < 1) || (LABEL_WORKERS > LABEL_MAX_WORKERS) ) {
+		err = 1;
+		log_warning("Invalid site default for labeling workers.");
+		LabelControls.workers = 1;
+	}
+	else
+		LabelControls.workers = LABEL_WORKERS;
+
+	return err;
 }
 
 /*--------------------------------------------------------------------------------------
@@ -82,10 +144,32 @@ int initLabelingSettings()
  * Input: none
  * Output: returns 0 on success, 1 on failure
  * He Yan @ July 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 int readLabelingSettings()
 {	
-	return 0;
+	int err = 0;
+	int result;
+	int num;
+
+	// get number of workers
+	result = getConfigValueAsInt(&num, XML_LABELING_WORKERS_PATH, 1, LABEL_MAX_WORKERS);
+	if (result == CONFIG_VALID_ENTRY) 
+		LabelControls.workers = num;
+	else{
+		if (result == CONFIG_INVALID_ENTRY) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of labeling workers.");
+		}
+		else 
+			log_msg("No configuration of labeling workers, using default.");
+	}
+#ifdef DEBUG
+	debug( __FUNCTION__, "labeling workers %d.", LabelControls.workers);
+#endif
+
+	return err;
 }
 
 
@@ -94,30 +178,80 @@ int readLabelingSettings()
  * Input:  none
  * Output: returns 0 on success, 1 on failure
  * He Yan @ July 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 int saveLabelingSettings()
 {	
-	return 0;
+	int err = 0;
+
+	// save labeling tag
+	if ( openConfigElement(XML_LABELING_TAG) ) {
+		err = 1;
+		log_warning("Failed to save labeling to config file.");
+	}
+
+	// save number of workers
+	if ( setConfigValueAsInt(XML_LABELING_WORKERS, LabelControls.workers) ) {
+		err = 1;
+		log_warning("Failed to save labeling workers to config file.");
+	}
+
+	// save labeling tag
+	if ( closeConfigElement(XML_LABELING_TAG) ) {
+		err = 1;
+		log_warning("Failed to save labeling to config file.");
+	}
+
+	return err;
 }
 
 /*--------------------------------------------------------------------------------------
- * Purpose: launch labeling thread, called by main.c
+ * Purpose: launch labeling threads, called by main.c
  * Input:  none
  * Output: none
  * He Yan @ July 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 void launchLabelingThread()
 {
 	int error;
+	int i;
 	
 	pthread_t labelingThreadID;
 
+	LabelReorder.head = LabelReorder.tail = 0;
+	LabelReorder.done = FALSE;
+	if ((error = pthread_mutex_init(&LabelReorder.lock, NULL)) > 0 )
+		log_fatal("Failed to init labeling reorder lock: %s\n", strerror(error));
+	if ((error = pthread_cond_init(&LabelReorder.jobProcessed, NULL)) > 0 ||
+	    (error = pthread_cond_init(&LabelReorder.jobWritten, NULL)) > 0 )
+		log_fatal("Failed to init labeling reorder condition: %s\n", strerror(error));
+
+	if ((error = pthread_create(&LabelControls.outputThread, NULL, labelingOutputThread, NULL)) > 0 )
+		log_fatal("Failed to create labeling output thread: %s\n", strerror(error));
+
+	LabelReorder.workers = malloc(LabelControls.workers * sizeof(struct LabelWorkerStruct));
+	if (LabelReorder.workers == NULL)
+		log_fatal("launchLabelingThread: malloc failed");
+	for (i = 0; i < LabelControls.workers; i++)
+	{
+		LabelWorker worker = &LabelReorder.workers[i];
+		worker->jobs = malloc(LABEL_REORDER_WINDOW * sizeof(u_int64_t));
+		if (worker->jobs == NULL)
+			log_fatal("launchLabelingThread: malloc failed");
+		worker->head = worker->tail = 0;
+		if ((error = pthread_cond_init(&worker->jobAdded, NULL)) > 0 )
+			log_fatal("Failed to init labeling worker condition: %s\n", strerror(error));
+		if ((error = pthread_create(&worker->thread, NULL, labelingWorkerThread, worker)) > 0 )
+			log_fatal("Failed to create labeling worker thread: %s\n", strerror(error));
+	}
+
 	if ((error = pthread_create(&labelingThreadID, NULL, labelingThread, NULL)) > 0 )
 		log_fatal("Failed to create labeling thread: %s\n", strerror(error));
 
 	LabelControls.labelThread = labelingThreadID;
 
-	debug(__FUNCTION__, "Created labeling thread!");
+	debug(__FUNCTION__, "Created labeling thread and %d workers!", LabelControls.workers);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -128,78 +262,91 @@ void launchLabelingThread()
  * -------------------------------------------------------------------------------------*/
 int cleanRibTable(int sessionID)
 {
+	// the rib dumps reach the prefix nodes through the attribute table, empty it first
+	if( destroyAttrTable(Sessions[sessionID]->attributeTable, Sessions[sessionID]) ) 
+	{
+		log_err ("Failed to clean the attr table for session %d!", sessionID);
+		return -1;
+	}	
+
 	if( destroyPrefixTable(Sessions[sessionID]->prefixTable, Sessions[sessionID]) ) 
 	{
 		log_err ("Failed to clean the prefix table for session %d!", sessionID);
 		return -1;
 	}
 
-	if( destroyAttrTable(Sessions[sessionID]->attributeTable, Sessions[sessionID]) ) 
-	{
-		log_err ("Failed to clean the attr table for session %d!", sessionID);
-		return -1;
-	}	
+	// no prefix node points at the attribute nodes any more
+	resetRibArena(&(Sessions[sessionID]->attributeTable->arena), Sessions[sessionID]);
 	return 0;
 }
 
 /*--------------------------------------------------------------------------------------
- * Purpose:delete the entrie Rib table of a session
- * Input:  sessionID - ID of the session needs to delete Rib
+ * Purpose: Free the rib tables of a session
+ * Input:  sessionID - ID of the session
  * Output: 0 means success, -1 means failure.
- * He Yan @ July 22, 2008
+ * Note: Called with the rib lock of the session write locked.
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-int deleteRibTable(int sessionID)
+static int freeRibTables(int sessionID)
 {
-	int i;
-	int error;
+	if( Sessions[sessionID]->prefixTable == NULL || Sessions[sessionID]->attributeTable == NULL )
+		return -1;
+
+	// the rib dumps reach the prefix nodes through the attribute table, empty it first
+	if (destroyAttrTable(Sessions[sessionID]->attributeTable, Sessions[sessionID])) 
+	{
+		log_err("Failed to destroy the attribute table for session %d!", sessionID);
+		return -1;
+	}
+
 	// delete the prefix hash table
-	if( Sessions[sessionID]->prefixTable !=NULL )
+	if( destroyPrefixTable(Sessions[sessionID]->prefixTable, Sessions[sessionID]) ) 
 	{
-		if( destroyPrefixTable(Sessions[sessionID]->prefixTable, Sessions[sessionID]) ) 
-		{
-			log_err("Failed to destroy the prefix table for session %d!", sessionID);
-			return -1;
-		}    
-		free(Sessions[sessionID]->prefixTable->prefixEntries);
-		free(Sessions[sessionID]->prefixTable);
-		Sessions[sessionID]->prefixTable = NULL;
+		log_err("Failed to destroy the prefix table for session %d!", sessionID);
+		return -1;
+	}    
+	free(Sessions[sessionID]->prefixTable->slots);
+	pthread_rwlock_destroy(&(Sessions[sessionID]->prefixTable->lock));
+	free(Sessions[sessionID]->prefixTable);
+	Sessions[sessionID]->prefixTable = NULL;
 #ifdef DEBUG
-		debug (__FUNCTION__,  "Successfully destroy the prefix table for session %d!", sessionID);
+	debug (__FUNCTION__,  "Successfully destroy the prefix table for session %d!", sessionID);
 #endif 
-	}
-	else
-		return -1;
 
 	// delete the attribute hash table
-	if( Sessions[sessionID]->attributeTable !=NULL )
-	{
-
-		if (destroyAttrTable(Sessions[sessionID]->attributeTable, Sessions[sessionID])) 
-		{
-			log_err("Failed to destroy the attribute table for session %d!", sessionID);
-			return -1;
-		}
-		for (i=0; i<Sessions[sessionID]->attributeTable->tableSize; i++) 
-		{
-			if ((error = pthread_rwlock_destroy(&(Sessions[sessionID]->attributeTable->attrEntries[i].lock))) > 0)  
-			{
-				log_err("Failed to destroy rwlock: %s\n", strerror(error));  
-				return -1;
-			}
-		}  		
-		free(Sessions[sessionID]->attributeTable->attrEntries);
-		free(Sessions[sessionID]->attributeTable);
-		Sessions[sessionID]->attributeTable = NULL;
+	resetRibArena(&(Sessions[sessionID]->attributeTable->arena), Sessions[sessionID]);
+	free(Sessions[sessionID]->attributeTable->attrEntries);
+	pthread_mutex_destroy(&(Sessions[sessionID]->attributeTable->walkLock));
+	free(Sessions[sessionID]->attributeTable);
+	Sessions[sessionID]->attributeTable = NULL;
 #ifdef DEBUG
-		debug (__FUNCTION__,  "Successfully destroy the attribute table for session %d!", sessionID);
+	debug (__FUNCTION__,  "Successfully destroy the attribute table for session %d!", sessionID);
 #endif
-	}
-	else
-		return -1;
 	
 	return 0;
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose:delete the entrie Rib table of a session
+ * Input:  sessionID - ID of the session needs to delete Rib
+ * Output: 0 means success, -1 means failure.
+ * He Yan @ July 22, 2008
+ * -------------------------------------------------------------------------------------*/
+int deleteRibTable(int sessionID)
+{
+	int result;
+
+	// the rib dumps stop at their next bucket and release the read lock
+	if( Sessions[sessionID]->attributeTable != NULL )
+		closeAttrTableWalks(Sessions[sessionID]->attributeTable);
+	// the rib queries and dumps of other threads hold the read lock while they use the tables
+	if( pthread_rwlock_wrlock(&(Sessions[sessionID]->ribLock)) )
+		log_fatal( "Failed to wrlock the rib tables of session %d", sessionID );
+	result = freeRibTables(sessionID);
+	pthread_rwlock_unlock(&(Sessions[sessionID]->ribLock));
+	return result;
+}
+
 /*----------------------------------------------------------------------------------------
  * Purpose: Process one BMF message 
  * Input: BMF message
@@ -217,6 +364,7 @@ int processBMF (BMF bmf)
 	u_int16_t		bgpType = 0;
 	u_int32_t		bgpMsgLen = 0;
 	ParsedBGPUpdate	parsedUpdateMsg;
+	int				result;
 	
 	//  labeling only applies to messages from the peer 
 	if ((type != BMF_TYPE_MSG_FROM_PEER) && (type != BMF_TYPE_TABLE_TRANSFER)) 
@@ -295,19 +443,18 @@ int processBMF (BMF bmf)
 	{
 		// Convert BMF message from type BMF_TYPE_MSG_FROM_PEER to type BMF_TYPE_MSG_LABELED
 		bmf->type = BMF_TYPE_MSG_LABELED;
-		if( applyBGPUpdate(time, &parsedUpdateMsg, Sessions[bmf->sessionID], bmf) )
-		{
-			log_err( "processBMF, Failed to apply BGP update message to rib table!");
-			return -1;
-		}
+		result = applyBGPUpdate(time, &parsedUpdateMsg, Sessions[bmf->sessionID], bmf);
 	}
 	else
 	{
-		if( applyBGPUpdate(time, &parsedUpdateMsg, Sessions[bmf->sessionID], NULL) )
-		{
-			log_err( "processBMF, Failed to apply BGP update message to rib table!");
-			return -1;
-		}		
+		result = applyBGPUpdate(time, &parsedUpdateMsg, Sessions[bmf->sessionID], NULL);
+	}
+	// the prefixes applied so far make the next version of the rib, even if the update failed half way
+	commitRibVersion(Sessions[bmf->sessionID]);
+	if( result )
+	{
+		log_err( "processBMF, Failed to apply BGP update message to rib table!");
+		return -1;
 	}
 
 	
@@ -322,83 +469,392 @@ int processBMF (BMF bmf)
 
 
 /*----------------------------------------------------------------------------------------
- * Purpose: Entry function of rib/label thread
+ * Purpose: Apply one message read from the peer queue to the rib table of its session
+ * Input:   bmf - the message
+ * Output:  the message to write to the labeled queue, NULL if it was freed
+ * He Yan @ Jun 22, 2008
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static BMF
+labelBMF( BMF bmf )
+{
+	incrementSessionMsgCount(bmf->sessionID);
+	
+	int action  = getSessionLabelAction(bmf->sessionID);
+	if( action >= 0)
+	{
+		if( action == Label || action == StoreRibOnly )	
+		{	
+			if(processBMF( bmf )){
+				destroyBMF(bmf);
+				return NULL;
+			}
+		}
+	}
+
+
+	// delete the rib table of closed session
+	if( bmf->type == BMF_TYPE_FSM_STATE_CHANGE )
+	{
+		if( checkStateChangeMessage(bmf) )
+		{				
+			if( deleteRibTable(bmf->sessionID) )
+				log_msg( "no rib table for session %d", bmf->sessionID);
+			else
+				log_msg( "Successfully destroy the rib table for session %d!", bmf->sessionID);
+		}
+
+	}		
+
+	if( bmf->type == BMF_TYPE_TABLE_TRANSFER )
+	{
+		destroyBMF(bmf);
+		return NULL;
+	}
+	return bmf;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Entry function of rib/label thread, hands the messages of the peer queue
+ *          to the workers of their sessions in order
  * Input:
  * Output:
  * He Yan @ Jun 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 void *
 labelingThread( void *arg ) 
 {
+	int i;
+
 	log_msg( "Labeling Thread Started" );
 	QueueReader peerQueueReader =  createQueueReader( peerQueue );
-	QueueWriter labeledQueueWriter = createQueueWriter( labeledQueue );
 
 	while( LabelControls.shutdown == FALSE )
 	{
                 // update the last active time for this thread
 		LabelControls.lastAction = time(NULL);
 		
-		BMF bmf = NULL;	
+		BMF bmfs[QUEUE_READ_BATCH];
 		#ifdef DEBUG
 		debug (__FUNCTION__, "Labeling thread waiting to read from peer queue");
 		#endif
-		readQueue( peerQueueReader, (void **)&bmf );
+		long n = readQueueBatch( peerQueueReader, (void **)bmfs, QUEUE_READ_BATCH );
 		#ifdef DEBUG
-		debug (__FUNCTION__, "Labeling thread read from queue, processing BMF");
+		debug (__FUNCTION__, "Labeling thread read %ld messages from queue", n);
 		#endif
-		incrementSessionMsgCount(bmf->sessionID);
-		
-		int action  = getSessionLabelAction(bmf->sessionID);
-		if( action >= 0)
+
+		pthread_mutex_lock( &LabelReorder.lock );
+
+		for( i = 0; i < n; i++ )
 		{
-			if( action == Label || action == StoreRibOnly )	
-			{	
-				if(processBMF( bmf )){
-                                  free(bmf);
-                                  continue;
-                                }
-			}
+			BMF bmf = bmfs[i];
+
+			// wait for a free slot
+			while( LabelReorder.head - LabelReorder.tail >= LABEL_REORDER_WINDOW )
+				pthread_cond_wait( &LabelReorder.jobWritten, &LabelReorder.lock );
+
+			struct LabelJobStruct *job = &LabelReorder.jobs[LabelReorder.head % LABEL_REORDER_WINDOW];
+			job->bmf = bmf;
+			job->state = LABEL_JOB_PENDING;
+
+			// the messages of a session are always processed by the same worker
+			LabelWorker worker = &LabelReorder.workers[bmf->sessionID % LabelControls.workers];
+			worker->jobs[worker->head % LABEL_REORDER_WINDOW] = LabelReorder.head;
+			worker->head++;
+			LabelReorder.head++;
+			pthread_cond_signal( &worker->jobAdded );
 		}
 
+		pthread_mutex_unlock( &LabelReorder.lock );
+	}
+
+	// let the workers and the output thread finish the remaining jobs
+	pthread_mutex_lock( &LabelReorder.lock );
+	LabelReorder.done = TRUE;
+	for( i = 0; i < LabelControls.workers; i++ )
+		pthread_cond_signal( &LabelReorder.workers[i].jobAdded );
+	pthread_cond_signal( &LabelReorder.jobProcessed );
+	pthread_mutex_unlock( &LabelReorder.lock );
+
+	destroyQueueReader(peerQueueReader);
+	log_warning( "Labeling thread exiting" );
+
+	return NULL;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Entry function of the labeling worker threads, applies the messages of
+ *          the worker's sessions to their rib tables
+ * Input:   arg - the worker's LabelWorker structure
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *
+labelingWorkerThread( void *arg )
+{
+	LabelWorker worker = (LabelWorker)arg;
+
+	pthread_mutex_lock( &LabelReorder.lock );
+	while( TRUE )
+	{
+		while( worker->tail == worker->head && LabelReorder.done == FALSE )
+			pthread_cond_wait( &worker->jobAdded, &LabelReorder.lock );
+		if( worker->tail == worker->head )
+			break;
+
+		u_int64_t n = worker->jobs[worker->tail % LABEL_REORDER_WINDOW];
+		worker->tail++;
+		struct LabelJobStruct *job = &LabelReorder.jobs[n % LABEL_REORDER_WINDOW];
+		pthread_mutex_unlock( &LabelReorder.lock );
+
+		BMF bmf = labelBMF( job->bmf );
+
+		pthread_mutex_lock( &LabelReorder.lock );
+		job->bmf = bmf;
+		job->state = LABEL_JOB_PROCESSED;
+		if( n == LabelReorder.tail )
+			pthread_cond_signal( &LabelReorder.jobProcessed );
+	}
+	pthread_mutex_unlock( &LabelReorder.lock );
+
+	return NULL;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Entry function of the labeling output thread, writes the processed
+ *          messages to the labeled queue in peer queue order
+ * Input:   arg - not used
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *
+labelingOutputThread( void *arg )
+{
+	QueueWriter labeledQueueWriter = createQueueWriter( labeledQueue );
 
-		// delete the rib table of closed session
-		if( bmf->type == BMF_TYPE_FSM_STATE_CHANGE )
+	pthread_mutex_lock( &LabelReorder.lock );
+	while( TRUE )
+	{
+		while( (LabelReorder.tail == LabelReorder.head && LabelReorder.done == FALSE) ||
+		       (LabelReorder.tail != LabelReorder.head &&
+		        LabelReorder.jobs[LabelReorder.tail % LABEL_REORDER_WINDOW].state != LABEL_JOB_PROCESSED) )
+			pthread_cond_wait( &LabelReorder.jobProcessed, &LabelReorder.lock );
+		if( LabelReorder.tail == LabelReorder.head )
+			break;
+
+		// take the processed messages in order, up to a batch
+		BMF bmfs[QUEUE_WRITE_BATCH];
+		int n = 0, count = 0;
+		while( count < QUEUE_WRITE_BATCH && LabelReorder.tail + count != LabelReorder.head &&
+		       LabelReorder.jobs[(LabelReorder.tail + count) % LABEL_REORDER_WINDOW].state == LABEL_JOB_PROCESSED )
 		{
-			if( checkStateChangeMessage(bmf) )
-			{				
-				if( deleteRibTable(bmf->sessionID) )
-					log_msg( "no rib table for session %d", bmf->sessionID);
-				else
-					log_msg( "Successfully destroy the rib table for session %d!", bmf->sessionID);
-			}
+			BMF bmf = LabelReorder.jobs[(LabelReorder.tail + count) % LABEL_REORDER_WINDOW].bmf;
+			if( bmf != NULL )
+				bmfs[n++] = bmf;
+			count++;
+		}
+		pthread_mutex_unlock( &LabelReorder.lock );
 
-		}		
-		
 		#ifdef DEBUG
-		debug (__FUNCTION__, "Labeling thread processed BMF, writing to labeled queue");
+		debug (__FUNCTION__, "Labeling output thread writing %d messages to labeled queue", n);
 		#endif
+		writeQueueBatch( labeledQueueWriter, (void **)bmfs, n );
+
+		pthread_mutex_lock( &LabelReorder.lock );
+		LabelReorder.tail += count;
+		pthread_cond_signal( &LabelReorder.jobWritten );
+	}
+	pthread_mutex_unlock( &LabelReorder.lock );
+
+	destroyQueueWriter(labeledQueueWriter);
+	log_warning( "Labeling output thread exiting" );
+
+	return NULL;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Get the number of seconds between two times
+ * Input:   from, to - the times, from CLOCK_MONOTONIC
+ * Output:  the seconds, negative if to is before from
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static double
+secondsBetween( const struct timespec *from, const struct timespec *to )
+{
+	return (double)(to->tv_sec - from->tv_sec) + (double)(to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+/*----------------------------------------------------------------------------------------
+ * The rib transfers running at the same time share a budget of 
+ * PeriodicEvents.RibTransferRate messages per second, 0 for no limit.  A transfer
+ * takes the messages it sent from the budget, so the budget can go below zero,
+ * and the transfers wait until it is back to a message.
+ * -------------------------------------------------------------------------------------*/
+static struct
+{
+	pthread_mutex_t		lock;
+	double			tokens;
+	// when tokens were last added, 0 before the first transfer
+	struct timespec		last;
+} RibBudget = { PTHREAD_MUTEX_INITIALIZER, 0, {0, 0} };
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Get how long the rib transfers have to wait for the shared budget
+ * Input:   now - the current time, from CLOCK_MONOTONIC
+ * Output:  the seconds to wait, 0 if a message can be sent now
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static double
+waitRibBudget( const struct timespec *now )
+{
+	double rate = PeriodicEvents.RibTransferRate;
+	double wait = 0;
+
+	if( rate <= 0 )
+		return 0;
+
+	pthread_mutex_lock(&RibBudget.lock);
+	if( RibBudget.last.tv_sec == 0 && RibBudget.last.tv_nsec == 0 )
+		RibBudget.tokens = RIB_TRANSFER_BURST;
+	else
+		RibBudget.tokens += rate * secondsBetween(&RibBudget.last, now);
+	if( RibBudget.tokens > RIB_TRANSFER_BURST )
+		RibBudget.tokens = RIB_TRANSFER_BURST;
+	RibBudget.last = *now;
+	if( RibBudget.tokens < 1 )
+		wait = (1 - RibBudget.tokens) / rate;
+	pthread_mutex_unlock(&RibBudget.lock);
+
+	return wait;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Take the messages a rib transfer sent from the shared budget
+ * Input:   messages - the number of messages sent
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+chargeRibBudget( u_int32_t messages )
+{
+	if( PeriodicEvents.RibTransferRate <= 0 )
+		return;
+
+	pthread_mutex_lock(&RibBudget.lock);
+	RibBudget.tokens -= messages;
+	pthread_mutex_unlock(&RibBudget.lock);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Start pacing a rib transfer
+ * Input:   pacer - the pacer of the transfer
+ *          transfer_time - the seconds the transfer should take
+ *          attrTable - the attribute table sent
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+initRibPacer( RibPacer *pacer, int transfer_time, AttrTable *attrTable )
+{
+	if( transfer_time < 1 )
+		transfer_time = 1;
+	clock_gettime(CLOCK_MONOTONIC, &pacer->last);
+	pacer->due = pacer->last;
+	pacer->due.tv_sec += transfer_time;
+	pacer->deadline = pacer->due;
+	pacer->late = FALSE;
+	pacer->rate = 0;
+	pacer->attrTable = attrTable;
+	// the first message goes out right away
+	pacer->tokens = 1;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Wait until a rib transfer can send its next message. The tokens come in
+ *          at the rate that sends the attributes left by the deadline, at half 
+ *          that rate while the labeled queue fills up, and the shared budget of
+ *          all rib transfers must have a message left too.
+ * Input:   pacer - the pacer of the transfer
+ *          remaining - the number of attributes left to send
+ * Output:  0 when a message can be sent, 1 if the table is about to be deleted
+ *          or -1 if BGPmon is closing
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+waitRibPacer( RibPacer *pacer, double remaining )
+{
+	struct timespec	now, pause;
+	double			left, wait;
+	float			used = 0;
+	int				total;
+
+	for( ;; )
+	{
+		// the session closed, its table is deleted once the transfer stops
+		if( isAttrTableClosing(pacer->attrTable) )
+			return 1;
+
+		clock_gettime(CLOCK_MONOTONIC, &now);
 
-		if( bmf->type != BMF_TYPE_TABLE_TRANSFER )
+		// a transfer past its deadline gets a second to catch up
+		left = secondsBetween(&now, &pacer->deadline);
+		if( left <= 0 )
 		{
-			writeQueue( labeledQueueWriter, bmf);
+			pacer->late = TRUE;
+			pacer->deadline = now;
+			pacer->deadline.tv_sec += 1;
+			left = 1;
 		}
-		else
+		pacer->rate = (remaining > 1 ? remaining : 1) / left;
+
+		// slow down while the labeled queue is filling up, so the transfer doesn't
+		// push it into pacing, the rate makes up for it later
+		total = getItemsTotal(LABEL_QUEUE_NAME);
+		if( total > 0 )
+			used = (float)getItemsUsed(LABEL_QUEUE_NAME) / (float)total;
+		if( pacer->late == FALSE && used >= getPacingOffThresh() )
+			pacer->rate /= 2;
+
+		pacer->tokens += pacer->rate * secondsBetween(&pacer->last, &now);
+		if( pacer->tokens > RIB_TRANSFER_BURST )
+			pacer->tokens = RIB_TRANSFER_BURST;
+		pacer->last = now;
+		if( pacer->tokens >= 1 )
 		{
-			free(bmf);
+			wait = waitRibBudget(&now);
+			if( wait <= 0 )
+				return 0;
 		}
-			
-		#ifdef DEBUG
-		debug (__FUNCTION__, "read from queue");
-		#endif
- 		// end remove for testing only
+		else
+			wait = (1 - pacer->tokens) / pacer->rate;
+		if( wait > RIB_TRANSFER_CHECK_USEC / 1e6 )
+			wait = RIB_TRANSFER_CHECK_USEC / 1e6;
+		pause.tv_sec = (time_t)wait;
+		pause.tv_nsec = (long)((wait - pause.tv_sec) * 1e9);
+		nanosleep(&pause, NULL);
 
+		// after sleep update thread time
+		PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
+		// check if BGPmon is closing
+		if ( PeriodicEvents.shutdown != FALSE )
+			return -1;
 	}
-	destroyQueueReader(peerQueueReader);
-	destroyQueueWriter(labeledQueueWriter);
-	log_warning( "Labeling thread exiting" );
+}
 
-	return NULL;
+/*----------------------------------------------------------------------------------------
+ * Purpose: Get how late a rib transfer is
+ * Input:   pacer - the pacer of the transfer
+ * Output:  the seconds since the transfer was due, negative if it is not due yet
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static double
+ribPacerLateness( RibPacer *pacer )
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return secondsBetween(&pacer->due, &now);
 }
 
 /*----------------------------------------------------------------------------------------
@@ -406,28 +862,23 @@ labelingThread( void *arg )
  * Input:	ID of a session
  * 		Queue rwiter
  * 		time for each session to tranfer data
+ * 		delta - TRUE to send only the changes since the previous transfer of the 
+ * 		session, a full table is sent if there is none
  * Output: 0 means success, -1 means failure
  * He Yan @ Jun 22, 2008
  * Mikhail Strizhov @ July 23, 2010
  * -------------------------------------------------------------------------------------*/
-int sendRibTable(int sessionID, QueueWriter labeledQueueWriter, int transfer_time)
+int sendRibTable(int sessionID, QueueWriter labeledQueueWriter, int transfer_time, int delta)
 {
-	int i,j, error;
+	int i;
 	int xml_message_counter = 0;
 	u_int32_t num_of_sleeps = 0;
-	int indexes_per_second=0, index_counter=0, timethrloop=0;
-	// get time when we enter this function
-	time_t function_start_stamp, current_time_stamp, function_end_stamp, desired_time;
-
-	// for printing time
-	char desired_time_extended[64];
-	memset(desired_time_extended, 0, 64);
-#ifdef DEBUG
-	struct tm * desired_tm = NULL;
-#endif
-
-	// get time
-	function_start_stamp = time(NULL);
+	u_int64_t version = 0;
+	u_int64_t since = 0;
+	u_int32_t version_half;
+	RibDelta ribDelta;
+	QueueBatch batch;
+	int paced;
 
  	Session_structp session;
 	if( sessionID == -1 )
@@ -453,12 +904,49 @@ int sendRibTable(int sessionID, QueueWriter labeledQueueWriter, int transfer_tim
 	else
 		 session = Sessions[sessionID];
 
-	// send TABLE_START message with sessionID
+	// the rib tables are not deleted until the transfer releases the rib lock
+	if( session != NULL && pthread_rwlock_rdlock(&(session->ribLock)) )
+		log_fatal( "Failed to rdlock the rib tables of session %d", sessionID );
+
+	// the table is sent as it is at this version, the updates applied while it is sent are not in it
+	if( session != NULL && session->attributeTable != NULL )
+	{
+		version = openRibSnapshot(session->attributeTable);
+		// a delta starts from the version of the previous transfer
+		if( delta == TRUE )
+			since = getRibDeltaBase(session->attributeTable);
+		if( since == RIB_NO_DELTA_BASE )
+			since = 0;
+		// a full table is sent if the withdrawn prefixes do not fit in memory
+		if( since > 0 && collectRibDelta(session->attributeTable, &ribDelta, since, version) )
+		{
+			log_err ("Failed to collect the withdrawn prefixes of session %d, sending the full table", sessionID);
+			since = 0;
+		}
+	}
+
+	// send TABLE_START message with sessionID and the version of the table
 	BMF bmf_start = createBMF( sessionID, BMF_TYPE_TABLE_START );
+	// only the RIB clients that asked for deltas get the messages of a delta
+	bmf_start->ribSince = since;
+	version_half = htonl((u_int32_t)(version >> 32));
+	bgpmonMessageAppend( bmf_start, &version_half, sizeof(u_int32_t) );
+	version_half = htonl((u_int32_t)version);
+	bgpmonMessageAppend( bmf_start, &version_half, sizeof(u_int32_t) );
+	// and the version a delta starts from
+	if( since > 0 )
+	{
+		version_half = htonl((u_int32_t)(since >> 32));
+		bgpmonMessageAppend( bmf_start, &version_half, sizeof(u_int32_t) );
+		version_half = htonl((u_int32_t)since);
+		bgpmonMessageAppend( bmf_start, &version_half, sizeof(u_int32_t) );
+	}
 	writeQueue( labeledQueueWriter, bmf_start );
 
 	if( session == NULL || session->attributeTable == NULL )
 	{
+		if( session != NULL )
+			pthread_rwlock_unlock(&(session->ribLock));
 		log_err ("Failed to send a rib table of session %d", sessionID);
 		num_of_sleeps = transfer_time / THREAD_CHECK_INTERVAL;
 		for (i=0; i < num_of_sleeps; i++) 
@@ -478,136 +966,138 @@ int sendRibTable(int sessionID, QueueWriter labeledQueueWriter, int transfer_tim
 		return -1;
 	}
 	
-	// calculate how many messages we need to send per second
-	indexes_per_second = session->attributeTable->tableSize / transfer_time;
-	if (indexes_per_second < 1)
-	{
-		indexes_per_second = 1;
-		log_warning("Session %d, Indexes per seconds in table transfer is too low, set it to 1", sessionID);
-	}
+	// the attribute table keeps its buckets until the walk is finished
+	beginAttrTableWalk(session->attributeTable);
+
+	// the messages of the table are written to the labeled queue in batches
+	initQueueBatch(&batch, labeledQueueWriter);
+
+	// pace the messages to spread the transfer over transfer_time
+	RibPacer pacer;
+	initRibPacer(&pacer, transfer_time, session->attributeTable);
 #ifdef DEBUG	  
-	debug(__FUNCTION__, "Session %d, indexes per second is %d, transfer_time is %d", sessionID, indexes_per_second, transfer_time);
+	debug(__FUNCTION__, "Session %d, %u attributes to send, transfer_time is %d", sessionID, session->attributeTable->attrCount, transfer_time);
 #endif 
+	// a delta sends the prefixes withdrawn since the previous transfer first
+	if( since > 0 )
+	{
+		int withdrawn = sendWithdrawnBMF(ribDelta.withdrawn, ribDelta.withdrawnCount, sessionID, since, &batch);
+		if( withdrawn == -1 )
+			log_err ("Failed to send the withdrawn prefixes of Session %d", sessionID);
+		else
+		{
+			xml_message_counter += withdrawn;
+			chargeRibBudget(withdrawn);
+		}
+		freeRibDelta(&ribDelta);
+	}
+
 	// to through table size
 	// remember - tablesize is an index table and has different number of attribute entries inside
 	for (i=0; i<session->attributeTable->tableSize; i++) 
 	{
-		// check i index is eq to send rate
-		if ( index_counter == indexes_per_second)
+		// wait for the bucket to send a message, not in the read section so the labeling worker can free nodes,
+		// the attributes left are estimated from the buckets left since the table may change while it is sent
+		double remaining = (double)__atomic_load_n(&(session->attributeTable->attrCount), __ATOMIC_RELAXED)
+			* (session->attributeTable->tableSize - i) / session->attributeTable->tableSize;
+		// the messages already made are not held back while the pacer waits
+		if( pacer.tokens < 1 )
+			flushQueueBatch(&batch);
+		paced = waitRibPacer(&pacer, remaining);
+		if( paced < 0 )
 		{
-#ifdef DEBUG		
-			debug(__FUNCTION__, "index is %d", i);
-#endif			
-			// update refresh time
-			PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
-			// close BGPmon if shutdown is enabled
-			if ( PeriodicEvents.shutdown != FALSE )
-			{
-				return -1;
-			}
-
-			// reset index to 0
-			index_counter = 0;
-
-			// assume that each send block (messages_per_second ) will take 1 second
-			timethrloop++;
-
-			current_time_stamp = time(NULL);
-			desired_time = function_start_stamp + timethrloop;
-#ifdef DEBUG
-			debug(__FUNCTION__, "Desired time - current time stamp is %f",difftime(desired_time, current_time_stamp));
-#endif 			
-			if ( (int)(difftime(desired_time, current_time_stamp)) > 2)
-			{
-#ifdef DEBUG			
-				debug(__FUNCTION__, "going to sleep for %f seconds", difftime(desired_time, current_time_stamp));
-#endif				
-				int difference = (int)(difftime(desired_time, current_time_stamp));
-				num_of_sleeps = difference / THREAD_CHECK_INTERVAL;
-				for (j=0; j < num_of_sleeps; j++) 
-				{
-					sleep(THREAD_CHECK_INTERVAL);
-					// after sleep update thread time
-					PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
-					// check if BGPmon is closing
-					if ( PeriodicEvents.shutdown != FALSE )
-					{
-						return -1;
-					}
-				}
-				sleep(difference % THREAD_CHECK_INTERVAL);
-				// after sleep update thread time
-				PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
-			}
-			else 
-			if ( (int)(difftime(desired_time,current_time_stamp)) < 2)
-			{
-#ifdef DEBUG
-				desired_tm = localtime(&desired_time);
-				strftime(desired_time_extended, sizeof(desired_time_extended), "%Y-%m-%dT%H:%M:%SZ", desired_tm);
-				log_warning("Session %d, Table transfer took %d seconds to proceed %d/%d indexes, desired time is %s", sessionID, (int)(difftime(desired_time,current_time_stamp)), i, session->attributeTable->tableSize, desired_time_extended );
-#endif
-			}	
-		} // end of if check
+			flushQueueBatch(&batch);
+			endAttrTableWalk(session->attributeTable);
+			closeRibSnapshot(session->attributeTable);
+			pthread_rwlock_unlock(&(session->ribLock));
+			return -1;
+		}
 
-		//check to see if session has been shut down by another thread
-		if(!Sessions[sessionID]){
+		//check to see if session has been shut down by another thread, it waits for the rib lock to delete the table
+		if( paced > 0 || isAttrTableClosing(session->attributeTable) ){
 			log_msg("Session %d closed while sending its RIB!",sessionID);
+			flushQueueBatch(&batch);
+			endAttrTableWalk(session->attributeTable);
+			closeRibSnapshot(session->attributeTable);
+			pthread_rwlock_unlock(&(session->ribLock));
 			// send TABLE_STOP message with sessionID
 			BMF bmf_stop = createBMF( sessionID, BMF_TYPE_TABLE_STOP);
+			bmf_stop->ribSince = since;
 			u_int32_t super_counter = htonl(xml_message_counter);
 			bgpmonMessageAppend( bmf_stop, &super_counter, sizeof(u_int32_t) );   // include number of xml messages in bmf_stop
+			version_half = htonl((u_int32_t)(version >> 32));
+			bgpmonMessageAppend( bmf_stop, &version_half, sizeof(u_int32_t) );   // and the version of the table
+			version_half = htonl((u_int32_t)version);
+			bgpmonMessageAppend( bmf_stop, &version_half, sizeof(u_int32_t) );
 			writeQueue( labeledQueueWriter, bmf_stop);
 			return 0;	//if the session gets torn down somewhere along the line, break out of the loop because there will be no more stuff coming			
 		}
 	
-		if ((error = pthread_rwlock_rdlock (&(session->attributeTable->attrEntries[i].lock))) > 0) 
-		{
-			log_err ("Failed to rdlock an entry in the rib table: %s", strerror(error));
-		 	continue;
-		}
+		// the labeling worker keeps the nodes of the bucket until the read section ends
+		u_int32_t epoch = enterRibEpoch(&(session->attributeTable->epoch));
+		u_int32_t walked = 0;
+		u_int32_t sent = 0;
 		AttrNode *node;
-		node = session->attributeTable->attrEntries[i].node;
+		node = __atomic_load_n(&(session->attributeTable->attrEntries[i].node), __ATOMIC_ACQUIRE);
 		while (node != NULL)
 		{
-			// send messages
-			if  (sendBMFFromAttrNode(node, session->sessionID, labeledQueueWriter) == -1)
+			// the attributes of prefixes removed before the snapshot, or added after it or before since, are skipped
+			if( isAttrInRibDelta(node, since, version) )
 			{
-				log_err ("Failed to send BMF message for Session %d, Attribute index is %d", session->sessionID, i);
+				// send messages
+				if  (sendBMFFromAttrNode(node, session->sessionID, since, version, &batch) == -1)
+				{
+					log_err ("Failed to send BMF message for Session %d, Attribute index is %d", session->sessionID, i);
+				}
+				// increment number of sent XML messages
+				xml_message_counter++;
+				sent++;
 			}
-			// increment number of sent XML messages
-			xml_message_counter++;
-			node = node->next;
+			walked++;
+			node = __atomic_load_n(&(node->next), __ATOMIC_ACQUIRE);
 		}	
-		pthread_rwlock_unlock(&(session->attributeTable->attrEntries[i].lock));
-		
-		// count how many indexes were send
-		index_counter++;
+		exitRibEpoch(&(session->attributeTable->epoch), epoch);
+		// every attribute takes a token, so the walk ends on time
+		pacer.tokens -= walked;
+		// while the shared budget only pays for the messages sent
+		chargeRibBudget(sent);
 				
 	} // end of tablesize for-loop
+	flushQueueBatch(&batch);
+
+	// the next delta starts from this transfer
+	setRibDeltaBase(session->attributeTable, PeriodicEvents.RibDeltaTransfers > 0 ? version : RIB_NO_DELTA_BASE);
+	endAttrTableWalk(session->attributeTable);
+	closeRibSnapshot(session->attributeTable);
+	pthread_rwlock_unlock(&(session->ribLock));
 
 	// send TABLE_STOP message with sessionID
 	BMF bmf_stop = createBMF( sessionID, BMF_TYPE_TABLE_STOP);
+	bmf_stop->ribSince = since;
 	u_int32_t super_counter = htonl(xml_message_counter);
 	bgpmonMessageAppend( bmf_stop, &super_counter, sizeof(u_int32_t) );   // include number of xml messages in bmf_stop
+	version_half = htonl((u_int32_t)(version >> 32));
+	bgpmonMessageAppend( bmf_stop, &version_half, sizeof(u_int32_t) );   // and the version of the table
+	version_half = htonl((u_int32_t)version);
+	bgpmonMessageAppend( bmf_stop, &version_half, sizeof(u_int32_t) );
 	writeQueue( labeledQueueWriter, bmf_stop);
 	
-	// check time difference with transfer time
-	function_end_stamp = time(NULL);
+	// check time difference with transfer time, the last tokens come in just before the deadline
+	double late = ribPacerLateness(&pacer);
 #ifdef DEBUG	
-	debug(__FUNCTION__, "Diff btw finish and start functions is %d, transfer_time is %d", function_end_stamp - function_start_stamp, transfer_time);
+	debug(__FUNCTION__, "Session %d, table transfer finished %f seconds after its deadline", sessionID, late);
 #endif	
-	if ( (function_end_stamp - function_start_stamp) > transfer_time)
+	if ( late > RIB_TRANSFER_TOLERANCE )
 	{
 		log_warning("Session %d, Table transfer: Sending messages too slow!", sessionID);
 	}
 	else
-	if ( (function_end_stamp - function_start_stamp) < transfer_time)
+	if ( late < -RIB_TRANSFER_TOLERANCE )
 	{
 		log_warning("Session %d, Table transfer: Sending messages too fast!", sessionID);
 	}
 
-	log_msg( "Successfully sent RIB table of session %d ! ", session->sessionID);
+	log_msg( "Successfully sent RIB table of session %d ! ", sessionID);
 	return 0;
 }
 
@@ -642,8 +1132,19 @@ void signalLabelShutdown()
 void waitForLabelShutdown() 
 {
 	void * status = NULL;
+	int i;
 
 	// wait for label control thread exit
 	pthread_join(LabelControls.labelThread, status);
+
+	// the workers and the output thread exit once the remaining jobs are written
+	for (i = 0; i < LabelControls.workers; i++)
+	{
+		pthread_join(LabelReorder.workers[i].thread, status);
+		free(LabelReorder.workers[i].jobs);
+	}
+	pthread_join(LabelControls.outputThread, status);
+	free(LabelReorder.workers);
+	LabelReorder.workers = NULL;
 }
 
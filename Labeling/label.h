@@ -47,6 +47,10 @@ struct LabelControls_struct_st {
 	time_t		lastAction;
 	pthread_t 	labelThread;
 	int		shutdown;
+	// number of threads applying updates to the rib tables
+	int		workers;
+	// thread writing the labeled messages in order
+	pthread_t	outputThread;
 };
 typedef struct LabelControls_struct_st LabelControls_struct;
 
@@ -114,11 +118,13 @@ int deleteRibTable(int sessionID);
  * Input:	ID of a session
  * 		Queue rwiter
  * 		time for each session to tranfer data
+ * 		delta - TRUE to send only the changes since the previous transfer of the 
+ * 		session, a full table is sent if there is none
  * Output: 0 means success, -1 means failure
  * He Yan @ Jun 22, 2008
  * Mikhail Strizhov @ July 23, 2010
  * -------------------------------------------------------------------------------------*/
-int sendRibTable(int sessionID, QueueWriter labeledQueueWriter, int transfer_time);
+int sendRibTable(int sessionID, QueueWriter labeledQueueWriter, int transfer_time, int delta);
 
 /*--------------------------------------------------------------------------------------
  * Purpose: get the last action time of the lable thread
@@ -30,6 +30,7 @@
 
 #ifndef LABELINTERNAL_H_
 #define LABELINTERNAL_H_
+#include <time.h>
 #include "rtable.h"
 /* needed for copying BGPmon Internal Format messages */
 #include "../Util/bgpmon_formats.h"
@@ -38,6 +39,21 @@
 /* needed for MAX_PEER_IDS  */
 #include "../site_defaults.h"
 
+/* constants */
+#define LABEL_MAX_WORKERS     64        /* max number of labeling threads */
+#define LABEL_REORDER_WINDOW  1024      /* max number of messages between the peer queue and the labeled queue */
+
+/* token bucket pacing the messages of a rib transfer */
+typedef struct RibPacerStruct {
+	double			tokens;		/* messages that can be sent now */
+	double			rate;		/* tokens added per second */
+	struct timespec	last;		/* when tokens were last added */
+	struct timespec	due;		/* when the transfer should be finished */
+	struct timespec	deadline;	/* when the tokens should run out, moves on while the transfer is late */
+	int				late;		/* TRUE once the transfer is past due */
+	AttrTable		*attrTable;	/* the table sent, the transfer stops when it is deleted */
+} RibPacer;
+
 /*----------------------------------------------------------------------------------------
  * Purpose: Process one BMF message 
  * Input: BMF message
@@ -67,6 +83,24 @@ int applyBGPUpdate (time_t originatedTS, ParsedBGPUpdate *parsedUpdateMsg, Sessi
  * -------------------------------------------------------------------------------------*/
 void * labelingThread( void *arg ) ;
 
+/*----------------------------------------------------------------------------------------
+ * Purpose: Entry function of the labeling worker threads, applies the messages of
+ *          the worker's sessions to their rib tables
+ * Input:   arg - the worker's LabelWorker structure
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void * labelingWorkerThread( void *arg );
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Entry function of the labeling output thread, writes the processed
+ *          messages to the labeled queue in peer queue order
+ * Input:   arg - not used
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void * labelingOutputThread( void *arg );
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Destory a prefix table
  * Input:	 prefixTable - the pointer to a prefix table
@@ -87,6 +121,27 @@ int destroyPrefixTable ( PrefixTable *prefixTable, Session_structp session );
 int destroyAttrTable ( AttrTable *attrTable, Session_structp session );
 
 
+/*----------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix from the prefix reference list of a attribure node
+ * Input:	 prefixNode - the pointer to the prefix node to be deleted
+ *		 attrNode - the pointer to the associated attribute node of the prefix node to be deleted
+ *		 session - the corresponding session structure
+ * Output:  0 for success or -1 for failure
+ * He Yan @ July 4th, 2008
+ * -------------------------------------------------------------------------------------*/
+int removePefixFomAttr( PrefixNode *prefixNode, AttrNode *attrNode, Session_structp session );
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Remove the given attr node from attr table and free that attr node's space
+ * Input:	 removedNode - the pointer to the attribute node to be deleted
+ *		 session - the corresponding session structure
+ * Output:  0 for success or -1 for failure
+ * NOTE: The ref count of the attr to be removed should be 0.
+ * He Yan @ July 4th, 2008
+ * -------------------------------------------------------------------------------------*/
+int removeAttrNode( AttrNode *removedNode, Session_structp session );
+
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Print a attribute table
  * Input:	 session - the corresponding session structure which includes the attribute table
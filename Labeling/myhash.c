@@ -30,6 +30,7 @@
 
 #include <sys/types.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "myhash.h"
 #include "../Util/log.h"
@@ -60,6 +61,25 @@ INDEX prefix_hash ( const u_char *key, u_int16_t len, u_int32_t table_size )
 
 */
 
+   INDEX hash_val = prefix_hash_value(key, len);
+
+#ifdef DEBUG
+   debug(__FUNCTION__, "The computed attr hash value is %ld.", hash_val % table_size);
+#endif
+
+   return hash_val % table_size;
+
+
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Hash function, used to compute the full hash value of a prefix
+ * Input:   The pointer and len of the prefix
+ * Return:  The 32 bits hash value, tables of 2^n slots use the low n bits
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+INDEX prefix_hash_value ( const u_char *key, u_int16_t len )
+{
    u_int16_t i;
    INDEX hash_val = 0;
      
@@ -72,13 +92,7 @@ INDEX prefix_hash ( const u_char *key, u_int16_t len, u_int32_t table_size )
    hash_val ^= (hash_val >> 11);
    hash_val += (hash_val << 15);
 
-#ifdef DEBUG
-   debug(__FUNCTION__, "The computed attr hash value is %ld.", hash_val % table_size);
-#endif
-
-   return hash_val % table_size;
-
-
+   return hash_val;
 }
 
 
@@ -109,3 +123,87 @@ INDEX attr_hash ( const u_char *key, u_int16_t len, u_int32_t table_size )
 
    return hash_val % table_size;
 }
+
+/* primes of the 64 bits fingerprint */
+#define FP_PRIME1 11400714785074694791ULL
+#define FP_PRIME2 14029467366897019727ULL
+#define FP_PRIME3 1609587929392839161ULL
+#define FP_PRIME4 9650029242287828579ULL
+#define FP_PRIME5 2870177450012600261ULL
+
+#define FP_ROTL(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline u_int64_t fp_read64 ( const u_char *p ) { u_int64_t v; memcpy(&v, p, 8); return v; }
+static inline u_int32_t fp_read32 ( const u_char *p ) { u_int32_t v; memcpy(&v, p, 4); return v; }
+
+static inline u_int64_t fp_round ( u_int64_t acc, u_int64_t input )
+{
+   acc += input * FP_PRIME2;
+   acc = FP_ROTL(acc, 31);
+   return acc * FP_PRIME1;
+}
+
+static inline u_int64_t fp_merge ( u_int64_t acc, u_int64_t val )
+{
+   acc ^= fp_round(0, val);
+   return acc * FP_PRIME1 + FP_PRIME4;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Hash function, used to compute the fingerprint of an AS path or attributes,
+ *          it is the XXH64 hash which reads 8 bytes at a time
+ * Input:   The pointer and len of the data
+ * Return:  The 64 bits fingerprint, tables of 2^n buckets use the low n bits
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+u_int64_t attr_fingerprint ( const u_char *key, u_int32_t len )
+{
+   const u_char *p = key;
+   const u_char *end = key + len;
+   u_int64_t h, v1, v2, v3, v4;
+
+   if (len >= 32) {
+      v1 = FP_PRIME1 + FP_PRIME2;
+      v2 = FP_PRIME2;
+      v3 = 0;
+      v4 = -FP_PRIME1;
+      do {
+         v1 = fp_round(v1, fp_read64(p));
+         v2 = fp_round(v2, fp_read64(p+8));
+         v3 = fp_round(v3, fp_read64(p+16));
+         v4 = fp_round(v4, fp_read64(p+24));
+         p += 32;
+      } while (p + 32 <= end);
+      h = FP_ROTL(v1, 1) + FP_ROTL(v2, 7) + FP_ROTL(v3, 12) + FP_ROTL(v4, 18);
+      h = fp_merge(h, v1);
+      h = fp_merge(h, v2);
+      h = fp_merge(h, v3);
+      h = fp_merge(h, v4);
+   }
+   else
+      h = FP_PRIME5;
+   h += len;
+
+   while (p + 8 <= end) {
+      h ^= fp_round(0, fp_read64(p));
+      h = FP_ROTL(h, 27) * FP_PRIME1 + FP_PRIME4;
+      p += 8;
+   }
+   if (p + 4 <= end) {
+      h ^= (u_int64_t)fp_read32(p) * FP_PRIME1;
+      h = FP_ROTL(h, 23) * FP_PRIME2 + FP_PRIME3;
+      p += 4;
+   }
+   while (p < end) {
+      h ^= (*p) * FP_PRIME5;
+      h = FP_ROTL(h, 11) * FP_PRIME1;
+      p++;
+   }
+
+   h ^= h >> 33;
+   h *= FP_PRIME2;
+   h ^= h >> 29;
+   h *= FP_PRIME3;
+   h ^= h >> 32;
+   return h;
+}
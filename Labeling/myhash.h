@@ -35,5 +35,7 @@ typedef u_int32_t INDEX;
 
 INDEX attr_hash ( const u_char *, u_int16_t, u_int32_t );
 INDEX prefix_hash ( const u_char *, u_int16_t, u_int32_t);
+INDEX prefix_hash_value ( const u_char *, u_int16_t );
+u_int64_t attr_fingerprint ( const u_char *, u_int32_t );
 
 #endif /*MYHASH_H_*/
@@ -0,0 +1,559 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ * 
+ *  File: prefixtable.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "prefixtable.h"
+#include "myhash.h"
+#include "../Util/log.h"
+
+//#define DEBUG
+
+/* number of routes a route array grows by */
+#define PREFIX_ROUTES_STEP	16
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find the slot of a prefix in a slot array
+ * Input: slots - the slot array, size - its number of slots
+ *		prefix - the prefix, hash - its hash value, keyLen - its length in bytes
+ * Output: the slot of the prefix or NULL if it is not in the array
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static PrefixSlot *
+findPrefixSlot( PrefixSlot *slots, u_int32_t size, const Prefix *prefix, u_int32_t hash, int keyLen )
+{
+	u_int32_t mask = size - 1;
+	u_int32_t i = hash & mask;
+	u_int16_t probe = 1;
+
+	// the slots of a probe sequence are ordered by distance from their home slot,
+	// so the search ends at the first slot that is closer to its home than the prefix would be
+	while( slots[i].probe >= probe )
+	{
+		if( slots[i].hash == hash && slots[i].node != NULL 
+			&& !memcmp(prefix, &(slots[i].node->keyPrefix), keyLen) )
+			return &slots[i];
+		i = (i + 1) & mask;
+		probe++;
+	}
+	return NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Put a prefix node in a slot array, displacing nodes that are closer to
+ *		their home slot
+ * Input: slots - the slot array, size - its number of slots
+ *		node - the prefix node, hash - the hash value of its prefix
+ * Output: the longest probe length written
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static u_int16_t
+placePrefixSlot( PrefixSlot *slots, u_int32_t size, PrefixNode *node, u_int32_t hash )
+{
+	u_int32_t mask = size - 1;
+	u_int32_t i = hash & mask;
+	u_int16_t longest = 0;
+	PrefixSlot entry, tmp;
+
+	entry.node = node;
+	entry.hash = hash;
+	entry.probe = 1;
+	while( slots[i].probe != 0 )
+	{
+		if( slots[i].probe < entry.probe )
+		{
+			if( entry.probe > longest )
+				longest = entry.probe;
+			tmp = slots[i];
+			slots[i] = entry;
+			entry = tmp;
+		}
+		i = (i + 1) & mask;
+		entry.probe++;
+	}
+	if( entry.probe > longest )
+		longest = entry.probe;
+	slots[i] = entry;
+	return longest;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Empty a slot of the current slot array, the following nodes of the probe
+ *		sequence are shifted back by one slot
+ * Input: slots - the slot array, size - its number of slots
+ *		slot - the slot to empty
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static void
+clearPrefixSlot( PrefixSlot *slots, u_int32_t size, PrefixSlot *slot )
+{
+	u_int32_t mask = size - 1;
+	u_int32_t i = slot - slots;
+	u_int32_t next = (i + 1) & mask;
+
+	while( slots[next].probe > 1 )
+	{
+		slots[i] = slots[next];
+		slots[i].probe--;
+		i = next;
+		next = (next + 1) & mask;
+	}
+	memset(&slots[i], 0, sizeof(PrefixSlot));
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Move slots of the old slot array to the current one
+ * Input: table - the prefix table
+ *		count - the number of old slots to move
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static void
+migratePrefixSlots( PrefixTable *table, u_int32_t count, Session_structp session )
+{
+	PrefixSlot *slot;
+	u_int16_t probe;
+
+	while( table->oldSlots != NULL && count > 0 )
+	{
+		slot = &table->oldSlots[table->migrated];
+		if( slot->node != NULL )
+		{
+			probe = placePrefixSlot(table->slots, table->tableSize, slot->node, slot->hash);
+			if( probe > table->maxProbe )
+				table->maxProbe = probe;
+			// the old slot keeps its probe length so lookups in the old slots still work
+			slot->node = NULL;
+		}
+		table->migrated++;
+		count--;
+
+		if( table->migrated == table->oldTableSize )
+		{
+			free(table->oldSlots);
+			session->stats.memoryUsed -= table->oldTableSize*sizeof(PrefixSlot);
+			table->oldSlots = NULL;
+			table->oldTableSize = 0;
+			table->migrated = 0;
+#ifdef DEBUG
+			debug(__FUNCTION__, "session %d prefix table moved to %u slots", session->sessionID, table->tableSize);
+#endif
+		}
+	}
+	session->stats.prefixMaxProbe = table->maxProbe;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Double the number of slots of a prefix table, the nodes are moved to the
+ *		new slots by the following inserts and removes
+ * Input: table - the prefix table
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static void
+growPrefixTable( PrefixTable *table, Session_structp session )
+{
+	PrefixSlot *slots;
+
+	// finish the previous resize first
+	if( table->oldSlots != NULL )
+		migratePrefixSlots(table, table->oldTableSize - table->migrated, session);
+
+	slots = calloc(table->tableSize*2, sizeof(PrefixSlot));
+	if( slots == NULL )
+		log_fatal( "growPrefixTable: session %d calloc failed", session->sessionID );
+	session->stats.memoryUsed += table->tableSize*2*sizeof(PrefixSlot);
+
+	table->oldSlots = table->slots;
+	table->oldTableSize = table->tableSize;
+	table->migrated = 0;
+	table->slots = slots;
+	table->tableSize *= 2;
+	table->maxProbe = 0;
+	session->stats.prefixTableSize = table->tableSize;
+	log_msg( "session %d prefix table grows to %u slots", session->sessionID, table->tableSize );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Take a prefix node from the node pool of a prefix table
+ * Input: table - the prefix table
+ *		session - the corresponding session structure
+ * Output: the prefix node
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *
+allocPrefixNode( PrefixTable *table, Session_structp session )
+{
+	PrefixNodeChunk *chunk;
+	PrefixNode *node;
+	int i;
+
+	if( table->freeNodes == NULL )
+	{
+		chunk = malloc(sizeof(PrefixNodeChunk));
+		if( chunk == NULL )
+			log_fatal( "allocPrefixNode: session %d malloc failed", session->sessionID );
+		session->stats.memoryUsed += sizeof(PrefixNodeChunk);
+		chunk->next = table->chunks;
+		table->chunks = chunk;
+		for( i = PREFIX_NODE_CHUNK-1; i >= 0; i-- )
+		{
+			chunk->nodes[i].next = table->freeNodes;
+			table->freeNodes = &chunk->nodes[i];
+		}
+	}
+	node = table->freeNodes;
+	table->freeNodes = node->next;
+	node->next = NULL;
+	node->dataAttr = NULL;
+	node->attrNext = NULL;
+	node->attrPrev = NULL;
+	node->trieParent = NULL;
+	node->trieChild[0] = NULL;
+	node->trieChild[1] = NULL;
+	return node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Return a prefix node to the node pool of a prefix table
+ * Input: table - the prefix table
+ *		node - the prefix node
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+freePrefixNode( PrefixTable *table, PrefixNode *node )
+{
+	node->dataAttr = NULL;
+	node->next = table->freeNodes;
+	table->freeNodes = node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Look up a prefix in the prefix table of a session
+ * Input: table - the prefix table
+ *		prefix - the prefix to look for
+ * Output: the prefix node or NULL if the prefix is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *
+findPrefixNode( PrefixTable *table, const Prefix *prefix )
+{
+	int keyLen = sizeof(Prefix) + PREFIX_SIZE(prefix->addr.p_len);
+	u_int32_t hash = prefix_hash_value((u_char *)prefix, keyLen);
+	PrefixSlot *slot;
+
+	slot = findPrefixSlot(table->slots, table->tableSize, prefix, hash, keyLen);
+	if( slot == NULL && table->oldSlots != NULL )
+		slot = findPrefixSlot(table->oldSlots, table->oldTableSize, prefix, hash, keyLen);
+	if( slot == NULL )
+		return NULL;
+	return slot->node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a prefix to the prefix table of a session, the table grows as needed
+ * Input: table - the prefix table
+ *		prefix - the prefix to add, it must not be in the table yet
+ *		session - the corresponding session structure
+ * Output: the new prefix node, the caller sets its attribute and timestamp
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *
+insertPrefixNode( PrefixTable *table, const Prefix *prefix, Session_structp session )
+{
+	int keyLen = sizeof(Prefix) + PREFIX_SIZE(prefix->addr.p_len);
+	u_int32_t hash = prefix_hash_value((u_char *)prefix, keyLen);
+	PrefixNode *node;
+	u_int16_t probe;
+
+	if( (u_int64_t)(table->prefixCount + 1)*100 > (u_int64_t)table->tableSize*PREFIX_TABLE_MAX_LOAD )
+		growPrefixTable(table, session);
+	else
+		migratePrefixSlots(table, PREFIX_TABLE_MIGRATE_STEP, session);
+
+	node = allocPrefixNode(table, session);
+	memcpy(&(node->keyPrefix), prefix, keyLen);
+	node->originatedTS = 0;
+
+	probe = placePrefixSlot(table->slots, table->tableSize, node, hash);
+	if( probe > table->maxProbe )
+		table->maxProbe = probe;
+	table->prefixCount++;
+	session->stats.prefixMaxProbe = table->maxProbe;
+
+	// a long probe sequence in a table that is not full yet means a poor spread of the hash values
+	if( probe > table->maxCollision && (u_int64_t)table->prefixCount*4 >= table->tableSize )
+	{
+		log_warning( "session %d prefix table probe length %d exceeds %d", session->sessionID, probe, table->maxCollision );
+		growPrefixTable(table, session);
+	}
+	return node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node from the prefix table of a session, but keep the node
+ * Input: table - the prefix table
+ *		node - the prefix node returned by findPrefixNode or insertPrefixNode
+ *		session - the corresponding session structure
+ * Output:  0 for success or -1 if the node is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+detachPrefixNode( PrefixTable *table, PrefixNode *node, Session_structp session )
+{
+	int keyLen = sizeof(Prefix) + PREFIX_SIZE(node->keyPrefix.addr.p_len);
+	u_int32_t hash = prefix_hash_value((u_char *)&(node->keyPrefix), keyLen);
+	PrefixSlot *slot;
+
+	slot = findPrefixSlot(table->slots, table->tableSize, &(node->keyPrefix), hash, keyLen);
+	if( slot != NULL )
+		clearPrefixSlot(table->slots, table->tableSize, slot);
+	else if( table->oldSlots != NULL 
+		&& (slot = findPrefixSlot(table->oldSlots, table->oldTableSize, &(node->keyPrefix), hash, keyLen)) != NULL )
+		// the old slots don't move, leave the probe length for the lookups of the following nodes
+		slot->node = NULL;
+	else
+		return -1;
+
+	table->prefixCount--;
+
+	migratePrefixSlots(table, PREFIX_TABLE_MIGRATE_STEP, session);
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node from the prefix table of a session and free it
+ * Input: table - the prefix table
+ *		node - the prefix node returned by findPrefixNode or insertPrefixNode
+ *		session - the corresponding session structure
+ * Output:  0 for success or -1 if the node is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+removePrefixNode( PrefixTable *table, PrefixNode *node, Session_structp session )
+{
+	if( detachPrefixNode(table, node, session) )
+		return -1;
+	freePrefixNode(table, node);
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Put a copy of a prefix node in its place in the prefix table
+ * Input: table - the prefix table
+ *		oldNode - the prefix node in the table
+ *		newNode - a node with the same prefix, not linked in the table
+ * Output:  0 for success or -1 if the old node is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+replacePrefixNode( PrefixTable *table, PrefixNode *oldNode, PrefixNode *newNode )
+{
+	int keyLen = sizeof(Prefix) + PREFIX_SIZE(oldNode->keyPrefix.addr.p_len);
+	u_int32_t hash = prefix_hash_value((u_char *)&(oldNode->keyPrefix), keyLen);
+	PrefixSlot *slot;
+
+	slot = findPrefixSlot(table->slots, table->tableSize, &(oldNode->keyPrefix), hash, keyLen);
+	if( slot == NULL && table->oldSlots != NULL )
+		slot = findPrefixSlot(table->oldSlots, table->oldTableSize, &(oldNode->keyPrefix), hash, keyLen);
+	if( slot == NULL || slot->node != oldNode )
+		return -1;
+	slot->node = newNode;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Walk the prefix nodes of a prefix table
+ * Input: table - the prefix table
+ *		position - the walk position, 0 to start a walk
+ * Output: the next prefix node or NULL at the end of the table
+ * Note: The caller must hold the table lock, the slots move while the table grows.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *
+getNextPrefixNode( PrefixTable *table, u_int32_t *position )
+{
+	PrefixNode *node;
+
+	// the old slots that are not moved yet come first
+	while( *position < table->oldTableSize )
+	{
+		node = table->oldSlots[*position].node;
+		(*position)++;
+		if( node != NULL )
+			return node;
+	}
+	while( *position < table->oldTableSize + table->tableSize )
+	{
+		node = table->slots[*position - table->oldTableSize].node;
+		(*position)++;
+		if( node != NULL )
+			return node;
+	}
+	return NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free all the prefix nodes of a prefix table and empty its slots
+ * Input: table - the prefix table
+ *		session - the corresponding session structure
+ * Output: the number of prefixes that were in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int32_t
+clearPrefixTable( PrefixTable *table, Session_structp session )
+{
+	u_int32_t position = 0, prefixCount = 0;
+	PrefixNodeChunk *chunk;
+
+	while( getNextPrefixNode(table, &position) != NULL )
+		prefixCount++;
+
+	if( table->oldSlots != NULL )
+	{
+		free(table->oldSlots);
+		session->stats.memoryUsed -= table->oldTableSize*sizeof(PrefixSlot);
+		table->oldSlots = NULL;
+		table->oldTableSize = 0;
+		table->migrated = 0;
+	}
+	memset(table->slots, 0, table->tableSize*sizeof(PrefixSlot));
+
+	while( table->chunks != NULL )
+	{
+		chunk = table->chunks;
+		table->chunks = chunk->next;
+		free(chunk);
+		session->stats.memoryUsed -= sizeof(PrefixNodeChunk);
+	}
+	table->freeNodes = NULL;
+	memset(table->trieRoots, 0, sizeof(table->trieRoots));
+	table->prefixCount = 0;
+	table->maxProbe = 0;
+	session->stats.prefixMaxProbe = 0;
+	return prefixCount;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a copy of a prefix node to a route array
+ * Input: node - the prefix node
+ *		session - the session of the node
+ *		routes - the route array, count - its number of routes
+ * Output: the new number of routes
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+addPrefixRoute( PrefixNode *node, Session_structp session, PrefixRoute **routes, int count )
+{
+	PrefixRoute *route;
+	u_char *asPath;
+
+	if( count % PREFIX_ROUTES_STEP == 0 )
+	{
+		*routes = realloc(*routes, (count + PREFIX_ROUTES_STEP)*sizeof(PrefixRoute));
+		if( *routes == NULL )
+			log_fatal( "addPrefixRoute: realloc failed" );
+	}
+	route = &(*routes)[count];
+	memcpy(&route->keyPrefix, &node->keyPrefix, sizeof(Prefix) + PREFIX_SIZE(node->keyPrefix.addr.p_len));
+	route->originatedTS = node->originatedTS;
+
+	// skip the flags, type and 1 or 2 length bytes of the AS path attribute
+	asPath = node->dataAttr->asPath->asPathData.data;
+	if( asPath[0] & 0x10 )
+		route->asPath = printASPath(asPath+4, session->fsm.ASNumlen);
+	else
+		route->asPath = printASPath(asPath+3, session->fsm.ASNumlen);
+	return count + 1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Copy all the routes of a session
+ * Input: session - the session structure
+ *		routes - set to an array of the routes, free it with freePrefixRoutes
+ * Output: the number of routes
+ * Note: The routes are copied under the table lock, so the caller can print them
+ *       at its own pace while the rib changes.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+listPrefixTable( Session_structp session, PrefixRoute **routes )
+{
+	PrefixTable *table;
+	PrefixNode *node;
+	u_int32_t position = 0;
+	int count = 0, error;
+
+	*routes = NULL;
+	// the rib tables are not deleted while the session's rib lock is held
+	if( (error = pthread_rwlock_rdlock(&session->ribLock)) > 0 )
+		log_fatal( "Failed to rdlock the rib tables: %s", strerror(error) );
+	table = session->prefixTable;
+	if( table == NULL )
+	{
+		pthread_rwlock_unlock(&session->ribLock);
+		return 0;
+	}
+
+	if( (error = pthread_rwlock_rdlock(&table->lock)) > 0 )
+		log_fatal( "Failed to rdlock the prefix table: %s", strerror(error) );
+	while( (node = getNextPrefixNode(table, &position)) != NULL )
+	{
+		if( node->dataAttr != NULL )
+			count = addPrefixRoute(node, session, routes, count);
+	}
+	pthread_rwlock_unlock(&table->lock);
+	pthread_rwlock_unlock(&session->ribLock);
+	return count;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the routes returned by listPrefixTable or queryPrefixTable
+ * Input: routes - the route array
+ *		count - the number of routes
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+freePrefixRoutes( PrefixRoute *routes, int count )
+{
+	int i;
+
+	for( i = 0; i < count; i++ )
+		free(routes[i].asPath);
+	free(routes);
+}
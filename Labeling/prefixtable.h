@@ -0,0 +1,160 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ * 
+ *  File: prefixtable.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef PREFIXTABLE_H_
+#define PREFIXTABLE_H_
+
+#include "rtable.h"
+#include "../Peering/peersession.h"
+
+/* a route copied out of the prefix table, it stays valid after the rib changes */
+typedef struct PrefixRouteStruct {
+   Prefix                     keyPrefix;
+   u_char                     keyAddr[PREFIX_MAX_BYTES];	/* storage of keyPrefix.addr.paddr */
+   u_int32_t                  originatedTS;
+   char                      *asPath;
+} PrefixRoute;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Look up a prefix in the prefix table of a session
+ * Input: table - the prefix table
+ *		prefix - the prefix to look for
+ * Output: the prefix node or NULL if the prefix is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *findPrefixNode( PrefixTable *table, const Prefix *prefix );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a prefix to the prefix table of a session, the table grows as needed
+ * Input: table - the prefix table
+ *		prefix - the prefix to add, it must not be in the table yet
+ *		session - the corresponding session structure
+ * Output: the new prefix node, the caller sets its attribute and timestamp
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *insertPrefixNode( PrefixTable *table, const Prefix *prefix, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node from the prefix table of a session and free it
+ * Input: table - the prefix table
+ *		node - the prefix node returned by findPrefixNode or insertPrefixNode
+ *		session - the corresponding session structure
+ * Output:  0 for success or -1 if the node is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int removePrefixNode( PrefixTable *table, PrefixNode *node, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node from the prefix table of a session, but keep the node
+ * Input: table - the prefix table
+ *		node - the prefix node returned by findPrefixNode or insertPrefixNode
+ *		session - the corresponding session structure
+ * Output:  0 for success or -1 if the node is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int detachPrefixNode( PrefixTable *table, PrefixNode *node, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Put a copy of a prefix node in its place in the prefix table
+ * Input: table - the prefix table
+ *		oldNode - the prefix node in the table
+ *		newNode - a node with the same prefix, not linked in the table
+ * Output:  0 for success or -1 if the old node is not in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int replacePrefixNode( PrefixTable *table, PrefixNode *oldNode, PrefixNode *newNode );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Take a prefix node from the node pool of a prefix table
+ * Input: table - the prefix table
+ *		session - the corresponding session structure
+ * Output: the prefix node, not linked in the table or the trie
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *allocPrefixNode( PrefixTable *table, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Return a prefix node to the node pool of a prefix table
+ * Input: table - the prefix table
+ *		node - the prefix node
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void freePrefixNode( PrefixTable *table, PrefixNode *node );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Walk the prefix nodes of a prefix table
+ * Input: table - the prefix table
+ *		position - the walk position, 0 to start a walk
+ * Output: the next prefix node or NULL at the end of the table
+ * Note: The caller must hold the table lock, the slots move while the table grows.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+PrefixNode *getNextPrefixNode( PrefixTable *table, u_int32_t *position );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free all the prefix nodes of a prefix table and empty its slots
+ * Input: table - the prefix table
+ *		session - the corresponding session structure
+ * Output: the number of prefixes that were in the table
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int32_t clearPrefixTable( PrefixTable *table, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a copy of a prefix node to a route array
+ * Input: node - the prefix node
+ *		session - the session of the node
+ *		routes - the route array, count - its number of routes
+ * Output: the new number of routes
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int addPrefixRoute( PrefixNode *node, Session_structp session, PrefixRoute **routes, int count );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Copy all the routes of a session
+ * Input: session - the session structure
+ *		routes - set to an array of the routes, free it with freePrefixRoutes
+ * Output: the number of routes
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int listPrefixTable( Session_structp session, PrefixRoute **routes );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the routes returned by listPrefixTable or queryPrefixTable
+ * Input: routes - the route array
+ *		count - the number of routes
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void freePrefixRoutes( PrefixRoute *routes, int count );
+
+#endif /*PREFIXTABLE_H_*/
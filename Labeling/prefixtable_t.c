@@ -0,0 +1,293 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ *	
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: prefixtable_t.c
+ *  Authors: agent
+ *  Date: Oct 17, 2026
+ */
+#include <CUnit/Basic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "prefixtable.h"
+#include "../Peering/peersession.h"
+
+/* a few global variables to play with across tests */
+#define PT_TEST_SESSION 5
+#define PT_TEST_PREFIXES 4000
+
+Session_structp ptSession;
+RibPrefixKey ptKeys[PT_TEST_PREFIXES];
+PrefixNode *ptNodes[PT_TEST_PREFIXES];
+int ptInserted;
+
+/* the i-th test prefix, a /24 or a /32 in 10.0.0.0/8 */
+static void
+ptMakeKey(int i, RibPrefixKey *key)
+{
+  memset(key, 0, sizeof(RibPrefixKey));
+  key->keyPrefix.afi = 1;
+  key->keyPrefix.safi = 1;
+  key->keyPrefix.addr.p_len = (i % 5) ? 24 : 32;
+  key->keyAddr[0] = 10;
+  key->keyAddr[1] = (i >> 8) & 0xff;
+  key->keyAddr[2] = i & 0xff;
+  key->keyAddr[3] = (i % 5) ? 0 : 1;
+}
+
+/* inserts the next test prefix */
+static PrefixNode *
+ptInsertNext()
+{
+  PrefixTable *table = ptSession->prefixTable;
+  int i = ptInserted++;
+
+  ptMakeKey(i, &ptKeys[i]);
+  ptNodes[i] = insertPrefixNode(table, &ptKeys[i].keyPrefix, ptSession);
+  if(ptNodes[i] != NULL){
+    ptNodes[i]->originatedTS = i + 1;
+  }
+  return ptNodes[i];
+}
+
+/* counts the prefixes of the table that are found where they should be,
+ * the removed ones must not be found */
+static int
+ptCheckAll()
+{
+  PrefixTable *table = ptSession->prefixTable;
+  PrefixNode *node;
+  int i, found = 0;
+
+  for(i = 0; i < ptInserted; i++){
+    node = findPrefixNode(table, &ptKeys[i].keyPrefix);
+    if(ptNodes[i] == NULL){
+      if(node != NULL){
+        fprintf(stderr,"removed prefix %d still found\n", i);
+        return -1;
+      }
+    }
+    else if(node != ptNodes[i] || node->originatedTS != (u_int32_t)i + 1){
+      fprintf(stderr,"prefix %d not found\n", i);
+      return -1;
+    }
+    else{
+      found++;
+    }
+  }
+  return found;
+}
+
+/* walks the table, every node must be seen once */
+static int
+ptWalk()
+{
+  PrefixTable *table = ptSession->prefixTable;
+  PrefixNode *node;
+  u_int32_t position = 0;
+  char *seen = calloc(PT_TEST_PREFIXES + 1, 1);
+  int count = 0;
+
+  while((node = getNextPrefixNode(table, &position)) != NULL){
+    if(node->originatedTS == 0 || node->originatedTS > PT_TEST_PREFIXES || seen[node->originatedTS]){
+      count = -1;
+      break;
+    }
+    seen[node->originatedTS] = 1;
+    count++;
+  }
+  free(seen);
+  return count;
+}
+
+/* The suite initialization function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+init_prefixtable(void)
+{
+  ptSession = calloc(1, sizeof(struct SessionStruct));
+  if(ptSession == NULL){
+    return -1;
+  }
+  ptSession->sessionID = PT_TEST_SESSION;
+  Sessions[PT_TEST_SESSION] = ptSession;
+  // a small table, so the test goes through several resizes
+  createPrefixTable(PT_TEST_SESSION, 4, 8);
+  ptInserted = 0;
+  return 0;
+}
+
+/* The suite cleanup function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+clean_prefixtable(void)
+{
+  if(ptSession->prefixTable != NULL){
+    clearPrefixTable(ptSession->prefixTable, ptSession);
+    pthread_rwlock_destroy(&ptSession->prefixTable->lock);
+    free(ptSession->prefixTable->slots);
+    free(ptSession->prefixTable);
+  }
+  Sessions[PT_TEST_SESSION] = NULL;
+  free(ptSession);
+  return 0;
+}
+
+/* TEST: the table grows as prefixes are added, lookups find the prefixes
+ *       in the old and the new slots while they are moved
+ */
+void
+testPrefixTable_growth()
+{
+  PrefixTable *table = ptSession->prefixTable;
+  u_int32_t size = table->tableSize;
+  int grows = 0, migrating = 0;
+
+  CU_ASSERT(4 == table->tableSize);
+  CU_ASSERT(NULL == findPrefixNode(table, &ptKeys[0].keyPrefix));
+
+  while(ptInserted < PT_TEST_PREFIXES / 2){
+    CU_ASSERT(NULL != ptInsertNext());
+    if(table->tableSize != size){
+      CU_ASSERT(table->tableSize == size * 2);
+      size = table->tableSize;
+      grows++;
+    }
+    CU_ASSERT((u_int64_t)table->prefixCount * 100 <= (u_int64_t)table->tableSize * PREFIX_TABLE_MAX_LOAD);
+    if(table->oldSlots != NULL){
+      // check everything a few times during each resize
+      if(migrating++ % 8 == 0){
+        CU_ASSERT(ptInserted == ptCheckAll());
+      }
+    }
+  }
+  CU_ASSERT(grows >= 8);
+  CU_ASSERT(migrating > 0);
+  CU_ASSERT(ptInserted == (int)table->prefixCount);
+  CU_ASSERT(ptInserted == ptCheckAll());
+  CU_ASSERT(ptInserted == ptWalk());
+  CU_ASSERT(ptSession->stats.prefixTableSize == table->tableSize);
+}
+
+/* TEST: prefixes removed or replaced while the table is being resized
+ */
+void
+testPrefixTable_deleteDuringMigration()
+{
+  PrefixTable *table = ptSession->prefixTable;
+  PrefixNode *node;
+  int i, count, removed = 0;
+
+  // insert up to the start of the next resize
+  while(table->oldSlots == NULL && ptInserted < PT_TEST_PREFIXES){
+    ptInsertNext();
+  }
+  CU_ASSERT(NULL != table->oldSlots);
+  if(table->oldSlots == NULL){
+    return;
+  }
+  CU_ASSERT(table->migrated < table->oldTableSize);
+
+  // every third prefix goes, most of them still in the old slots
+  for(i = 0; i < ptInserted; i += 3){
+    CU_ASSERT(0 == removePrefixNode(table, ptNodes[i], ptSession));
+    ptNodes[i] = NULL;
+    removed++;
+    if(i % 300 == 0){
+      CU_ASSERT(ptInserted - removed == ptCheckAll());
+    }
+  }
+  CU_ASSERT(ptInserted - removed == (int)table->prefixCount);
+
+  // a node that is not in the table is refused
+  ptMakeKey(PT_TEST_PREFIXES - 1, &ptKeys[PT_TEST_PREFIXES - 1]);
+  node = allocPrefixNode(table, ptSession);
+  memcpy(&node->keyPrefix, &ptKeys[PT_TEST_PREFIXES - 1].keyPrefix, sizeof(RibPrefixKey));
+  CU_ASSERT(-1 == removePrefixNode(table, node, ptSession));
+  CU_ASSERT(-1 == replacePrefixNode(table, node, node));
+
+  // a copy takes the place of a node wherever it is
+  for(i = 1; i < ptInserted; i += 3){
+    memcpy(&node->keyPrefix, &ptKeys[i].keyPrefix, sizeof(RibPrefixKey));
+    node->originatedTS = i + 1;
+    CU_ASSERT(0 == replacePrefixNode(table, ptNodes[i], node));
+    CU_ASSERT(node == findPrefixNode(table, &ptKeys[i].keyPrefix));
+    CU_ASSERT(0 == replacePrefixNode(table, node, ptNodes[i]));
+    if(i > 300){
+      break;
+    }
+  }
+  freePrefixNode(table, node);
+
+  // more inserts and removes finish the resize
+  while(table->oldSlots != NULL && ptInserted < PT_TEST_PREFIXES - 1){
+    ptInsertNext();
+  }
+  CU_ASSERT(NULL == table->oldSlots);
+  CU_ASSERT(0 == table->migrated && 0 == table->oldTableSize);
+  count = ptCheckAll();
+  CU_ASSERT(count == (int)table->prefixCount);
+  CU_ASSERT(count == ptWalk());
+
+  // removing everything empties the table, whatever the order
+  for(i = ptInserted - 1; i >= 0; i--){
+    if(ptNodes[i] != NULL){
+      CU_ASSERT(0 == removePrefixNode(table, ptNodes[i], ptSession));
+      CU_ASSERT(-1 == detachPrefixNode(table, ptNodes[i], ptSession));
+      ptNodes[i] = NULL;
+    }
+  }
+  CU_ASSERT(0 == table->prefixCount);
+  CU_ASSERT(0 == ptCheckAll());
+  CU_ASSERT(0 == ptWalk());
+}
+
+/* TEST: clearing a table frees its nodes and keeps its slots
+ */
+void
+testPrefixTable_clear()
+{
+  PrefixTable *table = ptSession->prefixTable;
+  u_int32_t size;
+
+  ptInserted = 0;
+  while(ptInserted < PT_TEST_PREFIXES / 2){
+    ptInsertNext();
+  }
+  size = table->tableSize;
+  CU_ASSERT(ptInserted == (int)clearPrefixTable(table, ptSession));
+  CU_ASSERT(0 == table->prefixCount);
+  CU_ASSERT(NULL == table->oldSlots);
+  CU_ASSERT(size == table->tableSize);
+  CU_ASSERT(0 == ptWalk());
+  CU_ASSERT(NULL == findPrefixNode(table, &ptKeys[0].keyPrefix));
+
+  // the table is usable again
+  ptInserted = 0;
+  CU_ASSERT(NULL != ptInsertNext());
+  CU_ASSERT(1 == ptCheckAll());
+}
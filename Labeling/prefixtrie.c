@@ -0,0 +1,502 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ * 
+ *  File: prefixtrie.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "prefixtrie.h"
+#include "prefixtable.h"
+#include "../Util/log.h"
+
+//#define DEBUG
+
+/* the bit i of a prefix address, bit 0 is the most significant bit of the first byte */
+#define prefixBit(addr, i) (((addr)[(i)>>3] >> (7-((i)&7))) & 1)
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Count the leading bits two prefix addresses have in common
+ * Input: a, b - the prefix addresses
+ *		maxBits - the number of bits to compare
+ * Output: the number of common leading bits, at most maxBits
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static int
+commonPrefixBits( const u_char *a, const u_char *b, int maxBits )
+{
+	int i = 0;
+	u_char diff;
+
+	while( i + 8 <= maxBits && a[i>>3] == b[i>>3] )
+		i += 8;
+	if( i < maxBits )
+	{
+		diff = a[i>>3] ^ b[i>>3];
+		while( i < maxBits && !(diff & (0x80 >> (i&7))) )
+			i++;
+	}
+	return i;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Find the trie root of an afi/safi
+ * Input: table - the prefix table
+ *		afi, safi - the address family
+ *		create - if the afi/safi has no trie yet, return a free root
+ * Output: the root pointer or NULL
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static PrefixNode **
+findTrieRoot( PrefixTable *table, u_int16_t afi, u_int8_t safi, int create )
+{
+	PrefixNode **freeRoot = NULL;
+	int i;
+
+	for( i = 0; i < PREFIX_TRIE_ROOTS; i++ )
+	{
+		if( table->trieRoots[i] == NULL )
+		{
+			if( freeRoot == NULL )
+				freeRoot = &table->trieRoots[i];
+		}
+		else if( table->trieRoots[i]->keyPrefix.afi == afi && table->trieRoots[i]->keyPrefix.safi == safi )
+			return &table->trieRoots[i];
+	}
+	return create ? freeRoot : NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Point the link to a trie node at another node
+ * Input: root - the trie root
+ *		oldNode - the node that is linked now
+ *		newNode - the node to link instead, may be NULL
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static void
+replaceTrieLink( PrefixNode **root, PrefixNode *oldNode, PrefixNode *newNode )
+{
+	PrefixNode *parent = oldNode->trieParent;
+
+	if( parent == NULL )
+		*root = newNode;
+	else if( parent->trieChild[0] == oldNode )
+		parent->trieChild[0] = newNode;
+	else
+		parent->trieChild[1] = newNode;
+	if( newNode != NULL )
+		newNode->trieParent = parent;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Make a trie node that only joins two branches
+ * Input: table - the prefix table
+ *		key - a prefix the node is a part of
+ *		len - the prefix length of the node
+ *		session - the corresponding session structure
+ * Output: the new trie node
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static PrefixNode *
+createTrieGlue( PrefixTable *table, const PrefixNode *key, int len, Session_structp session )
+{
+	PrefixNode *glue = allocPrefixNode(table, session);
+
+	glue->originatedTS = 0;
+	glue->keyPrefix.afi = key->keyPrefix.afi;
+	glue->keyPrefix.safi = key->keyPrefix.safi;
+	glue->keyPrefix.addr.p_len = len;
+	memset(glue->keyAddr, 0, PREFIX_MAX_BYTES);
+	memcpy(glue->keyAddr, key->keyAddr, PREFIX_SIZE(len));
+	if( len & 7 )
+		glue->keyAddr[len>>3] &= 0xFF << (8 - (len&7));
+	return glue;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a prefix node to the prefix trie of its afi/safi
+ * Input: table - the prefix table
+ *		node - the prefix node, its attribute must be set
+ *		session - the corresponding session structure
+ * Output: 0 for success or -1 if the node could not be indexed
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+insertPrefixTrie( PrefixTable *table, PrefixNode *node, Session_structp session )
+{
+	PrefixNode **root, *cur, *glue;
+	int len = node->keyPrefix.addr.p_len;
+	int curLen, common, bit;
+
+	root = findTrieRoot(table, node->keyPrefix.afi, node->keyPrefix.safi, 1);
+	if( root == NULL )
+	{
+		log_warning( "session %d has too many address families for the prefix trie", session->sessionID );
+		return -1;
+	}
+
+	node->trieParent = NULL;
+	node->trieChild[0] = NULL;
+	node->trieChild[1] = NULL;
+	if( *root == NULL )
+	{
+		*root = node;
+		return 0;
+	}
+
+	cur = *root;
+	while( 1 )
+	{
+		curLen = cur->keyPrefix.addr.p_len;
+		common = commonPrefixBits(cur->keyAddr, node->keyAddr, curLen < len ? curLen : len);
+		if( common < curLen )
+		{
+			if( common == len )
+			{
+				// the new prefix covers the current node
+				replaceTrieLink(root, cur, node);
+				node->trieChild[prefixBit(cur->keyAddr, len)] = cur;
+				cur->trieParent = node;
+			}
+			else
+			{
+				// the prefixes branch off, join them with a new node
+				glue = createTrieGlue(table, node, common, session);
+				replaceTrieLink(root, cur, glue);
+				glue->trieChild[prefixBit(node->keyAddr, common)] = node;
+				glue->trieChild[prefixBit(cur->keyAddr, common)] = cur;
+				node->trieParent = glue;
+				cur->trieParent = glue;
+			}
+			return 0;
+		}
+
+		if( curLen == len )
+		{
+			// only the bits after the prefix length differ from a node in the trie
+			if( cur->dataAttr != NULL )
+				return -1;
+			// the new prefix takes the place of the joining node
+			node->trieChild[0] = cur->trieChild[0];
+			node->trieChild[1] = cur->trieChild[1];
+			if( node->trieChild[0] != NULL )
+				node->trieChild[0]->trieParent = node;
+			if( node->trieChild[1] != NULL )
+				node->trieChild[1]->trieParent = node;
+			replaceTrieLink(root, cur, node);
+			freePrefixNode(table, cur);
+			return 0;
+		}
+
+		bit = prefixBit(node->keyAddr, curLen);
+		if( cur->trieChild[bit] == NULL )
+		{
+			cur->trieChild[bit] = node;
+			node->trieParent = cur;
+			return 0;
+		}
+		cur = cur->trieChild[bit];
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node from the prefix trie of its afi/safi
+ * Input: table - the prefix table
+ *		node - the prefix node
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+removePrefixTrie( PrefixTable *table, PrefixNode *node, Session_structp session )
+{
+	PrefixNode **root, *parent, *child, *glue;
+
+	root = findTrieRoot(table, node->keyPrefix.afi, node->keyPrefix.safi, 0);
+	// nodes that insertPrefixTrie refused are not in the trie
+	if( root == NULL || (node->trieParent == NULL && *root != node) )
+		return;
+
+	if( node->trieChild[0] != NULL && node->trieChild[1] != NULL )
+	{
+		// the node still joins two branches
+		glue = createTrieGlue(table, node, node->keyPrefix.addr.p_len, session);
+		glue->trieChild[0] = node->trieChild[0];
+		glue->trieChild[1] = node->trieChild[1];
+		glue->trieChild[0]->trieParent = glue;
+		glue->trieChild[1]->trieParent = glue;
+		replaceTrieLink(root, node, glue);
+	}
+	else
+	{
+		child = node->trieChild[0] != NULL ? node->trieChild[0] : node->trieChild[1];
+		parent = node->trieParent;
+		replaceTrieLink(root, node, child);
+
+		// a joining node left with one branch is not needed any more
+		if( child == NULL && parent != NULL && parent->dataAttr == NULL )
+		{
+			child = parent->trieChild[0] != NULL ? parent->trieChild[0] : parent->trieChild[1];
+			replaceTrieLink(root, parent, child);
+			freePrefixNode(table, parent);
+		}
+	}
+	node->trieParent = NULL;
+	node->trieChild[0] = NULL;
+	node->trieChild[1] = NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Put a copy of a prefix node in its place in the prefix trie
+ * Input: table - the prefix table
+ *		oldNode - the prefix node in the trie
+ *		newNode - a node with the same prefix, not linked in the trie
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+replacePrefixTrie( PrefixTable *table, PrefixNode *oldNode, PrefixNode *newNode )
+{
+	PrefixNode **root;
+	int i;
+
+	root = findTrieRoot(table, oldNode->keyPrefix.afi, oldNode->keyPrefix.safi, 0);
+	// nodes that insertPrefixTrie refused are not in the trie
+	if( root == NULL || (oldNode->trieParent == NULL && *root != oldNode) )
+		return;
+
+	replaceTrieLink(root, oldNode, newNode);
+	for( i = 0; i < 2; i++ )
+	{
+		newNode->trieChild[i] = oldNode->trieChild[i];
+		if( newNode->trieChild[i] != NULL )
+			newNode->trieChild[i]->trieParent = newNode;
+		oldNode->trieChild[i] = NULL;
+	}
+	oldNode->trieParent = NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Look up the routes of a session that match a prefix
+ * Input: session - the session structure
+ *		type - one of the PREFIX_QUERY_* types
+ *		prefix - the prefix to look for, a safi of 0 matches any safi
+ *		routes - set to an array of the routes found, free it with freePrefixRoutes
+ * Output: the number of routes found
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+queryPrefixTable( Session_structp session, int type, const Prefix *prefix, PrefixRoute **routes )
+{
+	PrefixTable *table;
+	PrefixNode *cur, *longest, *stack[PREFIX_MAX_BYTES*8 + 1];
+	int len = prefix->addr.p_len;
+	int count = 0, depth, curLen, i, error;
+
+	*routes = NULL;
+	// the rib tables are not deleted while the session's rib lock is held
+	if( (error = pthread_rwlock_rdlock(&session->ribLock)) > 0 )
+		log_fatal( "Failed to rdlock the rib tables: %s", strerror(error) );
+	table = session->prefixTable;
+	if( table == NULL )
+	{
+		pthread_rwlock_unlock(&session->ribLock);
+		return 0;
+	}
+
+	if( (error = pthread_rwlock_rdlock(&table->lock)) > 0 )
+		log_fatal( "Failed to rdlock the prefix table: %s", strerror(error) );
+
+	for( i = 0; i < PREFIX_TRIE_ROOTS; i++ )
+	{
+		cur = table->trieRoots[i];
+		if( cur == NULL || cur->keyPrefix.afi != prefix->afi 
+			|| (prefix->safi != 0 && cur->keyPrefix.safi != prefix->safi) )
+			continue;
+
+		// follow the path of the prefix down the trie
+		longest = NULL;
+		while( cur != NULL )
+		{
+			curLen = cur->keyPrefix.addr.p_len;
+			if( commonPrefixBits(cur->keyAddr, prefix->addr.paddr, curLen < len ? curLen : len) < (curLen < len ? curLen : len) )
+				break;
+
+			if( curLen >= len )
+			{
+				if( type == PREFIX_QUERY_MORE_SPECIFIC )
+				{
+					// every prefix in the subtree is at least as specific
+					depth = 0;
+					stack[depth++] = cur;
+					while( depth > 0 )
+					{
+						cur = stack[--depth];
+						if( cur->dataAttr != NULL )
+							count = addPrefixRoute(cur, session, routes, count);
+						if( cur->trieChild[1] != NULL )
+							stack[depth++] = cur->trieChild[1];
+						if( cur->trieChild[0] != NULL )
+							stack[depth++] = cur->trieChild[0];
+					}
+				}
+				else if( curLen == len && cur->dataAttr != NULL )
+				{
+					if( type == PREFIX_QUERY_LONGEST_MATCH )
+						longest = cur;
+					else
+						count = addPrefixRoute(cur, session, routes, count);
+				}
+				break;
+			}
+
+			if( cur->dataAttr != NULL )
+			{
+				if( type == PREFIX_QUERY_COVERING )
+					count = addPrefixRoute(cur, session, routes, count);
+				else if( type == PREFIX_QUERY_LONGEST_MATCH )
+					longest = cur;
+			}
+			cur = cur->trieChild[prefixBit(prefix->addr.paddr, curLen)];
+		}
+		if( longest != NULL )
+			count = addPrefixRoute(longest, session, routes, count);
+	}
+
+	pthread_rwlock_unlock(&table->lock);
+	pthread_rwlock_unlock(&session->ribLock);
+	return count;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the prefix query type from its name
+ * Input: name - exact, longest-match, covering or more-specifics
+ * Output: the PREFIX_QUERY_* type or -1 for an unknown name
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+getPrefixQueryType( const char *name )
+{
+	if( strcmp(name, "exact") == 0 )
+		return PREFIX_QUERY_EXACT;
+	if( strcmp(name, "longest-match") == 0 )
+		return PREFIX_QUERY_LONGEST_MATCH;
+	if( strcmp(name, "covering") == 0 )
+		return PREFIX_QUERY_COVERING;
+	if( strcmp(name, "more-specifics") == 0 )
+		return PREFIX_QUERY_MORE_SPECIFIC;
+	return -1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Parse a prefix like 192.168.0.0/16 or 2001:db8::/32
+ * Input: str - the prefix string, an address without a length is a host route
+ *		prefix - the prefix to fill in, with room for PREFIX_MAX_BYTES address bytes
+ * Output: 0 for success or -1 for a malformed prefix
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+parsePrefix( const char *str, Prefix *prefix )
+{
+	char addr[INET6_ADDRSTRLEN];
+	const char *slash;
+	char *end;
+	long len;
+	int maxLen;
+
+	slash = strchr(str, '/');
+	if( slash == NULL )
+		slash = str + strlen(str);
+	if( slash - str >= INET6_ADDRSTRLEN )
+		return -1;
+	memcpy(addr, str, slash - str);
+	addr[slash - str] = '\0';
+
+	memset(prefix->addr.paddr, 0, 16);
+	if( inet_pton(AF_INET, addr, prefix->addr.paddr) == 1 )
+	{
+		prefix->afi = 1;
+		maxLen = 32;
+	}
+	else if( inet_pton(AF_INET6, addr, prefix->addr.paddr) == 1 )
+	{
+		prefix->afi = 2;
+		maxLen = 128;
+	}
+	else
+		return -1;
+	prefix->safi = 0;
+
+	len = maxLen;
+	if( *slash == '/' )
+	{
+		len = strtol(slash+1, &end, 10);
+		if( end == slash+1 || *end != '\0' || len < 0 || len > maxLen )
+			return -1;
+	}
+	prefix->addr.p_len = len;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Print a prefix like 192.168.0.0/16 or 2001:db8::/32
+ * Input: prefix - the prefix
+ *		buf - the output buffer, len - its size
+ * Output: buf
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+char *
+formatPrefix( const Prefix *prefix, char *buf, int len )
+{
+	u_char addr[16];
+	char str[INET6_ADDRSTRLEN];
+	int size = PREFIX_SIZE(prefix->addr.p_len);
+
+	memset(addr, 0, sizeof(addr));
+	if( prefix->afi == 1 && prefix->addr.p_len <= 32 )
+	{
+		memcpy(addr, prefix->addr.paddr, size);
+		inet_ntop(AF_INET, addr, str, sizeof(str));
+	}
+	else if( prefix->afi == 2 && prefix->addr.p_len <= 128 )
+	{
+		memcpy(addr, prefix->addr.paddr, size);
+		inet_ntop(AF_INET6, addr, str, sizeof(str));
+	}
+	else
+		snprintf(str, sizeof(str), "afi%d", prefix->afi);
+	snprintf(buf, len, "%s/%d", str, prefix->addr.p_len);
+	return buf;
+}
@@ -0,0 +1,112 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ * 
+ *  File: prefixtrie.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef PREFIXTRIE_H_
+#define PREFIXTRIE_H_
+
+#include "rtable.h"
+#include "prefixtable.h"
+#include "../Peering/peersession.h"
+
+/* prefix query types */
+#define PREFIX_QUERY_EXACT		1
+#define PREFIX_QUERY_LONGEST_MATCH	2
+#define PREFIX_QUERY_COVERING		3
+#define PREFIX_QUERY_MORE_SPECIFIC	4
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a prefix node to the prefix trie of its afi/safi
+ * Input: table - the prefix table
+ *		node - the prefix node, its attribute must be set
+ *		session - the corresponding session structure
+ * Output: 0 for success or -1 if the node could not be indexed
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int insertPrefixTrie( PrefixTable *table, PrefixNode *node, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node from the prefix trie of its afi/safi
+ * Input: table - the prefix table
+ *		node - the prefix node
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void removePrefixTrie( PrefixTable *table, PrefixNode *node, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Put a copy of a prefix node in its place in the prefix trie
+ * Input: table - the prefix table
+ *		oldNode - the prefix node in the trie
+ *		newNode - a node with the same prefix, not linked in the trie
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void replacePrefixTrie( PrefixTable *table, PrefixNode *oldNode, PrefixNode *newNode );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Look up the routes of a session that match a prefix
+ * Input: session - the session structure
+ *		type - one of the PREFIX_QUERY_* types
+ *		prefix - the prefix to look for, a safi of 0 matches any safi
+ *		routes - set to an array of the routes found, free it with freePrefixRoutes
+ * Output: the number of routes found
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int queryPrefixTable( Session_structp session, int type, const Prefix *prefix, PrefixRoute **routes );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the prefix query type from its name
+ * Input: name - exact, longest-match, covering or more-specifics
+ * Output: the PREFIX_QUERY_* type or -1 for an unknown name
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int getPrefixQueryType( const char *name );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Parse a prefix like 192.168.0.0/16 or 2001:db8::/32
+ * Input: str - the prefix string, an address without a length is a host route
+ *		prefix - the prefix to fill in, with room for PREFIX_MAX_BYTES address bytes
+ * Output: 0 for success or -1 for a malformed prefix
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int parsePrefix( const char *str, Prefix *prefix );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Print a prefix like 192.168.0.0/16 or 2001:db8::/32
+ * Input: prefix - the prefix
+ *		buf - the output buffer, len - its size
+ * Output: buf
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+char *formatPrefix( const Prefix *prefix, char *buf, int len );
+
+#endif /*PREFIXTRIE_H_*/
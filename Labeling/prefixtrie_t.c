@@ -0,0 +1,294 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ *	
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: prefixtrie_t.c
+ *  Authors: agent
+ *  Date: Oct 17, 2026
+ */
+#include <CUnit/Basic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "prefixtrie.h"
+#include "prefixtable.h"
+#include "../Peering/peersession.h"
+
+/* a few global variables to play with across tests */
+#define TR_TEST_SESSION 6
+#define TR_TEST_PREFIXES 16
+
+Session_structp trSession;
+/* the AS path attribute 65001 65002, flags, type, length and one AS_SEQUENCE segment */
+u_char trASPathData[] = {0x40, 0x02, 0x06, 0x02, 0x02, 0xfd, 0xe9, 0xfd, 0xea};
+ASPath trASPath;
+AttrNode trAttr;
+RibPrefixKey trKeys[TR_TEST_PREFIXES];
+PrefixNode *trNodes[TR_TEST_PREFIXES];
+
+/* the routes of the test session, safi 1 unless one is given after a space */
+const char *trPrefixes[TR_TEST_PREFIXES] = {
+  "10.0.0.0/8",
+  "10.1.0.0/16",
+  "10.1.2.0/24",
+  "10.2.0.0/16",
+  "10.128.0.0/9",
+  "192.168.0.0/16",
+  "0.0.0.0/0",
+  "10.1.0.0/16 2",
+  "2001:db8::/32",
+  "2001:db8:1::/48",
+  "2001:db8:1:2::1/128",
+  NULL
+};
+
+/* adds the i-th test prefix to the table and the trie */
+static int
+trAdd(int i)
+{
+  PrefixTable *table = trSession->prefixTable;
+  char str[64];
+  char *safi;
+
+  strncpy(str, trPrefixes[i], sizeof(str) - 1);
+  str[sizeof(str) - 1] = '\0';
+  safi = strchr(str, ' ');
+  if(safi != NULL){
+    *safi++ = '\0';
+  }
+  if(parsePrefix(str, &trKeys[i].keyPrefix)){
+    return -1;
+  }
+  trKeys[i].keyPrefix.safi = safi != NULL ? atoi(safi) : 1;
+  trNodes[i] = insertPrefixNode(table, &trKeys[i].keyPrefix, trSession);
+  trNodes[i]->dataAttr = &trAttr;
+  trNodes[i]->originatedTS = i + 1;
+  return insertPrefixTrie(table, trNodes[i], trSession);
+}
+
+/* removes the i-th test prefix from the trie and the table */
+static void
+trRemove(int i)
+{
+  PrefixTable *table = trSession->prefixTable;
+
+  removePrefixTrie(table, trNodes[i], trSession);
+  removePrefixNode(table, trNodes[i], trSession);
+  trNodes[i] = NULL;
+}
+
+/* runs a query and checks the prefixes of the routes found, in order */
+static int
+trQuery(int type, const char *prefix, const char *expected)
+{
+  RibPrefixKey key;
+  PrefixRoute *routes = NULL;
+  char found[512], buf[64];
+  int count, i;
+
+  if(parsePrefix(prefix, &key.keyPrefix)){
+    return 0;
+  }
+  count = queryPrefixTable(trSession, type, &key.keyPrefix, &routes);
+  found[0] = '\0';
+  for(i = 0; i < count; i++){
+    if(i > 0){
+      strcat(found, " ");
+    }
+    strcat(found, formatPrefix(&routes[i].keyPrefix, buf, sizeof(buf)));
+    // every route carries a copy of its AS path
+    if(routes[i].asPath == NULL || strncmp(routes[i].asPath, "65001 65002", 11)){
+      strcat(found, " (bad AS path)");
+    }
+  }
+  freePrefixRoutes(routes, count);
+  if(strcmp(found, expected)){
+    fprintf(stderr,"query %d %s found \"%s\" expected \"%s\"\n", type, prefix, found, expected);
+    return 0;
+  }
+  return 1;
+}
+
+/* The suite initialization function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+init_prefixtrie(void)
+{
+  trSession = calloc(1, sizeof(struct SessionStruct));
+  if(trSession == NULL){
+    return -1;
+  }
+  trSession->sessionID = TR_TEST_SESSION;
+  trSession->fsm.ASNumlen = 2;
+  if(pthread_rwlock_init(&trSession->ribLock, NULL)){
+    return -1;
+  }
+  Sessions[TR_TEST_SESSION] = trSession;
+  createPrefixTable(TR_TEST_SESSION, 16, 8);
+
+  trASPath.asPathData.data = trASPathData;
+  trASPath.asPathData.len = sizeof(trASPathData);
+  trAttr.asPath = &trASPath;
+  return 0;
+}
+
+/* The suite cleanup function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+clean_prefixtrie(void)
+{
+  if(trSession->prefixTable != NULL){
+    clearPrefixTable(trSession->prefixTable, trSession);
+    pthread_rwlock_destroy(&trSession->prefixTable->lock);
+    free(trSession->prefixTable->slots);
+    free(trSession->prefixTable);
+  }
+  pthread_rwlock_destroy(&trSession->ribLock);
+  Sessions[TR_TEST_SESSION] = NULL;
+  free(trSession);
+  return 0;
+}
+
+/* TEST: parsePrefix, formatPrefix and getPrefixQueryType
+ */
+void
+testPrefixTrie_parse()
+{
+  RibPrefixKey key;
+  char buf[64];
+
+  CU_ASSERT(0 == parsePrefix("192.0.2.0/24", &key.keyPrefix));
+  CU_ASSERT(1 == key.keyPrefix.afi && 0 == key.keyPrefix.safi && 24 == key.keyPrefix.addr.p_len);
+  CU_ASSERT(192 == key.keyAddr[0] && 2 == key.keyAddr[2]);
+  CU_ASSERT(0 == strcmp("192.0.2.0/24", formatPrefix(&key.keyPrefix, buf, sizeof(buf))));
+  CU_ASSERT(0 == parsePrefix("192.0.2.1", &key.keyPrefix));
+  CU_ASSERT(32 == key.keyPrefix.addr.p_len);
+  CU_ASSERT(0 == parsePrefix("2001:db8::/32", &key.keyPrefix));
+  CU_ASSERT(2 == key.keyPrefix.afi && 32 == key.keyPrefix.addr.p_len);
+  CU_ASSERT(0 == strcmp("2001:db8::/32", formatPrefix(&key.keyPrefix, buf, sizeof(buf))));
+
+  CU_ASSERT(-1 == parsePrefix("192.0.2.0/33", &key.keyPrefix));
+  CU_ASSERT(-1 == parsePrefix("192.0.2.0/", &key.keyPrefix));
+  CU_ASSERT(-1 == parsePrefix("192.0.2.0/24x", &key.keyPrefix));
+  CU_ASSERT(-1 == parsePrefix("2001:db8::/129", &key.keyPrefix));
+  CU_ASSERT(-1 == parsePrefix("example", &key.keyPrefix));
+
+  CU_ASSERT(PREFIX_QUERY_EXACT == getPrefixQueryType("exact"));
+  CU_ASSERT(PREFIX_QUERY_LONGEST_MATCH == getPrefixQueryType("longest-match"));
+  CU_ASSERT(PREFIX_QUERY_COVERING == getPrefixQueryType("covering"));
+  CU_ASSERT(PREFIX_QUERY_MORE_SPECIFIC == getPrefixQueryType("more-specifics"));
+  CU_ASSERT(-1 == getPrefixQueryType("longest"));
+}
+
+/* TEST: exact, longest match, covering and more specific queries
+ */
+void
+testPrefixTrie_query()
+{
+  PrefixNode *dup;
+  int i;
+
+  for(i = 0; trPrefixes[i] != NULL; i++){
+    CU_ASSERT(0 == trAdd(i));
+  }
+
+  // the same prefix cannot be indexed twice
+  dup = allocPrefixNode(trSession->prefixTable, trSession);
+  memcpy(&dup->keyPrefix, &trKeys[1].keyPrefix, sizeof(RibPrefixKey));
+  dup->dataAttr = &trAttr;
+  CU_ASSERT(-1 == insertPrefixTrie(trSession->prefixTable, dup, trSession));
+  freePrefixNode(trSession->prefixTable, dup);
+
+  CU_ASSERT(trQuery(PREFIX_QUERY_EXACT, "10.1.0.0/16", "10.1.0.0/16 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_EXACT, "10.0.0.0/14", ""));
+  CU_ASSERT(trQuery(PREFIX_QUERY_EXACT, "10.1.2.0/23", ""));
+  CU_ASSERT(trQuery(PREFIX_QUERY_EXACT, "2001:db8:1:2::1", "2001:db8:1:2::1/128"));
+
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.1.2.3", "10.1.2.0/24 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.1.3.1", "10.1.0.0/16 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.3.0.1", "10.0.0.0/8"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.200.0.1", "10.128.0.0/9"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "11.0.0.1", "0.0.0.0/0"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "2001:db8:1:3::1", "2001:db8:1::/48"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "2001:db9::1", ""));
+
+  CU_ASSERT(trQuery(PREFIX_QUERY_COVERING, "10.1.2.0/24", "0.0.0.0/0 10.0.0.0/8 10.1.0.0/16 10.1.2.0/24 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_COVERING, "10.2.3.0/24", "0.0.0.0/0 10.0.0.0/8 10.2.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_COVERING, "2001:db8:1:2::/64", "2001:db8::/32 2001:db8:1::/48"));
+
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "10.0.0.0/8", 
+                    "10.0.0.0/8 10.1.0.0/16 10.1.2.0/24 10.2.0.0/16 10.128.0.0/9 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "10.0.0.0/12", "10.1.0.0/16 10.1.2.0/24 10.2.0.0/16 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "172.16.0.0/12", ""));
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "2001:db8:1::/48", "2001:db8:1::/48 2001:db8:1:2::1/128"));
+}
+
+/* TEST: the trie keeps its shape as prefixes come and go
+ */
+void
+testPrefixTrie_remove()
+{
+  int i = 0;
+
+  // 10.0.0.0/14 takes the place of the node joining 10.1.0.0/16 and 10.2.0.0/16
+  while(trPrefixes[i] != NULL){
+    i++;
+  }
+  trPrefixes[i] = "10.0.0.0/14";
+  CU_ASSERT(0 == trAdd(i));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.3.0.1", "10.0.0.0/14"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_COVERING, "10.2.0.0/16", "0.0.0.0/0 10.0.0.0/8 10.0.0.0/14 10.2.0.0/16"));
+  trRemove(i);
+  trPrefixes[i] = NULL;
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.3.0.1", "10.0.0.0/8"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "10.0.0.0/12", "10.1.0.0/16 10.1.2.0/24 10.2.0.0/16 10.1.0.0/16"));
+
+  // a node with two children becomes a joining node, the lookups go through it
+  trRemove(0);
+  CU_ASSERT(trQuery(PREFIX_QUERY_EXACT, "10.0.0.0/8", ""));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.3.0.1", "0.0.0.0/0"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "10.0.0.0/8", 
+                    "10.1.0.0/16 10.1.2.0/24 10.2.0.0/16 10.128.0.0/9 10.1.0.0/16"));
+
+  // a node with one child is cut out, a joining node left with one branch goes too
+  trRemove(1);
+  trRemove(3);
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.1.2.3", "10.1.2.0/24 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_COVERING, "10.1.2.0/24", "0.0.0.0/0 10.1.2.0/24 10.1.0.0/16"));
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "10.0.0.0/8", "10.1.2.0/24 10.128.0.0/9 10.1.0.0/16"));
+
+  // the other afi/safi are not touched
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "2001:db8::/32", "2001:db8::/32 2001:db8:1::/48 2001:db8:1:2::1/128"));
+
+  for(i = 0; trPrefixes[i] != NULL; i++){
+    if(trNodes[i] != NULL){
+      trRemove(i);
+    }
+  }
+  CU_ASSERT(0 == trSession->prefixTable->prefixCount);
+  CU_ASSERT(trQuery(PREFIX_QUERY_MORE_SPECIFIC, "0.0.0.0/0", ""));
+  CU_ASSERT(trQuery(PREFIX_QUERY_LONGEST_MATCH, "10.1.2.3", ""));
+}
@@ -0,0 +1,189 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: ribarena.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "ribarena.h"
+#include "../Util/log.h"
+
+//#define DEBUG
+
+/* round a size up to the arena granule */
+#define RIB_ARENA_ROUND(x)	(((x) + RIB_ARENA_GRANULE - 1) & ~(RIB_ARENA_GRANULE - 1))
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize an empty RIB arena
+ * Input: arena - the arena
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+initRibArena( RibArena *arena )
+{
+	memset(arena, 0, sizeof(RibArena));
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Allocate an object from a RIB arena
+ * Input: arena - the arena
+ *		size - the size of the object in bytes
+ *		session - the corresponding session structure
+ * Output: the object, exits on fatal error if there is no memory
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void *
+ribArenaAlloc( RibArena *arena, u_int32_t size, Session_structp session )
+{
+	u_int32_t	rounded = RIB_ARENA_ROUND(size);
+	u_int32_t	class;
+	u_char		*block;
+	void		*object;
+	RibArenaLarge	*large;
+
+	if( rounded > RIB_ARENA_MAX_OBJECT )
+	{
+		large = malloc(RIB_ARENA_ROUND(sizeof(RibArenaLarge)) + rounded);
+		if( large == NULL )
+			log_fatal( "ribArenaAlloc: session %d malloc failed", session->sessionID );
+		session->stats.memoryUsed += RIB_ARENA_ROUND(sizeof(RibArenaLarge)) + rounded;
+		arena->largeBytes += RIB_ARENA_ROUND(sizeof(RibArenaLarge)) + rounded;
+		large->prev = NULL;
+		large->next = arena->large;
+		if( arena->large != NULL )
+			arena->large->prev = large;
+		arena->large = large;
+		arena->inUse += rounded;
+		return (u_char *)large + RIB_ARENA_ROUND(sizeof(RibArenaLarge));
+	}
+
+	// reuse an object of the same size class
+	class = rounded/RIB_ARENA_GRANULE - 1;
+	if( arena->freeLists[class] != NULL )
+	{
+		object = arena->freeLists[class];
+		arena->freeLists[class] = *(void **)object;
+		arena->inUse += rounded;
+		return object;
+	}
+
+	// the rest of the newest block is dropped when the object doesn't fit
+	if( arena->cur == NULL || arena->end - arena->cur < rounded )
+	{
+		block = malloc(RIB_ARENA_BLOCK_SIZE);
+		if( block == NULL )
+			log_fatal( "ribArenaAlloc: session %d malloc failed", session->sessionID );
+		session->stats.memoryUsed += RIB_ARENA_BLOCK_SIZE;
+		*(void **)block = arena->blocks;
+		arena->blocks = block;
+		arena->cur = block + RIB_ARENA_ROUND(sizeof(void *));
+		arena->end = block + RIB_ARENA_BLOCK_SIZE;
+	}
+	object = arena->cur;
+	arena->cur += rounded;
+	arena->inUse += rounded;
+	return object;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Return an object to a RIB arena
+ * Input: arena - the arena
+ *		object - the object returned by ribArenaAlloc
+ *		size - the size it was allocated with
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+ribArenaFree( RibArena *arena, void *object, u_int32_t size, Session_structp session )
+{
+	u_int32_t	rounded = RIB_ARENA_ROUND(size);
+	u_int32_t	class;
+	RibArenaLarge	*large;
+
+	if( object == NULL )
+		return;
+	arena->inUse -= rounded;
+
+	if( rounded > RIB_ARENA_MAX_OBJECT )
+	{
+		large = (RibArenaLarge *)((u_char *)object - RIB_ARENA_ROUND(sizeof(RibArenaLarge)));
+		if( large->prev != NULL )
+			large->prev->next = large->next;
+		else
+			arena->large = large->next;
+		if( large->next != NULL )
+			large->next->prev = large->prev;
+		free(large);
+		session->stats.memoryUsed -= RIB_ARENA_ROUND(sizeof(RibArenaLarge)) + rounded;
+		arena->largeBytes -= RIB_ARENA_ROUND(sizeof(RibArenaLarge)) + rounded;
+		return;
+	}
+
+	class = rounded/RIB_ARENA_GRANULE - 1;
+	*(void **)object = arena->freeLists[class];
+	arena->freeLists[class] = object;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release all the objects of a RIB arena at once
+ * Input: arena - the arena
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+resetRibArena( RibArena *arena, Session_structp session )
+{
+	void		*block;
+	RibArenaLarge	*large;
+	int		blockCount = 0;
+
+	while( arena->blocks != NULL )
+	{
+		block = arena->blocks;
+		arena->blocks = *(void **)block;
+		free(block);
+		session->stats.memoryUsed -= RIB_ARENA_BLOCK_SIZE;
+		blockCount++;
+	}
+	while( arena->large != NULL )
+	{
+		large = arena->large;
+		arena->large = large->next;
+		free(large);
+	}
+	session->stats.memoryUsed -= arena->largeBytes;
+#ifdef DEBUG
+	debug( __FUNCTION__, "session %d released %d arena blocks", session->sessionID, blockCount );
+#endif
+	initRibArena(arena);
+}
@@ -0,0 +1,75 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: ribarena.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef RIBARENA_H_
+#define RIBARENA_H_
+
+#include "rtable.h"
+#include "../Peering/peersession.h"
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize an empty RIB arena
+ * Input: arena - the arena
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void initRibArena( RibArena *arena );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Allocate an object from a RIB arena
+ * Input: arena - the arena
+ *		size - the size of the object in bytes
+ *		session - the corresponding session structure
+ * Output: the object, exits on fatal error if there is no memory
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void *ribArenaAlloc( RibArena *arena, u_int32_t size, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Return an object to a RIB arena
+ * Input: arena - the arena
+ *		object - the object returned by ribArenaAlloc
+ *		size - the size it was allocated with
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void ribArenaFree( RibArena *arena, void *object, u_int32_t size, Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release all the objects of a RIB arena at once
+ * Input: arena - the arena
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void resetRibArena( RibArena *arena, Session_structp session );
+
+#endif /*RIBARENA_H_*/
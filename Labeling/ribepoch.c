@@ -0,0 +1,195 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: ribepoch.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "ribepoch.h"
+#include "ribarena.h"
+#include "prefixtable.h"
+#include "../Util/log.h"
+
+//#define DEBUG
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the epoch of an attribute table
+ * Input: epoch - the epoch structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+initRibEpoch( RibEpoch *epoch )
+{
+	memset(epoch, 0, sizeof(RibEpoch));
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Start a read section, the nodes reachable from the attribute table
+ *		are not freed until the section ends
+ * Input: epoch - the epoch structure of the attribute table
+ * Output: the epoch the reader entered, to pass to exitRibEpoch
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int32_t
+enterRibEpoch( RibEpoch *epoch )
+{
+	u_int32_t entered;
+
+	for( ;; )
+	{
+		entered = __atomic_load_n(&epoch->epoch, __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&epoch->readers[entered & 1], 1, __ATOMIC_SEQ_CST);
+		// the labeling worker may have freed the previous epoch before the reader was counted
+		if( __atomic_load_n(&epoch->epoch, __ATOMIC_SEQ_CST) == entered )
+			return entered;
+		__atomic_sub_fetch(&epoch->readers[entered & 1], 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Finish a read section
+ * Input: epoch - the epoch structure of the attribute table
+ *		entered - the epoch returned by enterRibEpoch
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+exitRibEpoch( RibEpoch *epoch, u_int32_t entered )
+{
+	__atomic_sub_fetch(&epoch->readers[entered & 1], 1, __ATOMIC_SEQ_CST);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand an unlinked attribute node over to be freed when no reader can see it
+ * Input: epoch - the epoch structure of the attribute table
+ *		node - the attribute node
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+retireAttrNode( RibEpoch *epoch, AttrNode *node )
+{
+	node->retiredNext = epoch->retiredAttrs[epoch->epoch & 1];
+	epoch->retiredAttrs[epoch->epoch & 1] = node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand an AS path nobody uses any more over to be freed when no reader can see it
+ * Input: epoch - the epoch structure of the attribute table
+ *		path - the AS path
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+retireASPath( RibEpoch *epoch, ASPath *path )
+{
+	path->retiredNext = epoch->retiredPaths[epoch->epoch & 1];
+	epoch->retiredPaths[epoch->epoch & 1] = path;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand an unlinked prefix node over to be freed when no reader can see it
+ * Input: epoch - the epoch structure of the attribute table
+ *		node - the prefix node
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+retirePrefixNode( RibEpoch *epoch, PrefixNode *node )
+{
+	node->next = epoch->retiredPrefixes[epoch->epoch & 1];
+	epoch->retiredPrefixes[epoch->epoch & 1] = node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the nodes retired in the previous epoch and move to the next 
+ *		epoch, if no reader is left in the previous epoch
+ * Input: session - the session structure that has the attribute and prefix tables
+ * Output: 1 if the epoch moved on, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+advanceRibEpoch( Session_structp session )
+{
+	AttrTable	*attrTable = session->attributeTable;
+	RibEpoch	*epoch = &attrTable->epoch;
+	u_int32_t	previous = (epoch->epoch + 1) & 1;
+	AttrNode	*attrNode;
+	ASPath		*path;
+	PrefixNode	*prefixNode;
+
+	if( __atomic_load_n(&epoch->readers[previous], __ATOMIC_SEQ_CST) != 0 )
+		return 0;
+
+	// the readers of the current epoch entered after these nodes were unlinked
+	while( (attrNode = epoch->retiredAttrs[previous]) != NULL )
+	{
+		epoch->retiredAttrs[previous] = attrNode->retiredNext;
+		ribArenaFree(&attrTable->arena, attrNode, sizeof(AttrNode) + attrNode->totalAttrLen, session);
+	}
+	while( (path = epoch->retiredPaths[previous]) != NULL )
+	{
+		epoch->retiredPaths[previous] = path->retiredNext;
+		ribArenaFree(&attrTable->arena, path, sizeof(ASPath) + path->asPathData.len, session);
+	}
+	while( (prefixNode = epoch->retiredPrefixes[previous]) != NULL )
+	{
+		epoch->retiredPrefixes[previous] = prefixNode->next;
+		freePrefixNode(session->prefixTable, prefixNode);
+	}
+
+	// the retired list of the previous epoch is the list of the next one
+	__atomic_store_n(&epoch->epoch, epoch->epoch + 1, __ATOMIC_SEQ_CST);
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Wait until the readers that may see the retired nodes are gone, and 
+ *		free all the retired nodes
+ * Input: session - the session structure that has the attribute and prefix tables
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+synchronizeRibEpoch( Session_structp session )
+{
+	int advanced = 0;
+
+	// the first step frees the previous epoch, the second one the current epoch
+	while( advanced < 2 )
+	{
+		if( advanceRibEpoch(session) )
+			advanced++;
+		else
+			usleep(1000);
+	}
+}
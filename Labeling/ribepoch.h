@@ -0,0 +1,93 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: ribepoch.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef RIBEPOCH_H_
+#define RIBEPOCH_H_
+
+#include "rtable.h"
+#include "../Peering/peersession.h"
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the epoch of an attribute table
+ * Input: epoch - the epoch structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void initRibEpoch( RibEpoch *epoch );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Start a read section, the nodes reachable from the attribute table
+ *		are not freed until the section ends
+ * Input: epoch - the epoch structure of the attribute table
+ * Output: the epoch the reader entered, to pass to exitRibEpoch
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int32_t enterRibEpoch( RibEpoch *epoch );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Finish a read section
+ * Input: epoch - the epoch structure of the attribute table
+ *		entered - the epoch returned by enterRibEpoch
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void exitRibEpoch( RibEpoch *epoch, u_int32_t entered );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand an unlinked node over to be freed when no reader can see it,
+ *		only called by the labeling worker of the session
+ * Input: epoch - the epoch structure of the attribute table
+ *		node - the attribute node, AS path or prefix node
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void retireAttrNode( RibEpoch *epoch, AttrNode *node );
+void retireASPath( RibEpoch *epoch, ASPath *path );
+void retirePrefixNode( RibEpoch *epoch, PrefixNode *node );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the nodes retired in the previous epoch and move to the next 
+ *		epoch, if no reader is left in the previous epoch
+ * Input: session - the session structure that has the attribute and prefix tables
+ * Output: 1 if the epoch moved on, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int advanceRibEpoch( Session_structp session );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Wait until the readers that may see the retired nodes are gone, and 
+ *		free all the retired nodes
+ * Input: session - the session structure that has the attribute and prefix tables
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void synchronizeRibEpoch( Session_structp session );
+
+#endif /*RIBEPOCH_H_*/
@@ -0,0 +1,492 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: ribsnapshot.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "ribsnapshot.h"
+#include "ribepoch.h"
+#include "myhash.h"
+#include "labelinternal.h"
+#include "../Util/log.h"
+
+//#define DEBUG
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the snapshots of an attribute table
+ * Input: snapshots - the snapshot structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+initRibSnapshots( RibSnapshots *snapshots )
+{
+	memset(snapshots, 0, sizeof(RibSnapshots));
+	snapshots->deltaBase = RIB_NO_DELTA_BASE;
+	snapshots->purgedBase = RIB_NO_DELTA_BASE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Open a snapshot of the rib, the prefixes removed from now on stay 
+ *		readable until the snapshot is closed
+ * Input: attrTable - the attribute table of the session
+ * Output: the version of the rib the snapshot reads
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int64_t
+openRibSnapshot( AttrTable *attrTable )
+{
+	// counted before the version is read, so the labeling worker either sees the
+	// snapshot and keeps the removed nodes, or unlinks nodes removed up to the version read here
+	__atomic_add_fetch(&(attrTable->snapshots.open), 1, __ATOMIC_SEQ_CST);
+	return __atomic_load_n(&(attrTable->snapshots.version), __ATOMIC_SEQ_CST);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Close a snapshot of the rib
+ * Input: attrTable - the attribute table of the session
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+closeRibSnapshot( AttrTable *attrTable )
+{
+	__atomic_sub_fetch(&(attrTable->snapshots.open), 1, __ATOMIC_SEQ_CST);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if a prefix is in the rib at a version
+ * Input: node - the prefix node, read from the prefix list of an attribute node
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if the prefix is in the snapshot, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+isPrefixInRibSnapshot( PrefixNode *node, u_int64_t version )
+{
+	u_int64_t removed = __atomic_load_n(&(node->removedVersion), __ATOMIC_RELAXED);
+
+	// addedVersion is set before the node is published on the prefix list
+	return node->addedVersion <= version && (removed == 0 || removed > version);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if a prefix was added to the rib between two versions and is 
+ *		still in it
+ * Input: node - the prefix node, read from the prefix list of an attribute node
+ *		since - the version of the previous transfer, 0 for a full transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if the prefix is sent by a transfer of the changes since since, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+isPrefixInRibDelta( PrefixNode *node, u_int64_t since, u_int64_t version )
+{
+	return node->addedVersion > since && isPrefixInRibSnapshot(node, version);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if an attribute node is used by a prefix added to the rib 
+ *		between two versions
+ * Input: node - the attribute node
+ *		since - the version of the previous transfer, 0 for a full transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if a prefix of the delta uses the node, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+isAttrInRibDelta( AttrNode *node, u_int64_t since, u_int64_t version )
+{
+	PrefixNode *prefixNode;
+
+	prefixNode = __atomic_load_n(&(node->prefixList), __ATOMIC_ACQUIRE);
+	while( prefixNode != NULL )
+	{
+		if( isPrefixInRibDelta(prefixNode, since, version) )
+			return 1;
+		prefixNode = __atomic_load_n(&(prefixNode->attrNext), __ATOMIC_ACQUIRE);
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if a prefix was withdrawn from the rib between two versions. 
+ *		A prefix that moved to another attribute node is not withdrawn, the
+ *		transfer sends it with its new attributes.
+ * Input: node - the prefix node, read from the prefix list of an attribute node
+ *		since - the version of the previous transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if the prefix is withdrawn by a transfer of the changes since since, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+isPrefixWithdrawnInRibDelta( PrefixNode *node, u_int64_t since, u_int64_t version )
+{
+	u_int64_t removed = __atomic_load_n(&(node->removedVersion), __ATOMIC_RELAXED);
+
+	// replaced is set before removedVersion
+	return removed > since && removed <= version && node->replaced == 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the version the next delta transfer of a session starts from
+ * Input: attrTable - the attribute table of the session
+ * Output: the version, RIB_NO_DELTA_BASE if the next transfer must be a full one
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int64_t
+getRibDeltaBase( AttrTable *attrTable )
+{
+	return __atomic_load_n(&(attrTable->snapshots.deltaBase), __ATOMIC_SEQ_CST);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Set the version the next delta transfer of a session starts from, the
+ *		prefixes removed after it are kept until the base moves on
+ * Input: attrTable - the attribute table of the session
+ *		version - the version of the transfer just sent, RIB_NO_DELTA_BASE to 
+ *		keep no removed prefixes
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+setRibDeltaBase( AttrTable *attrTable, u_int64_t version )
+{
+	__atomic_store_n(&(attrTable->snapshots.deltaBase), version, __ATOMIC_SEQ_CST);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the number of bytes of a prefix key that identify the prefix
+ * Input: prefix - the prefix
+ * Output: the length of the afi, safi, prefix length and address bytes
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static u_int16_t
+ribPrefixKeyLen( Prefix *prefix )
+{
+	return sizeof(Prefix) + PREFIX_SIZE(prefix->addr.p_len);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a prefix to the announced set of a delta
+ * Input: delta - the delta
+ *		prefix - the prefix, followed by its address bytes
+ * Output: 1 if the prefix was added, 0 if it was in the set, -1 if the set could
+ *		not grow
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static int
+addRibDeltaAnnounced( RibDelta *delta, Prefix *prefix )
+{
+	RibPrefixKey	*slots, *slot;
+	u_int32_t	i, j, size, mask;
+	u_int16_t	len = ribPrefixKeyLen(prefix);
+
+	// keep the set at most half full
+	if( (delta->announcedCount + 1) * 2 > delta->announcedSize )
+	{
+		size = delta->announcedSize * 2;
+		slots = calloc(size, sizeof(RibPrefixKey));
+		if( slots == NULL )
+			return -1;
+		for( i = 0; i < delta->announcedSize; i++ )
+		{
+			slot = &(delta->announced[i]);
+			if( slot->keyPrefix.afi == 0 )
+				continue;
+			j = prefix_hash_value((u_char *)slot, ribPrefixKeyLen(&(slot->keyPrefix))) & (size - 1);
+			while( slots[j].keyPrefix.afi != 0 )
+				j = (j + 1) & (size - 1);
+			slots[j] = *slot;
+		}
+		free(delta->announced);
+		delta->announced = slots;
+		delta->announcedSize = size;
+	}
+
+	mask = delta->announcedSize - 1;
+	j = prefix_hash_value((u_char *)prefix, len) & mask;
+	while( delta->announced[j].keyPrefix.afi != 0 )
+	{
+		if( memcmp(&(delta->announced[j]), prefix, len) == 0 )
+			return 0;
+		j = (j + 1) & mask;
+	}
+	memcpy(&(delta->announced[j]), prefix, len);
+	delta->announcedCount++;
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add a prefix to the withdrawn prefixes of a delta
+ * Input: delta - the delta
+ *		prefix - the prefix, followed by its address bytes
+ * Output: 0 for success, -1 if the list could not grow
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static int
+addRibDeltaWithdrawn( RibDelta *delta, Prefix *prefix )
+{
+	RibPrefixKey	*keys;
+	u_int32_t	size;
+
+	if( delta->withdrawnCount == delta->withdrawnSize )
+	{
+		size = delta->withdrawnSize > 0 ? delta->withdrawnSize * 2 : RIB_DELTA_INIT_SIZE;
+		keys = realloc(delta->withdrawn, size * sizeof(RibPrefixKey));
+		if( keys == NULL )
+			return -1;
+		delta->withdrawn = keys;
+		delta->withdrawnSize = size;
+	}
+	memcpy(&(delta->withdrawn[delta->withdrawnCount]), prefix, ribPrefixKeyLen(prefix));
+	delta->withdrawnCount++;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Order prefix keys by afi and safi, so the withdrawals of an address 
+ *		family share messages
+ * Input: a, b - the prefix keys
+ * Output: the qsort order
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static int
+compareRibPrefixKeys( const void *a, const void *b )
+{
+	const Prefix *pa = &(((const RibPrefixKey *)a)->keyPrefix);
+	const Prefix *pb = &(((const RibPrefixKey *)b)->keyPrefix);
+
+	if( pa->afi != pb->afi )
+		return pa->afi < pb->afi ? -1 : 1;
+	if( pa->safi != pb->safi )
+		return pa->safi < pb->safi ? -1 : 1;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Collect the prefixes withdrawn from the rib between two versions. A prefix 
+ *		removed several times is withdrawn once, and a prefix also sent by the 
+ *		delta is not withdrawn at all. The prefixes are copied since the nodes
+ *		may be freed once the read section of their bucket ends.
+ * Input: attrTable - the attribute table of the session, a snapshot of version is open
+ *		delta - the delta to fill in
+ *		since - the version of the previous transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 0 for success, -1 if the memory ran out, the delta is freed then
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+collectRibDelta( AttrTable *attrTable, RibDelta *delta, u_int64_t since, u_int64_t version )
+{
+	u_int32_t	i, count, epoch;
+	AttrNode	*node;
+	PrefixNode	*prefixNode;
+	int		failed = 0;
+
+	memset(delta, 0, sizeof(RibDelta));
+	delta->announced = calloc(RIB_DELTA_INIT_SIZE, sizeof(RibPrefixKey));
+	if( delta->announced == NULL )
+		return -1;
+	delta->announcedSize = RIB_DELTA_INIT_SIZE;
+
+	beginAttrTableWalk(attrTable);
+	for( i = 0; i < attrTable->tableSize && !failed; i++ )
+	{
+		epoch = enterRibEpoch(&(attrTable->epoch));
+		node = __atomic_load_n(&(attrTable->attrEntries[i].node), __ATOMIC_ACQUIRE);
+		while( node != NULL && !failed )
+		{
+			prefixNode = __atomic_load_n(&(node->prefixList), __ATOMIC_ACQUIRE);
+			while( prefixNode != NULL && !failed )
+			{
+				if( isPrefixInRibDelta(prefixNode, since, version) )
+					failed = addRibDeltaAnnounced(delta, &(prefixNode->keyPrefix)) == -1;
+				else if( isPrefixWithdrawnInRibDelta(prefixNode, since, version) )
+					failed = addRibDeltaWithdrawn(delta, &(prefixNode->keyPrefix)) == -1;
+				prefixNode = __atomic_load_n(&(prefixNode->attrNext), __ATOMIC_ACQUIRE);
+			}
+			node = __atomic_load_n(&(node->next), __ATOMIC_ACQUIRE);
+		}
+		exitRibEpoch(&(attrTable->epoch), epoch);
+	}
+	endAttrTableWalk(attrTable);
+
+	// a prefix in the rib at version was added after since, so it is in the announced set,
+	// adding the withdrawn prefixes to the set keeps the ones neither sent nor seen before
+	count = 0;
+	for( i = 0; i < delta->withdrawnCount && !failed; i++ )
+	{
+		switch( addRibDeltaAnnounced(delta, &(delta->withdrawn[i].keyPrefix)) )
+		{
+			case 1:
+				delta->withdrawn[count++] = delta->withdrawn[i];
+				break;
+			case -1:
+				failed = 1;
+				break;
+		}
+	}
+	if( failed )
+	{
+		freeRibDelta(delta);
+		return -1;
+	}
+	delta->withdrawnCount = count;
+	qsort(delta->withdrawn, count, sizeof(RibPrefixKey), compareRibPrefixKeys);
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the prefixes collected for a delta transfer
+ * Input: delta - the delta
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+freeRibDelta( RibDelta *delta )
+{
+	free(delta->announced);
+	free(delta->withdrawn);
+	memset(delta, 0, sizeof(RibDelta));
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the version the update being applied to the rib creates
+ * Input: attrTable - the attribute table of the session
+ * Output: the version to stamp the added and removed prefixes with
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int64_t
+nextRibVersion( AttrTable *attrTable )
+{
+	// only the labeling worker of the session changes the version
+	return attrTable->snapshots.version + 1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node that was taken out of the prefix table from the 
+ *		rib, it stays on the prefix list of its attribute node until no snapshot
+ *		reads it
+ * Input: session - the session structure
+ *		node - the prefix node
+ *		replaced - TRUE if the prefix moved to another attribute node
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+removeRibPrefix( Session_structp session, PrefixNode *node, int replaced )
+{
+	RibSnapshots *snapshots = &(session->attributeTable->snapshots);
+
+	node->replaced = replaced;
+	__atomic_store_n(&(node->removedVersion), nextRibVersion(session->attributeTable), __ATOMIC_RELEASE);
+	node->next = snapshots->removedPrefixes;
+	snapshots->removedPrefixes = node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove an attribute node nobody uses from the rib, it stays in its
+ *		bucket until no snapshot reads it, and is kept if a prefix uses it again
+ * Input: session - the session structure
+ *		node - the attribute node, its reference count is 0
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+removeRibAttr( Session_structp session, AttrNode *node )
+{
+	RibSnapshots *snapshots = &(session->attributeTable->snapshots);
+
+	if( node->unlinkPending )
+		return;
+	node->unlinkPending = 1;
+	node->retiredNext = snapshots->removedAttrs;
+	snapshots->removedAttrs = node;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Finish the update applied to the rib, the snapshots opened from now on
+ *		read its version. If no snapshot is open the removed nodes are unlinked 
+ *		and retired, except for the prefixes removed after the delta base and 
+ *		the attribute nodes that list them.
+ * Input: session - the session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+commitRibVersion( Session_structp session )
+{
+	AttrTable		*attrTable = session->attributeTable;
+	RibSnapshots	*snapshots = &(attrTable->snapshots);
+	PrefixNode		*prefixNode, **prefixLink;
+	AttrNode		*attrNode, **attrLink;
+	u_int64_t		base;
+
+	__atomic_store_n(&(snapshots->version), snapshots->version + 1, __ATOMIC_SEQ_CST);
+
+	// a snapshot opened from now on reads the new version, the removed nodes are not in it,
+	// with a delta base the nodes are kept until the base moves on
+	base = __atomic_load_n(&(snapshots->deltaBase), __ATOMIC_SEQ_CST);
+	if( __atomic_load_n(&(snapshots->open), __ATOMIC_SEQ_CST) == 0 
+		&& (base == RIB_NO_DELTA_BASE || base != snapshots->purgedBase) )
+	{
+		// the prefixes are newest first, the ones removed after the base stay
+		prefixLink = &(snapshots->removedPrefixes);
+		while( *prefixLink != NULL && (*prefixLink)->removedVersion > base )
+			prefixLink = &((*prefixLink)->next);
+		while( (prefixNode = *prefixLink) != NULL )
+		{
+			*prefixLink = prefixNode->next;
+			if( removePefixFomAttr(prefixNode, prefixNode->dataAttr, session) )
+				log_err("Failed to remove a prefix fom a attribute.");
+			retirePrefixNode(&(attrTable->epoch), prefixNode);
+		}
+		attrLink = &(snapshots->removedAttrs);
+		while( (attrNode = *attrLink) != NULL )
+		{
+			// the node still lists prefixes kept for the next delta transfer
+			if( attrNode->refCount == 0 && attrNode->prefixList != NULL )
+			{
+				attrLink = &(attrNode->retiredNext);
+				continue;
+			}
+			*attrLink = attrNode->retiredNext;
+			attrNode->retiredNext = NULL;
+			attrNode->unlinkPending = 0;
+			// the node may be used again since it was removed
+			if( attrNode->refCount == 0 && removeAttrNode(attrNode, session) )
+				log_err("Failed to remove given attr from attr table");
+		}
+		snapshots->purgedBase = base;
+	}
+	advanceRibEpoch(session);
+}
@@ -0,0 +1,186 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: ribsnapshot.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef RIBSNAPSHOT_H_
+#define RIBSNAPSHOT_H_
+
+#include "rtable.h"
+#include "../Peering/peersession.h"
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the snapshots of an attribute table
+ * Input: snapshots - the snapshot structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void initRibSnapshots( RibSnapshots *snapshots );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Open a snapshot of the rib, the prefixes removed from now on stay 
+ *		readable until the snapshot is closed
+ * Input: attrTable - the attribute table of the session
+ * Output: the version of the rib the snapshot reads
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int64_t openRibSnapshot( AttrTable *attrTable );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Close a snapshot of the rib
+ * Input: attrTable - the attribute table of the session
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void closeRibSnapshot( AttrTable *attrTable );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if a prefix is in the rib at a version
+ * Input: node - the prefix node, read from the prefix list of an attribute node
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if the prefix is in the snapshot, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int isPrefixInRibSnapshot( PrefixNode *node, u_int64_t version );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if a prefix was added to the rib between two versions and is 
+ *		still in it
+ * Input: node - the prefix node, read from the prefix list of an attribute node
+ *		since - the version of the previous transfer, 0 for a full transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if the prefix is sent by a transfer of the changes since since, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int isPrefixInRibDelta( PrefixNode *node, u_int64_t since, u_int64_t version );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if an attribute node is used by a prefix added to the rib 
+ *		between two versions
+ * Input: node - the attribute node
+ *		since - the version of the previous transfer, 0 for a full transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if a prefix of the delta uses the node, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int isAttrInRibDelta( AttrNode *node, u_int64_t since, u_int64_t version );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if a prefix was withdrawn from the rib between two versions. 
+ *		A prefix that moved to another attribute node is not withdrawn, the
+ *		transfer sends it with its new attributes.
+ * Input: node - the prefix node, read from the prefix list of an attribute node
+ *		since - the version of the previous transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 1 if the prefix is withdrawn by a transfer of the changes since since, 0 otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int isPrefixWithdrawnInRibDelta( PrefixNode *node, u_int64_t since, u_int64_t version );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the version the next delta transfer of a session starts from
+ * Input: attrTable - the attribute table of the session
+ * Output: the version, RIB_NO_DELTA_BASE if the next transfer must be a full one
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int64_t getRibDeltaBase( AttrTable *attrTable );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Set the version the next delta transfer of a session starts from, the
+ *		prefixes removed after it are kept until the base moves on
+ * Input: attrTable - the attribute table of the session
+ *		version - the version of the transfer just sent, RIB_NO_DELTA_BASE to 
+ *		keep no removed prefixes
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void setRibDeltaBase( AttrTable *attrTable, u_int64_t version );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Collect the prefixes withdrawn from the rib between two versions. A prefix 
+ *		removed several times is withdrawn once, and a prefix also sent by the 
+ *		delta is not withdrawn at all.
+ * Input: attrTable - the attribute table of the session, a snapshot of version is open
+ *		delta - the delta to fill in
+ *		since - the version of the previous transfer
+ *		version - the version returned by openRibSnapshot
+ * Output: 0 for success, -1 if the memory ran out, the delta is freed then
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int collectRibDelta( AttrTable *attrTable, RibDelta *delta, u_int64_t since, u_int64_t version );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the prefixes collected for a delta transfer
+ * Input: delta - the delta
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void freeRibDelta( RibDelta *delta );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the version the update being applied to the rib creates
+ * Input: attrTable - the attribute table of the session
+ * Output: the version to stamp the added and removed prefixes with
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+u_int64_t nextRibVersion( AttrTable *attrTable );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove a prefix node that was taken out of the prefix table from the 
+ *		rib, it stays on the prefix list of its attribute node until no snapshot
+ *		reads it
+ * Input: session - the session structure
+ *		node - the prefix node
+ *		replaced - TRUE if the prefix moved to another attribute node
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void removeRibPrefix( Session_structp session, PrefixNode *node, int replaced );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Remove an attribute node nobody uses from the rib, it stays in its
+ *		bucket until no snapshot reads it, and is kept if a prefix uses it again
+ * Input: session - the session structure
+ *		node - the attribute node, its reference count is 0
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void removeRibAttr( Session_structp session, AttrNode *node );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Finish the update applied to the rib, the snapshots opened from now on
+ *		read its version. If no snapshot is open the removed nodes are unlinked 
+ *		and retired, except for the prefixes removed after the delta base and 
+ *		the attribute nodes that list them.
+ * Input: session - the session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void commitRibVersion( Session_structp session );
+
+#endif /*RIBSNAPSHOT_H_*/
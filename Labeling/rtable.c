@@ -40,6 +40,11 @@
 #include <pthread.h>
 
 #include "rtable.h"
+#include "prefixtable.h"
+#include "prefixtrie.h"
+#include "ribarena.h"
+#include "ribepoch.h"
+#include "ribsnapshot.h"
 #include "label.h"
 #include "labelutils.h"
 #include "../Util/log.h"
@@ -56,49 +61,49 @@
 
 //#define DEBUG
 
-#define PREFIX_SIZE(x) ((x/8)*8 == x)?x/8:x/8+1
 #define MAXV(x, y) (x>y)?x:y
 
-static u_char buffer[MAX_BGP_MESSAGE_LEN];
-static u_char buffer1[MAX_BGP_MESSAGE_LEN];
 
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Create a prefix table for a session
  * Input: sessionID -  the ID of the session
- *		prefixTableSize - size(#buckets) of prefix table
- *		maxCollision -  max number of hash collisions 
+ *		prefixTableSize - initial size(#slots) of prefix table, rounded up to a power of 2
+ *		maxCollision -  max probe length before the table grows 
  * Output:
  * He Yan @ June 15, 2008
  * -------------------------------------------------------------------------------------*/ 
 void createPrefixTable(int sessionID, u_int32_t prefixTableSize, u_int16_t  maxCollision) 
 {
-	u_int32_t i;
+	u_int32_t tableSize = 1;
 
 	Session_structp session = Sessions[sessionID];
 	assert(session->prefixTable == NULL);
 	
 	/*Allocation Memory*/
-	session->prefixTable = malloc(sizeof(struct PrefixTableStruct));
+	session->prefixTable = calloc(1, sizeof(struct PrefixTableStruct));
 
 	if( session->prefixTable )
 	{
+		/* the slot index is taken from the low bits of the hash value */
+		while( tableSize < prefixTableSize )
+			tableSize *= 2;
+
 		/* Initialize prefix table */
-		session->prefixTable->tableSize = prefixTableSize; 
+		session->prefixTable->tableSize = tableSize; 
 		session->prefixTable->prefixCount = 0;
-		session->prefixTable->ocupiedSize = 0;
-		session->prefixTable->maxNodeCount = 0;
+		session->prefixTable->maxProbe = 0;
 		session->prefixTable->maxCollision = maxCollision;
-		session->prefixTable->prefixEntries = calloc (prefixTableSize, sizeof(PrefixEntry));
+		session->prefixTable->slots = calloc (tableSize, sizeof(PrefixSlot));
 	
-		if (session->prefixTable->prefixEntries == NULL) 
+		if (session->prefixTable->slots == NULL) 
 	  		log_fatal( "createPrefixTable: session %d calloc failed", sessionID );
+		if( pthread_rwlock_init(&(session->prefixTable->lock), NULL) )
+			log_fatal( "createPrefixTable: session %d failed to init the lock", sessionID );
 		
-		for (i=0; i<session->prefixTable->tableSize; i++) {
-		  session->prefixTable->prefixEntries[i].nodeCount = 0;
-		  session->prefixTable->prefixEntries[i].node = NULL;
-		}   
-		session->stats.memoryUsed += sizeof(PrefixTable) + prefixTableSize*sizeof(PrefixEntry);
+		session->stats.memoryUsed += sizeof(PrefixTable) + tableSize*sizeof(PrefixSlot);
+		session->stats.prefixTableSize = tableSize;
+		session->stats.prefixMaxProbe = 0;
 		log_msg( "createPrefixTable: session %d successfully", session->sessionID);
 	}
 	else
@@ -115,8 +120,8 @@ void printPrefixTable(Session_structp session)
 {
 	log_msg("prefix table size: %d", session->prefixTable->tableSize);
 	log_msg("prefix table attrCount: %d", session->prefixTable->prefixCount);
-	log_msg("prefix table occupied size: %d", session->prefixTable->ocupiedSize);
-	log_msg("prefix table max nodeCount: %d", session->prefixTable->maxNodeCount);
+	log_msg("prefix table old size: %d", session->prefixTable->oldTableSize);
+	log_msg("prefix table max probe: %d", session->prefixTable->maxProbe);
 	log_msg("prefix table max collision: %d", session->prefixTable->maxCollision);
 }
 
@@ -129,39 +134,23 @@ void printPrefixTable(Session_structp session)
  * -------------------------------------------------------------------------------------*/
 int destroyPrefixTable ( PrefixTable *prefixTable, Session_structp session )
 {
-	u_int32_t      i, prefixCount = 0;
-	PrefixNode    *prefixNode;
-	PrefixNode    *nextPrefixNode;
+	u_int32_t      prefixCount, expectedCount;
+	int            error;
 
 	if( prefixTable == NULL)
 		return -1;
 	
-	for( i=0; i< prefixTable->tableSize; i++ ) 
-	{
-		if (prefixTable->prefixEntries[i].node != NULL) 
-		{
-			prefixNode = prefixTable->prefixEntries[i].node;
-			while (prefixNode != NULL) 
-			{
-				nextPrefixNode = prefixNode->next;
-				session->stats.memoryUsed -= ( sizeof(PrefixNode) + (PREFIX_SIZE(prefixNode->keyPrefix.addr.p_len)) ); 
-				free(prefixNode);
-				prefixCount++;
-				prefixNode = nextPrefixNode;
-			}
-	  	}
-	    prefixTable->prefixEntries[i].nodeCount= 0;
-	    prefixTable->prefixEntries[i].node = NULL;
-	}
+	if( (error = pthread_rwlock_wrlock(&(prefixTable->lock))) > 0 )
+		log_fatal( "Failed to wrlock the prefix table: %s", strerror(error) );
+	expectedCount = prefixTable->prefixCount;
+	prefixCount = clearPrefixTable(prefixTable, session);
+	pthread_rwlock_unlock(&(prefixTable->lock));
 
-	if( prefixTable->prefixCount != prefixCount)
+	if( expectedCount != prefixCount)
 	{
-		log_err("prefixTable's prefix count(%d) != actual prefix count(%d)", prefixTable->prefixCount, prefixCount);
+		log_err("prefixTable's prefix count(%d) != actual prefix count(%d)", expectedCount, prefixCount);
 		return -1;
 	}
-	prefixTable->prefixCount= 0;
-	prefixTable->ocupiedSize= 0;
-	prefixTable->maxNodeCount= 0;
 
 	return 0;
 }
@@ -177,7 +166,7 @@ int destroyPrefixTable ( PrefixTable *prefixTable, Session_structp session )
 void createAttributeTable(int sessionID, u_int32_t attributeTableSize, u_int16_t  maxCollision) 
 {
 	u_int32_t i;
-	int error;
+	u_int32_t tableSize = 1;
 
 	Session_structp session = Sessions[sessionID];
 	assert(session->attributeTable== NULL);
@@ -187,11 +176,23 @@ void createAttributeTable(int sessionID, u_int32_t attributeTableSize, u_int16_t
 
 	if( session->attributeTable )
 	{
+		/* the bucket is taken from the low bits of the fingerprint */
+		while( tableSize < attributeTableSize )
+			tableSize *= 2;
+		attributeTableSize = tableSize;
+
 		session->attributeTable->tableSize = attributeTableSize;
 		session->attributeTable->attrCount = 0;
 		session->attributeTable->ocupiedSize = 0;
 		session->attributeTable->maxNodeCount = 0;  
 		session->attributeTable->maxCollision = maxCollision;
+		session->attributeTable->walkers = 0;
+		session->attributeTable->closing = FALSE;
+		initRibArena(&(session->attributeTable->arena));
+		initRibEpoch(&(session->attributeTable->epoch));
+		initRibSnapshots(&(session->attributeTable->snapshots));
+		if( pthread_mutex_init(&(session->attributeTable->walkLock), NULL) )
+			log_fatal( "createAttributeTable: session %d failed to init the walk lock", session->sessionID );
 		session->attributeTable->attrEntries = calloc(attributeTableSize, sizeof(AttrEntry));
 		if (session->attributeTable->attrEntries == NULL) 
 		  log_fatal( "createAttributeTable: session %d calloc failed", session->sessionID);
@@ -200,8 +201,6 @@ void createAttributeTable(int sessionID, u_int32_t attributeTableSize, u_int16_t
 		{
 			session->attributeTable->attrEntries[i].nodeCount = 0;
 			session->attributeTable->attrEntries[i].node = NULL;
- 			if ((error = pthread_rwlock_init(&(session->attributeTable->attrEntries[i].lock), NULL)) > 0)       
-		     	log_fatal("createAttributeTable: session %d failed to init rwlock: %s\n", session->sessionID, strerror(error));    			
 		}
 		
 		session->stats.memoryUsed += sizeof(AttrTable) + attributeTableSize*sizeof(AttrEntry);
@@ -219,12 +218,13 @@ void createAttributeTable(int sessionID, u_int32_t attributeTableSize, u_int16_t
  * -------------------------------------------------------------------------------------*/ 
 void printAttrTable( Session_structp session )
 {
-	int i,j;
+	int i;
 	log_msg("attribute table size: %d", session->attributeTable->tableSize);
 	log_msg("attribute table attrCount: %d", session->attributeTable->attrCount);
 	log_msg("attribute table occupied size: %d", session->attributeTable->ocupiedSize);
 	log_msg("attribute table max nodeCount: %d", session->attributeTable->maxNodeCount);
 	log_msg("attribute table max collision: %d", session->attributeTable->maxCollision);
+	log_msg("attribute table arena in use: %ld", session->attributeTable->arena.inUse);
 	log_msg("withdraw updates: %d", session->stats.withRcvd);
 	log_msg("duplicate withdraw updates: %d", session->stats.duwiRcvd);
 	log_msg("new updates: %d", session->stats.nannRcvd);
@@ -233,76 +233,24 @@ void printAttrTable( Session_structp session )
 	log_msg("spath updates: %d", session->stats.spathRcvd);
 
 	int asPathCount = 0;
+	AttrNode *attrNode, *prevNode;
 	for(i=0; i<session->attributeTable->tableSize; i++)
 	{
-		if( session->attributeTable->attrEntries[i].nodeCount > 0 )
-		{
-			//log_msg("attribute hash bucket %d: collision %d", i, session->attributeTable->attrEntries[i].nodeCount);
-			int *tmpArray = malloc(sizeof(int)*session->attributeTable->attrEntries[i].nodeCount);
-			memset(tmpArray, 0, session->attributeTable->attrEntries[i].nodeCount);
-			
-			for(j=0; j<session->attributeTable->attrEntries[i].nodeCount; j++)
-			{	
-				struct AttrNodeStruct	*attrNode = session->attributeTable->attrEntries[i].node;
-				tmpArray[attrNode->asPath->asPathID] = 1;
-				//printASPath(attrNode->asPath->asPathData.data);
-				//log_msg("node %d of bucket %d: AS PATH(id %d): %s", 
-					//j, session->attributeTable->attrEntries[i].node->bucketIndex, attrNode->asPath->asPathID, asBuffer);	
-				attrNode = attrNode->next;			
-			}
-
-			for(j=0; j<session->attributeTable->attrEntries[i].nodeCount; j++)
+		// the nodes sharing an AS path are in the same bucket, count each AS path once
+		for(attrNode = session->attributeTable->attrEntries[i].node; attrNode != NULL; attrNode = attrNode->next)
+		{	
+			for(prevNode = session->attributeTable->attrEntries[i].node; prevNode != attrNode; prevNode = prevNode->next)
 			{
-				if(tmpArray[j] == 1)
-					asPathCount++;
+				if( prevNode->asPath == attrNode->asPath )
+					break;
 			}
-			free(tmpArray);
-                        tmpArray = NULL;
+			if( prevNode == attrNode )
+				asPathCount++;
 		}
 	}
 	log_msg("attribute table AS Path Count: %d", asPathCount);
 }
 
-/*--------------------------------------------------------------------------------------
- * Purpose: Destory a attribute node
- * Input:	attrNode - pointer to the attribute node needed to be deleted
- *		session - the corresponding session structure which includes the attribute table
- * Output:
- * He Yan @ June 15, 2008
- * -------------------------------------------------------------------------------------*/ 
-void destroyAttrNode ( AttrNode *attrNode, Session_structp session )
-{
-	int error;
-  	if( (error = pthread_rwlock_wrlock (&(attrNode->lock))) > 0 ) 
-	{
-    	log_fatal ("Failed to wrlock an entry in the rib table: %s", strerror(error));
-	}	
-	PrefixRefNode *prefixRefNode = NULL;
-	PrefixRefNode *nextPrefixRefNode = NULL;
-	prefixRefNode = attrNode->prefixRefNode;	
-	while( prefixRefNode != NULL )
-	{
-		nextPrefixRefNode = prefixRefNode->next;
-	 	free(prefixRefNode);
-	 	session->stats.memoryUsed -= sizeof(PrefixRefNode);
-	 	prefixRefNode = nextPrefixRefNode;	 	
-	}
-	pthread_rwlock_unlock(&(attrNode->lock));
-	if( (error = pthread_rwlock_destroy(&(attrNode->lock))) > 0 )       
-    	log_fatal("Failed to destroy rwlock: %s\n", strerror(error));  		
-	session->stats.memoryUsed -= (sizeof(AttrNode) + attrNode->totalAttrLen);
-	attrNode->asPath->refCount--;
-	if( attrNode->asPath->refCount == 0 )
-	{
-		free(attrNode->asPath->asPathData.data);
-                attrNode->asPath->asPathData.data = NULL;
-		free(attrNode->asPath);
-                attrNode->asPath = NULL;
-	}
-    free(attrNode);   
-}
-
-
 /*--------------------------------------------------------------------------------------
  * Purpose: Destory a attribute table
  * Input:	 attrTable - the pointer to a attribute table
@@ -313,35 +261,27 @@ void destroyAttrNode ( AttrNode *attrNode, Session_structp session )
 int destroyAttrTable ( AttrTable *attrTable, Session_structp session )
 {
 	u_int32_t      i, attrCount = 0;
-	AttrNode      *attrNode;
-	AttrNode      *nextAttrNode;
-	int error;
    
 	if( attrTable == NULL )
 	{
 		return -1;
 	}
+	// the removed nodes go with the tables, whatever snapshot is still open
+	attrTable->snapshots.removedPrefixes = NULL;
+	attrTable->snapshots.removedAttrs = NULL;
+
+	// unlink the buckets, the rib dumps that start from now on see an empty table
 	for (i=0; i<attrTable->tableSize; i++) 
 	{
-		attrNode = attrTable->attrEntries[i].node;
-		if( (error = pthread_rwlock_wrlock (&(attrTable->attrEntries[i].lock))) > 0 ) 
-		{
-			log_err ("Failed to wrlock an entry in the attribute table: %s", strerror(error));
-			return -1;
-		}      	
-
-		while (attrNode != NULL) 
-		{
-			nextAttrNode = attrNode->next;
-			destroyAttrNode (attrNode, session);
-			attrCount++;
-         	        attrNode = nextAttrNode;
-		}
+		attrCount += attrTable->attrEntries[i].nodeCount;
 		attrTable->attrEntries[i].nodeCount= 0;
-		attrTable->attrEntries[i].node= NULL;
-		pthread_rwlock_unlock(&(attrTable->attrEntries[i].lock));
+		__atomic_store_n(&(attrTable->attrEntries[i].node), NULL, __ATOMIC_RELEASE);
 	}
 
+	// wait for the rib dumps that may still read the old nodes and free the retired nodes,
+	// the rest of the nodes are released with the arena once the prefix table is gone
+	synchronizeRibEpoch(session);
+
    	// sanity check
 	if(attrTable->attrCount != attrCount)
 		return -1;
@@ -353,6 +293,23 @@ int destroyAttrTable ( AttrTable *attrTable, Session_structp session )
 	return 0;
 }
 
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add a prefix to the prefix reference list of a attribure node
+ * Input:	 prefixNode - the pointer to the prefix node to be added
+ *		 attrNode - the pointer to the attribute node the prefix node uses
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void addPrefixToAttr( PrefixNode *prefixNode, AttrNode *attrNode )
+{
+  prefixNode->attrNext = attrNode->prefixList;
+  if( attrNode->prefixList != NULL )
+    attrNode->prefixList->attrPrev = &(prefixNode->attrNext);
+  prefixNode->attrPrev = &(attrNode->prefixList);
+  // the rib dumps read the list without locks, publish the node once it is complete
+  __atomic_store_n(&(attrNode->prefixList), prefixNode, __ATOMIC_RELEASE);
+}
+
 /*----------------------------------------------------------------------------------------
  * Purpose: Remove a prefix from the prefix reference list of a attribure node
  * Input:	 prefixNode - the pointer to the prefix node to be deleted
@@ -363,28 +320,18 @@ int destroyAttrTable ( AttrTable *attrTable, Session_structp session )
  * -------------------------------------------------------------------------------------*/
 int removePefixFomAttr( PrefixNode *prefixNode, AttrNode *attrNode, Session_structp session )
 {
-  PrefixRefNode *prefixRefNode = NULL;
-  PrefixRefNode *prevNode = NULL;
-  prefixRefNode = prefixNode->dataAttr->prefixRefNode;	
-	   
-  while( prefixRefNode != NULL && prefixRefNode->prefixNode != prefixNode ){
-    prevNode = prefixRefNode;
-    prefixRefNode = prefixRefNode->next;
-  }
-
-  if( prefixRefNode == NULL ) {
+  // the prefix node knows the link that points at it, no need to walk the list
+  if( prefixNode->attrPrev == NULL ) {
 #ifdef DEBUG
 		log_err ("Try to remove a non-exist prefix_ref_node in attr node.");
 #endif 		
     return -1;
   }
-  if( prevNode == NULL ){ // the removed node is the first node in the link list 
-    prefixNode->dataAttr->prefixRefNode = prefixRefNode->next;
-  }else{
-    prevNode->next = prefixRefNode->next;   
-  }
-  free(prefixRefNode);
-  session->stats.memoryUsed -= sizeof(prefixRefNode);
+  // a rib dump standing on the node still finds the rest of the list through attrNext
+  __atomic_store_n(prefixNode->attrPrev, prefixNode->attrNext, __ATOMIC_RELEASE);
+  if( prefixNode->attrNext != NULL )
+    prefixNode->attrNext->attrPrev = prefixNode->attrPrev;
+  prefixNode->attrPrev = NULL;
   return 0;		
 }
 
@@ -403,7 +350,7 @@ int removeAttrNode( AttrNode *removedNode, Session_structp session )
 	prevNode = NULL;
 
 	/* search the attr node */
-	i = attr_hash(removedNode->asPath->asPathData.data, removedNode->asPath->asPathData.len, session->attributeTable->tableSize);      
+	i = removedNode->asPath->fingerprint & (session->attributeTable->tableSize - 1);
 	node =  session->attributeTable->attrEntries[i].node;
 	while (node != NULL && node != removedNode) 
 	{
@@ -427,12 +374,16 @@ int removeAttrNode( AttrNode *removedNode, Session_structp session )
 //#endif   
    assert (node != NULL);
    
+	/* the removed node keeps its next link for the rib dumps that still read it */
 	if (prevNode == NULL) /* the removed node is the first node in the link list */ 
-		session->attributeTable->attrEntries[i].node = node->next;
+		__atomic_store_n(&(session->attributeTable->attrEntries[i].node), node->next, __ATOMIC_RELEASE);
 	else 
-		prevNode->next = node->next;   
+		__atomic_store_n(&(prevNode->next), node->next, __ATOMIC_RELEASE);
 
-	destroyAttrNode(node, session);
+	node->asPath->refCount--;
+	if( node->asPath->refCount == 0 )
+		retireASPath(&(session->attributeTable->epoch), node->asPath);
+	retireAttrNode(&(session->attributeTable->epoch), node);
         node = NULL;
 
 	if (session->attributeTable->attrEntries[i].node == NULL )
@@ -448,59 +399,162 @@ int removeAttrNode( AttrNode *removedNode, Session_structp session )
    return 0;
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Start a walk over the buckets of an attribute table, 
+ *		the table keeps its buckets until the walk is finished
+ * Input: attrTable - the attribute table
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void beginAttrTableWalk(AttrTable *attrTable)
+{
+	if( pthread_mutex_lock(&(attrTable->walkLock)) )
+		log_fatal( "Failed to lock the attribute table walk lock" );
+	attrTable->walkers++;
+	pthread_mutex_unlock(&(attrTable->walkLock));
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Finish a walk over the buckets of an attribute table
+ * Input: attrTable - the attribute table
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void endAttrTableWalk(AttrTable *attrTable)
+{
+	if( pthread_mutex_lock(&(attrTable->walkLock)) )
+		log_fatal( "Failed to lock the attribute table walk lock" );
+	attrTable->walkers--;
+	pthread_mutex_unlock(&(attrTable->walkLock));
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Tell the rib dumps walking an attribute table that it is about to be deleted
+ * Input: attrTable - the attribute table
+ * Output:
+ * Note: The table is deleted once the rib dumps release the rib lock of the session.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void closeAttrTableWalks(AttrTable *attrTable)
+{
+	__atomic_store_n(&(attrTable->closing), TRUE, __ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if an attribute table is about to be deleted
+ * Input: attrTable - the attribute table
+ * Output: TRUE if the rib dumps must stop walking it, FALSE otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int isAttrTableClosing(AttrTable *attrTable)
+{
+	return __atomic_load_n(&(attrTable->closing), __ATOMIC_ACQUIRE);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Double the number of buckets of an attribute table, unless a walk 
+ *		over the buckets is in progress
+ * Input: attrTable - the attribute table
+ *		session - the corresponding session structure
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static void growAttrTable(AttrTable *attrTable, Session_structp session)
+{
+	AttrEntry	*entries, *entry;
+	AttrNode	*node, *nextNode;
+	u_int32_t	i, tableSize, mask;
+
+	if( pthread_mutex_lock(&(attrTable->walkLock)) )
+		log_fatal( "Failed to lock the attribute table walk lock" );
+	// a rib dump holds on to the buckets, try again on a later insert
+	if( attrTable->walkers > 0 )
+	{
+		pthread_mutex_unlock(&(attrTable->walkLock));
+		return;
+	}
+
+	tableSize = attrTable->tableSize*2;
+	mask = tableSize - 1;
+	entries = calloc(tableSize, sizeof(AttrEntry));
+	if( entries == NULL )
+		log_fatal( "growAttrTable: session %d calloc failed", session->sessionID );
+
+	attrTable->ocupiedSize = 0;
+	attrTable->maxNodeCount = 0;
+	for( i = 0; i < attrTable->tableSize; i++ )
+	{
+		for( node = attrTable->attrEntries[i].node; node != NULL; node = nextNode )
+		{
+			nextNode = node->next;
+			entry = &entries[node->asPath->fingerprint & mask];
+			if( entry->node == NULL )
+				attrTable->ocupiedSize++;
+			node->next = entry->node;
+			entry->node = node;
+			entry->nodeCount++;
+			attrTable->maxNodeCount = MAXV(attrTable->maxNodeCount, entry->nodeCount);
+		}
+	}
+	free(attrTable->attrEntries);
+	session->stats.memoryUsed += attrTable->tableSize*sizeof(AttrEntry);
+	attrTable->attrEntries = entries;
+	attrTable->tableSize = tableSize;
+
+	pthread_mutex_unlock(&(attrTable->walkLock));
+	log_msg( "session %d attribute table grows to %u buckets", session->sessionID, tableSize );
+}
+
 /*----------------------------------------------------------------------------------------
  * Purpose: Create and Insert a new attr node into the given attr table
- * Input:   bucketIndex - the index of bucket the new node will stay
- *		  asPath - a pointer to a ASPath structure
+ * Input:   asPath - a pointer to a ASPath structure, it selects the bucket
  *		  attr - a pointer to the attributes(normal attrs + mp reach attributes(without mp NLRI))
  *		  totalAttrLen - the length of all the attributes
  *		  basicAttrLen - the length of the normal attributes
+ *		  fingerprint - the fingerprint of the attributes
  *		  session - the corresponding session structure
  * Output: success: the pointer to the new node
  *		   Failure: NULL
  * He Yan @ July 4th, 2008
  * -------------------------------------------------------------------------------------*/
-AttrNode * createAttrNode( INDEX bucketIndex, ASPath *asPath, u_char *attr, u_int16_t totalAttrLen, u_int16_t basicAttrLen, Session_structp session )
+AttrNode * createAttrNode( ASPath *asPath, u_char *attr, u_int16_t totalAttrLen, u_int16_t basicAttrLen, u_int64_t fingerprint, Session_structp session )
 {
    	AttrNode      *newNode = NULL;
-	int            error;
+	AttrEntry     *entry;
 
    	/* create a new node for the new attr */
-   	newNode = malloc(sizeof(AttrNode) + totalAttrLen);
-	if( newNode == NULL )
-	{
-		log_err( "createAttrNode: malloc failed" );
-		return NULL;
-	}
-	
-	session->stats.memoryUsed += (sizeof(AttrNode) + totalAttrLen);
+   	newNode = ribArenaAlloc(&(session->attributeTable->arena), sizeof(AttrNode) + totalAttrLen, session);
    	memcpy( newNode->attr, attr, totalAttrLen);
    	newNode->refCount = 0;
+   	newNode->unlinkPending = 0;
 	
-   	newNode->prefixRefNode = NULL;
-	if( (error = pthread_rwlock_init(&(newNode->lock), NULL)) > 0 )       
-    	log_fatal("createAttrNode: Failed to init rwlock: %s\n", strerror(error)); 
+   	newNode->prefixList = NULL;
+   	newNode->retiredNext = NULL;
 
 	newNode->asPath = asPath;
 	newNode->asPath->refCount++;
-	newNode->bucketIndex = bucketIndex;
+	newNode->fingerprint = fingerprint;
 	
    	newNode->totalAttrLen = totalAttrLen;
    	newNode->basicAttrLen = basicAttrLen;
 
-   	if( session->attributeTable->attrEntries[bucketIndex].node == NULL )
+	entry = &session->attributeTable->attrEntries[asPath->fingerprint & (session->attributeTable->tableSize - 1)];
+   	if( entry->node == NULL )
     	session->attributeTable->ocupiedSize++;
    
-   	newNode->next = session->attributeTable->attrEntries[bucketIndex].node;   //point to the head of current list   
-   	session->attributeTable->attrEntries[bucketIndex].node = newNode;         //make new node as the head of the list 
-   	session->attributeTable->attrEntries[bucketIndex].nodeCount++;
-   	session->attributeTable->maxNodeCount = MAXV(session->attributeTable->maxNodeCount, session->attributeTable->attrEntries[bucketIndex].nodeCount);
+   	newNode->next = entry->node;   //point to the head of current list   
+   	__atomic_store_n(&(entry->node), newNode, __ATOMIC_RELEASE);         //make new node as the head of the list 
+   	entry->nodeCount++;
+   	session->attributeTable->maxNodeCount = MAXV(session->attributeTable->maxNodeCount, entry->nodeCount);
    	if( session->attributeTable->maxNodeCount > session->attributeTable->maxCollision )
 	{
 		log_err("The maximum collision in the attribute hash table was reached.");
    	}   
    	session->attributeTable->attrCount++;
 	session->stats.attrCount++;
+
+	if( (u_int64_t)session->attributeTable->attrCount*100 > (u_int64_t)session->attributeTable->tableSize*ATTR_TABLE_MAX_LOAD )
+		growAttrTable(session->attributeTable, session);
    
    	return newNode;
 }
@@ -517,60 +571,58 @@ AttrNode * createAttrNode( INDEX bucketIndex, ASPath *asPath, u_char *attr, u_in
 AttrNode * searchAttrNode( u_char *asPathData, u_int16_t len, u_char *attr, u_int16_t totalAttrLen, u_int16_t basicAttrLen, Session_structp session )
 {
 	AttrNode		*node;
-	INDEX			i;
 	ASPath			*asPath;
-	i = attr_hash(asPathData, len, session->attributeTable->tableSize);
-	node = session->attributeTable->attrEntries[i].node;
+	ASPath			*existingAsPath = NULL;
+	u_int64_t		pathFingerprint, attrFingerprint;
 
-	int maxPathID = 0;
-	AttrNode	*tmpNode = NULL;
-	// if AS path of the 'node' is same as the new AS path specified by 'asPathData'
+	pathFingerprint = attr_fingerprint(asPathData, len);
+	attrFingerprint = attr_fingerprint(attr, totalAttrLen);
+	node = session->attributeTable->attrEntries[pathFingerprint & (session->attributeTable->tableSize - 1)].node;
+
+	// the fingerprints rule out almost all the other nodes of the bucket without reading their bytes
 	while( node != NULL )
 	{
 		// if AS paths are same, continue to check other attributes
-		if( len == node->asPath->asPathData.len && !memcmp(node->asPath->asPathData.data, asPathData, len)) 	
+		if( node->asPath->fingerprint == pathFingerprint && len == node->asPath->asPathData.len 
+			&& (node->asPath == existingAsPath || !memcmp(node->asPath->asPathData.data, asPathData, len)) ) 	
 		{
-			if( totalAttrLen == node->totalAttrLen && !memcmp(node->attr, attr, totalAttrLen))
+			if( node->fingerprint == attrFingerprint && totalAttrLen == node->totalAttrLen 
+				&& !memcmp(node->attr, attr, totalAttrLen) )
 			{
 				return node;
 			}
-			else
-			{
-				tmpNode = node;
-			}
+			existingAsPath = node->asPath;
 		}
-		if( maxPathID < node->asPath->asPathID )
-			maxPathID = node->asPath->asPathID;
      	node = node->next;   
 	}
 
-	if( tmpNode != NULL )
+	if( existingAsPath != NULL )
 	{
 		// create a new attr node with the existing ASPath
 #ifdef DEBUG
 		log_msg("--------------------------------");
 		hexdump (LOG_INFO, asPathData, len);
-		hexdump (LOG_INFO, tmpNode->asPath->asPathData.data, tmpNode->asPath->asPathData.len);
+		hexdump (LOG_INFO, existingAsPath->asPathData.data, existingAsPath->asPathData.len);
 		hexdump (LOG_INFO, attr, totalAttrLen);
-		hexdump (LOG_INFO, tmpNode->attr, tmpNode->totalAttrLen);
 #endif
-		ASPath *existingAsPath = tmpNode->asPath;
-		node =	createAttrNode(i, existingAsPath, attr, totalAttrLen, basicAttrLen, session);
+		node =	createAttrNode(existingAsPath, attr, totalAttrLen, basicAttrLen, attrFingerprint, session);
 		return node;
 	}
 	else
 	{
 		//if none of the attr nodes of this bucket has the same AS path specified by 'asPathData' or the bucket is empty
 		//create a new attr node with a new ASPath structure
-		asPath = malloc(sizeof(ASPath));
-		asPath->asPathData.data = malloc(sizeof(u_char)*len);
+		// the AS path data follows the ASPath structure
+		asPath = ribArenaAlloc(&(session->attributeTable->arena), sizeof(ASPath) + len, session);
+		asPath->asPathData.data = (u_char *)(asPath + 1);
 		asPath->asPathData.len = len;
 		memcpy( asPath->asPathData.data, asPathData, len);
-		asPath->asPathID = maxPathID;
+		asPath->fingerprint = pathFingerprint;
 		asPath->refCount = 0;
+		asPath->retiredNext = NULL;
 
 		// create the attr node			
-		node = createAttrNode(i, asPath, attr, totalAttrLen, basicAttrLen, session);
+		node = createAttrNode(asPath, attr, totalAttrLen, basicAttrLen, attrFingerprint, session);
 		return node;
 	}
 }
@@ -635,10 +687,10 @@ int parseBGPUpdate (void *rawBGPUpdate, u_int32_t len, ParsedBGPUpdate *parsedBG
 
 	/* initialize buffer */
 	mstream_init(&s, rawBGPUpdate+19, length);
-	memset (buffer, 0, MAX_BGP_MESSAGE_LEN);
-	mstream_init(&b, buffer, MAX_BGP_MESSAGE_LEN);
-	memset (buffer1, 0, MAX_BGP_MESSAGE_LEN);
-	mstream_init(&b1, buffer1, MAX_BGP_MESSAGE_LEN);	
+	memset (parsedBGPUpdate->buffer, 0, MAX_BGP_MESSAGE_LEN);
+	mstream_init(&b, parsedBGPUpdate->buffer, MAX_BGP_MESSAGE_LEN);
+	memset (parsedBGPUpdate->buffer1, 0, MAX_BGP_MESSAGE_LEN);
+	mstream_init(&b1, parsedBGPUpdate->buffer1, MAX_BGP_MESSAGE_LEN);	
 	
 	/* process IPv4 unicast unreach nlri */   
 	mstream_getw( &s, &parsedBGPUpdate->unreachNlri.nlriLen );   
@@ -1052,13 +1104,9 @@ char * printPrefix(u_char *prefix, u_int8_t len)
 int applyReachablePrefix (const Prefix *prefix, AttrNode *attrNode, u_int32_t originatedTS, Session_structp session, BMF bmf)
 {
    	PrefixNode   *prefixNode = NULL;
-   	INDEX          i;
-   	int            error;
+   	PrefixNode   *newPrefixNode = NULL;
 
-	i = prefix_hash((u_char *)prefix, (PREFIX_SIZE(prefix->addr.p_len))+sizeof(Prefix), session->prefixTable->tableSize);
-   	prefixNode = session->prefixTable->prefixEntries[i].node;
-   	while( prefixNode != NULL && memcmp(prefix, &(prefixNode->keyPrefix), (PREFIX_SIZE(prefix->addr.p_len))+sizeof(Prefix)) )
-		prefixNode = prefixNode->next;   
+   	prefixNode = findPrefixNode(session->prefixTable, prefix);
 
    	/* If the prefix is not existing in the rib table */
    	if( prefixNode == NULL ) 
@@ -1077,46 +1125,17 @@ int applyReachablePrefix (const Prefix *prefix, AttrNode *attrNode, u_int32_t or
 		session->stats.nannRcvd++;
 
 		/* Create and insert a new prefix node */
-		#ifdef DEBUG
-	    debug(__FUNCTION__, "Malloc a prefix node: %d %d %d", PREFIX_SIZE(prefix->addr.p_len), sizeof(PrefixNode), (PREFIX_SIZE(prefix->addr.p_len))+sizeof(PrefixNode));
-		#endif		
-	    prefixNode = malloc((PREFIX_SIZE(prefix->addr.p_len)) + sizeof(PrefixNode));  
-		session->stats.memoryUsed += (sizeof(PrefixNode) + (PREFIX_SIZE(prefix->addr.p_len)));
-		prefixNode->keyPrefix.afi = prefix->afi;
-	 	prefixNode->keyPrefix.safi = prefix->safi;
-		prefixNode->keyPrefix.addr.p_len = prefix->addr.p_len;
-	    memcpy( &(prefixNode->keyPrefix.addr.paddr), prefix->addr.paddr, PREFIX_SIZE(prefix->addr.p_len) );
+	    prefixNode = insertPrefixNode(session->prefixTable, prefix, session);
 	    prefixNode->dataAttr = attrNode;
 		prefixNode->originatedTS = originatedTS;
+		prefixNode->addedVersion = nextRibVersion(session->attributeTable);
+		prefixNode->removedVersion = 0;
+		insertPrefixTrie(session->prefixTable, prefixNode, session);
 
-		/* Create and insert a new prefix ref node in the prefix ref list of attribute node*/	
-		if( (error = pthread_rwlock_wrlock (&(attrNode->lock))) > 0 ) 
-		{
-			log_fatal ("Failed to wrlock an attribute node in the attribute table: %s", strerror(error));
-		}	
+		/* Insert the prefix in the prefix ref list of attribute node*/	
 	    attrNode->refCount++;
-		PrefixRefNode *newRefNode = NULL;
-		newRefNode = malloc(sizeof(PrefixRefNode));
-		session->stats.memoryUsed += sizeof(PrefixRefNode);
-		newRefNode->prefixNode = prefixNode;
-		newRefNode->next = attrNode->prefixRefNode;
-		attrNode->prefixRefNode = newRefNode;		    
-		pthread_rwlock_unlock(&(attrNode->lock));
-
-		/*Update the prefix entry*/
-	    if( session->prefixTable->prefixEntries[i].node == NULL )
-	    	session->prefixTable->ocupiedSize++;
-	    prefixNode->next = session->prefixTable->prefixEntries[i].node;
-	    session->prefixTable->prefixEntries[i].node = prefixNode;	      
-	    session->prefixTable->prefixEntries[i].nodeCount++;
-
-		/*Check if the max collision happens */
-	    session->prefixTable->maxNodeCount = MAXV(session->prefixTable->maxNodeCount, session->prefixTable->prefixEntries[i].nodeCount);
-	    if( session->prefixTable->maxNodeCount > session->prefixTable->maxCollision )
-		{
-	    	log_err("The maximum collision in the prefix hash table was reached.");
-	    }
-		session->prefixTable->prefixCount++;
+		addPrefixToAttr(prefixNode, attrNode);
+
 		session->stats.prefixCount++;
 	} 
 	/* If the prefix is already existing in the rib table */
@@ -1144,8 +1163,7 @@ int applyReachablePrefix (const Prefix *prefix, AttrNode *attrNode, u_int32_t or
     	}
 		
 		/* If the attributes are not same, then check the AS path to determine it is a DPATH or SPATH update */	   
-	    if( prefixNode->dataAttr->bucketIndex != attrNode->bucketIndex || 
-			prefixNode->dataAttr->asPath->asPathID != attrNode->asPath->asPathID )
+	    if( prefixNode->dataAttr->asPath != attrNode->asPath )
 	    {
 	    	#ifdef DEBUG
 		    debug (__FUNCTION__,  "Found a DPATH prefix.");
@@ -1174,38 +1192,30 @@ int applyReachablePrefix (const Prefix *prefix, AttrNode *attrNode, u_int32_t or
 			session->stats.spathRcvd++;
 		}
 
-		/* Remove the prefix from the prefix ref list of old attribute node */
-		if( (error = pthread_rwlock_wrlock (&(prefixNode->dataAttr->lock))) > 0 ) 
-		{
-			log_fatal ("Failed to wrlock an attribute node in the attribute table: %s", strerror(error));
-		}	
+		/* A rib dump may be walking the prefix list of the old attribute node, so the
+		   prefix moves to the new attribute node in a copy of its prefix node */
+		newPrefixNode = allocPrefixNode(session->prefixTable, session);
+		memcpy(&(newPrefixNode->keyPrefix), &(prefixNode->keyPrefix), sizeof(Prefix) + PREFIX_SIZE(prefixNode->keyPrefix.addr.p_len));
+		if( replacePrefixNode(session->prefixTable, prefixNode, newPrefixNode) )
+			log_fatal("Failed to replace a prefix node in the prefix table.");
+		replacePrefixTrie(session->prefixTable, prefixNode, newPrefixNode);
+
+		/* The old prefix node stays on the prefix ref list of the old attribute node
+		   for the rib snapshots taken before this update */
 		prefixNode->dataAttr->refCount--;
-		if( removePefixFomAttr(prefixNode, prefixNode->dataAttr, session) )
-			log_fatal("Failed to remove a prefix fom a attribute.");
-		pthread_rwlock_unlock(&(prefixNode->dataAttr->lock));
+		removeRibPrefix(session, prefixNode, TRUE);
 		  	
 	    /* If the old attribute node is not used by any prefixes, delete it*/    
 	    if( prefixNode->dataAttr->refCount == 0 ) 
-		{
-			if( removeAttrNode( prefixNode->dataAttr, session ) ) 
-					log_err ("Failed to remove given attr from attr table");
-	    }
+			removeRibAttr(session, prefixNode->dataAttr);
 
 		/* Add the prefix to the prefix ref list of new attribute node */
-		if( (error = pthread_rwlock_wrlock (&(attrNode->lock))) > 0 ) 
-		{
-			log_fatal ("Failed to wrlock an attribute node in the attribute table: %s", strerror(error));
-		}	      
-	    prefixNode->dataAttr= attrNode;
-		prefixNode->originatedTS = originatedTS;
+	    newPrefixNode->dataAttr= attrNode;
+		newPrefixNode->originatedTS = originatedTS;
+		newPrefixNode->addedVersion = nextRibVersion(session->attributeTable);
+		newPrefixNode->removedVersion = 0;
 	    attrNode->refCount++;
-	    PrefixRefNode *newRefNode = NULL;
-	    newRefNode = malloc(sizeof(PrefixRefNode));
-		session->stats.memoryUsed += sizeof(PrefixRefNode);
-	    newRefNode->prefixNode = prefixNode;
-	    newRefNode->next = attrNode->prefixRefNode;
-	    attrNode->prefixRefNode = newRefNode;    
-		pthread_rwlock_unlock(&(attrNode->lock));	
+	    addPrefixToAttr(newPrefixNode, attrNode);
 	}
 	return 0;
 }
@@ -1221,20 +1231,10 @@ int applyReachablePrefix (const Prefix *prefix, AttrNode *attrNode, u_int32_t or
  * -------------------------------------------------------------------------------------*/
 int applyUnreachablePrefix (const Prefix *prefix, Session_structp session, BMF bmf)
 {
-	INDEX			i;
-	PrefixNode		*node, *prevNode;
-	int				error;
+	PrefixNode		*node;
    
-	prevNode = NULL;
-	i = prefix_hash((u_char *)prefix, (PREFIX_SIZE(prefix->addr.p_len))+sizeof(Prefix), session->prefixTable->tableSize);
-
 	/* lookup the prefix */
- 	node = session->prefixTable->prefixEntries[i].node;
-	while( node != NULL && memcmp(prefix, &(node->keyPrefix), (PREFIX_SIZE(prefix->addr.p_len))+sizeof(Prefix)) )
-	{
-		prevNode = node;
-    	node = node->next;
-   	}
+ 	node = findPrefixNode(session->prefixTable, prefix);
    
    	// create the corresponding entry in label table   
    	/* if nonexist */
@@ -1263,35 +1263,16 @@ int applyUnreachablePrefix (const Prefix *prefix, Session_structp session, BMF b
 	}
 	session->stats.withRcvd++;
 			
-	if( (error = pthread_rwlock_wrlock (&(node->dataAttr->lock))) > 0 ) 
-	{
-		log_fatal ("Failed to wrlock an entry in the rib table: %s", strerror(error));
-	}
    	node->dataAttr->refCount--;
-	
-   	if( removePefixFomAttr(node, node->dataAttr, session) )
-		log_err("Failed to remove a prefix fom a attribute.");
-	pthread_rwlock_unlock(&(node->dataAttr->lock));
-	
 	  
    	if( node->dataAttr->refCount == 0 )
-	{
-    	if( removeAttrNode( node->dataAttr, session ) ) 
-        	log_err ("Failed to remove given attr from attr table");
-   	}
+		removeRibAttr(session, node->dataAttr);
 
-	if( prevNode == NULL )
-    	session->prefixTable->prefixEntries[i].node = node->next;
-   	else 
-    	prevNode->next = node->next;
-   
-  	if (session->prefixTable->prefixEntries[i].node == NULL)
-    	session->prefixTable->ocupiedSize--;
-   
-   	session->prefixTable->prefixEntries[i].nodeCount--;
-	session->stats.memoryUsed -= ( sizeof(PrefixNode) + (PREFIX_SIZE(node->keyPrefix.addr.p_len)) );	
-	free(node);
-   	session->prefixTable->prefixCount--;
+	removePrefixTrie(session->prefixTable, node, session);
+	if( detachPrefixNode(session->prefixTable, node, session) )
+		log_err("Failed to remove a prefix node from the prefix table.");
+	// the node stays on the prefix ref list of its attribute node for the rib snapshots taken before this update
+	removeRibPrefix(session, node, FALSE);
 	session->stats.prefixCount--;
    	return 0;
 }
@@ -1311,13 +1292,20 @@ void applyReachableNLRI (time_t originatedTS, BGPNlri *nlri, AttrNode	*attrNode,
 {
 	MSTREAM		s;
 	u_int8_t	len;
-	Prefix		*prefix = NULL;
+	struct {
+		Prefix	prefix;
+		u_char	addr[PREFIX_MAX_BYTES];
+	}			key;
+	Prefix		*prefix = &key.prefix;
+	int			error;
 	
+	// prefix readers of other threads walk the table
+	if( (error = pthread_rwlock_wrlock(&(session->prefixTable->lock))) > 0 )
+		log_fatal( "Failed to wrlock the prefix table: %s", strerror(error) );
 	mstream_init(&s, nlri->nlri, nlri->nlriLen);
 	while( mstream_can_read(&s) > 0 )
 	{
 		mstream_getc(&s, &len);
-		prefix = malloc(sizeof(Prefix) + (PREFIX_SIZE(len)));
 		prefix->afi = nlri->afi;
 		prefix->safi = nlri->safi;
 		prefix->addr.p_len = len;
@@ -1334,9 +1322,8 @@ void applyReachableNLRI (time_t originatedTS, BGPNlri *nlri, AttrNode	*attrNode,
 		debug (__FUNCTION__, "Succefully apply a reachable prefix to the rib table.");
 	#endif
    		s.position += PREFIX_SIZE(prefix->addr.p_len);
-		free(prefix);
-		prefix = NULL;
 	}
+	pthread_rwlock_unlock(&(session->prefixTable->lock));
 }
 
 /*----------------------------------------------------------------------------------------
@@ -1352,13 +1339,20 @@ void applyUnreachableNLRI (BGPNlri *nlri, Session_structp session, BMF bmf)
 {
 	MSTREAM		s;
 	u_int8_t	len;
-	Prefix		*prefix = NULL;
+	struct {
+		Prefix	prefix;
+		u_char	addr[PREFIX_MAX_BYTES];
+	}			key;
+	Prefix		*prefix = &key.prefix;
+	int			error;
 	
+	// prefix readers of other threads walk the table
+	if( (error = pthread_rwlock_wrlock(&(session->prefixTable->lock))) > 0 )
+		log_fatal( "Failed to wrlock the prefix table: %s", strerror(error) );
 	mstream_init(&s, nlri->nlri, nlri->nlriLen);
 	while( mstream_can_read(&s) > 0 )
 	{
 		mstream_getc(&s, &len);
-		prefix = malloc(sizeof(Prefix) + (PREFIX_SIZE(len)));
 		prefix->afi = nlri->afi;
 		prefix->safi = nlri->safi;
 		prefix->addr.p_len = len;
@@ -1372,10 +1366,8 @@ void applyUnreachableNLRI (BGPNlri *nlri, Session_structp session, BMF bmf)
 		debug (__FUNCTION__, "Succefully withdraw a IPv4 prefix from rib table.");
 	#endif
 		s.position += PREFIX_SIZE(prefix->addr.p_len);
-		free(prefix);
-		prefix = NULL;
 	}
-
+	pthread_rwlock_unlock(&(session->prefixTable->lock));
 }
 
 /*--------------------------------------------------------------------------------------
@@ -1537,16 +1529,18 @@ int applyBGPUpdate (time_t originatedTS, ParsedBGPUpdate *parsedUpdateMsg, Sessi
 			If all prefixes wont fit in a single BMF message, multiple BMF messages will be sent.
  * Input: attrNode -  the attribute node used to create a BMF
  *		sessionID -  the ID of the session	
- *	  labeledQueueWriter - name of queue for sending BMF messages	
+ *		since - only the prefixes added after this version are sent, 0 for all
+ *		version - the version of the rib snapshot being sent
+ *	  labeledQueueBatch - batch of the labeled queue the BMF messages are added to	
  * Output: 0 for success or -1 for failure
  * He Yan @ July 4th, 2008
  * Mikhail Strizhov @ July 21st, 2010
  * -------------------------------------------------------------------------------------*/ 
-static u_char	updateBuf[MAX_BGP_MESSAGE_LEN];
-static u_char	mpAttrBuf[MAX_BGP_MESSAGE_LEN];
-static u_char	nlriBuf[MAX_BGP_MESSAGE_LEN];
-int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQueueWriter)
+int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, u_int64_t since, u_int64_t version, QueueBatch *labeledQueueBatch)
 {
+	// the buffers are on the stack since several rib transfers run at the same time
+	u_char			mpAttrBuf[MAX_BGP_MESSAGE_LEN];
+	u_char			nlriBuf[MAX_BGP_MESSAGE_LEN];
 	MSTREAM			source;
 	// initialize buffer for the mp attrbutes section in a update
 	MSTREAM			mpAttr;
@@ -1557,19 +1551,16 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 	memset (nlriBuf, 0, MAX_BGP_MESSAGE_LEN);
 	mstream_init(&nlri, nlriBuf, MAX_BGP_MESSAGE_LEN);
 
-	// lock this attribute node 
+	// the caller is in a read section of the attribute table, the prefix list
+	// is read without locks while the labeling worker changes it, and only the
+	// prefixes of the snapshot added since the previous transfer are sent
 	int error;
-	if( (error = pthread_rwlock_rdlock (&(attrNode->lock))) > 0 ) 
-	{
-		log_err("Failed to read lock an attribute node in the attribute table: %s", strerror(error));
-		return -1;
-	}	
 	
 	//1. process the mp attributes
 	u_int16_t startPos;
 	u_int16_t mpAttrLen;
 	u_char mpAttrFlag, mpAttrType, ampAttrLenShort;
-	PrefixRefNode *prefixRefNode = NULL;
+	PrefixNode *prefixRef = NULL;
 	mstream_init(&source, attrNode->attr+attrNode->basicAttrLen, attrNode->totalAttrLen-attrNode->basicAttrLen);
 	while( mstream_can_read(&source) > 0 ) 
 	{
@@ -1577,13 +1568,11 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 		if( mstream_getc(&source, &mpAttrFlag) )
 		{
 			log_err("%s [%d] - Failed! Message was corrupt.", __FILE__, __LINE__);
-			pthread_rwlock_unlock(&(attrNode->lock));
 			return -1;
 		}			
 		if( mstream_getc(&source, &mpAttrType) ) 
 		{
 			log_err("%s [%d] - Failed! Message was corrupt.", __FILE__, __LINE__);
-			pthread_rwlock_unlock(&(attrNode->lock));
 			return -1;
 		}		
 		/* get attribute length */
@@ -1592,7 +1581,6 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 			if( mstream_getw(&source, &mpAttrLen) )
 			{
 				log_err("%s [%d] - Failed! Message was corrupt.", __FILE__, __LINE__);
-				pthread_rwlock_unlock(&(attrNode->lock));
 				return -1;
 			}					
 		} 
@@ -1601,7 +1589,6 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 			if( mstream_getc(&source,&ampAttrLenShort) )
 			{
 				log_err("%s [%d] - Failed! Message was corrupt.", __FILE__, __LINE__);
-				pthread_rwlock_unlock(&(attrNode->lock));
 				return -1;
 			}
 			mpAttrLen = ampAttrLenShort;
@@ -1610,7 +1597,6 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 		if( mstream_can_read(&source) < mpAttrLen) 
 		{
 			log_err("%s [%d] - Failed! Message was corrupt.", __FILE__, __LINE__);
-			pthread_rwlock_unlock(&(attrNode->lock));
 			return -1;
 		}			
 
@@ -1624,25 +1610,24 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 					if( mstream_getw(&source, &afi) )
 					{
 						log_err("%s [%d] - Failed! Mpreach message was corrupt.", __FILE__, __LINE__);
-						pthread_rwlock_unlock(&(attrNode->lock));
 						return -1;
 					}
 					if( mstream_getc(&source, &safi) )
 					{
 						log_err("%s [%d] - Failed! Mpreach message was corrupt.", __FILE__, __LINE__);
-						pthread_rwlock_unlock(&(attrNode->lock));
 						return -1;
 					}
 
 					// find all prefixes with the same afi&safi as this mp attribute.
-					prefixRefNode = attrNode->prefixRefNode;
+					prefixRef = __atomic_load_n(&(attrNode->prefixList), __ATOMIC_ACQUIRE);
 					int flag = 0;
 					u_int16_t mpStartPos = mpAttr.position;;
-					while( prefixRefNode != NULL )
+					while( prefixRef != NULL )
 					{
 						//find one matched prefix with the same afi&safi as this mp attribute.
-						if( prefixRefNode->prefixNode->keyPrefix.afi == afi
-							&& prefixRefNode->prefixNode->keyPrefix.safi == safi )
+						if( prefixRef->keyPrefix.afi == afi
+							&& prefixRef->keyPrefix.safi == safi
+							&& isPrefixInRibDelta(prefixRef, since, version) )
 						{
 							if( flag == 0)
 							{
@@ -1650,20 +1635,18 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 								if(mstream_add( &mpAttr, source.start+startPos, mpAttrLen + source.position - startPos -3 ))
 								{
 							 		log_err("Buffer is overflow!1");
-									pthread_rwlock_unlock(&(attrNode->lock));
 							 		return -1;
 								}		
 								flag = 1;
 							}
 							// insert every matched prefix
-							u_int16_t prefixLenInBytes = PREFIX_SIZE(prefixRefNode->prefixNode->keyPrefix.addr.p_len);
-							if( mstream_add( &mpAttr, &prefixRefNode->prefixNode->keyPrefix.addr, prefixLenInBytes+1 ) )
+							u_int16_t prefixLenInBytes = PREFIX_SIZE(prefixRef->keyPrefix.addr.p_len);
+							if( mstream_add( &mpAttr, &prefixRef->keyPrefix.addr, prefixLenInBytes+1 ) )
 							{
 								// BGP update message is full, send it and start new message
-								if (createAndSendBMFFromAttr(sessionID, attrNode,mpAttr, nlri, labeledQueueWriter) == -1)
+								if (createAndSendBMFFromAttr(sessionID, attrNode,mpAttr, nlri, since, labeledQueueBatch) == -1)
 								{
 									log_err("%s [%d] Could not send BMF message!", __FILE__, __LINE__);
-									pthread_rwlock_unlock(&(attrNode->lock));
 									return -1;
 								}
 								// reset mp reach to 0
@@ -1672,14 +1655,12 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 								if(mstream_add( &mpAttr, source.start+startPos, mpAttrLen + source.position - startPos -3 ))
 								{
 							 		log_err("Buffer is overflow!1");
-									pthread_rwlock_unlock(&(attrNode->lock));
 							 		return -1;
 								}		
-								if( mstream_add( &mpAttr, &prefixRefNode->prefixNode->keyPrefix.addr, prefixLenInBytes+1 ) )
+								if( mstream_add( &mpAttr, &prefixRef->keyPrefix.addr, prefixLenInBytes+1 ) )
 
 								{
 							 		log_err("Buffer is overflow!2");
-									pthread_rwlock_unlock(&(attrNode->lock));
 							 		return -1;
 								}		
 							}									
@@ -1694,7 +1675,7 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 								*((u_int8_t *)(mpAttr.start + mpStartPos + 2)) += (prefixLenInBytes+1);
 							}
 						}
-						prefixRefNode = prefixRefNode->next;
+						prefixRef = __atomic_load_n(&(prefixRef->attrNext), __ATOMIC_ACQUIRE);
 					}	
 					source.position += mpAttrLen-3;
 				}				
@@ -1702,7 +1683,6 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 
 			case BGP_MP_UNREACH:
 				log_err("%s [%d] - Failed! Found a mp unreach attribute.", __FILE__, __LINE__);
-				pthread_rwlock_unlock(&(attrNode->lock));
 				return -1;
 				break;
 				
@@ -1713,7 +1693,6 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 				log_msg("--------------------------------------");
 				hexdump(LOG_INFO, attrNode->attr+attrNode->basicAttrLen, attrNode->totalAttrLen-attrNode->basicAttrLen);
 #endif				
-				pthread_rwlock_unlock(&(attrNode->lock));
 				return -1;
 				break;
 		}
@@ -1724,24 +1703,24 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 	// initialize buffer for the NLRI section(afi:1 and safi:1) in a update
 	// calculate the remaining len of update message buffer
 	int remainingLen = MAX_BGP_MESSAGE_LEN - 2 - 2 - attrNode->basicAttrLen - attrNode->asPath->asPathData.len - mpAttr.position;
-	prefixRefNode = attrNode->prefixRefNode;
-	while( prefixRefNode != NULL )
+	prefixRef = __atomic_load_n(&(attrNode->prefixList), __ATOMIC_ACQUIRE);
+	while( prefixRef != NULL )
 	{
 		//find a prefix with afi:1 and safi:1
-		//log_msg("preifx loop %d %d", prefixRefNode->prefixNode->keyPrefix.afi, prefixRefNode->prefixNode->keyPrefix.safi);
-		if( prefixRefNode->prefixNode->keyPrefix.afi == 1
-			&& prefixRefNode->prefixNode->keyPrefix.safi == 1 )
+		//log_msg("preifx loop %d %d", prefixRef->keyPrefix.afi, prefixRef->keyPrefix.safi);
+		if( prefixRef->keyPrefix.afi == 1
+			&& prefixRef->keyPrefix.safi == 1
+			&& isPrefixInRibDelta(prefixRef, since, version) )
 		{
 			// insert every matched prefix
-			u_int16_t prefixLenInBytes = PREFIX_SIZE(prefixRefNode->prefixNode->keyPrefix.addr.p_len);
+			u_int16_t prefixLenInBytes = PREFIX_SIZE(prefixRef->keyPrefix.addr.p_len);
 			// check if the remaining buffer len is suffcient
 			if( remainingLen < prefixLenInBytes + 1 )
 			{
 				// BGP update message is full, send it and start new message
-				if (createAndSendBMFFromAttr(sessionID, attrNode,mpAttr, nlri, labeledQueueWriter) == -1)
+				if (createAndSendBMFFromAttr(sessionID, attrNode,mpAttr, nlri, since, labeledQueueBatch) == -1)
 				{
 					log_err("%s [%d] Could not send BMF message!", __FILE__, __LINE__);
-					pthread_rwlock_unlock(&(attrNode->lock));
 					return -1;
 				}
 				// reset mp reach to 0
@@ -1752,20 +1731,18 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
 				mstream_init(&nlri, nlriBuf, MAX_BGP_MESSAGE_LEN);
 				remainingLen = MAX_BGP_MESSAGE_LEN - 2 - 2 - attrNode->basicAttrLen - attrNode->asPath->asPathData.len;
 			}	
-			if( mstream_add( &nlri, &prefixRefNode->prefixNode->keyPrefix.addr, prefixLenInBytes+1 ))
+			if( mstream_add( &nlri, &prefixRef->keyPrefix.addr, prefixLenInBytes+1 ))
 			{
 				log_err("Buffer is overflow %d!3", nlri.position);
-				pthread_rwlock_unlock(&(attrNode->lock));
 		 		return -1;
 			}	
 			remainingLen -= (prefixLenInBytes + 1);
 			
 		}
-		prefixRefNode = prefixRefNode->next;
+		prefixRef = __atomic_load_n(&(prefixRef->attrNext), __ATOMIC_ACQUIRE);
 	}
-	pthread_rwlock_unlock(&(attrNode->lock));
 		
-	error = createAndSendBMFFromAttr(sessionID, attrNode, mpAttr, nlri, labeledQueueWriter);
+	error = createAndSendBMFFromAttr(sessionID, attrNode, mpAttr, nlri, since, labeledQueueBatch);
 
 	return error;
 }
@@ -1775,14 +1752,16 @@ int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQu
  * Purpose: create and send BMF message from Attributes
  * Input: attrNode -  the attribute node used to create a BMF
  * 	  nlri - NLRI structure
- *	  labeledQueueWriter - name of queue for sending BMF messages	
+ *	  since - the version a delta transfer starts from, 0 for a full transfer
+ *	  labeledQueueBatch - batch of the labeled queue the BMF messages are added to	
  * Output: 0 for success or -1 for failure
  * Mikhail Strizhov @ July 21st, 2010
  * -------------------------------------------------------------------------------------*/ 
-int createAndSendBMFFromAttr(int sessionID,AttrNode *attrNode, MSTREAM mpAttr, MSTREAM nlri,  QueueWriter labeledQueueWriter) 
+int createAndSendBMFFromAttr(int sessionID,AttrNode *attrNode, MSTREAM mpAttr, MSTREAM nlri, u_int64_t since, QueueBatch *labeledQueueBatch) 
 {
 
 	// initialize buffer for the body of update 
+	u_char		updateBuf[MAX_BGP_MESSAGE_LEN];
 	MSTREAM		update;	
 	memset (updateBuf, 0, MAX_BGP_MESSAGE_LEN);
 	mstream_init(&update, updateBuf, MAX_BGP_MESSAGE_LEN);
@@ -1841,15 +1820,147 @@ int createAndSendBMFFromAttr(int sessionID,AttrNode *attrNode, MSTREAM mpAttr, M
 	setBGPHeaderLength( hdr, update.position );
 
 	// 10. create the BMF message
-	BMF bmf = createBMF(sessionID, BMF_TYPE_TABLE_TRANSFER);
+	BMF bmf = createBMFWithLength(sessionID, BMF_TYPE_TABLE_TRANSFER, 19 + update.position);
+	bmf->ribSince = since;
 	bgpmonMessageAppend( bmf, hdr, 19);
 	bgpmonMessageAppend( bmf, update.start, update.position );	
 	
 	// write BMF message to queue
-	writeQueue (labeledQueueWriter, bmf);
+	addQueueBatch (labeledQueueBatch, bmf);
 
 	free(hdr);
 	return 0;
 }	
-/* END */
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: create and send a table transfer BMF message that withdraws prefixes
+ * Input: sessionID - the ID of the session
+ *	  since - the version the delta transfer starts from
+ *	  withdrawn - the IPv4 unicast prefixes
+ *	  mpUnreach - the prefixes of afi and safi, put in a MP_UNREACH attribute
+ *	  afi, safi - the address family of mpUnreach
+ *	  labeledQueueBatch - batch of the labeled queue the BMF messages are added to	
+ * Output: 0 for success or -1 for failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static int createAndSendWithdrawnBMF(int sessionID, u_int64_t since, MSTREAM *withdrawn, MSTREAM *mpUnreach, u_int16_t afi, u_int8_t safi, QueueBatch *labeledQueueBatch)
+{
+	u_char		updateBuf[MAX_BGP_MESSAGE_LEN];
+	MSTREAM		update;
+	u_int16_t	len;
+	u_char		c;
+
+	if( withdrawn->position == 0 && mpUnreach->position == 0 )
+		return 0;
+	mstream_init(&update, updateBuf, MAX_BGP_MESSAGE_LEN);
+
+	// withdrawn routes
+	len = htons(withdrawn->position);
+	if( mstream_add(&update, &len, 2) || mstream_add(&update, withdrawn->start, withdrawn->position) )
+	{
+		log_err("Buffer is overflow!");
+		return -1;
+	}
+
+	// the MP_UNREACH attribute is the only attribute
+	len = htons(mpUnreach->position > 0 ? 7 + mpUnreach->position : 0);
+	if( mstream_add(&update, &len, 2) )
+	{
+		log_err("Buffer is overflow!");
+		return -1;
+	}
+	if( mpUnreach->position > 0 )
+	{
+		c = BGP_ATTR_FLAG_OPTIONAL | BGP_ATTR_FLAG_EXT_LEN;
+		mstream_add(&update, &c, 1);
+		c = BGP_MP_UNREACH;
+		mstream_add(&update, &c, 1);
+		len = htons(3 + mpUnreach->position);
+		mstream_add(&update, &len, 2);
+		len = htons(afi);
+		mstream_add(&update, &len, 2);
+		mstream_add(&update, &safi, 1);
+		if( mstream_add(&update, mpUnreach->start, mpUnreach->position) )
+		{
+			log_err("Buffer is overflow!");
+			return -1;
+		}
+	}
+
+	PBgpHeader hdr = createBGPHeader( typeUpdate );
+	setBGPHeaderLength( hdr, update.position );
+
+	BMF bmf = createBMFWithLength(sessionID, BMF_TYPE_TABLE_TRANSFER, BGP_HEADER_LEN + update.position);
+	bmf->ribSince = since;
+	bgpmonMessageAppend( bmf, hdr, BGP_HEADER_LEN);
+	bgpmonMessageAppend( bmf, update.start, update.position );	
+	addQueueBatch (labeledQueueBatch, bmf);
+
+	free(hdr);
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Create and send table transfer BMF messages that withdraw prefixes. The IPv4
+ *			unicast prefixes go in the withdrawn routes of the updates, the others
+ *			in MP_UNREACH attributes.
+ * Input: keys - the prefixes, sorted by afi and safi
+ *		count - the number of prefixes
+ *		sessionID - the ID of the session	
+ *		since - the version the delta transfer starts from
+ *	  labeledQueueBatch - batch of the labeled queue the BMF messages are added to	
+ * Output: the number of messages sent, or -1 for failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int sendWithdrawnBMF(RibPrefixKey *keys, u_int32_t count, int sessionID, u_int64_t since, QueueBatch *labeledQueueBatch)
+{
+	u_char			withdrawnBuf[MAX_BGP_MESSAGE_LEN];
+	u_char			mpUnreachBuf[MAX_BGP_MESSAGE_LEN];
+	MSTREAM			withdrawn, mpUnreach;
+	u_int16_t		afi = 0;
+	u_int8_t		safi = 0;
+	int			sent = 0;
+	int			mp, prefixLen, used;
+	u_int32_t		i;
+	Prefix			*prefix;
+
+	mstream_init(&withdrawn, withdrawnBuf, MAX_BGP_MESSAGE_LEN);
+	mstream_init(&mpUnreach, mpUnreachBuf, MAX_BGP_MESSAGE_LEN);
+
+	for( i = 0; i < count; i++ )
+	{
+		prefix = &(keys[i].keyPrefix);
+		mp = prefix->afi != 1 || prefix->safi != 1;
+		prefixLen = PREFIX_SIZE(prefix->addr.p_len) + 1;
+
+		// the length fields, the MP_UNREACH header and the prefixes must fit in a BGP message
+		used = 2 + withdrawn.position + 2 + (mpUnreach.position > 0 || mp ? 7 + mpUnreach.position : 0);
+		if( used + prefixLen > MAX_BGP_MESSAGE_LEN - BGP_HEADER_LEN
+			|| (mp && mpUnreach.position > 0 && (prefix->afi != afi || prefix->safi != safi)) )
+		{
+			if( createAndSendWithdrawnBMF(sessionID, since, &withdrawn, &mpUnreach, afi, safi, labeledQueueBatch) )
+				return -1;
+			sent++;
+			mstream_init(&withdrawn, withdrawnBuf, MAX_BGP_MESSAGE_LEN);
+			mstream_init(&mpUnreach, mpUnreachBuf, MAX_BGP_MESSAGE_LEN);
+		}
+
+		if( mp )
+		{
+			afi = prefix->afi;
+			safi = prefix->safi;
+			mstream_add(&mpUnreach, &prefix->addr, prefixLen);
+		}
+		else
+			mstream_add(&withdrawn, &prefix->addr, prefixLen);
+	}
+
+	if( withdrawn.position > 0 || mpUnreach.position > 0 )
+	{
+		if( createAndSendWithdrawnBMF(sessionID, since, &withdrawn, &mpUnreach, afi, safi, labeledQueueBatch) )
+			return -1;
+		sent++;
+	}
+	return sent;
+}
+/* END */
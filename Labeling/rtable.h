@@ -53,24 +53,23 @@ typedef struct BGPASPathStruct {
  * -------------------------------------------------------------------------------------*/
 typedef struct PrefixNodeStruct PrefixNode;
 
-typedef struct PrefixRefNodeStruct {
-   struct PrefixRefNodeStruct	*next;
-   PrefixNode					*prefixNode;
-} PrefixRefNode;
-
+/* the AS paths are shared by the attribute nodes with the same AS path,
+ * so two attribute nodes have the same AS path if they point at the same ASPath */
 typedef struct ASPathStruct {
 	BGPASPath 	asPathData;
-	u_int16_t	asPathID;
+	u_int64_t	fingerprint;	/* hash of the AS path, selects the bucket of the attribute table */
 	u_int32_t	refCount;
+	struct ASPathStruct	*retiredNext;	/* link of the retired AS paths */
 } ASPath;
 
 typedef struct AttrNodeStruct {
    struct AttrNodeStruct	*next;
    u_int16_t				refCount;
-   PrefixRefNode			*prefixRefNode;
-   pthread_rwlock_t			lock;
+   u_int16_t				unlinkPending;	/* on the removed list of the snapshots while it is not used */
+   PrefixNode				*prefixList;	/* prefixes using these attributes, linked through attrNext */
+   struct AttrNodeStruct	*retiredNext;	/* link of the retired or removed attribute nodes */
    ASPath					*asPath;
-   INDEX					bucketIndex;
+   u_int64_t				fingerprint;	/* hash of the attributes */
    u_int16_t				basicAttrLen;
    u_int16_t				totalAttrLen;
    u_char					attr[0];
@@ -78,17 +77,100 @@ typedef struct AttrNodeStruct {
 
 typedef struct AttrEntryStruct {
    struct AttrNodeStruct	*node;
-   pthread_rwlock_t          lock;
    u_int16_t				nodeCount;
 } AttrEntry;
 
+/* size of the blocks the RIB arena of a session takes from malloc */
+#define RIB_ARENA_BLOCK_SIZE	(256*1024)
+
+/* arena objects are rounded up to this many bytes */
+#define RIB_ARENA_GRANULE	16
+
+/* objects larger than this are allocated one by one, but still released by the arena */
+#define RIB_ARENA_MAX_OBJECT	4096
+
+#define RIB_ARENA_CLASSES	(RIB_ARENA_MAX_OBJECT/RIB_ARENA_GRANULE)
+
+/* header of an object larger than RIB_ARENA_MAX_OBJECT */
+typedef struct RibArenaLargeStruct {
+   struct RibArenaLargeStruct	*next;
+   struct RibArenaLargeStruct	*prev;
+} RibArenaLarge;
+
+/* Memory of the attribute nodes and AS paths of a session. Objects are carved
+ * from large blocks and freed objects are kept on per-size free lists, so the
+ * whole RIB is released by freeing the blocks. Only the labeling worker of the
+ * session allocates and frees, so the arena has no lock. */
+typedef struct RibArenaStruct {
+   void                      *blocks;	/* blocks from malloc, linked through their first bytes */
+   u_char                    *cur;	/* unused part of the newest block */
+   u_char                    *end;
+   void                      *freeLists[RIB_ARENA_CLASSES];
+   RibArenaLarge             *large;
+   long                       largeBytes;	/* bytes taken from malloc for the large objects */
+   long                       inUse;	/* bytes handed out */
+} RibArena;
+
+/* The rib dumps read the attribute nodes and their prefix lists without locks.
+ * A reader stays in the epoch it entered until it leaves its read section. The
+ * labeling worker of the session unlinks nodes in place and retires them to
+ * the list of the current epoch. It frees the nodes retired in the previous
+ * epoch, and moves to the next epoch, once no reader is left in the previous one. */
+typedef struct RibEpochStruct {
+   u_int32_t                  epoch;
+   u_int32_t                  readers[2];	/* readers in a read section, by the parity of their epoch */
+   /* objects retired during an epoch, by its parity */
+   AttrNode                  *retiredAttrs[2];
+   ASPath                    *retiredPaths[2];
+   PrefixNode                *retiredPrefixes[2];	/* linked through their next field */
+} RibEpoch;
+
+/* A rib dump reads the rib as it was at a version, the number of updates
+ * applied to the session when the dump started. The prefixes removed while a
+ * dump is open stay on the prefix list of their attribute node, stamped with
+ * the version that removed them, and the attribute nodes nobody uses stay in
+ * their bucket. They are unlinked by the first update applied once no dump
+ * is open. */
+typedef struct RibSnapshotsStruct {
+   u_int64_t                  version;	/* the last update applied completely */
+   u_int32_t                  open;	/* number of open snapshots */
+   PrefixNode                *removedPrefixes;	/* linked through their next field, newest first */
+   AttrNode                  *removedAttrs;	/* linked through retiredNext */
+   /* the version the next delta transfer starts from, the prefixes removed 
+      after it are kept for that transfer */
+   u_int64_t                  deltaBase;
+   u_int64_t                  purgedBase;	/* deltaBase when the removed nodes were last unlinked */
+} RibSnapshots;
+
+/* deltaBase of a session whose rib transfers are not deltas */
+#define RIB_NO_DELTA_BASE	(~(u_int64_t)0)
+
+/* the attribute table doubles when it holds more than this percent of its bucket count */
+#define ATTR_TABLE_MAX_LOAD	100
+
+/* Chained hash table of the attribute nodes of a session, the bucket is
+ * selected by the fingerprint of the AS path so the nodes sharing an AS path
+ * are in the same chain. Candidates are compared by fingerprint before their
+ * bytes are compared. The table grows with the number of attributes, but
+ * not while a rib dump walks its buckets. */
 typedef struct AttrTableStruct {
    u_int32_t                  attrCount;
-   u_int32_t                  tableSize;
+   u_int32_t                  tableSize;	/* number of buckets, a power of 2 */
    u_int32_t                  ocupiedSize;
    u_int32_t                  maxNodeCount;
    u_int16_t                  maxCollision; 
    AttrEntry                 *attrEntries;
+   /* number of threads walking the buckets, the table doesn't grow while it is not 0 */
+   u_int32_t                  walkers;
+   pthread_mutex_t            walkLock;
+   /* set when the table is about to be deleted, the rib dumps stop walking it */
+   int                        closing;
+   /* the attribute nodes and AS paths */
+   RibArena                   arena;
+   /* reclamation of the nodes the rib dumps may still read */
+   RibEpoch                   epoch;
+   /* versions of the rib read by the rib dumps */
+   RibSnapshots               snapshots;
 } AttrTable;
 
 
@@ -107,25 +189,97 @@ typedef struct PrefixStruct {
    PAddress       addr;
 } Prefix;
 
+/* number of bytes of a prefix of x bits */
+#define PREFIX_SIZE(x) ((((x)/8)*8 == (x))?(x)/8:(x)/8+1)
+
+/* the longest prefix address, the prefix length is 8 bits */
+#define PREFIX_MAX_BYTES	32
+
+/* the prefix table grows when it is more than this percent full */
+#define PREFIX_TABLE_MAX_LOAD	85
+
+/* number of slots moved from the old table by each insert or remove while the table grows */
+#define PREFIX_TABLE_MIGRATE_STEP	64
+
+/* number of prefix nodes allocated at once */
+#define PREFIX_NODE_CHUNK	512
+
+/* number of afi/safi pairs a prefix trie can index */
+#define PREFIX_TRIE_ROOTS	16
+
 struct PrefixNodeStruct {
-   struct PrefixNodeStruct  *next;
-   AttrNode                  *dataAttr;
+   struct PrefixNodeStruct  *next;	/* next free or retired node, only used while the node is free or retired */
+   AttrNode                  *dataAttr;	/* NULL for a trie node that only joins two branches */
+   /* links of the prefix list of dataAttr, attrPrev points at the link that points at this node */
+   struct PrefixNodeStruct  *attrNext;
+   struct PrefixNodeStruct **attrPrev;
+   /* links of the prefix trie */
+   struct PrefixNodeStruct  *trieParent;
+   struct PrefixNodeStruct  *trieChild[2];
    u_int32_t                  originatedTS;      
+   u_int32_t                  replaced;	/* removed because the prefix moved to another attribute node */
+   /* versions of the rib the prefix was added and removed at, removedVersion is 0 while it is in the rib */
+   u_int64_t                  addedVersion;
+   u_int64_t                  removedVersion;
    Prefix                     keyPrefix;
+   u_char                     keyAddr[PREFIX_MAX_BYTES];	/* storage of keyPrefix.addr.paddr */
 };
 
-typedef struct PrefixEntryStruct {
-   struct PrefixNodeStruct  *node;
-   u_int16_t                  nodeCount;
-} PrefixEntry;
+typedef struct PrefixSlotStruct {
+   PrefixNode                *node;
+   u_int32_t                  hash;
+   u_int16_t                  probe;	/* distance from the home slot plus 1, 0 for an empty slot */
+} PrefixSlot;
 
+/* a prefix copied out of the rib, keyAddr is the storage of keyPrefix.addr.paddr */
+typedef struct RibPrefixKeyStruct {
+   Prefix                     keyPrefix;
+   u_char                     keyAddr[PREFIX_MAX_BYTES];
+} RibPrefixKey;
+
+/* the prefixes of a delta transfer, collected before the transfer starts */
+typedef struct RibDeltaStruct {
+   RibPrefixKey              *announced;	/* open addressing set of the prefixes sent, afi 0 marks an empty slot */
+   u_int32_t                  announcedSize;	/* a power of 2 */
+   u_int32_t                  announcedCount;
+   RibPrefixKey              *withdrawn;	/* sorted by afi and safi */
+   u_int32_t                  withdrawnSize;
+   u_int32_t                  withdrawnCount;
+} RibDelta;
+
+/* initial number of slots of the announced set of a delta */
+#define RIB_DELTA_INIT_SIZE	1024
+
+typedef struct PrefixNodeChunkStruct {
+   struct PrefixNodeChunkStruct	*next;
+   PrefixNode                 nodes[PREFIX_NODE_CHUNK];
+} PrefixNodeChunk;
+
+/* Open addressed (robin hood) hash table of the prefix nodes of a session.
+ * When the table gets too full a table of twice the size is allocated and
+ * the slots of the old table are moved over a few at a time by the following
+ * inserts and removes, lookups check both tables until the old one is empty.
+ * Nodes are taken from chunks owned by the table and never move, so the
+ * attribute nodes can keep pointers to them.
+ * The same nodes also form a path compressed binary trie per afi/safi, used
+ * for covering and more specific prefix queries. */
 typedef struct PrefixTableStruct {
    u_int32_t                  prefixCount;
-   u_int32_t                  tableSize;
-   u_int32_t                  ocupiedSize;
-   u_int16_t                  maxNodeCount;
-   u_int16_t                  maxCollision;   
-   PrefixEntry               *prefixEntries;
+   u_int32_t                  tableSize;	/* number of slots, a power of 2 */
+   u_int16_t                  maxProbe;	/* longest probe sequence since the table last grew */
+   u_int16_t                  maxCollision;	/* the table grows early when a probe gets longer */
+   PrefixSlot                *slots;
+   /* the table being moved to slots */
+   PrefixSlot                *oldSlots;
+   u_int32_t                  oldTableSize;
+   u_int32_t                  migrated;	/* number of old slots already moved */
+   /* the node pool */
+   PrefixNodeChunk           *chunks;
+   PrefixNode                *freeNodes;
+   /* the prefix tries, one per afi/safi */
+   PrefixNode                *trieRoots[PREFIX_TRIE_ROOTS];
+   /* held by the labeling thread while it changes the table, and by the readers of other threads */
+   pthread_rwlock_t           lock;
 } PrefixTable;
 
 
@@ -171,6 +325,10 @@ typedef struct ParsedBGPUpdateStruct {
 	u_int8_t	numOfMpNlri;
 	BGPASPath		asPath;		/*as path*/
 	BGPAttribute	 attr;	   /*other attributes*/ 
+	/* storage the parsed nlri and attributes point into, kept with the
+	   parsed update so several labeling threads can parse at once */
+	u_char		buffer[MAX_BGP_MESSAGE_LEN];
+	u_char		buffer1[MAX_BGP_MESSAGE_LEN];
 } ParsedBGPUpdate;
 
 
@@ -180,8 +338,8 @@ typedef struct ParsedBGPUpdateStruct {
 /*--------------------------------------------------------------------------------------
  * Purpose: Create a prefix table for a session
  * Input: sessionID -  the ID of the session
- *		prefixTableSize - size(#buckets) of prefix table
- *		maxCollision -	max number of hash collisions 
+ *		prefixTableSize - initial size(#slots) of prefix table, rounded up to a power of 2
+ *		maxCollision -	max probe length before the table grows 
  * Output:
  * He Yan @ June 15, 2008
  * -------------------------------------------------------------------------------------*/ 
@@ -191,13 +349,39 @@ void createPrefixTable(int sessionID, u_int32_t prefixTableSize, u_int16_t	maxCo
 /*--------------------------------------------------------------------------------------
  * Purpose: Create a attribute table for a session
  * Input: sessionID -  the ID of the session
- *		attributeTableSize - size(#buckets) of attribute table
+ *		attributeTableSize - initial size(#buckets) of attribute table, rounded up to a power of 2
  *		maxCollision -  max number of hash collisions 
  * Output:
  * He Yan @ June 15, 2008
  * -------------------------------------------------------------------------------------*/ 
 void createAttributeTable(int sessionID, u_int32_t attributeTableSize, u_int16_t  maxCollision);
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Start and finish a walk over the buckets of an attribute table, 
+ *		the table keeps its buckets until the walk is finished
+ * Input: attrTable - the attribute table
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void beginAttrTableWalk(AttrTable *attrTable);
+void endAttrTableWalk(AttrTable *attrTable);
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Tell the rib dumps walking an attribute table that it is about to be deleted
+ * Input: attrTable - the attribute table
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void closeAttrTableWalks(AttrTable *attrTable);
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check if an attribute table is about to be deleted
+ * Input: attrTable - the attribute table
+ * Output: TRUE if the rib dumps must stop walking it, FALSE otherwise
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int isAttrTableClosing(AttrTable *attrTable);
+
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Parse a BGP Update message into reach nlri, unreach nlri, mpreach
@@ -234,22 +418,39 @@ char * printPrefix(u_char *prefix, u_int8_t len);
 			If all prefixes wont fit in a single BMF message, multiple BMF messages will be sent.
  * Input: attrNode -  the attribute node used to create a BMF
  *		sessionID -  the ID of the session	
- *	  labeledQueueWriter - name of queue for sending BMF messages	
+ *		since - only the prefixes added after this version are sent, 0 for all
+ *		version - the version of the rib snapshot being sent
+ *	  labeledQueueBatch - batch of the labeled queue the BMF messages are added to	
  * Output: 0 for success or -1 for failure
  * He Yan @ July 4th, 2008
  * Mikhail Strizhov @ July 21st, 2010
  * -------------------------------------------------------------------------------------*/ 
-int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, QueueWriter labeledQueueWriter);
+int sendBMFFromAttrNode(AttrNode *attrNode, int sessionID, u_int64_t since, u_int64_t version, QueueBatch *labeledQueueBatch);
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Create and send table transfer BMF messages that withdraw prefixes. The IPv4
+ *			unicast prefixes go in the withdrawn routes of the updates, the others
+ *			in MP_UNREACH attributes.
+ * Input: keys - the prefixes, sorted by afi and safi
+ *		count - the number of prefixes
+ *		sessionID - the ID of the session	
+ *		since - the version the delta transfer starts from
+ *	  labeledQueueBatch - batch of the labeled queue the BMF messages are added to	
+ * Output: the number of messages sent, or -1 for failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int sendWithdrawnBMF(RibPrefixKey *keys, u_int32_t count, int sessionID, u_int64_t since, QueueBatch *labeledQueueBatch);
 
 
 /*--------------------------------------------------------------------------------------
  * Purpose: create and send BMF message from Attributes
  * Input: attrNode -  the attribute node used to create a BMF
  * 	  nlri - NLRI structure
- *	  labeledQueueWriter - name of queue for sending BMF messages	
+ *	  since - the version a delta transfer starts from, 0 for a full transfer
+ *	  labeledQueueBatch - batch of the labeled queue the BMF messages are added to	
  * Output: 0 for success or -1 for failure
  * Mikhail Strizhov @ July 21st, 2010
  * -------------------------------------------------------------------------------------*/ 
-int createAndSendBMFFromAttr(int sessionID,AttrNode *attrNode, MSTREAM mpAttr, MSTREAM nlri,  QueueWriter labeledQueueWriter); 
+int createAndSendBMFFromAttr(int sessionID,AttrNode *attrNode, MSTREAM mpAttr, MSTREAM nlri, u_int64_t since, QueueBatch *labeledQueueBatch); 
 
 #endif /*RTABLE_H_*/
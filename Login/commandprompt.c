@@ -890,6 +890,20 @@ int initPeerCommands(commandNode * root) {
 				buildCommand("prefix", "prefix", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, NULL));
 		temp = buildCommandTree(root, "show bgp prefix", 1,
 				buildCommand("*", "[prefix]", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, &cmdShowBGPprefix));
+
+		// show the routes of the prefixes that cover, are covered by or best match a prefix
+		temp = buildCommandTree(root, "show bgp", 1,
+				buildCommand("covering", "covering", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, NULL));
+		temp = buildCommandTree(root, "show bgp covering", 1,
+				buildCommand("*", "[prefix]", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, &cmdShowBGPCovering));
+		temp = buildCommandTree(root, "show bgp", 1,
+				buildCommand("more-specifics", "more-specifics", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, NULL));
+		temp = buildCommandTree(root, "show bgp more-specifics", 1,
+				buildCommand("*", "[prefix]", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, &cmdShowBGPMoreSpecifics));
+		temp = buildCommandTree(root, "show bgp", 1,
+				buildCommand("longest-match", "longest-match", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, NULL));
+		temp = buildCommandTree(root, "show bgp longest-match", 1,
+				buildCommand("*", "[prefix or address]", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, &cmdShowBGPLongestMatch));
 	// setup [SHOW RUNNING] command
 	temp = buildCommandTree(root, "show", 1,
 			buildCommand("running", "running", ACCESS | ENABLE | CONFIGURE | ROUTER_BGP, &cmdShowRunning));
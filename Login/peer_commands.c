@@ -60,6 +60,9 @@
 #include "../Peering/peergroup.h"
 // needed for peerLabelAction
 #include "../Labeling/label.h"
+// needed for walking the prefix table
+#include "../Labeling/prefixtable.h"
+#include "../Labeling/prefixtrie.h"
 // needed for hexStringToByteArray function
 #include "../Config/configfile.h"
 // needed for routing table
@@ -978,6 +981,8 @@ int cmdShowBGPNeighbor(commandArgument * ca, clientThreadArguments * client, com
 					time_t sessionLastRouteRefreshTime = getSessionLastRouteRefreshTime(sessionId);
 					int sessionPrefixCount = getSessionPrefixCount(sessionId);
 					int sessionAttributeCount = getSessionAttributeCount(sessionId);
+					int sessionPrefixTableLoad = getSessionPrefixTableLoad(sessionId);
+					int sessionPrefixMaxProbe = getSessionPrefixMaxProbe(sessionId);
 
 					struct tm * timeinfo;
 					timeinfo = localtime ( &sessionLastActionTime );
@@ -999,6 +1004,8 @@ int cmdShowBGPNeighbor(commandArgument * ca, clientThreadArguments * client, com
 					timeinfo = localtime(&sessionLastRouteRefreshTime);
 					sendMessage(client->socket, "\tlast route refresh time: %s", asctime (timeinfo));
 					sendMessage(client->socket, "\tprefix count: %d\n", sessionPrefixCount);
+					sendMessage(client->socket, "\tprefix table load: %d%%\n", sessionPrefixTableLoad);
+					sendMessage(client->socket, "\tprefix table max probe length: %d\n", sessionPrefixMaxProbe);
 					sendMessage(client->socket, "\tattribute count: %d\n\n", sessionAttributeCount);
 				}
 			}
@@ -1324,6 +1331,37 @@ int cmdClearNeighbor(commandArgument * ca, clientThreadArguments * client, comma
 	return 0;
 }
 
+/*----------------------------------------------------------------------------------------
+ * Purpose: Copy the routes of a session with its peer address and AS number length
+ * Input: sessionID - the session ID
+ * 	peer - set to the remote address of the session, ADDR_MAX_CHARS long
+ * 	ASLen - set to the length of the AS numbers of the session
+ * 	routes - set to the routes, free them with freePrefixRoutes
+ * Output:  the number of routes or -1 if the session is gone
+ * Note: The session is only locked while the routes are copied, it may close while 
+ * 	they are shown.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int listSessionRoutes(int sessionID, char *peer, int *ASLen, PrefixRoute **routes) {
+
+	Session_structp session;
+	char * addr;
+	int count;
+
+	session = lockSession(sessionID);
+	if (session == NULL)
+		return -1;
+	addr = getSessionRemoteAddr(sessionID);
+	strncpy(peer, addr != NULL ? addr : "", ADDR_MAX_CHARS-1);
+	peer[ADDR_MAX_CHARS-1] = '\0';
+	// 2 or 4 bytes AS 
+	*ASLen = session->fsm.ASNumlen;
+	// the routes are copied, the rib may change while they are shown
+	count = listPrefixTable(session, routes);
+	unlockSession();
+	return count;
+}
+
 /*----------------------------------------------------------------------------------------
  * Purpose: show bgp routes which stored in rtable.c
  * Input: commandArgument - A linked list that provides all the parameters the users typed 
@@ -1338,19 +1376,18 @@ int cmdClearNeighbor(commandArgument * ca, clientThreadArguments * client, comma
 int cmdShowBGPRoutes(commandArgument * ca, clientThreadArguments * client, commandNode * root) {
 
 	int i = 0, showcount = 0;
-	u_int32_t j = 0;
+	int j = 0, count;
 	int establishedSessions[MAX_SESSION_IDS];
 	int establishedSessionCount;
-        PrefixNode    *prefixNode;
-        PrefixNode    *nextPrefixNode;
+	PrefixRoute   *routes;
 
 	establishedSessionCount = 0;
 	memset(establishedSessions, 0, sizeof(int)*MAX_SESSION_IDS);
 	
 	char * msg;
-	char * aspath;
 	char * prefixaddr;
 	char * peerAddress = NULL;
+	char peer[ADDR_MAX_CHARS];
 
 	int ASLen=0;
 
@@ -1372,69 +1409,49 @@ int cmdShowBGPRoutes(commandArgument * ca, clientThreadArguments * client, comma
 
 	for (i=0; i<establishedSessionCount; i++)
 	{
-		Session_structp session = getSessionByID(establishedSessions[i]);
-		if (session)
+		count = listSessionRoutes(establishedSessions[i], peer, &ASLen, &routes);
+		if (count >= 0)
 		{
 			
-			if(peerAddress == NULL || (strcmp(getSessionRemoteAddr(establishedSessions[i]),peerAddress)==0))
+			if(peerAddress == NULL || (strcmp(peer,peerAddress)==0))
 			{
 
 			//sendMessage(client->socket, "Session is %d\n", establishedSessions[i]);
-			
-			// 2 or 4 bytes AS 
-			ASLen = session->fsm.ASNumlen;
 
 			sendMessage(client->socket, "Network\t\tNext Hop\tASLen\tAS Path\n");
-			for( j=0; j < session->prefixTable->tableSize; j++ ) 
+			for (j=0; j<count; j++)
 			{
-				if (session->prefixTable->prefixEntries[j].node != NULL) 
+				
+				prefixaddr = printPrefix(routes[j].keyAddr, routes[j].keyPrefix.addr.p_len);
+				sendMessage(client->socket, "%s\t", prefixaddr);
+				free(prefixaddr);
+				
+				sendMessage(client->socket, "%s\t", peer);
+				sendMessage(client->socket, "%d\t", ASLen);
+				sendMessage(client->socket, "%s\n", routes[j].asPath);
+
+				showcount++;
+				if (showcount > 30)
 				{
-					prefixNode = session->prefixTable->prefixEntries[j].node;
-					while (prefixNode != NULL) 
-					{
-						
-						prefixaddr = printPrefix(prefixNode->keyPrefix.addr.paddr,  prefixNode->keyPrefix.addr.p_len);
-						sendMessage(client->socket, "%s\t", prefixaddr);
-						free(prefixaddr);
-						
-						sendMessage(client->socket, "%s\t", getSessionRemoteAddr(establishedSessions[i]));
-						sendMessage(client->socket, "%d\t", ASLen);
-					
-						// check if we have 2 byte lenght of as path
-						if (prefixNode->dataAttr->asPath->asPathData.data[0] & 0x10 )
+					sendMessage(client->socket, "\n\nPress ENTER to see more or Q to leave: ");
+					msg = (char *)malloc(sizeof(char));
+					getMessage(client->socket, msg, 5);
+						if (strcmp(msg,"q")==0 || strcmp(msg,"Q")==0)
 						{
-							aspath = printASPath(prefixNode->dataAttr->asPath->asPathData.data+4, ASLen);
+							free(msg);
+							freePrefixRoutes(routes, count);
+							return 0;
 						}
 						else
 						{
-							aspath = printASPath(prefixNode->dataAttr->asPath->asPathData.data+3, ASLen);
-						}
-						sendMessage(client->socket, "%s\n", aspath);
-						free(aspath);
-
-						nextPrefixNode = prefixNode->next;
-						prefixNode = nextPrefixNode;
-						showcount++;
-						if (showcount > 30)
-						{
-							sendMessage(client->socket, "\n\nPress ENTER to see more or Q to leave: ");
-							msg = (char *)malloc(sizeof(char));
-							getMessage(client->socket, msg, 5);
-								if (strcmp(msg,"q")==0 || strcmp(msg,"Q")==0)
-								{
-									free(msg);
-									return 0;
-								}
-								else
-								{
-									showcount = 0;
-								}
-							free(msg);
+							showcount = 0;
 						}
-					}
+					free(msg);
 				}
 			}
 			}
+			if (count > 0)
+				freePrefixRoutes(routes, count);
 		}// session end
 		
 	}
@@ -1459,19 +1476,18 @@ int cmdShowBGPRoutes(commandArgument * ca, clientThreadArguments * client, comma
 int cmdShowBGProutesASpath(commandArgument * ca, clientThreadArguments * client, commandNode * root) {
 
 	int i = 0;
-	u_int32_t j = 0;
+	int j = 0, count;
 	int establishedSessions[MAX_SESSION_IDS];
 	int establishedSessionCount;
-        PrefixNode    *prefixNode;
-        PrefixNode    *nextPrefixNode;
+	PrefixRoute   *routes;
 
 	establishedSessionCount = 0;
 	memset(establishedSessions, 0, sizeof(int)*MAX_SESSION_IDS);
 	
-	char * aspath;
 	char * prefixaddr = NULL;
 	char * tempprefixaddr = NULL;
 	char * peerAddress = NULL;
+	char peer[ADDR_MAX_CHARS];
 
 	int ASLen=0;
 
@@ -1512,57 +1528,35 @@ int cmdShowBGProutesASpath(commandArgument * ca, clientThreadArguments * client,
 
 	for (i=0; i<establishedSessionCount; i++)
 	{
-		Session_structp session = getSessionByID(establishedSessions[i]);
-		if (session)
+		count = listSessionRoutes(establishedSessions[i], peer, &ASLen, &routes);
+		if (count >= 0)
 		{
 			
-			if( (strcmp(getSessionRemoteAddr(establishedSessions[i]),peerAddress)==0))
+			if( (strcmp(peer,peerAddress)==0))
 			{
 
 			//sendMessage(client->socket, "Session is %d\n", establishedSessions[i]);
-			
-			// 2 or 4 bytes AS 
-			ASLen = session->fsm.ASNumlen;
 
-			for( j=0; j < session->prefixTable->tableSize; j++ ) 
+			for (j=0; j<count; j++)
 			{
-				if (session->prefixTable->prefixEntries[j].node != NULL) 
-				{
-					prefixNode = session->prefixTable->prefixEntries[j].node;
-					while (prefixNode != NULL) 
-					{
-						// get prefix name
-						tempprefixaddr = printPrefix(prefixNode->keyPrefix.addr.paddr,  prefixNode->keyPrefix.addr.p_len);
-
-						if( (strcmp(tempprefixaddr,prefixaddr)==0))
-						{
-							sendMessage(client->socket, "Network\t\tNext Hop\tASLen\tAS Path\n");
-							sendMessage(client->socket, "%s\t", tempprefixaddr);
-						
-							sendMessage(client->socket, "%s\t", getSessionRemoteAddr(establishedSessions[i]));
-							sendMessage(client->socket, "%d\t", ASLen);
-					
-							// check if we have 2 byte lenght of as path
-							if (prefixNode->dataAttr->asPath->asPathData.data[0] & 0x10 )
-							{
-								aspath = printASPath(prefixNode->dataAttr->asPath->asPathData.data+4, ASLen);
-							}
-							else
-							{
-								aspath = printASPath(prefixNode->dataAttr->asPath->asPathData.data+3, ASLen);
-							}
-							sendMessage(client->socket, "%s\n", aspath);
-							free(aspath);
-						}
-						// free prefix memory
-						free(tempprefixaddr);
+				// get prefix name
+				tempprefixaddr = printPrefix(routes[j].keyAddr, routes[j].keyPrefix.addr.p_len);
 
-						nextPrefixNode = prefixNode->next;
-						prefixNode = nextPrefixNode;
-					}
+				if( (strcmp(tempprefixaddr,prefixaddr)==0))
+				{
+					sendMessage(client->socket, "Network\t\tNext Hop\tASLen\tAS Path\n");
+					sendMessage(client->socket, "%s\t", tempprefixaddr);
+				
+					sendMessage(client->socket, "%s\t", peer);
+					sendMessage(client->socket, "%d\t", ASLen);
+					sendMessage(client->socket, "%s\n", routes[j].asPath);
 				}
+				// free prefix memory
+				free(tempprefixaddr);
 			}
 			}
+			if (count > 0)
+				freePrefixRoutes(routes, count);
 		}// session end
 		
 	}
@@ -1584,18 +1578,17 @@ int cmdShowBGProutesASpath(commandArgument * ca, clientThreadArguments * client,
 int cmdShowBGPprefix(commandArgument * ca, clientThreadArguments * client, commandNode * root) {
 
 	int i = 0;
-	u_int32_t j = 0;
+	int j = 0, count;
 	int establishedSessions[MAX_SESSION_IDS];
 	int establishedSessionCount;
-        PrefixNode    *prefixNode;
-        PrefixNode    *nextPrefixNode;
+	PrefixRoute   *routes;
 
 	establishedSessionCount = 0;
 	memset(establishedSessions, 0, sizeof(int)*MAX_SESSION_IDS);
 	
-	char * aspath;
 	char * prefixaddr = NULL;
 	char * tempprefixaddr = NULL;
+	char peer[ADDR_MAX_CHARS];
 
 	int ASLen=0;
 	int found = 0;
@@ -1627,56 +1620,34 @@ int cmdShowBGPprefix(commandArgument * ca, clientThreadArguments * client, comma
 	sendMessage(client->socket, "Network\t\tNext Hop\tASLen\tAS Path\n");
 	for (i=0; i<establishedSessionCount; i++)
 	{
-		Session_structp session = getSessionByID(establishedSessions[i]);
-		if (session)
+		count = listSessionRoutes(establishedSessions[i], peer, &ASLen, &routes);
+		if (count >= 0)
 		{
 			found = 0;
-			// 2 or 4 bytes AS 
-			ASLen = session->fsm.ASNumlen;
-
-			for( j=0; j < session->prefixTable->tableSize; j++ ) 
+			for (j=0; j<count; j++)
 			{
-				if (session->prefixTable->prefixEntries[j].node != NULL) 
-				{
-					prefixNode = session->prefixTable->prefixEntries[j].node;
-					while (prefixNode != NULL) 
-					{
-						// get prefix name
-						tempprefixaddr = printPrefix(prefixNode->keyPrefix.addr.paddr,  prefixNode->keyPrefix.addr.p_len);
-
-						if( (strcmp(tempprefixaddr,prefixaddr)==0))
-						{
-							found = 1;
-							sendMessage(client->socket, "%s\t", tempprefixaddr);
-						
-							sendMessage(client->socket, "%s\t", getSessionRemoteAddr(establishedSessions[i]));
-							sendMessage(client->socket, "%d\t", ASLen);
-					
-							// check if we have 2 byte lenght of as path
-							if (prefixNode->dataAttr->asPath->asPathData.data[0] & 0x10 )
-							{
-								aspath = printASPath(prefixNode->dataAttr->asPath->asPathData.data+4, ASLen);
-							}
-							else
-							{
-								aspath = printASPath(prefixNode->dataAttr->asPath->asPathData.data+3, ASLen);
-							}
-							sendMessage(client->socket, "%s\n", aspath);
-							free(aspath);
-						}
-						// free prefix memory
-						free(tempprefixaddr);
+				// get prefix name
+				tempprefixaddr = printPrefix(routes[j].keyAddr, routes[j].keyPrefix.addr.p_len);
 
-						nextPrefixNode = prefixNode->next;
-						prefixNode = nextPrefixNode;
-					}
+				if( (strcmp(tempprefixaddr,prefixaddr)==0))
+				{
+					found = 1;
+					sendMessage(client->socket, "%s\t", tempprefixaddr);
+				
+					sendMessage(client->socket, "%s\t", peer);
+					sendMessage(client->socket, "%d\t", ASLen);
+					sendMessage(client->socket, "%s\n", routes[j].asPath);
 				}
+				// free prefix memory
+				free(tempprefixaddr);
 			} // table for loop
+			if (count > 0)
+				freePrefixRoutes(routes, count);
 	
 		if (found != 1)
 		{
 			sendMessage(client->socket, "%s\t", prefixaddr);
-			sendMessage(client->socket, "%s\t", getSessionRemoteAddr(establishedSessions[i]));
+			sendMessage(client->socket, "%s\t", peer);
 			sendMessage(client->socket, "%d\t", ASLen);
 			sendMessage(client->socket, "%s\n", "N/A");
 		}
@@ -1688,4 +1659,110 @@ int cmdShowBGPprefix(commandArgument * ca, clientThreadArguments * client, comma
 	return 0;
 }
 
+/*----------------------------------------------------------------------------------------
+ * Purpose: show the routes of all established sessions that match a prefix query
+ * Input: commandArgument - the prefix the user typed in
+ * 	clientThreadArguments - A struct providing the basic address information for the 
+ * 		current connection.
+ * 	type - the PREFIX_QUERY_* type
+ * Output:  0 for success or 1 for failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int showBGPPrefixQuery(commandArgument * ca, clientThreadArguments * client, int type) {
+
+	int i = 0, j = 0;
+	int count, total = 0;
+	struct {
+		Prefix	prefix;
+		u_char	addr[PREFIX_MAX_BYTES];
+	} key;
+	PrefixRoute *routes;
+	char prefixstr[INET6_ADDRSTRLEN+5];
+	char peer[ADDR_MAX_CHARS];
+	char *addr;
+	int ASLen;
+	Session_structp session;
+
+	if (ca==NULL || parsePrefix(ca->commandArgument, &key.prefix))
+	{
+		sendMessage(client->socket, "Please enter a prefix like 192.168.0.0/16\n");
+		return 1;
+	}
+
+	sendMessage(client->socket, "Network\t\tNext Hop\tASLen\tAS Path\n");
+	for(i=0; i<MAX_SESSION_IDS; i++ )
+	{
+		// the session is not destroyed while it is queried, it is unlocked before the routes are sent
+		session = lockSession(i);
+		if( session == NULL )
+			continue;
+		if( isSessionEstablished(i) != TRUE )
+		{
+			unlockSession();
+			continue;
+		}
+		count = queryPrefixTable(session, type, &key.prefix, &routes);
+		addr = getSessionRemoteAddr(i);
+		strncpy(peer, addr != NULL ? addr : "", ADDR_MAX_CHARS-1);
+		peer[ADDR_MAX_CHARS-1] = '\0';
+		ASLen = session->fsm.ASNumlen;
+		unlockSession();
+
+		for (j=0; j<count; j++)
+		{
+			sendMessage(client->socket, "%s\t", formatPrefix(&routes[j].keyPrefix, prefixstr, sizeof(prefixstr)));
+			sendMessage(client->socket, "%s\t", peer);
+			sendMessage(client->socket, "%d\t", ASLen);
+			sendMessage(client->socket, "%s\n", routes[j].asPath);
+		}
+		if (count > 0)
+			freePrefixRoutes(routes, count);
+		total += count;
+	}
+	if (total == 0)
+		sendMessage(client->socket, "%s\tN/A\n", ca->commandArgument);
+
+	return 0;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: show the routes of all prefixes that cover a prefix, the prefix included
+ * Input: commandArgument - A linked list that provides all the parameters the users typed 
+ * 		in. This list is in the same order as they were typed.
+ * 	clientThreadArguments - A struct providing the basic address information for the 
+ * 		current connection.
+ * 	commandNode - A pointer to the current node in the command tree structure.
+ * Output:  0 for success or 1 for failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int cmdShowBGPCovering(commandArgument * ca, clientThreadArguments * client, commandNode * root) {
+	return showBGPPrefixQuery(ca, client, PREFIX_QUERY_COVERING);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: show the routes of a prefix and all the prefixes it covers
+ * Input: commandArgument - A linked list that provides all the parameters the users typed 
+ * 		in. This list is in the same order as they were typed.
+ * 	clientThreadArguments - A struct providing the basic address information for the 
+ * 		current connection.
+ * 	commandNode - A pointer to the current node in the command tree structure.
+ * Output:  0 for success or 1 for failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int cmdShowBGPMoreSpecifics(commandArgument * ca, clientThreadArguments * client, commandNode * root) {
+	return showBGPPrefixQuery(ca, client, PREFIX_QUERY_MORE_SPECIFIC);
+}
 
+/*----------------------------------------------------------------------------------------
+ * Purpose: show the longest matching route of a prefix or address from each session
+ * Input: commandArgument - A linked list that provides all the parameters the users typed 
+ * 		in. This list is in the same order as they were typed.
+ * 	clientThreadArguments - A struct providing the basic address information for the 
+ * 		current connection.
+ * 	commandNode - A pointer to the current node in the command tree structure.
+ * Output:  0 for success or 1 for failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int cmdShowBGPLongestMatch(commandArgument * ca, clientThreadArguments * client, commandNode * root) {
+	return showBGPPrefixQuery(ca, client, PREFIX_QUERY_LONGEST_MATCH);
+}
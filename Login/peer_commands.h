@@ -42,6 +42,9 @@ int cmdShowBGPNeighbor(commandArgument * ca, clientThreadArguments * client, com
 int cmdShowBGPRoutes(commandArgument * ca, clientThreadArguments * client, commandNode * root);
 int cmdShowBGProutesASpath(commandArgument * ca, clientThreadArguments * client, commandNode * root);
 int cmdShowBGPprefix(commandArgument * ca, clientThreadArguments * client, commandNode * root);
+int cmdShowBGPCovering(commandArgument * ca, clientThreadArguments * client, commandNode * root);
+int cmdShowBGPMoreSpecifics(commandArgument * ca, clientThreadArguments * client, commandNode * root);
+int cmdShowBGPLongestMatch(commandArgument * ca, clientThreadArguments * client, commandNode * root);
 
 int cmdNeighborPeerGroupCreate(commandArgument * ca, clientThreadArguments * client, commandNode * root);
 int cmdNeighborPeerGroupAssign(commandArgument * ca, clientThreadArguments * client, commandNode * root);
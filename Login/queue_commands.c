@@ -90,6 +90,7 @@ int showQueue(commandArgument * ca, clientThreadArguments * client, commandNode
 	sendMessage(client->socket, "alpha : %f\n", alpha);
 	sendMessage(client->socket, "minimum writes limit: %d\n", minWritesLimit);
 	sendMessage(client->socket, "pacing interval: %d\n", pacingInterval);
+	sendMessage(client->socket, "queue engine: %s\n", getQueueEngine() == QUEUE_ENGINE_LOCKFREE ? "lock-free" : "mutex");
 
 	// check to see if this is a specific queue
 	if(strcmp(cn->command, "queue")!=0) {
@@ -493,6 +493,10 @@ void writeBGPTableToQueue(int ID, struct BGPTableStruct **start, QueueWriter wri
 	// check if its already free
 	if( *start == NULL ) return;   
 	
+	// the messages of the table are written to the queue in batches
+	QueueBatch batch;
+	initQueueBatch(&batch, writerpointer);
+
 	struct BGPTableStruct *ptr = NULL;
 	for (ptr = *start; ptr != NULL; ptr = ptr->next) 
 	{
@@ -508,9 +512,10 @@ void writeBGPTableToQueue(int ID, struct BGPTableStruct **start, QueueWriter wri
           free(bgpSerialized);
           bgpSerialized = NULL;
           BGP_freeMessage(ptr->BGPmessage);
-	  writeQueue(writerpointer, m );
+	  addQueueBatch(&batch, m );
 	  incrementSessionMsgCount(ID);
 	} // for loop; end
+	flushQueueBatch(&batch);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -1905,7 +1910,7 @@ MRT_processType16SubtypeMessage(uint8_t *rawMessage,int asNumLen,MRTheader *mrtH
     }
   }
 
-  (*bmf) = createBMF(0,  BMF_TYPE_MSG_FROM_PEER);
+  (*bmf) = createBMFWithLength(0,  BMF_TYPE_MSG_FROM_PEER, bgp_length);
   if(bgpmonMessageAppend( (*bmf), &rawMessage[idx], bgp_length)){
     log_err("MRT_processType16SubtypeMessage: Unable to submit message\n");
     return -1;
@@ -45,7 +45,7 @@ MrtNode cn;
 int
 init_mrtinstance(void)
 {
-  peerQueue = createQueue(copyBMF, sizeOfBMF, "test", strlen("test"), FALSE);
+  peerQueue = createQueue(copyBMF, sizeOfBMF, freeBMF, "test", strlen("test"), FALSE);
   return 0;
 }
 
@@ -255,5 +255,5 @@ testMRT_processType16SubtypeMessage(){
   }
   CU_ASSERT(0 == MRT_processType16SubtypeMessage(rawMessage1,asNumLen,&mrtHeader1,&mrtMessage,&bmf));
   CU_ASSERT(NULL != bmf);
-  free(bmf); 
+  destroyBMF(bmf); 
 }
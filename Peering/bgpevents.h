@@ -43,6 +43,9 @@
  * refresh timer expires and when a route refresh message
  * arrives).
  * 
+ * eventTcpConnectionPending - a non-blocking connect is still
+ * in progress, the session stays in the connect state.
+ * 
  * eventLast - marker used to give the upper bound on events
  */
 
@@ -85,6 +88,7 @@ enum bgpEvent {
 	/* implementation specific events */
 	eventRouteRefreshTimer_Expires = 64,
 	eventRouteRefreshMsg,
+	eventTcpConnectionPending,
 	/* use for range checking */
 	eventLast
 };
@@ -82,13 +82,28 @@ fsmConnect(Session_structp s)
 	debug( "fsmConnect", "");
 #endif	
 	int event = checkTimers( s );
+
+	// a non-blocking connect in progress is checked when its socket is writable
+	if ( s->fsm.connecting == TRUE )
+		event = eventTcpConnectionPending;
+
 	switch ( event )
 	{
 
 		case eventConnectRetryTimer_Expires:
-			event = completeConnection( s );
+		case eventTcpConnectionPending:
+			if ( event == eventTcpConnectionPending )
+				event = checkConnection( s );
+			else
+				event = completeConnection( s );
 			switch ( event )
 			{
+				case eventTcpConnectionPending:
+					// the connect retry interval bounds the time the connect may take
+					s->fsm.connectRetryTimer = sessionClock() + s->fsm.connectRetryInt * 1000;
+					updateSessionTimer( s );
+					break;
+
 				case eventTcpConnectionConfirmed: 
 					zeroSessionConnectRetryTimer( s );
 					zeroSessionConnectRetryCount( s );
@@ -902,3 +902,127 @@ writeBGPNotification( PBgpNotification ntf, int socket )
 	} 
 	return( l );
 }
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: functions to frame BGP messages from a receive buffer
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+resetBGPReader( PBgpReader r )
+{
+	r->start = 0;
+	r->end = 0;
+}
+
+int
+hasBGPMessage( PBgpReader r )
+{
+	int avail = r->end - r->start;
+	if ( avail < sizeof(struct BGPHeaderStruct) )
+		return( FALSE );
+	int len = getBGPHeaderLength( (PBgpHeader)(r->data + r->start) );
+	// an invalid length is reported by the next read
+	return( avail >= len || len > bufferLength );
+}
+
+u_char *
+nextBGPMessage( PBgpReader r, int socket )
+{
+	int hl = sizeof(struct BGPHeaderStruct);
+	int len = 0;	// the message length, known once its header is buffered
+	PBgpHeader h;
+	u_char *msg;
+	ssize_t n;
+
+	while ( len == 0 || r->end - r->start < len )
+	{
+		// check the header as soon as it is buffered
+		if ( len == 0 && r->end - r->start >= hl )
+		{
+			h = (PBgpHeader)(r->data + r->start);
+			len = getBGPHeaderLength( h );
+			if ( !maskOK(h) || len < hl || len > bufferLength )
+			{
+				log_err("nextBGPMessage:%s: %d","invalid header",len);
+#ifdef DEBUG			
+				hexdump(LOG_ERR, h, hl);
+#endif			
+				resetBGPReader( r );
+				return( NULL );
+			}
+			continue;
+		}
+
+		// move the partial message to the front to make room for the rest
+		if ( r->start > 0 )
+		{
+			memmove( r->data, r->data + r->start, r->end - r->start );
+			r->end -= r->start;
+			r->start = 0;
+		}
+		n = read( socket, r->data + r->end, BGP_READ_BUFFER_SIZE - r->end );
+		if ( n < 0 && errno == EINTR )
+			continue;
+		if ( n <= 0 )
+		{
+			if ( n < 0 && errno == EWOULDBLOCK )
+				log_err("Read socket timeout!!!!");
+			return( NULL );
+		}
+		r->end += n;
+	}
+
+	msg = r->data + r->start;
+	r->start += len;
+#ifdef DEBUG
+	debug("nextBGPMessage", "");
+	hexdump(LOG_DEBUG, msg, len);
+#endif
+	return( msg );
+}
+
+int
+fillBGPReader( PBgpReader r, int socket )
+{
+	/* Read what the socket holds without blocking.
+	 * Returns the number of bytes read, 0 if nothing is available
+	 * or -1 if the connection is closed or failed.
+	 */
+	ssize_t n;
+
+	if ( r->start > 0 )
+	{
+		memmove( r->data, r->data + r->start, r->end - r->start );
+		r->end -= r->start;
+		r->start = 0;
+	}
+	if ( r->end == BGP_READ_BUFFER_SIZE )
+		return( 0 );
+	n = recv( socket, r->data + r->end, BGP_READ_BUFFER_SIZE - r->end, MSG_DONTWAIT );
+	if ( n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) )
+		return( 0 );
+	if ( n <= 0 )
+		return( -1 );
+	r->end += n;
+	return( n );
+}
+
+int
+peekBGPMessage( int socket )
+{
+	/* Returns TRUE if a whole message waits on the socket, or if the 
+	 * connection is closed so the next read returns at once.
+	 */
+	u_char buf[bufferLength];
+	int hl = sizeof(struct BGPHeaderStruct);
+	ssize_t n = recv( socket, buf, bufferLength, MSG_PEEK | MSG_DONTWAIT );
+	if ( n < 0 )
+		return( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? FALSE : TRUE );
+	if ( n == 0 )
+		return( TRUE );
+	if ( n < hl )
+		return( FALSE );
+	// an invalid length is left to the reader to report
+	int len = getBGPHeaderLength( (PBgpHeader)buf );
+	return( n >= len || len > bufferLength );
+}
@@ -249,6 +249,33 @@ ssize_t 			writeBGPRefresh		( PBgpRefresh,  int  );
 int 					lengthBGPRefresh	( PBgpRefresh );
 void 				destroyBGPRefresh	( PBgpRefresh );
 
+/*
+ * BGP receive buffer
+ *
+ * Reads the peer socket in large chunks and frames the BGP messages
+ * in place, so a message costs no read call of its own once the peer 
+ * has sent several of them.  A message returned by nextBGPMessage
+ * stays valid until the next call.
+ *
+ * fillBGPReader and peekBGPMessage never block, they tell an event 
+ * loop whether the next read of a message would.
+ */
+#define BGP_READ_BUFFER_SIZE 65536
+
+struct BGPReaderStruct
+{
+	u_char		data[BGP_READ_BUFFER_SIZE];
+	int			start;	// first byte not yet framed
+	int			end;	// end of the bytes read from the socket
+};
+typedef struct 		BGPReaderStruct 	*PBgpReader;
+
+void 			resetBGPReader		( PBgpReader );
+int 			hasBGPMessage		( PBgpReader );
+u_char *		nextBGPMessage		( PBgpReader, int );
+int 			fillBGPReader		( PBgpReader, int );
+int 			peekBGPMessage		( int );
+
 /*--------------------------------------------------------------------------------------
  * Purpose: check BGP open message for 4-byte ASN capability
  * Input:  capabilities, as number from Open message
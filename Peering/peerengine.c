@@ -0,0 +1,548 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: peerengine.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#include "../config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
+#include "peerengine.h"
+#include "peers.h"
+#include "peersession.h"
+#include "bgppacket.h"
+#include "bgpstates.h"
+#include "../site_defaults.h"
+#include "../Util/log.h"
+#include "../Util/bgpmon_defaults.h"
+#include "../Config/configdefaults.h"
+#include "../Config/configfile.h"
+
+//#define DEBUG
+
+/* max steps of one peer in a turn of its event loop, so a busy peer can't starve the others */
+#define PEERING_STEPS_PER_TURN	64
+/* max time an event loop sleeps, it bounds how late a disabled peer is closed */
+#define PEERING_MAX_WAIT_MS		1000
+/* max socket events taken by one wait */
+#define PEERING_MAX_EVENTS		256
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the default peering engine settings
+ * Input: none
+ * Output: returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int initPeeringSettings()
+{
+	int err = 0;
+
+	// peering engine
+	if ( (PEERING_ENGINE != PEERING_ENGINE_THREADS) && (PEERING_ENGINE != PEERING_ENGINE_EVENTS) ) {
+		err = 1;
+		log_warning("Invalid site default for peering engine.");
+		PeeringControls.engine = PEERING_ENGINE_THREADS;
+	}
+	else
+		PeeringControls.engine = PEERING_ENGINE;
+
+	// number of event loop threads
+	if ( (PEERING_EVENT_THREADS < 1) || (PEERING_EVENT_THREADS > PEERING_MAX_EVENT_THREADS) ) {
+		err = 1;
+		log_warning("Invalid site default for peering event threads.");
+		PeeringControls.eventThreads = 1;
+	}
+	else
+		PeeringControls.eventThreads = PEERING_EVENT_THREADS;
+
+#ifndef HAVE_SYS_EPOLL_H
+	if ( PeeringControls.engine == PEERING_ENGINE_EVENTS ) {
+		log_warning("Event peering engine is not supported on this system, using one thread per peer.");
+		PeeringControls.engine = PEERING_ENGINE_THREADS;
+	}
+#endif
+
+	return err;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read the peering engine settings from the config file.
+ * Input: none
+ * Output: returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int readPeeringSettings()
+{	
+	int err = 0;
+	int result;
+	int num;
+
+	// get the peering engine
+	result = getConfigValueAsInt(&num, XML_PEERING_ENGINE_PATH, PEERING_ENGINE_THREADS, PEERING_ENGINE_EVENTS);
+	if (result == CONFIG_VALID_ENTRY) 
+		PeeringControls.engine = num;
+	else{
+		if (result == CONFIG_INVALID_ENTRY) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of peering engine.");
+		}
+		else 
+			log_msg("No configuration of peering engine, using default.");
+	}
+
+	// get number of event loop threads
+	result = getConfigValueAsInt(&num, XML_PEERING_THREADS_PATH, 1, PEERING_MAX_EVENT_THREADS);
+	if (result == CONFIG_VALID_ENTRY) 
+		PeeringControls.eventThreads = num;
+	else{
+		if (result == CONFIG_INVALID_ENTRY) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of peering event threads.");
+		}
+		else 
+			log_msg("No configuration of peering event threads, using default.");
+	}
+
+#ifndef HAVE_SYS_EPOLL_H
+	if ( PeeringControls.engine == PEERING_ENGINE_EVENTS ) {
+		log_warning("Event peering engine is not supported on this system, using one thread per peer.");
+		PeeringControls.engine = PEERING_ENGINE_THREADS;
+	}
+#endif
+#ifdef DEBUG
+	debug( __FUNCTION__, "peering engine %d, event threads %d.", PeeringControls.engine, PeeringControls.eventThreads);
+#endif
+
+	return err;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Save the peering engine settings to the config file.
+ * Input:  none
+ * Output: returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int savePeeringSettings()
+{	
+	int err = 0;
+
+	// save peering tag
+	if ( openConfigElement(XML_PEERING_TAG) ) {
+		err = 1;
+		log_warning("Failed to save peering to config file.");
+	}
+
+	// save the peering engine
+	if ( setConfigValueAsInt(XML_PEERING_ENGINE, PeeringControls.engine) ) {
+		err = 1;
+		log_warning("Failed to save peering engine to config file.");
+	}
+
+	// save number of event loop threads
+	if ( setConfigValueAsInt(XML_PEERING_THREADS, PeeringControls.eventThreads) ) {
+		err = 1;
+		log_warning("Failed to save peering event threads to config file.");
+	}
+
+	// save peering tag
+	if ( closeConfigElement(XML_PEERING_TAG) ) {
+		err = 1;
+		log_warning("Failed to save peering to config file.");
+	}
+
+	return err;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+
+/* a peer run by an event loop */
+struct PeerTaskStruct
+{
+	int				peerID;
+	int				sessionID;
+	int				socket;		// socket registered in the epoll set, -1 if none
+	u_int32_t		events;		// events registered for the socket
+	int				ready;		// the socket was reported by the last wait
+	int				timerFired;	// the earliest session timer expired
+	struct PeerTaskStruct	*next;
+};
+typedef struct PeerTaskStruct PeerTask;
+
+/* an event loop thread and the peers it runs */
+struct PeerLoopStruct
+{
+	int				epfd;
+	pthread_t		thread;
+	int				started;
+	pthread_mutex_t	lock;		// protects newTasks
+	PeerTask		*newTasks;	// peers handed over by addPeerToEngine
+	PeerTask		*tasks;		// peers owned by the loop thread
+	TimerWheel		wheel;		// timers of the sessions, owned by the loop thread
+};
+typedef struct PeerLoopStruct PeerLoop;
+
+static PeerLoop PeerLoops[PEERING_MAX_EVENT_THREADS];
+static int PeerAttached[MAX_PEER_IDS];
+static int PeerEngineShutdown = FALSE;
+static pthread_mutex_t PeerEngineLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: called by the timer wheel when the earliest timer of a session expires
+ * Input:  the timer of the session
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+peerTimerExpired( TimerEntry *entry )
+{
+	PeerTask *t = entry->data;
+	t->timerFired = TRUE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Bring the timer and the epoll registration of a peer in line with its session
+ * Input:  the loop and the peer task
+ * Output: none
+ * Note: Called right after each step, so a socket closed by the step is never
+ *       confused with a new socket reusing its number.  A session created by the
+ *       step is moved to the timer wheel of the loop here.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+syncPeerTask( PeerLoop *loop, PeerTask *t )
+{
+	Session_structp s = (t->sessionID >= 0) ? Sessions[t->sessionID] : NULL;
+	int sock = (s != NULL && s->fsm.socket > 0) ? s->fsm.socket : -1;
+	u_int32_t events = EPOLLIN;
+	struct epoll_event ev;
+
+	// the session timers change through updateSessionTimer from now on
+	if ( s != NULL && s->fsm.timerWheel != &loop->wheel )
+	{
+		s->fsm.timerWheel = &loop->wheel;
+		initTimerEntry( &s->fsm.timerEntry, peerTimerExpired, t );
+		updateSessionTimer( s );
+	}
+
+	if ( s != NULL && s->fsm.connecting == TRUE )
+		events |= EPOLLOUT;
+
+	if ( t->socket >= 0 && t->socket != sock )
+	{
+		// the old socket is usually closed already, which removed it from the set
+		epoll_ctl( loop->epfd, EPOLL_CTL_DEL, t->socket, NULL );
+		t->socket = -1;
+	}
+	if ( sock < 0 )
+		return;
+
+	memset( &ev, 0, sizeof(ev) );
+	ev.events = events;
+	ev.data.ptr = t;
+	if ( t->socket == sock )
+	{
+		if ( t->events == events )
+			return;
+		if ( epoll_ctl( loop->epfd, EPOLL_CTL_MOD, sock, &ev ) == 0 )
+		{
+			t->events = events;
+			return;
+		}
+		if ( errno != ENOENT )
+		{
+			log_err("peer %d: failed to modify socket events: %s", t->peerID, strerror(errno));
+			return;
+		}
+	}
+	if ( epoll_ctl( loop->epfd, EPOLL_CTL_ADD, sock, &ev ) < 0 )
+	{
+		log_err("peer %d: failed to add socket to event loop: %s", t->peerID, strerror(errno));
+		return;
+	}
+	t->socket = sock;
+	t->events = events;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Check whether the state machine of a peer can take a step without blocking
+ * Input:  the peer task
+ * Output: TRUE if a timer expired or the awaited data is there, FALSE otherwise
+ * Note: In established state the socket is drained into the session's read buffer,
+ *       so the step only runs once a whole message is buffered.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+peerTaskDue( PeerTask *t )
+{
+	Session_structp s = Sessions[t->sessionID];
+
+	// a step checks the timers before it reads
+	if ( s->fsm.state == stateIdle || t->timerFired )
+		return TRUE;
+	if ( s->fsm.socket <= 0 )
+		return FALSE;
+
+	switch ( s->fsm.state )
+	{
+		case stateConnect:
+			return( s->fsm.connecting == TRUE && t->ready );
+
+		case stateOpenSent:
+		case stateOpenConfirm:
+			return( t->ready && peekBGPMessage( s->fsm.socket ) );
+
+		case stateEstablished:
+			if ( hasBGPMessage( &s->reader ) )
+				return TRUE;
+			if ( !t->ready )
+				return FALSE;
+			if ( fillBGPReader( &s->reader, s->fsm.socket ) < 0 )
+				return TRUE;
+			return( hasBGPMessage( &s->reader ) );
+
+		default:
+			return FALSE;
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: the main function of an event loop thread
+ * Input:	the event loop
+ * Output: 
+ * Note: Each turn adopts the peers handed over, waits for socket events or the
+ *       next timer of the wheel and then runs the steps of the peers that are due.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+static void *
+peerLoopThread( void *arg )
+{
+	PeerLoop *loop = arg;
+	struct epoll_event events[PEERING_MAX_EVENTS];
+	PeerTask *t, *prev, *next;
+	int i, n, timeout, steps, step;
+	int busy = FALSE;	// a peer is due without waiting
+
+	initTimerWheel( &loop->wheel, sessionClock() );
+	debug(__FUNCTION__, "Peering event loop starting!");
+	while ( TRUE )
+	{
+		// adopt the peers handed over since the last turn
+		pthread_mutex_lock( &loop->lock );
+		PeerTask *adopted = loop->newTasks;
+		loop->newTasks = NULL;
+		pthread_mutex_unlock( &loop->lock );
+		while ( adopted != NULL )
+		{
+			t = adopted;
+			adopted = adopted->next;
+			log_msg("The event loop for peer(peerID:%d) starting!", t->peerID);
+			t->sessionID = createSessionStruct( t->peerID, 0, 0 );
+			if ( t->sessionID == -1 )
+			{
+				log_msg("closing peer %d as it is deleted!", t->peerID);
+				PeerAttached[t->peerID] = FALSE;
+				free( t );
+				continue;
+			}
+			t->next = loop->tasks;
+			loop->tasks = t;
+			syncPeerTask( loop, t );
+			busy = TRUE;
+		}
+
+		if ( PeerEngineShutdown == TRUE && loop->tasks == NULL )
+			break;
+
+		// sleep until the next timer, or not at all if a peer is due already
+		timeout = busy ? 0 : nextTimerWheelTimeout( &loop->wheel, sessionClock(), PEERING_MAX_WAIT_MS );
+		busy = FALSE;
+
+		n = epoll_wait( loop->epfd, events, PEERING_MAX_EVENTS, timeout );
+		if ( n < 0 )
+		{
+			if ( errno != EINTR )
+				log_fatal("peering event loop: epoll_wait error: %s", strerror(errno));
+			n = 0;
+		}
+		for ( i = 0; i < n; i++ )
+			((PeerTask *)events[i].data.ptr)->ready = TRUE;
+		advanceTimerWheel( &loop->wheel, sessionClock() );
+
+		// run the peers that are due
+		prev = NULL;
+		for ( t = loop->tasks; t != NULL; t = next )
+		{
+			next = t->next;
+			step = PEER_STEP_RUNNING;
+			steps = 0;
+			if ( getPeerEnabledFlag( t->peerID ) != TRUE )
+			{
+				log_msg("peer %d! is closing", t->peerID);
+				step = PEER_STEP_CLOSING;
+			}
+			else
+			{
+				for ( steps = 0; steps < PEERING_STEPS_PER_TURN && peerTaskDue( t ); steps++ )
+				{
+					// an expired timer is handled by this step, a later one fires again
+					t->ready = FALSE;
+					t->timerFired = FALSE;
+					step = runPeerSession( t->peerID, &t->sessionID );
+					if ( step != PEER_STEP_RUNNING )
+						break;
+					syncPeerTask( loop, t );
+				}
+				t->ready = FALSE;
+			}
+
+			if ( step == PEER_STEP_RUNNING )
+			{
+				Session_structp s = Sessions[t->sessionID];
+				if ( steps == PEERING_STEPS_PER_TURN || s->fsm.state == stateIdle || hasBGPMessage( &s->reader ) )
+					busy = TRUE;
+				prev = t;
+				continue;
+			}
+
+			// the peer is disabled or deleted, release it
+			if ( step == PEER_STEP_CLOSING )
+				cleanupSession( Sessions[t->sessionID] );
+			if ( t->socket >= 0 )
+				epoll_ctl( loop->epfd, EPOLL_CTL_DEL, t->socket, NULL );
+			if ( prev == NULL )
+				loop->tasks = next;
+			else
+				prev->next = next;
+			PeerAttached[t->peerID] = FALSE;
+			free( t );
+		}
+	}
+
+	debug(__FUNCTION__, "Peering event loop exiting!");
+	pthread_exit( NULL );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand a peer to the event engine, the event loops are started with the
+ *          first peer
+ * Input:  the peer ID
+ * Output: none
+ * Note: A peer already run by the engine is ignored.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void addPeerToEngine( int peerID )
+{
+	int error;
+	PeerLoop *loop;
+	PeerTask *t;
+
+	pthread_mutex_lock( &PeerEngineLock );
+	if ( PeerEngineShutdown == TRUE || PeerAttached[peerID] == TRUE )
+	{
+		pthread_mutex_unlock( &PeerEngineLock );
+		return;
+	}
+
+	loop = &PeerLoops[peerID % PeeringControls.eventThreads];
+	if ( loop->started == FALSE )
+	{
+		if ( (loop->epfd = epoll_create( MAX_PEER_IDS )) < 0 )
+			log_fatal("Failed to create peering event loop: %s\n", strerror(errno));
+		if ((error = pthread_mutex_init(&loop->lock, NULL)) > 0 )
+			log_fatal("Failed to init peering event loop lock: %s\n", strerror(error));
+		loop->newTasks = NULL;
+		loop->tasks = NULL;
+		if ((error = pthread_create(&loop->thread, NULL, peerLoopThread, loop)) > 0 )
+			log_fatal("Failed to create peering event loop thread: %s\n", strerror(error));
+		loop->started = TRUE;
+	}
+
+	t = malloc( sizeof(PeerTask) );
+	if ( t == NULL )
+		log_fatal("Failed to allocate memory for peer %d's event task", peerID);
+	t->peerID = peerID;
+	t->sessionID = -1;
+	t->socket = -1;
+	t->events = 0;
+	t->ready = FALSE;
+	t->timerFired = FALSE;
+	PeerAttached[peerID] = TRUE;
+
+	pthread_mutex_lock( &loop->lock );
+	t->next = loop->newTasks;
+	loop->newTasks = t;
+	pthread_mutex_unlock( &loop->lock );
+	pthread_mutex_unlock( &PeerEngineLock );
+
+	debug(__FUNCTION__, "Handed peer %d to event loop %d", peerID, peerID % PeeringControls.eventThreads);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Wait until the event loops have closed the sessions of the disabled peers
+ *          and stopped
+ * Input:  none
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void waitForPeerEngineShutdown()
+{
+	int i;
+
+	pthread_mutex_lock( &PeerEngineLock );
+	PeerEngineShutdown = TRUE;
+	pthread_mutex_unlock( &PeerEngineLock );
+
+	for ( i = 0; i < PEERING_MAX_EVENT_THREADS; i++ )
+	{
+		if ( PeerLoops[i].started == TRUE )
+			pthread_join( PeerLoops[i].thread, NULL );
+	}
+}
+
+#else /* HAVE_SYS_EPOLL_H */
+
+/* without epoll the settings fall back to one thread per peer and these are never called */
+void addPeerToEngine( int peerID )
+{
+	log_err("addPeerToEngine: the event peering engine is not supported on this system");
+}
+
+void waitForPeerEngineShutdown()
+{
+}
+
+#endif /* HAVE_SYS_EPOLL_H */
@@ -0,0 +1,95 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: peerengine.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef PEERENGINE_H_
+#define PEERENGINE_H_
+
+/* engines running the BGP sessions of the peers */
+#define PEERING_ENGINE_THREADS	0	// one thread per peer
+#define PEERING_ENGINE_EVENTS	1	// event loop threads shared by the peers
+
+/* max number of event loop threads */
+#define PEERING_MAX_EVENT_THREADS 64
+
+/* The peering controls hold the settings of the engine running the peers */
+struct PeeringControls_struct_st {
+	// PEERING_ENGINE_THREADS or PEERING_ENGINE_EVENTS
+	int		engine;
+	// number of event loop threads of the event engine
+	int		eventThreads;
+};
+typedef struct PeeringControls_struct_st PeeringControls_struct;
+
+PeeringControls_struct PeeringControls;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the default peering engine settings
+ * Input: none
+ * Output: returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int initPeeringSettings();
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read the peering engine settings from the config file.
+ * Input: none
+ * Output: returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int readPeeringSettings();
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Save the peering engine settings to the config file.
+ * Input:  none
+ * Output: returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int savePeeringSettings();
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand a peer to the event engine, the event loops are started with the
+ *          first peer
+ * Input:  the peer ID
+ * Output: none
+ * Note: A peer already run by the engine is ignored.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void addPeerToEngine( int peerID );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Wait until the event loops have closed the sessions of the disabled peers
+ *          and stopped
+ * Input:  none
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void waitForPeerEngineShutdown();
+
+#endif /*PEERENGINE_H_*/
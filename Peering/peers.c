@@ -49,6 +49,9 @@
 /* needed for session function */
 #include "peersession.h"
 
+/* needed for the event peering engine */
+#include "peerengine.h"
+
 /* needed for malloc and free */
 #include <stdlib.h>
 /* needed for strncpy */
@@ -2413,7 +2416,12 @@ void launchAllPeers()
 			if( getPeerEnabledFlag(Peers[i]->peerID)== TRUE && Peers[i]->sessionID == -1 )
 			{
 				// check the configuration of this peer
-				if( checkPeerConfiguration(i) == TRUE)
+				if( checkPeerConfiguration(i) == TRUE && PeeringControls.engine == PEERING_ENGINE_EVENTS )
+				{
+					// the event loops run the peer
+					addPeerToEngine(i);
+				}
+				else if( checkPeerConfiguration(i) == TRUE)
 				{					
 					int error;
 					// launch the peer thread
@@ -2461,6 +2469,12 @@ void waitForPeersShutdown()
 {
 	void * status = NULL;
 	int i;
+	// the event loops return once all their peers are closed
+	if( PeeringControls.engine == PEERING_ENGINE_EVENTS )
+	{
+		waitForPeerEngineShutdown();
+		return;
+	}
 	for(i = 0; i < MAX_PEER_IDS; i++)
 	{
 		if( Peers[i] != NULL )
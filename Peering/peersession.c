@@ -42,6 +42,8 @@
 #include <time.h>
 #include <syslog.h>
 #include <pthread.h> 
+#include <fcntl.h>
+#include <poll.h>
 
 #ifdef HAVE_LINUX_TCP_H
 #include <linux/tcp.h>
@@ -57,6 +59,7 @@
 #include "peersession.h"
 #include "bgpfsm.h"
 #include "peers.h"
+#include "peerengine.h"
 #include "../Util/unp.h"
 #include "../Util/address.h"
 #include "../Util/bgpmon_defaults.h"
@@ -70,6 +73,10 @@
 #define defaultHoldTime 180
 //#define DEBUG
 
+/* read locked by the threads that use a session they did not create, write locked
+ * while a session is destroyed */
+static pthread_rwlock_t SessionsLock = PTHREAD_RWLOCK_INITIALIZER;
+
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Create a configInUse structure based on a peer config ID
@@ -224,6 +231,8 @@ int createSessionStruct( int peerID, int downCount, time_t lastDownTime )
 	session->fsm.state = stateIdle;
 	session->fsm.reason = eventNone;
 	session->fsm.socket = -1;	
+	session->fsm.nonBlocking = (PeeringControls.engine == PEERING_ENGINE_EVENTS);
+	session->fsm.connecting = FALSE;
 	// determine the time intervals for the various timers
 	session->fsm.connectRetryInt = defaultConnectRetryTime;
 			
@@ -231,6 +240,9 @@ int createSessionStruct( int peerID, int downCount, time_t lastDownTime )
 	session->fsm.connectRetryTimer = 0;
 	session->fsm.keepaliveTimer =0;
 	session->fsm.holdTimer = 0;
+	session->fsm.timerWheel = NULL;
+	initTimerEntry( &session->fsm.timerEntry, NULL, NULL );
+	resetBGPReader( &session->reader );
 	
 	// create queue writer
 	session->peerQueueWriter = createQueueWriter(peerQueue);;
@@ -255,6 +267,10 @@ int createSessionStruct( int peerID, int downCount, time_t lastDownTime )
 	session->stats.sessionDownCount = downCount;
 	session->stats.lastDownTime = lastDownTime;
 
+	// the lock of the rib tables
+	if( pthread_rwlock_init(&(session->ribLock), NULL) )
+		log_fatal( "createSessionStruct: session %d failed to init the rib lock", i );
+
 	// insert it into the array
 	Sessions[i] = session;
 
@@ -348,6 +364,10 @@ int createMrtSessionStruct( u_int32_t srcAS, u_int32_t dstAS, char *scrAddr, cha
 	session->lastAction = 0;
 	session->reconnectFlag = FALSE;
 
+	// the lock of the rib tables
+	if( pthread_rwlock_init(&(session->ribLock), NULL) )
+		log_fatal( "createMrtSessionStruct: session %d failed to init the rib lock", i );
+
 	// insert it into the array
 	Sessions[i] = session;
 
@@ -413,6 +433,9 @@ destroySession( int sessionID )
 /* Frees the memory associated with the session.
  * Do not use the sesssion after this operation.
  */
+  // wait for the threads that locked the session
+  if( pthread_rwlock_wrlock(&SessionsLock) )
+	log_fatal( "Failed to wrlock the sessions" );
   if ( Sessions[sessionID] )
   {
   	int i;
@@ -434,10 +457,53 @@ destroySession( int sessionID )
 		free( Sessions[sessionID]->sessionStringIncoming);
 	if(Sessions[sessionID]->sessionStringOutgoing != NULL)
 		free( Sessions[sessionID]->sessionStringOutgoing);
-	
+
+	// wait for the rib queries and dumps still using the session
+	if( Sessions[sessionID]->attributeTable != NULL )
+		closeAttrTableWalks(Sessions[sessionID]->attributeTable);
+	if( pthread_rwlock_wrlock(&(Sessions[sessionID]->ribLock)) )
+		log_fatal( "Failed to wrlock the rib tables of session %d", sessionID );
+	pthread_rwlock_unlock(&(Sessions[sessionID]->ribLock));
+	pthread_rwlock_destroy(&(Sessions[sessionID]->ribLock));
 	free( Sessions[sessionID]);
 	Sessions[sessionID] = NULL;
   }
+  pthread_rwlock_unlock(&SessionsLock);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get a session and keep it from being destroyed until unlockSession
+ * Input:  sessionID - ID of the session
+ * Output: the session or NULL if there is no session with this ID
+ * Note: The lock is only held when a session is returned. It is shared by all
+ *       the sessions, so don't hold it while waiting on a client.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+Session_structp
+lockSession( int sessionID )
+{
+	Session_structp session;
+
+	if( sessionID < 0 || sessionID >= MAX_SESSION_IDS )
+		return NULL;
+	if( pthread_rwlock_rdlock(&SessionsLock) )
+		log_fatal( "Failed to rdlock the sessions" );
+	session = Sessions[sessionID];
+	if( session == NULL )
+		pthread_rwlock_unlock(&SessionsLock);
+	return session;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Let a session returned by lockSession be destroyed again
+ * Input:  
+ * Output: 
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+unlockSession()
+{
+	pthread_rwlock_unlock(&SessionsLock);
 }
 
 
@@ -451,6 +517,7 @@ void
 zeroSessionConnectRetryTimer( Session_structp s )
 {
 	s->fsm.connectRetryTimer = 0;
+	updateSessionTimer( s );
 }
 
 /*--------------------------------------------------------------------------------------
@@ -463,6 +530,7 @@ void
 zeroSessionKeepaliveTimer( Session_structp s )
 {
 	s->fsm.keepaliveTimer = 0;
+	updateSessionTimer( s );
 }
 
 /*--------------------------------------------------------------------------------------
@@ -475,6 +543,7 @@ void
 zeroSessionHoldTimer( Session_structp s )
 {
 	s->fsm.holdTimer = 0;
+	updateSessionTimer( s );
 }
 
 /*--------------------------------------------------------------------------------------
@@ -496,13 +565,49 @@ zeroSessionConnectRetryCount( Session_structp s )
  * He Yan @ Sep 22, 2008
  * -------------------------------------------------------------------------------------*/
 int 
-jitter( int seconds )
+jitter( int interval )
 {
 	int factor = 75 + (rand()%26);  // a number in the interval [75,100]
-	int delay = (seconds * factor) / 100;
+	int delay = (int)(((long long)interval * factor) / 100);
 	return( delay );
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the clock of the session timers
+ * Input:
+ * Output: the monotonic time in milliseconds
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long long 
+sessionClock()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return( (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000 );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: File the earliest timer of the session in the timer wheel running it
+ * Input:	the session structure
+ * Output:
+ * Note: Called whenever a timer changes, nothing is done for a session run by
+ *       its own thread.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+updateSessionTimer( Session_structp s )
+{
+	long long t;
+
+	if ( s->fsm.timerWheel == NULL )
+		return;
+	t = sessionTimer( s );
+	if ( t == 0 )
+		cancelTimer( s->fsm.timerWheel, &s->fsm.timerEntry );
+	else
+		scheduleTimer( s->fsm.timerWheel, &s->fsm.timerEntry, t );
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Restart the session's connect retry timer
  * Input:	the session structure
@@ -515,9 +620,10 @@ restartSessionConnectRetryTimer( Session_structp s )
 	int backoff = s->fsm.connectRetryInt * s->stats.connectRetryCount;
 	if ( backoff > 60 )
 		backoff = 60;
-	int delay = jitter( backoff  ); 
-	log_msg("Session(%d):Connect retry delay %d ", s->sessionID, delay);
-	s->fsm.connectRetryTimer = time(NULL) + delay; 
+	int delay = jitter( backoff * 1000 ); 
+	log_msg("Session(%d):Connect retry delay %d ms", s->sessionID, delay);
+	s->fsm.connectRetryTimer = sessionClock() + delay; 
+	updateSessionTimer( s );
 }
 
 /*--------------------------------------------------------------------------------------
@@ -529,8 +635,9 @@ restartSessionConnectRetryTimer( Session_structp s )
  void 
 restartSessionKeepaliveTimer( Session_structp s )
 {
-	int delay = jitter( s->fsm.keepaliveInt );
-	s->fsm.keepaliveTimer = time(NULL) + delay;
+	int delay = jitter( s->fsm.keepaliveInt * 1000 );
+	s->fsm.keepaliveTimer = sessionClock() + delay;
+	updateSessionTimer( s );
 }
 
 /*--------------------------------------------------------------------------------------
@@ -542,8 +649,9 @@ restartSessionKeepaliveTimer( Session_structp s )
 void 
 restartLargeSessionHoldTimer( Session_structp s )
 {
-	int delay = jitter( s->fsm.largeHoldTime );
-	s->fsm.holdTimer = time(NULL) + delay;
+	int delay = jitter( s->fsm.largeHoldTime * 1000 );
+	s->fsm.holdTimer = sessionClock() + delay;
+	updateSessionTimer( s );
 }
 
 /*--------------------------------------------------------------------------------------
@@ -555,20 +663,22 @@ restartLargeSessionHoldTimer( Session_structp s )
  void 
 restartSessionHoldTimer( Session_structp s )
 {
-	int delay = jitter( s->fsm.holdTime );
-	s->fsm.holdTimer = time(NULL) + delay;
+	int delay = jitter( s->fsm.holdTime * 1000 );
+	s->fsm.holdTimer = sessionClock() + delay;
+	updateSessionTimer( s );
 }
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Returns the earliest timer for this session (smallest nonzero) for use in calls to select.
  * Input:	the session structure
- * Output: the value of earliest timer
+ * Output: the value of earliest timer in milliseconds, 0 if none
  * He Yan @ Sep 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-int 
+long long 
 sessionTimer( Session_structp s )
 {
-	int t = 0;
+	long long t = 0;
 	//log_msg( "sessionTimer %d %d %d %d", s->connectRetryTimer, s->holdTimer, s->keepaliveTimer, s->routeRefreshTimer);
 	if ( s->fsm.connectRetryTimer > 0 && ( t == 0 || s->fsm.connectRetryTimer < t ) )
 		t = s->fsm.connectRetryTimer;
@@ -592,12 +702,12 @@ checkTimers( Session_structp s )
 	 * If multiple timers expire, only returns the first.
 	 * Returns eventNone if no timers have expired.
 	 */
-	time_t now = time(NULL);
-	if ( s->fsm.connectRetryTimer > 0 && s->fsm.connectRetryTimer <= now + 1 )
+	long long now = sessionClock();
+	if ( s->fsm.connectRetryTimer > 0 && s->fsm.connectRetryTimer <= now )
 		return( eventConnectRetryTimer_Expires );
-	if ( s->fsm.keepaliveTimer > 0 && s->fsm.keepaliveTimer <= now + 1)
+	if ( s->fsm.keepaliveTimer > 0 && s->fsm.keepaliveTimer <= now )
 		return( eventKeepaliveTimer_Expires );
-	if ( s->fsm.holdTimer > 0 && s->fsm.holdTimer <= now + 1)
+	if ( s->fsm.holdTimer > 0 && s->fsm.holdTimer <= now )
 		return( eventHoldTimer_Expires );
 	return( eventNone );
 }
@@ -696,10 +806,43 @@ Setsockopt(int fd, int level, int optname, const void *optval, socklen_t optlen)
 }
 
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: record the addresses of a tcp connection once it is made
+ * Input:	the session structure
+ * Output: Event to indicate if it successes
+ * He Yan @ Sep 22, 2008
+ * -------------------------------------------------------------------------------------*/
+static int 
+finishConnection( Session_structp session )
+{
+	if( strcmp( session->configInUse.localAddr, IPv4_ANY ) == 0 ||
+		strcmp( session->configInUse.localAddr, IPv6_ANY ) == 0 )
+	{
+		struct sockaddr sock;
+		int slen = sizeof(struct sockaddr); 
+		getsockname(session->fsm.socket, &sock, (socklen_t *)&slen);
+		char *address;
+		int port;
+		if( getAddressFromSockAddr(&sock, &address, &port) )
+		{
+			log_warning( "Unable to get address and port for new connection." );
+			return eventTcpConnectionFails;
+		}
+		setSessionString(session->sessionID,session->configInUse.remoteAddr, session->configInUse.remotePort, session->configInUse.remoteAS2, 
+							session->configInUse.localAddr, session->configInUse.localPort, session->configInUse.localAS2);
+		strcpy(session->sessionRealSrcAddr, address);
+		free(address);
+	}
+	log_msg("Session(%d): tcp connection ok ", session->sessionID);
+	return( eventTcpConnectionConfirmed);
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: complete a tcp connection of a session
  * Input:	the session structure
  * Output: Event to indicate if it successes
+ * Note: A session of the event engine returns eventTcpConnectionPending while
+ *       the connection is in progress, checkConnection completes it.
  * He Yan @ Sep 22, 2008
  * -------------------------------------------------------------------------------------*/
 int 
@@ -764,8 +907,19 @@ completeConnection( Session_structp session )
 		return( eventTcpConnectionFails );
 	}
 	
+	// the event engine doesn't wait for the connection to complete
+	if ( session->fsm.nonBlocking == TRUE )
+		fcntl(session->fsm.socket, F_SETFL, fcntl(session->fsm.socket, F_GETFL) | O_NONBLOCK);
+
 	// connect to the peer
   	int connection = connect(session->fsm.socket, remoteRes->ai_addr, remoteRes->ai_addrlen);
+	if (connection == -1 && errno == EINPROGRESS && session->fsm.nonBlocking == TRUE)
+	{
+		session->fsm.connecting = TRUE;
+		freeaddrinfo(remoteRes);
+		freeaddrinfo(localRes);
+		return( eventTcpConnectionPending );
+	}
 	if (connection == -1)
   	{
   		log_err("Session(%d): tcp connection error:%s", session->sessionID, strerror(errno));
@@ -775,33 +929,46 @@ completeConnection( Session_structp session )
 		freeaddrinfo(localRes);
   		return( eventTcpConnectionFails );
   	}
-	
-	if( strcmp( session->configInUse.localAddr, IPv4_ANY ) == 0 ||
-		strcmp( session->configInUse.localAddr, IPv6_ANY ) == 0 )
-	{
-		struct sockaddr sock;
-		int slen = sizeof(struct sockaddr); 
-		getsockname(session->fsm.socket, &sock, (socklen_t *)&slen);
-		char *address;
-		int port;
-		if( getAddressFromSockAddr(&sock, &address, &port) )
-		{
-			log_warning( "Unable to get address and port for new connection." );
-			freeaddrinfo(remoteRes);
-			freeaddrinfo(localRes);
-			return eventTcpConnectionFails;
-		}
-		setSessionString(session->sessionID,session->configInUse.remoteAddr, session->configInUse.remotePort, session->configInUse.remoteAS2, 
-							session->configInUse.localAddr, session->configInUse.localPort, session->configInUse.localAS2);
-		strcpy(session->sessionRealSrcAddr, address);
-		free(address);
-	}
 	freeaddrinfo(localRes);
 	freeaddrinfo(remoteRes);
-	log_msg("Session(%d): tcp connection ok ", session->sessionID);
-	return( eventTcpConnectionConfirmed);
+	return( finishConnection( session ) );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: check a non-blocking connect once its socket is writable or its timer expired
+ * Input:	the session structure
+ * Output: Event to indicate if it successes
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int 
+checkConnection( Session_structp session )
+{
+	struct pollfd pfd;
+	int error = 0;
+	socklen_t len = sizeof(error);
+
+	session->fsm.connecting = FALSE;
+	pfd.fd = session->fsm.socket;
+	pfd.events = POLLOUT;
+	pfd.revents = 0;
+	if ( poll(&pfd, 1, 0) <= 0 )
+		error = ETIMEDOUT;
+	else if ( getsockopt(session->fsm.socket, SOL_SOCKET, SO_ERROR, &error, &len) < 0 )
+		error = errno;
+	if ( error != 0 )
+	{
+  		log_err("Session(%d): tcp connection error:%s", session->sessionID, strerror(error));
+		close(session->fsm.socket);
+  		session->fsm.socket = -1;
+  		return( eventTcpConnectionFails );
+	}
+
+	// the messages are read only once they have arrived, writes may block as before
+	fcntl(session->fsm.socket, F_SETFL, fcntl(session->fsm.socket, F_GETFL) & ~O_NONBLOCK);
+	return( finishConnection( session ) );
 }
 
+
 /*--------------------------------------------------------------------------------------
  * Purpose: close the connection of a session
  * Input:	the session structure
@@ -819,6 +986,8 @@ dropConnection( Session_structp s )
 #endif	
 	close( s->fsm.socket );
 	s->fsm.socket = -1;
+	s->fsm.connecting = FALSE;
+	resetBGPReader( &s->reader );
 }
 
 /*--------------------------------------------------------------------------------------
@@ -1384,23 +1553,21 @@ receiveBGPMessage( Session_structp session )
 	if ( event != eventNone )
 		return( event );
 	
-	// must have something to read, get the header first.
-	PBgpHeader hdr = NULL;
-	PBgpUpdate update = NULL;
-	PBgpNotification notify = NULL;
-	PBgpRefresh refresh = NULL;
-
+	// must have something to read, frame the next message from the receive buffer
 	BMF bmf = NULL;	
 
-	hdr = readBGPHeader( session->fsm.socket, session->fsm.keepaliveInt);
-	if ( hdr == NULL )
+	u_char *msg = nextBGPMessage( &session->reader, session->fsm.socket );
+	if ( msg == NULL )
 	{
 #ifdef DEBUG
-log_err("receiveBGPMessage: readBGPHeader failed!");
+log_err("receiveBGPMessage: nextBGPMessage failed!");
 #endif
 		event = eventTcpConnectionFails;
 	}
 	else
+	{
+		PBgpHeader hdr = (PBgpHeader)msg;
+		int len = getBGPHeaderLength( hdr );
 		switch ( getBGPHeaderType( hdr ) )
 		{	 
 			case typeKeepalive:
@@ -1408,12 +1575,6 @@ log_err("receiveBGPMessage: readBGPHeader failed!");
 				log_msg("receiveBGPMessage: keepalive");
 				#endif
 				event = eventKeepaliveMsg;
-				
-				bmf = createBMF(session->sessionID,  BMF_TYPE_MSG_FROM_PEER);
-				bgpmonMessageAppend( bmf, hdr, 19);
-				writeQueue( session->peerQueueWriter, bmf );	
-				
-				session->stats.messageRcvd++;
 				break;
 				
 			case typeUpdate:
@@ -1421,70 +1582,43 @@ log_err("receiveBGPMessage: readBGPHeader failed!");
 				log_msg("receiveBGPMessage: update");
 				#endif
 				event = eventUpdateMsg;
-				// read the rest of the update message
-				update = readBGPUpdate( session->fsm.socket, getBGPHeaderLength( hdr )-19 );
-				if ( update == NULL)
-				{
-					event = eventTcpConnectionFails;
-				}
-				else
-				{
-					bmf = createBMF(session->sessionID,  BMF_TYPE_MSG_FROM_PEER);
-					bgpmonMessageAppend( bmf, hdr, 19);
-					bgpmonMessageAppend( bmf, update, getBGPHeaderLength(hdr)-19);
-					//if the message creation failed, don't enqueue the message!
-					if(bmf->length < getBGPHeaderLength(hdr)) break;
-
-					writeQueue( session->peerQueueWriter, bmf );
-					
-					session->stats.messageRcvd++;	
-				}
 				break;
 				
 			case typeNotification:
-				
 				event = eventNotificationMessage;
-				// read the rest of the notification message
-				notify = readBGPNotification( session->fsm.socket, getBGPHeaderLength( hdr )-19 );
-				if ( notify == NULL )
-				{
-					event = eventTcpConnectionFails;
-					break;
-				}
-				
-				bmf = createBMF(session->sessionID,  BMF_TYPE_MSG_FROM_PEER);
-				bgpmonMessageAppend( bmf, hdr, 19);
-				bgpmonMessageAppend( bmf, notify, getBGPHeaderLength(hdr)-19);
-				writeQueue( session->peerQueueWriter, bmf );	
-				
-				session->stats.messageRcvd++;	
 				#ifdef DEBUG
-				log_msg("receiveBGPMessage: notification: %d %d", notify->errorCode, notify->errorSubcode);
+				if ( len > 20 )
+					log_msg("receiveBGPMessage: notification: %d %d", msg[19], msg[20]);
 				#endif
 				break;
 				
 			case typeRouteRefresh:
 				// we don't support
 				event = eventUpdateMsgErr;
-				session->stats.messageRcvd++;
 				break;
 				
 			case typeOpen:
 				event = eventUpdateMsgErr;
-				session->stats.messageRcvd++;
 				break;
 				
 			default:
 				event = eventUpdateMsgErr;
-				session->stats.messageRcvd++;
 				break;
 		}
-	
-	// cleanup memory
-	destroyBGPRefresh(refresh);
-	destroyBGPNotification(notify);
-	destroyBGPUpdate(update);
-	destroyBGPHeader( hdr );
+		session->stats.messageRcvd++;
+
+		// the message is copied from the receive buffer into its BMF once
+		if ( event != eventUpdateMsgErr )
+		{
+			bmf = createBMFWithLength(session->sessionID,  BMF_TYPE_MSG_FROM_PEER, len);
+			bgpmonMessageAppend( bmf, msg, len );
+			//if the message creation failed, don't enqueue the message!
+			if( bmf->length < len )
+				destroyBMF( bmf );
+			else
+				writeQueue( session->peerQueueWriter, bmf );
+		}
+	}
 	
 	return( event );	
 }
@@ -1550,42 +1684,47 @@ void
 nextStepOfSession( Session_structp session )
 {
 	// timeout values
-	time_t now = time(NULL);
+	long long now = sessionClock();
+	long long timer;
 	struct timeval timeout; 
-	timeout.tv_usec = 0;
-	timeout.tv_sec = 0; 
 	int select_status = 0;
 	// sockets monitoring values
 	int fdMax = 0;
 	fd_set sockets;
-	FD_ZERO(&sockets); 
 
 	if ( session->fsm.state == stateIdle )
 		return;
-		
-	if ( sessionTimer( session ) <= now )
-	{
-		// timeout already occurred
-		return; 
-	}
-	else
+
+	// a message already framed in the receive buffer is handled right away
+	if ( hasBGPMessage( &session->reader ) )
+		return;
+
+	// wait until the earliest timer expired or data is available, select may wake early
+	while ( (timer = sessionTimer( session )) > now )
 	{
 		// earliest future timeout
-		timeout.tv_sec = sessionTimer( session) - now ;
-	}
+		timeout.tv_sec = (timer - now) / 1000;
+		timeout.tv_usec = ((timer - now) % 1000) * 1000;
 
-	if ( session->fsm.socket> 0 )
-	{
-		// check for data if the Session_structp has an open socket.
-		FD_SET( session->fsm.socket, &sockets);
-		if ( session->fsm.socket + 1 > fdMax )
-			fdMax = session->fsm.socket + 1;
-	}
-	//log_msg( "nextStepOfSession %d", timeout.tv_sec);
-	// wait for timeout or available data
-	if ( (select_status = select(fdMax, &sockets, NULL, NULL, &timeout)) < 0 )
-		log_fatal( "NextStepOfSession: select error");	
-	//log_msg( "nextStepOfSession");
+		FD_ZERO(&sockets); 
+		fdMax = 0;
+		if ( session->fsm.socket> 0 )
+		{
+			// check for data if the Session_structp has an open socket.
+			FD_SET( session->fsm.socket, &sockets);
+			if ( session->fsm.socket + 1 > fdMax )
+				fdMax = session->fsm.socket + 1;
+		}
+		//log_msg( "nextStepOfSession %d", timeout.tv_sec);
+		// wait for timeout or available data
+		if ( (select_status = select(fdMax, &sockets, NULL, NULL, &timeout)) < 0 )
+			log_fatal( "NextStepOfSession: select error");	
+		//log_msg( "nextStepOfSession");
+		if ( select_status > 0 )
+			return;
+		now = sessionClock();
+	}
+	// timeout already occurred
 	return;
 }
 
@@ -1668,6 +1807,13 @@ void cleanupSession( Session_structp session )
 	// reset the session as usual
 	resetSession( session, eventManualStop );
 
+	// leave the timer wheel of the event loop
+	if ( session->fsm.timerWheel != NULL )
+	{
+		cancelTimer( session->fsm.timerWheel, &session->fsm.timerEntry );
+		session->fsm.timerWheel = NULL;
+	}
+
 	// clear the thread control flags
 	session->reconnectFlag = FALSE;
 	session->lastAction = time(NULL);
@@ -1870,8 +2016,12 @@ void setSessionLabelAction(int sessionID, int labelAction)
 		log_msg("setSessionLabelAction: from %d to %d", Sessions[sessionID]->configInUse.labelAction, labelAction);
 		if( Sessions[sessionID]->configInUse.labelAction == NoAction )
 		{
+			// the rib queries see the tables once they are complete
+			if( pthread_rwlock_wrlock(&(Sessions[sessionID]->ribLock)) )
+				log_fatal( "Failed to wrlock the rib tables of session %d", sessionID );
 			createPrefixTable(Sessions[sessionID]->sessionID, PREFIX_TABLE_SIZE, MAX_HASH_COLLISION);
 			createAttributeTable(Sessions[sessionID]->sessionID, ATTRIBUTE_TABLE_SIZE, MAX_HASH_COLLISION);
+			pthread_rwlock_unlock(&(Sessions[sessionID]->ribLock));
 		}
 		else
 		{
@@ -2185,6 +2335,54 @@ int getSessionAttributeCount(int sessionID)
 	return Sessions[sessionID]->stats.attrCount;
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: get the load factor of the prefix table of a session
+ * Input:	the session's ID
+ * Output: the percent of the prefix table slots in use
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int getSessionPrefixTableLoad(int sessionID)
+{
+	// check the session ID is valid
+	if (sessionID >= MAX_SESSION_IDS)
+	{
+		log_err("getSessionPrefixTableLoad: session ID %d exceeds max %d", sessionID, MAX_SESSION_IDS);
+		return -1;
+	}
+	// check if the session is existing
+	if( Sessions[sessionID] == NULL ) 
+	{
+		log_err("getSessionPrefixTableLoad: couldn't find a session with ID:%d", sessionID);
+		return -1;
+	}
+	if( Sessions[sessionID]->stats.prefixTableSize == 0 )
+		return 0;
+	return (int)((u_int64_t)Sessions[sessionID]->stats.prefixCount*100/Sessions[sessionID]->stats.prefixTableSize);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: get the longest probe length of the prefix table of a session
+ * Input:	the session's ID
+ * Output: the number of slots checked by the longest lookup
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int getSessionPrefixMaxProbe(int sessionID)
+{
+	// check the session ID is valid
+	if (sessionID >= MAX_SESSION_IDS)
+	{
+		log_err("getSessionPrefixMaxProbe: session ID %d exceeds max %d", sessionID, MAX_SESSION_IDS);
+		return -1;
+	}
+	// check if the session is existing
+	if( Sessions[sessionID] == NULL ) 
+	{
+		log_err("getSessionPrefixMaxProbe: couldn't find a session with ID:%d", sessionID);
+		return -1;
+	}
+	return Sessions[sessionID]->stats.prefixMaxProbe;
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: get the memory usage of a session
  * Input:	the session's ID
@@ -3036,6 +3234,107 @@ void printAllSessions()
 }
 
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: run one step of the BGP finite state machine of a peer's session
+ * Input:	the peer ID and a pointer to the ID of its session, which is replaced 
+ *		when the session is reset
+ * Output: PEER_STEP_RUNNING while the peer keeps running,
+ *	   PEER_STEP_CLOSING if the peer is deleted and the session must be cleaned up,
+ *	   PEER_STEP_CLOSED if the peer is deleted and no session is left
+ * Note: The caller waits for the session's socket or timers before each step.
+ * He Yan @ Sep 22, 2008
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int
+runPeerSession( int peerID, int *psessionID )
+{
+	int sessionID = *psessionID;
+
+	// set the session ID
+	if( setPeerSessionID(peerID, sessionID) < 0 )
+	{			
+		log_msg("closing thread as peer %d is deleted!", peerID);
+		return PEER_STEP_CLOSING;
+	}
+	
+	// set the last action time
+	Sessions[sessionID]->lastAction = time(NULL);
+
+	// store the state before running FSM
+	int oldState = Sessions[sessionID]->fsm.state;
+	
+	// run BGP finite state machine
+	bgpFiniteStateMachine( Sessions[sessionID] );
+
+	// display the state change 
+	if( Sessions[sessionID]->fsm.state != oldState )
+	{
+		log_msg("peer %d's is changed from %d to %d", peerID, oldState, Sessions[sessionID]->fsm.state);
+	}
+
+	// check the reconnect flag is true or session state is changed to idle
+	if( Sessions[sessionID]->reconnectFlag == TRUE || ( oldState != stateConnect && Sessions[sessionID]->fsm.state == stateIdle ))
+	{
+		// clean up the current session
+		int downCount = Sessions[sessionID]->stats.sessionDownCount;
+		time_t lastDownTime = Sessions[sessionID]->stats.lastDownTime;
+		cleanupSession( Sessions[sessionID] );
+
+		// create a new session with the latest peer configuration
+		sessionID = createSessionStruct( peerID, downCount, lastDownTime );
+		*psessionID = sessionID;
+		if( sessionID == -1 )
+		{
+			log_msg("session(%d): closing thread as peer %d is deleted!", sessionID, peerID);	
+			return PEER_STEP_CLOSED;
+		}
+	}
+	else if( Sessions[sessionID]->fsm.state != oldState )
+	{
+		BMF bmf = NULL;
+		bmf = createStateChangeMsg( sessionID, oldState, Sessions[sessionID]->fsm.state, Sessions[sessionID]->fsm.reason );
+		writeQueue( Sessions[sessionID]->peerQueueWriter, bmf );		
+	}
+	
+	// update the session configuration in use, for the session which bounces between idle and connect 
+	if( Sessions[sessionID]->fsm.state == stateConnect && Sessions[sessionID]->stats.connectRetryCount != 0 )
+	{
+		if( setSessionConfigInUse(peerID, Sessions[sessionID]) < 0 )
+		{
+			log_msg("session(%d): closing thread as peer %d is deleted!", sessionID, peerID);
+			return PEER_STEP_CLOSING;
+		}
+		else
+		{
+			setSessionString(sessionID, Sessions[sessionID]->configInUse.remoteAddr, Sessions[sessionID]->configInUse.remotePort, Sessions[sessionID]->configInUse.remoteAS2, 
+								Sessions[sessionID]->configInUse.localAddr, Sessions[sessionID]->configInUse.localPort, Sessions[sessionID]->configInUse.localAS2);
+			strcpy(Sessions[sessionID]->sessionRealSrcAddr, Sessions[sessionID]->configInUse.localAddr);
+		}
+		if( getPeerLabelAction(peerID) < 0 )
+		{
+			log_msg("session(%d): closing thread as peer %d is deleted!", sessionID, peerID);
+			return PEER_STEP_CLOSING;
+		}
+		else
+			setSessionLabelAction(sessionID, getPeerLabelAction(peerID));
+	}
+
+	// check the route refresh flag
+	if( Sessions[sessionID]->fsm.routeRefreshFlag == 1 && Sessions[sessionID]->fsm.state == stateEstablished )
+	{
+		log_msg( "session(%d): Send a route refresh!", sessionID);
+		Sessions[sessionID]->fsm.routeRefreshFlag = 0;
+		int event = sendRouteRefreshMessage( Sessions[sessionID] );
+		if( event != eventNone )
+		{
+			log_err("session(%d) was reset! Reason:%d", sessionID, event);
+			resetSession( Sessions[sessionID], event);
+		}
+	}			
+
+	return PEER_STEP_RUNNING;
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: the main function of a peer
  * Input:	the peer ID
@@ -3062,87 +3361,13 @@ peerThreadFunction( void *arg )
 	// main loop starts
 	while( getPeerEnabledFlag(peerID) == TRUE )
 	{
-		// set the session ID
-		if( setPeerSessionID(peerID, sessionID) < 0 )
-		{			
-			log_msg("closing thread as peer %d is deleted!", peerID);
-			break;
-		}
-		
-		// set the last action time
-		Sessions[sessionID]->lastAction = time(NULL);
-
-		// store the state before running FSM
-		int oldState = Sessions[sessionID]->fsm.state;
-		
-		// run BGP finite state machine
+		// wait for data or the next timer, then run the state machine
 		nextStepOfSession( Sessions[sessionID] );
-  		bgpFiniteStateMachine( Sessions[sessionID] );
-
-		// display the state change 
-		if( Sessions[sessionID]->fsm.state != oldState )
-		{
-			log_msg("peer %d's is changed from %d to %d", peerID, oldState, Sessions[sessionID]->fsm.state);
-		}
-
-		// check the reconnect flag is true or session state is changed to idle
-		if( Sessions[sessionID]->reconnectFlag == TRUE || ( oldState != stateConnect && Sessions[sessionID]->fsm.state == stateIdle ))
-		{
-			// clean up the current session
-			int downCount = Sessions[sessionID]->stats.sessionDownCount;
-			time_t lastDownTime = Sessions[sessionID]->stats.lastDownTime;
-			cleanupSession( Sessions[sessionID] );
-
-			// create a new session with the latest peer configuration
-			sessionID = createSessionStruct( peerID, downCount, lastDownTime );
-			if( sessionID == -1 )
-			{
-				log_msg("session(%d): closing thread as peer %d is deleted!", sessionID, peerID);	
-				pthread_exit( NULL );	
-			}
-		}
-		else if( Sessions[sessionID]->fsm.state != oldState )
-		{
-			BMF bmf = NULL;
-			bmf = createStateChangeMsg( sessionID, oldState, Sessions[sessionID]->fsm.state, Sessions[sessionID]->fsm.reason );
-			writeQueue( Sessions[sessionID]->peerQueueWriter, bmf );		
-		}
-		
-		// update the session configuration in use, for the session which bounces between idle and connect 
-		if( Sessions[sessionID]->fsm.state == stateConnect && Sessions[sessionID]->stats.connectRetryCount != 0 )
-		{
-			if( setSessionConfigInUse(peerID, Sessions[sessionID]) < 0 )
-			{
-				log_msg("session(%d): closing thread as peer %d is deleted!", sessionID, peerID);
-				break;
-			}
-			else
-			{
-				setSessionString(sessionID, Sessions[sessionID]->configInUse.remoteAddr, Sessions[sessionID]->configInUse.remotePort, Sessions[sessionID]->configInUse.remoteAS2, 
-									Sessions[sessionID]->configInUse.localAddr, Sessions[sessionID]->configInUse.localPort, Sessions[sessionID]->configInUse.localAS2);
-				strcpy(Sessions[sessionID]->sessionRealSrcAddr, Sessions[sessionID]->configInUse.localAddr);
-			}
-			if( getPeerLabelAction(peerID) < 0 )
-			{
-				log_msg("session(%d): closing thread as peer %d is deleted!", sessionID, peerID);
-				break;
-			}
-			else
-				setSessionLabelAction(sessionID, getPeerLabelAction(peerID));
-		}
-
-		// check the route refresh flag
-		if( Sessions[sessionID]->fsm.routeRefreshFlag == 1 && Sessions[sessionID]->fsm.state == stateEstablished )
-		{
-			log_msg( "session(%d): Send a route refresh!", sessionID);
-			Sessions[sessionID]->fsm.routeRefreshFlag = 0;
-			int event = sendRouteRefreshMessage( Sessions[sessionID] );
-			if( event != eventNone )
-			{
-				log_err("session(%d) was reset! Reason:%d", sessionID, event);
-				resetSession( Sessions[sessionID], event);
-			}
-		}			
+		int step = runPeerSession( peerID, &sessionID );
+		if( step == PEER_STEP_CLOSED )
+			pthread_exit( NULL );	
+		if( step == PEER_STEP_CLOSING )
+			break;
 	}
 
 	log_msg("peer %d! is closing", peerID);	
@@ -37,6 +37,7 @@
 
 #include "../Queues/queue.h"
 #include "bgppacket.h"
+#include "timerwheel.h"
 #include "peers.h"
 #include "../Labeling/rtable.h"
 /* required for TRUE/FALSE defines  */
@@ -51,16 +52,20 @@ struct FSMStruct
 	int 			state; // the state of BGP FSM
 	int				reason;	// the reason of changing state
 	int 			connectRetryInt;
-	time_t			connectRetryTimer;
+	long long		connectRetryTimer;	// timers are in milliseconds of sessionClock
 	int 			keepaliveInt;
-	time_t			keepaliveTimer;
+	long long		keepaliveTimer;
 	int 			largeHoldTime;
 	int 			holdTime;
-	time_t			holdTimer;
+	long long		holdTimer;
 	int 			routeRefreshType;
 	int 			routeRefreshFlag;	// set by periodic module
         int 			ASNumlen; 		// 2 bytes or 4 bytes AS number 
 	PBgpCapabilities	peerCapabilities; // received Peer Capabilities	
+	int			nonBlocking;	// connect without blocking, for the event engine
+	int			connecting;	// a non-blocking connect is in progress
+	TimerWheel		*timerWheel;	// wheel of the event loop running the session, or NULL
+	TimerEntry		timerEntry;	// the earliest timer, filed in timerWheel
 };
 typedef struct FSMStruct FSM;
 
@@ -107,6 +112,8 @@ typedef struct StateChangeStruct StateChangeMsg;
 	long			memoryUsed;
 	int				prefixCount;
 	int				attrCount;
+	u_int32_t		prefixTableSize;
+	int				prefixMaxProbe;
  };
  typedef struct StatisticsStruct Statistics;
 
@@ -160,6 +167,9 @@ struct SessionStruct
 
 	/*peer queue writer*/
 	QueueWriter		peerQueueWriter;
+
+	/*receive buffer of the established session*/
+	struct BGPReaderStruct	reader;
 		
 	/*outgoing peering string for XML module*/
 	char				*sessionStringOutgoing;
@@ -176,6 +186,9 @@ struct SessionStruct
 	/*Attribute Table*/
 	AttrTable		*attributeTable;
 
+	/*read locked to use the rib tables from other threads, write locked to create or delete them*/
+	pthread_rwlock_t	ribLock;
+
 	/* thread related fields */
 	int			reconnectFlag;
 	time_t		lastAction;
@@ -241,6 +254,26 @@ int findSession( u_int32_t srcAS, u_int32_t dstAS, int srcPort, int dstPort, cha
 void 
 destroySession( int sessionID );
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get a session and keep it from being destroyed until unlockSession
+ * Input:  sessionID - ID of the session
+ * Output: the session or NULL if there is no session with this ID
+ * Note: The lock is only held when a session is returned. It is shared by all
+ *       the sessions, so don't hold it while waiting on a client.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+Session_structp
+lockSession( int sessionID );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Let a session returned by lockSession be destroyed again
+ * Input:  
+ * Output: 
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+unlockSession();
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Zero the session's connect retry timer
  * Input:	the session structure
@@ -279,12 +312,33 @@ zeroSessionConnectRetryCount( Session_structp s );
 
 /*--------------------------------------------------------------------------------------
  * Purpose: implements jitter for the timers in the range 75%-100% of the expected time.
- * Input:	the time in seconds
+ * Input:	the time, in any unit
  * Output: jitter time
  * He Yan @ Sep 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 int 
-jitter( int seconds );
+jitter( int interval );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the clock of the session timers
+ * Input:
+ * Output: the monotonic time in milliseconds
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long long 
+sessionClock();
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: File the earliest timer of the session in the timer wheel running it
+ * Input:	the session structure
+ * Output:
+ * Note: Called whenever a timer changes, nothing is done for a session run by
+ *       its own thread.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+updateSessionTimer( Session_structp s );
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Restart the session's connect retry timer
@@ -325,10 +379,11 @@ restartSessionHoldTimer( Session_structp s );
 /*--------------------------------------------------------------------------------------
  * Purpose: Returns the earliest timer for this session (smallest nonzero) for use in calls to select.
  * Input:	the session structure
- * Output: the value of earliest timer
+ * Output: the value of earliest timer in milliseconds, 0 if none
  * He Yan @ Sep 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-int 
+long long 
 sessionTimer( Session_structp s );
 
 /*--------------------------------------------------------------------------------------
@@ -381,11 +436,22 @@ Setsockopt(int fd, int level, int optname, const void *optval, socklen_t optlen)
  * Purpose: complete a tcp connection of a session
  * Input:	the session structure
  * Output: Event to indicate if it successes
+ * Note: A session of the event engine returns eventTcpConnectionPending while
+ *       the connection is in progress, checkConnection completes it.
  * He Yan @ Sep 22, 2008
  * -------------------------------------------------------------------------------------*/
 int 
 completeConnection( Session_structp session );
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: check a non-blocking connect once its socket is writable or its timer expired
+ * Input:	the session structure
+ * Output: Event to indicate if it successes
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int 
+checkConnection( Session_structp session );
+
 /*--------------------------------------------------------------------------------------
  * Purpose: close the connection of a session
  * Input:	the session structure
@@ -701,6 +767,22 @@ int getSessionPrefixCount(int sessionID);
  * -------------------------------------------------------------------------------------*/
 int getSessionAttributeCount(int sessionID);
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: get the load factor of the prefix table of a session
+ * Input:	the session's ID
+ * Output: the percent of the prefix table slots in use
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int getSessionPrefixTableLoad(int sessionID);
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: get the longest probe length of the prefix table of a session
+ * Input:	the session's ID
+ * Output: the number of slots checked by the longest lookup
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int getSessionPrefixMaxProbe(int sessionID);
+
 /*--------------------------------------------------------------------------------------
  * Purpose: get the memory usage of a session
  * Input:	the session's ID
@@ -936,6 +1018,24 @@ int setSessionASNumberLength( int sessionID, int ASNumLen);
  * -------------------------------------------------------------------------------------*/
 void printAllSessions();
 
+/* results of a step of a peer's session */
+#define PEER_STEP_RUNNING	0
+#define PEER_STEP_CLOSING	1
+#define PEER_STEP_CLOSED	2
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: run one step of the BGP finite state machine of a peer's session
+ * Input:	the peer ID and a pointer to the ID of its session, which is replaced 
+ *		when the session is reset
+ * Output: PEER_STEP_RUNNING while the peer keeps running,
+ *	   PEER_STEP_CLOSING if the peer is deleted and the session must be cleaned up,
+ *	   PEER_STEP_CLOSED if the peer is deleted and no session is left
+ * Note: The caller waits for the session's socket or timers before each step.
+ * He Yan @ Sep 22, 2008
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+int runPeerSession( int peerID, int *psessionID );
+
 /*--------------------------------------------------------------------------------------
  * Purpose: the main function of a peer
  * Input:	the peer ID
@@ -0,0 +1,239 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: timerwheel.c
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "timerwheel.h"
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: file a timer in a slot list
+ * Input:  the slot list and the timer
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+linkTimer( TimerEntry **list, TimerEntry *entry )
+{
+	entry->list = list;
+	entry->prev = NULL;
+	entry->next = *list;
+	if ( *list != NULL )
+		(*list)->prev = entry;
+	*list = entry;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: remove a timer from its slot list
+ * Input:  the timer
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+unlinkTimer( TimerEntry *entry )
+{
+	if ( entry->prev != NULL )
+		entry->prev->next = entry->next;
+	else
+		*entry->list = entry->next;
+	if ( entry->next != NULL )
+		entry->next->prev = entry->prev;
+	entry->list = NULL;
+	entry->prev = entry->next = NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: file a timer in the level and slot reaching its expiration
+ * Input:  the wheel and the timer
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+fileTimer( TimerWheel *wheel, TimerEntry *entry )
+{
+	// round up, so a timer never fires early
+	long long expTick = (entry->expires + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+	long long delta = expTick - wheel->tick;
+	int level;
+
+	// a timer due at the current tick is past its slot of level 0
+	if ( delta <= 0 )
+	{
+		linkTimer( &wheel->expired, entry );
+		return;
+	}
+	// beyond the last level the timer is filed at its reach and cascaded again
+	if ( delta >= 1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS) )
+	{
+		delta = (1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) - 1;
+		expTick = wheel->tick + delta;
+	}
+	for ( level = 0; level < TIMER_WHEEL_LEVELS - 1; level++ )
+	{
+		if ( delta < 1LL << (TIMER_WHEEL_BITS * (level + 1)) )
+			break;
+	}
+	linkTimer( &wheel->slots[level][(expTick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK], entry );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: fire all timers of a list
+ * Input:  the wheel and the list
+ * Output: the number of timers fired
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+fireTimers( TimerWheel *wheel, TimerEntry **list )
+{
+	int fired = 0;
+	while ( *list != NULL )
+	{
+		TimerEntry *entry = *list;
+		unlinkTimer( entry );
+		wheel->count--;
+		fired++;
+		if ( entry->callback != NULL )
+			entry->callback( entry );
+	}
+	return( fired );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: fire the timers on the expired list
+ * Input:  the wheel
+ * Output: the number of timers fired
+ * Note:   the list is taken first, so a callback scheduling its timer again in the
+ *         past fires at the next advance
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+fireExpiredTimers( TimerWheel *wheel )
+{
+	TimerEntry *due = wheel->expired;
+	TimerEntry *entry;
+
+	wheel->expired = NULL;
+	for ( entry = due; entry != NULL; entry = entry->next )
+		entry->list = &due;
+	return( fireTimers( wheel, &due ) );
+}
+
+void
+initTimerWheel( TimerWheel *wheel, long long now )
+{
+	memset( wheel, 0, sizeof(TimerWheel) );
+	wheel->tick = now / TIMER_WHEEL_TICK_MS;
+}
+
+void
+initTimerEntry( TimerEntry *entry, TimerCallback callback, void *data )
+{
+	entry->expires = 0;
+	entry->callback = callback;
+	entry->data = data;
+	entry->list = NULL;
+	entry->prev = entry->next = NULL;
+}
+
+void
+scheduleTimer( TimerWheel *wheel, TimerEntry *entry, long long expires )
+{
+	if ( entry->list != NULL )
+	{
+		if ( entry->expires == expires )
+			return;
+		unlinkTimer( entry );
+		wheel->count--;
+	}
+	entry->expires = expires;
+	fileTimer( wheel, entry );
+	wheel->count++;
+}
+
+void
+cancelTimer( TimerWheel *wheel, TimerEntry *entry )
+{
+	if ( entry->list == NULL )
+		return;
+	unlinkTimer( entry );
+	wheel->count--;
+}
+
+int
+advanceTimerWheel( TimerWheel *wheel, long long now )
+{
+	long long nowTick = now / TIMER_WHEEL_TICK_MS;
+	int fired = fireExpiredTimers( wheel );
+	int level;
+
+	while ( wheel->tick < nowTick )
+	{
+		wheel->tick++;
+		// when a level wraps, move the next slot of the level above down
+		for ( level = 1; level < TIMER_WHEEL_LEVELS; level++ )
+		{
+			if ( (wheel->tick & ((1LL << (TIMER_WHEEL_BITS * level)) - 1)) != 0 )
+				break;
+			TimerEntry **list = &wheel->slots[level][(wheel->tick >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK];
+			while ( *list != NULL )
+			{
+				TimerEntry *entry = *list;
+				unlinkTimer( entry );
+				fileTimer( wheel, entry );
+			}
+		}
+		fired += fireTimers( wheel, &wheel->slots[0][wheel->tick & TIMER_WHEEL_MASK] );
+	}
+	// the timers cascaded or scheduled at the current tick
+	fired += fireExpiredTimers( wheel );
+	return( fired );
+}
+
+int
+nextTimerWheelTimeout( TimerWheel *wheel, long long now, int maxWait )
+{
+	long long tick;
+	long long wait;
+
+	if ( wheel->expired != NULL )
+		return( 0 );
+	if ( wheel->count == 0 )
+		return( maxWait );
+	// the first busy slot of level 0 up to its wrap, where the levels above cascade
+	for ( tick = wheel->tick + 1; ; tick++ )
+	{
+		if ( wheel->slots[0][tick & TIMER_WHEEL_MASK] != NULL || (tick & TIMER_WHEEL_MASK) == 0 )
+			break;
+	}
+	wait = tick * TIMER_WHEEL_TICK_MS - now;
+	if ( wait < 0 )
+		wait = 0;
+	return( wait < maxWait ? (int)wait : maxWait );
+}
@@ -0,0 +1,129 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: timerwheel.h
+ * 	Authors: agent
+ *  Data: Oct 17, 2026
+ */
+
+#ifndef TIMERWHEEL_H_
+#define TIMERWHEEL_H_
+
+/*
+ * A hierarchical timing wheel.  Level 0 has one slot per tick, each
+ * higher level has slots TIMER_WHEEL_SLOTS times as wide.  A timer is
+ * filed in the lowest level that reaches its expiration and moves down
+ * a level each time the level below wraps, so scheduling, cancelling
+ * and expiring a timer are constant time whatever the number of timers.
+ * Timers never fire before their expiration, which is rounded up to
+ * the next tick.  A wheel is not locked, it belongs to one thread.
+ */
+
+/* milliseconds per tick */
+#define TIMER_WHEEL_TICK_MS	10
+/* slots per level, a power of 2 */
+#define TIMER_WHEEL_BITS	6
+#define TIMER_WHEEL_SLOTS	(1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK	(TIMER_WHEEL_SLOTS - 1)
+/* 4 levels of 64 slots of 10 ms reach 46 hours, later timers are cascaded again */
+#define TIMER_WHEEL_LEVELS	4
+
+struct TimerEntryStruct;
+typedef void (*TimerCallback)( struct TimerEntryStruct *entry );
+
+/* a timer, embedded in the structure it belongs to */
+struct TimerEntryStruct
+{
+	long long		expires;	// expiration in milliseconds
+	TimerCallback	callback;	// called when the timer expires
+	void			*data;		// owner of the timer
+	struct TimerEntryStruct	**list;	// slot the timer is filed in, NULL if not scheduled
+	struct TimerEntryStruct	*prev;
+	struct TimerEntryStruct	*next;
+};
+typedef struct TimerEntryStruct TimerEntry;
+
+struct TimerWheelStruct
+{
+	long long		tick;		// last tick processed
+	int				count;		// number of timers scheduled
+	TimerEntry		*expired;	// timers scheduled in the past
+	TimerEntry		*slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+typedef struct TimerWheelStruct TimerWheel;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize an empty timer wheel
+ * Input:  the wheel and the current time in milliseconds
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void initTimerWheel( TimerWheel *wheel, long long now );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize a timer that is not scheduled
+ * Input:  the timer, the function called when it expires and its owner
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void initTimerEntry( TimerEntry *entry, TimerCallback callback, void *data );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Schedule a timer, or move it if already scheduled
+ * Input:  the wheel, the timer and its expiration in milliseconds
+ * Output: none
+ * Note: A timer expiring at or before the current tick fires on the next advance.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void scheduleTimer( TimerWheel *wheel, TimerEntry *entry, long long expires );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Cancel a timer, nothing is done if it is not scheduled
+ * Input:  the wheel and the timer
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void cancelTimer( TimerWheel *wheel, TimerEntry *entry );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Advance the wheel to the current time and fire the expired timers
+ * Input:  the wheel and the current time in milliseconds
+ * Output: the number of timers fired
+ * Note: A timer is unscheduled before its callback runs, so the callback may
+ *       schedule it again.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int advanceTimerWheel( TimerWheel *wheel, long long now );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get how long the owner of the wheel may sleep
+ * Input:  the wheel, the current time and the longest sleep, in milliseconds
+ * Output: the time to sleep in milliseconds
+ * Note: Past the next level 0 wrap the wheel is advanced to cascade its timers.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int nextTimerWheelTimeout( TimerWheel *wheel, long long now, int maxWait );
+
+#endif /*TIMERWHEEL_H_*/
@@ -0,0 +1,266 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ *	
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: timerwheel_t.c
+ *  Authors: agent
+ *  Date: Oct 17, 2026
+ */
+#include <CUnit/Basic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "timerwheel.h"
+
+/* a few global variables to play with across tests */
+#define TW_TEST_TIMERS 64
+
+TimerWheel twWheel;
+TimerEntry twTimers[TW_TEST_TIMERS];
+long long twFiredAt[TW_TEST_TIMERS];
+int twOrder[TW_TEST_TIMERS];
+int twFiredCount;
+long long twNow;
+
+/* records when and in which order the timers fire */
+static void
+twRecordTimer(TimerEntry *entry)
+{
+  int i = entry - twTimers;
+  twFiredAt[i] = twNow;
+  twOrder[twFiredCount++] = i;
+}
+
+/* schedules the timer again one second later */
+static void
+twRepeatTimer(TimerEntry *entry)
+{
+  twRecordTimer(entry);
+  scheduleTimer(&twWheel, entry, entry->expires + 1000);
+}
+
+/* first time a wheel advanced every tick from its start reaches an expiration */
+static long long
+twDueTime(long long expires)
+{
+  return (expires + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS * TIMER_WHEEL_TICK_MS;
+}
+
+static void
+twReset(long long now)
+{
+  int i;
+  twNow = now;
+  twFiredCount = 0;
+  initTimerWheel(&twWheel, now);
+  for(i = 0; i < TW_TEST_TIMERS; i++){
+    initTimerEntry(&twTimers[i], twRecordTimer, NULL);
+    twFiredAt[i] = -1;
+    twOrder[i] = -1;
+  }
+}
+
+/* level of the slot a timer is filed in, -1 if it is not in a slot */
+static int
+twLevel(TimerEntry *entry)
+{
+  if(entry->list < &twWheel.slots[0][0] || entry->list > &twWheel.slots[TIMER_WHEEL_LEVELS-1][TIMER_WHEEL_MASK]){
+    return -1;
+  }
+  return (entry->list - &twWheel.slots[0][0]) / TIMER_WHEEL_SLOTS;
+}
+
+/* advances the wheel one tick at a time up to end */
+static void
+twRun(long long end)
+{
+  while(twNow < end){
+    twNow += TIMER_WHEEL_TICK_MS;
+    advanceTimerWheel(&twWheel, twNow);
+  }
+}
+
+/* The suite initialization function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+init_timerwheel(void)
+{
+  return 0;
+}
+
+/* The suite cleanup function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+clean_timerwheel(void)
+{
+  return 0;
+}
+
+/* TEST: timers fire in expiration order, at the first tick that reaches their expiration
+ */
+void
+testTimerWheel_expiryOrder()
+{
+  long long start = 1000000;
+  int i;
+
+  twReset(start);
+  // scrambled expirations within the reach of level 0, some of them on the same tick
+  for(i = 0; i < TW_TEST_TIMERS; i++){
+    scheduleTimer(&twWheel, &twTimers[i], start + 1 + (i * 37) % 600);
+  }
+  CU_ASSERT(TW_TEST_TIMERS == twWheel.count);
+
+  twRun(start + 700);
+  CU_ASSERT(TW_TEST_TIMERS == twFiredCount);
+  CU_ASSERT(0 == twWheel.count);
+  for(i = 0; i < TW_TEST_TIMERS; i++){
+    CU_ASSERT(twFiredAt[i] == twDueTime(twTimers[i].expires));
+    CU_ASSERT(twFiredAt[i] >= twTimers[i].expires);
+    CU_ASSERT(NULL == twTimers[i].list);
+  }
+  for(i = 1; i < TW_TEST_TIMERS; i++){
+    CU_ASSERT(twFiredAt[twOrder[i-1]] <= twFiredAt[twOrder[i]]);
+  }
+}
+
+/* TEST: timers filed in the higher levels move down as the levels below wrap
+ *       and fire on their own tick
+ */
+void
+testTimerWheel_cascade()
+{
+  long long start = 123456780;
+  long long reach, boundary;
+  int level, i = 0;
+
+  twReset(start);
+  // a few timers around the start and the end of the reach of each level
+  for(level = 0; level < TIMER_WHEEL_LEVELS - 1; level++){
+    reach = (1LL << (TIMER_WHEEL_BITS * (level + 1))) * TIMER_WHEEL_TICK_MS;
+    scheduleTimer(&twWheel, &twTimers[i++], start + reach - TIMER_WHEEL_TICK_MS - 3);
+    scheduleTimer(&twWheel, &twTimers[i++], start + reach);
+    scheduleTimer(&twWheel, &twTimers[i++], start + reach + 7);
+    scheduleTimer(&twWheel, &twTimers[i++], start + reach * 3 / 2 + 1);
+    // the first tick of a slot of the level, where the level cascades
+    boundary = ((start / TIMER_WHEEL_TICK_MS >> (TIMER_WHEEL_BITS * (level + 1))) + 2) << (TIMER_WHEEL_BITS * (level + 1));
+    scheduleTimer(&twWheel, &twTimers[i++], boundary * TIMER_WHEEL_TICK_MS);
+  }
+  // each timer is filed in the lowest level that reaches it
+  for(level = 0; level < TIMER_WHEEL_LEVELS - 1; level++){
+    CU_ASSERT(level == twLevel(&twTimers[5*level]));
+    CU_ASSERT(level + 1 == twLevel(&twTimers[5*level+1]));
+    CU_ASSERT(level + 1 == twLevel(&twTimers[5*level+2]));
+  }
+
+  // cancelled and moved timers
+  cancelTimer(&twWheel, &twTimers[5]);
+  CU_ASSERT(NULL == twTimers[5].list);
+  cancelTimer(&twWheel, &twTimers[5]);
+  scheduleTimer(&twWheel, &twTimers[6], start + 50);
+  CU_ASSERT(i - 1 == twWheel.count);
+
+  twRun(start + (1LL << (TIMER_WHEEL_BITS * (TIMER_WHEEL_LEVELS - 1))) * TIMER_WHEEL_TICK_MS * 2);
+  CU_ASSERT(i - 1 == twFiredCount);
+  CU_ASSERT(0 == twWheel.count);
+  CU_ASSERT(-1 == twFiredAt[5]);
+  for(level = 0; level < i; level++){
+    if(level == 5){
+      continue;
+    }
+    CU_ASSERT(twFiredAt[level] == twDueTime(twTimers[level].expires));
+    if(twFiredAt[level] != twDueTime(twTimers[level].expires)){
+      fprintf(stderr,"timer %d expires %lld fired %lld\n", level, twTimers[level].expires, twFiredAt[level]);
+    }
+  }
+}
+
+/* TEST: timers beyond the reach of the last level are cascaded again,
+ *       timers in the past fire on the next advance
+ */
+void
+testTimerWheel_farAndPast()
+{
+  long long start = 10;
+  long long reach = (1LL << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS)) * TIMER_WHEEL_TICK_MS;
+  long long far = start + reach + reach / 3;
+
+  twReset(start);
+  scheduleTimer(&twWheel, &twTimers[0], far);
+  scheduleTimer(&twWheel, &twTimers[1], start - 5000);
+  scheduleTimer(&twWheel, &twTimers[2], start);
+  CU_ASSERT(0 == nextTimerWheelTimeout(&twWheel, start, 1000));
+
+  // both due timers fire without the clock moving
+  CU_ASSERT(2 == advanceTimerWheel(&twWheel, start));
+  CU_ASSERT(2 == twFiredCount);
+  CU_ASSERT(1 == twWheel.count);
+
+  // one jump far past the reach of the wheel, then up to the timer
+  twNow = far - reach / 2;
+  CU_ASSERT(0 == advanceTimerWheel(&twWheel, twNow));
+  CU_ASSERT(NULL != twTimers[0].list);
+  twNow = far - 1;
+  CU_ASSERT(0 == advanceTimerWheel(&twWheel, twNow));
+  twNow = twDueTime(far);
+  CU_ASSERT(1 == advanceTimerWheel(&twWheel, twNow));
+  CU_ASSERT(twFiredAt[0] == twDueTime(far));
+  CU_ASSERT(0 == twWheel.count);
+}
+
+/* TEST: a callback may schedule its timer again, the timeout follows the next timer
+ */
+void
+testTimerWheel_reschedule()
+{
+  long long start = 5000;
+  int wait;
+
+  twReset(start);
+  CU_ASSERT(250 == nextTimerWheelTimeout(&twWheel, start, 250));
+  initTimerEntry(&twTimers[0], twRepeatTimer, NULL);
+  scheduleTimer(&twWheel, &twTimers[0], start + 1000);
+  scheduleTimer(&twWheel, &twTimers[1], start + 30);
+
+  wait = nextTimerWheelTimeout(&twWheel, start, 10000);
+  CU_ASSERT(30 == wait);
+  twRun(start + 30);
+  CU_ASSERT(1 == twFiredCount);
+  CU_ASSERT(1 == twOrder[0]);
+
+  // the level 0 wrap limits the wait while the repeating timer is in a higher level
+  wait = nextTimerWheelTimeout(&twWheel, twNow, 10000);
+  CU_ASSERT(wait > 0);
+  CU_ASSERT(wait <= (1 << TIMER_WHEEL_BITS) * TIMER_WHEEL_TICK_MS);
+
+  twRun(start + 3500);
+  CU_ASSERT(4 == twFiredCount);
+  CU_ASSERT(0 == twOrder[1] && 0 == twOrder[2] && 0 == twOrder[3]);
+  CU_ASSERT(start + 4000 == twTimers[0].expires);
+  CU_ASSERT(1 == twWheel.count);
+  cancelTimer(&twWheel, &twTimers[0]);
+  CU_ASSERT(0 == twWheel.count);
+  CU_ASSERT(0 == advanceTimerWheel(&twWheel, start + 5000));
+}
@@ -34,6 +34,8 @@
 #ifndef INTERNALPERIODIC_H_
 #define INTERNALPERIODIC_H_
 
+#define RIB_TRANSFER_MAX_WORKERS	64	/* max number of rib transfer threads */
+
 /* Data Structure of Periodic Event Handling Module */
 struct Periodic_struct_st {
 	int StatusMessageInterval;
@@ -41,6 +43,9 @@ struct Periodic_struct_st {
 	int isRouteRefreshEnabled;
 	int CacheExpirationInterval;
 	int CacheEntryLifetime;
+	int RibTransferWorkers;
+	int RibTransferRate;
+	int RibDeltaTransfers;
 	QueueWriter	lableQueueWriter;
 
 	time_t		routeRefreshThreadLastAction;
@@ -75,11 +80,12 @@ void sendSessionStatusMessage( int sessionID, QueueWriter labeledQueueWriter);
  * Input: 	sessionID - ID of the session 
  *		labeledQueueWriter - the writer of label queue 
  *		time to transfer to each session
+ *		delta - TRUE to send only the changes since the previous rib transfer
  * Output:
  * He Yan @ Jun 22, 2008
  * Mikhail Strizhov @ July 23, 2010
  * -------------------------------------------------------------------------------------*/
-void doRouteRefresh( int sessionID, QueueWriter labeledQueueWriter, int transfer_time ); 
+void doRouteRefresh( int sessionID, QueueWriter labeledQueueWriter, int transfer_time, int delta ); 
 
 /*----------------------------------------------------------------------------------------
  * Purpose: the thread of periodic sending route refresh for all sessions.
@@ -40,6 +40,7 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include <time.h>
+#include <pthread.h>
 //#ifdef TCPMD5
 //#include <linux/tcp.h>
 //#endif
@@ -110,6 +111,33 @@ initPeriodicSettings()
 	else
 		PeriodicEvents.CacheEntryLifetime = CACHE_ENTRY_LIFETIME;
 
+	// number of rib transfer threads
+	if ( (RIB_TRANSFER_WORKERS < 1) || (RIB_TRANSFER_WORKERS > RIB_TRANSFER_MAX_WORKERS) ) {
+		err = 1;
+		log_warning("Invalid site default for rib transfer workers.");
+		PeriodicEvents.RibTransferWorkers = 1;
+	}
+	else
+		PeriodicEvents.RibTransferWorkers = RIB_TRANSFER_WORKERS;
+
+	// messages per second of all rib transfers
+	if ( RIB_TRANSFER_RATE < 0 ) {
+		err = 1;
+		log_warning("Invalid site default for the rib transfer rate.");
+		PeriodicEvents.RibTransferRate = 0;
+	}
+	else
+		PeriodicEvents.RibTransferRate = RIB_TRANSFER_RATE;
+
+	// delta rib transfers between two full ones
+	if ( RIB_DELTA_TRANSFERS < 0 ) {
+		err = 1;
+		log_warning("Invalid site default for the rib delta transfers.");
+		PeriodicEvents.RibDeltaTransfers = 0;
+	}
+	else
+		PeriodicEvents.RibDeltaTransfers = RIB_DELTA_TRANSFERS;
+
 	// default transfer type
 	PeriodicEvents.isRouteRefreshEnabled = FALSE;
 
@@ -181,6 +209,51 @@ readPeriodicSettings()
 	debug( __FUNCTION__, "Route refresh is %d.", PeriodicEvents.isRouteRefreshEnabled );
 #endif
 
+	// get the number of rib transfer threads
+	result = getConfigValueAsInt(&num, XML_PERIODIC_RIB_TRANSFER_WORKERS_PATH, 1, RIB_TRANSFER_MAX_WORKERS);
+	if (result == CONFIG_VALID_ENTRY) 
+		PeriodicEvents.RibTransferWorkers = num; 
+	else if (result == CONFIG_INVALID_ENTRY) 
+	{
+		err = 1;
+		log_warning("Invalid configuration of the rib transfer workers.");
+	}
+	else 
+		log_msg("No configuration of the rib transfer workers, using default.");
+#ifdef DEBUG
+	debug( __FUNCTION__, "Rib transfer workers %d.", PeriodicEvents.RibTransferWorkers );
+#endif
+
+	// get the messages per second of all rib transfers
+	result = getConfigValueAsInt(&num, XML_PERIODIC_RIB_TRANSFER_RATE_PATH, 0, 1000000);
+	if (result == CONFIG_VALID_ENTRY) 
+		PeriodicEvents.RibTransferRate = num; 
+	else if (result == CONFIG_INVALID_ENTRY) 
+	{
+		err = 1;
+		log_warning("Invalid configuration of the rib transfer rate.");
+	}
+	else 
+		log_msg("No configuration of the rib transfer rate, using default.");
+#ifdef DEBUG
+	debug( __FUNCTION__, "Rib transfer rate %d.", PeriodicEvents.RibTransferRate );
+#endif
+
+	// get the number of delta rib transfers between two full ones
+	result = getConfigValueAsInt(&num, XML_PERIODIC_RIB_DELTA_TRANSFERS_PATH, 0, 65536);
+	if (result == CONFIG_VALID_ENTRY) 
+		PeriodicEvents.RibDeltaTransfers = num; 
+	else if (result == CONFIG_INVALID_ENTRY) 
+	{
+		err = 1;
+		log_warning("Invalid configuration of the rib delta transfers.");
+	}
+	else 
+		log_msg("No configuration of the rib delta transfers, using default.");
+#ifdef DEBUG
+	debug( __FUNCTION__, "Rib delta transfers %d.", PeriodicEvents.RibDeltaTransfers );
+#endif
+
 
 	return err;
 };
@@ -220,6 +293,24 @@ savePeriodicSettings()
 		log_warning("Failed to save send_route_refresh to config file.");
 	}
 
+	// save rib transfer workers
+	if ( setConfigValueAsInt(XML_RIB_TRANSFER_WORKERS, PeriodicEvents.RibTransferWorkers) ) {
+		err = 1;
+		log_warning("Failed to save rib transfer workers to config file.");
+	}
+
+	// save rib transfer rate
+	if ( setConfigValueAsInt(XML_RIB_TRANSFER_RATE, PeriodicEvents.RibTransferRate) ) {
+		err = 1;
+		log_warning("Failed to save rib transfer rate to config file.");
+	}
+
+	// save rib delta transfers
+	if ( setConfigValueAsInt(XML_RIB_DELTA_TRANSFERS, PeriodicEvents.RibDeltaTransfers) ) {
+		err = 1;
+		log_warning("Failed to save rib delta transfers to config file.");
+	}
+
 	// save queue tag
 	if ( closeConfigElement(XML_PERIODIC_TAG) ) {
 		err = 1;
@@ -370,14 +461,15 @@ void sendMRTStatusMessage( QueueWriter labeledQueueWriter)
  * Input: 	sessionID - ID of the session 
  *		labeledQueueWriter - the writer of label queue 
  *		time to transfer to each session
+ *		delta - TRUE to send only the changes since the previous rib transfer
  * Output:
  * He Yan @ Jun 22, 2008
  * Mikhail Strizhov @ July 23, 2010
  * -------------------------------------------------------------------------------------*/
-void doRouteRefresh( int sessionID, QueueWriter labeledQueueWriter, int transfer_time ) 
+void doRouteRefresh( int sessionID, QueueWriter labeledQueueWriter, int transfer_time, int delta ) 
 {
 	// always send the periodic table refresh
-	sendRibTable(sessionID, labeledQueueWriter, transfer_time);
+	sendRibTable(sessionID, labeledQueueWriter, transfer_time, delta);
 
 	if (getSessionUPTime(sessionID) > PeriodicEvents.RouteRefreshInterval )
 	{
@@ -391,11 +483,113 @@ void doRouteRefresh( int sessionID, QueueWriter labeledQueueWriter, int transfer
 	}
 }
 
+/*----------------------------------------------------------------------------------------
+ * The rib transfers of a route refresh cycle.  The route refresh thread lists the
+ * sessions to dump, the ones with the oldest rib transfer first, and the transfer 
+ * workers take them from the list in that order.
+ * -------------------------------------------------------------------------------------*/
+static struct
+{
+	int			sessions[MAX_SESSION_IDS];
+	int			count;
+	// the next session to take
+	int			next;
+	// sessions taken and not finished yet
+	int			running;
+	// the seconds each transfer should take
+	int			transferTime;
+	// when the last transfer of a session finished, 0 if it wasn't dumped since it came up
+	time_t			lastTransfer[MAX_SESSION_IDS];
+	// delta transfers of a session since its last full one
+	int			deltaTransfers[MAX_SESSION_IDS];
+	// full transfers requested for every session, and the requests a session's last transfer served
+	u_int32_t		fullRequests;
+	u_int32_t		fullRequestsSeen[MAX_SESSION_IDS];
+	pthread_t		workers[RIB_TRANSFER_MAX_WORKERS];
+	int			workerCount;
+	pthread_mutex_t		lock;
+	// sessions were listed, or BGPmon is closing
+	pthread_cond_t		jobAdded;
+	// a transfer finished
+	pthread_cond_t		jobDone;
+} RibTransferJobs;
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Order sessions by their last rib transfer, the oldest first
+ * Input:   a, b - pointers to the session IDs
+ * Output:  <0, 0 or >0 as for qsort
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+compareLastTransfer( const void *a, const void *b )
+{
+	time_t ta = RibTransferJobs.lastTransfer[*(const int *)a];
+	time_t tb = RibTransferJobs.lastTransfer[*(const int *)b];
+
+	if( ta != tb )
+		return ta < tb ? -1 : 1;
+	return *(const int *)a - *(const int *)b;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: the thread of a rib transfer worker, dumps the sessions listed by the
+ *          route refresh thread until BGPmon is closing.
+ * Input:
+ * Output:
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void *
+ribTransferWorker( void *arg )
+{
+	int sessionID, transferTime, delta;
+	u_int32_t fullRequests;
+	QueueWriter labeledQueueWriter = createQueueWriter( labeledQueue );
+
+	pthread_mutex_lock(&RibTransferJobs.lock);
+	while( PeriodicEvents.shutdown == FALSE )
+	{
+		if( RibTransferJobs.next >= RibTransferJobs.count )
+		{
+			pthread_cond_wait(&RibTransferJobs.jobAdded, &RibTransferJobs.lock);
+			continue;
+		}
+		sessionID = RibTransferJobs.sessions[RibTransferJobs.next];
+		RibTransferJobs.next++;
+		RibTransferJobs.running++;
+		transferTime = RibTransferJobs.transferTime;
+		// a full transfer every RibDeltaTransfers deltas, after the session came up and 
+		// when a RIB client connected since the previous transfer started
+		fullRequests = __atomic_load_n(&RibTransferJobs.fullRequests, __ATOMIC_ACQUIRE);
+		delta = RibTransferJobs.lastTransfer[sessionID] != 0
+			&& RibTransferJobs.deltaTransfers[sessionID] < PeriodicEvents.RibDeltaTransfers
+			&& RibTransferJobs.fullRequestsSeen[sessionID] == fullRequests;
+		RibTransferJobs.fullRequestsSeen[sessionID] = fullRequests;
+		pthread_mutex_unlock(&RibTransferJobs.lock);
+
+		log_msg( "Session %d route refresh scheduled!", sessionID);
+		doRouteRefresh(sessionID, labeledQueueWriter, transferTime, delta ? TRUE : FALSE);
+		log_msg("Done with %d Session", sessionID);
+
+		pthread_mutex_lock(&RibTransferJobs.lock);
+		RibTransferJobs.lastTransfer[sessionID] = time(NULL);
+		RibTransferJobs.deltaTransfers[sessionID] = delta ? RibTransferJobs.deltaTransfers[sessionID] + 1 : 0;
+		RibTransferJobs.running--;
+		pthread_cond_signal(&RibTransferJobs.jobDone);
+	}
+	pthread_mutex_unlock(&RibTransferJobs.lock);
+
+	destroyQueueWriter(labeledQueueWriter);
+	return NULL;
+}
+
 /*----------------------------------------------------------------------------------------
  * Purpose: the thread of periodic sending route refresh for all sessions.
+ *          Every RouteRefreshInterval it lists the sessions to dump for the rib
+ *          transfer workers and waits until they are done.
  * Input:
  * Output:
  * He Yan @ Jun 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 void *
 periodicRouteRefreshThread( void *arg )
@@ -403,129 +597,110 @@ periodicRouteRefreshThread( void *arg )
 	log_msg( "Periodic route refresh thread started" );
 	PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
 	
-	int i, transferInterval, extraSleepTime, sendsPerInt, extraSends;
-	int actualsends = 0;
-	int establishedSessions[MAX_SESSION_IDS];
-	int establishedSessionCount;
-	QueueWriter labeledQueueWriter = createQueueWriter( labeledQueue );
-	while( PeriodicEvents.shutdown == FALSE )
+	int i, error, rounds, sessionID;
+	time_t now, cycleEnd, sleepTime;
+	struct timespec wakeup;
+
+	pthread_mutex_init(&RibTransferJobs.lock, NULL);
+	pthread_cond_init(&RibTransferJobs.jobAdded, NULL);
+	pthread_cond_init(&RibTransferJobs.jobDone, NULL);
+	RibTransferJobs.count = 0;
+	RibTransferJobs.next = 0;
+	RibTransferJobs.running = 0;
+
+	// start the rib transfer workers
+	for( i=0; i<PeriodicEvents.RibTransferWorkers; i++ )
 	{
-		// reset counter
-		actualsends = 0;
+		if ((error = pthread_create(&RibTransferJobs.workers[i], NULL, ribTransferWorker, NULL)) > 0 )
+			log_fatal("Failed to create rib transfer worker thread: %s\n", strerror(error));
+	}
+	RibTransferJobs.workerCount = PeriodicEvents.RibTransferWorkers;
 
+	while( PeriodicEvents.shutdown == FALSE )
+	{
 		// after RR update thread time
 		PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
 
-		// reset the established session count and list
-		establishedSessionCount = 0;
-		memset(establishedSessions, 0, sizeof(int)*MAX_SESSION_IDS);
+		// check if the route refresh interval is zero
+		if( PeriodicEvents.RouteRefreshInterval == 0 )
+		{
+			sleep(THREAD_CHECK_INTERVAL);
+			continue;
+		}
+
+		pthread_mutex_lock(&RibTransferJobs.lock);
 
-		// get the established session count and list
+		// list the established sessions to dump
+		RibTransferJobs.count = 0;
+		now = time(NULL);
 		for( i=0; i<MAX_SESSION_IDS; i++ )
 		{
 			// check Sessions and check Sessions trigger = established or mrtestablished
-			if( Sessions[i] != NULL && isSessionEstablished(Sessions[i]->sessionID) == TRUE )
+			if( Sessions[i] != NULL && isSessionEstablished(Sessions[i]->sessionID) == TRUE 
+				&& getSessionRouteRefreshAction(Sessions[i]->sessionID) == TRUE )
 			{
-				establishedSessions[establishedSessionCount] = Sessions[i]->sessionID;
-				establishedSessionCount++;		
+				sessionID = Sessions[i]->sessionID;
+				// a session that came up again since its last transfer has not been dumped yet
+				if( RibTransferJobs.lastTransfer[sessionID] < now - getSessionUPTime(sessionID) )
+					RibTransferJobs.lastTransfer[sessionID] = 0;
+				RibTransferJobs.sessions[RibTransferJobs.count] = sessionID;
+				RibTransferJobs.count++;		
 			}
 		}
-		log_msg( "There are %d established sessions",  establishedSessionCount);
+		log_msg( "There are %d established sessions",  RibTransferJobs.count);
 		
-		// check if there is any established sessions and if the route refresh interval is zero
-		if( establishedSessionCount == 0 || PeriodicEvents.RouteRefreshInterval == 0 )
+		// check if there is any established sessions
+		if( RibTransferJobs.count == 0 )
 		{
+			pthread_mutex_unlock(&RibTransferJobs.lock);
 			sleep(THREAD_CHECK_INTERVAL);
 			continue;
 		}
-		
-		// distribute the route refresh evenly over time in order to prevent the queues being overwhelmed
-		if( PeriodicEvents.RouteRefreshInterval >= establishedSessionCount )
-		{
-			// each RR should take transferInterval seconds
-			transferInterval = PeriodicEvents.RouteRefreshInterval/establishedSessionCount;
-			sendsPerInt = 1;
-			extraSleepTime = PeriodicEvents.RouteRefreshInterval%establishedSessionCount;
-			extraSends = 0;
-		}
-		else
-		{
-			// send multiple RRs every 1s. If x = establishedSessionCount%PeriodicEvents.RouteRefreshInterval and y = establishedSessionCount%PeriodicEvents.RouteRefreshInterval then:
-			// In the first x seconds, y + 1 RRs are sent
-			// In the rest of RouteRefreshInterval, y RRs are sent	
-			transferInterval = 1;
-			sendsPerInt = establishedSessionCount/PeriodicEvents.RouteRefreshInterval;
-			extraSleepTime = 0;
-			extraSends = establishedSessionCount%PeriodicEvents.RouteRefreshInterval;
-		}
-	
-		// start to do route refresh
-		int nextSession = 0;
-		int sends = 0;
+
+		// the sessions with the oldest rib transfer go first
+		qsort(RibTransferJobs.sessions, RibTransferJobs.count, sizeof(int), compareLastTransfer);
+
+		// the workers dump the sessions in rounds, each round gets an equal share of the interval
+		rounds = (RibTransferJobs.count + RibTransferJobs.workerCount - 1) / RibTransferJobs.workerCount;
+		RibTransferJobs.transferTime = PeriodicEvents.RouteRefreshInterval / rounds;
+		if( RibTransferJobs.transferTime < 1 )
+			RibTransferJobs.transferTime = 1;
+		cycleEnd = now + PeriodicEvents.RouteRefreshInterval;
 #ifdef DEBUG		
-		log_msg("transferIntervval is %d", transferInterval);
-		log_msg("extraSleepTime is %d", extraSleepTime);
-		log_msg("Number of established sessions %d", establishedSessionCount);
+		log_msg("transferTime is %d", RibTransferJobs.transferTime);
+		log_msg("Number of established sessions %d", RibTransferJobs.count);
 #endif		
-		while( nextSession < establishedSessionCount )
-		{
-			if( extraSends >0 )
-			{
-				sends = sendsPerInt + 1;
-				extraSends--;
-			}
-			else
-				sends = sendsPerInt;
-			
-			for( i=0; i<sends; i++ )
-			{
-				int sessionID = establishedSessions[nextSession];
-				if( getSessionRouteRefreshAction(sessionID) == TRUE )
-				{	
-					log_msg( "Session %d route refresh scheduled!", sessionID);
-					doRouteRefresh(sessionID, labeledQueueWriter, transferInterval);
-					actualsends++;
-					log_msg("Done with %d Session", sessionID);
-				}
-				nextSession++;
-				if ( PeriodicEvents.shutdown != FALSE )
-				{
-					destroyQueueWriter(labeledQueueWriter);
-					log_warning( "Periodic route refresh thread exiting" );
-					return NULL;
-				}
-				PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
-			}
-		} // end of while loop
+		RibTransferJobs.next = 0;
+		pthread_cond_broadcast(&RibTransferJobs.jobAdded);
 
-		// check if doRouteRefresh was triggered, otherwise sleep
-		if ( actualsends == 0 )
+		// wait for the transfers of the cycle
+		while( (RibTransferJobs.next < RibTransferJobs.count || RibTransferJobs.running > 0) 
+			&& PeriodicEvents.shutdown == FALSE )
 		{
+			clock_gettime(CLOCK_REALTIME, &wakeup);
+			wakeup.tv_sec += THREAD_CHECK_INTERVAL;
+			pthread_cond_timedwait(&RibTransferJobs.jobDone, &RibTransferJobs.lock, &wakeup);
+			// after wait update thread time
 			PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
-			sleep(THREAD_CHECK_INTERVAL);
-			continue;
 		}
+		pthread_mutex_unlock(&RibTransferJobs.lock);
 
-		// sleep(extraSleepTime);
-		int num_of_sleeps = extraSleepTime / THREAD_CHECK_INTERVAL;
-		for (i=0; i < num_of_sleeps; i++) 
+		// sleep the rest of the interval
+		while( PeriodicEvents.shutdown == FALSE && (sleepTime = cycleEnd - time(NULL)) > 0 )
 		{
-			sleep(THREAD_CHECK_INTERVAL);
+			sleep(sleepTime < THREAD_CHECK_INTERVAL ? sleepTime : THREAD_CHECK_INTERVAL);
 			// after sleep update thread time
 			PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
-			// check if BGPmon is closing
-			if ( PeriodicEvents.shutdown != FALSE )
-			{
-				destroyQueueWriter(labeledQueueWriter);
-				log_warning( "Periodic route refresh thread exiting" );
-				return NULL;
-			}
 		}
-		sleep(extraSleepTime % THREAD_CHECK_INTERVAL);
-		// after sleep update thread time
-		PeriodicEvents.routeRefreshThreadLastAction = time(NULL);
 	}	
-	destroyQueueWriter(labeledQueueWriter);
+
+	// wake up the workers and wait for them to exit
+	pthread_mutex_lock(&RibTransferJobs.lock);
+	pthread_cond_broadcast(&RibTransferJobs.jobAdded);
+	pthread_mutex_unlock(&RibTransferJobs.lock);
+	for( i=0; i<RibTransferJobs.workerCount; i++ )
+		pthread_join(RibTransferJobs.workers[i], NULL);
+
 	log_warning( "periodic route refresh thread exiting" );
 	return NULL;
 }
@@ -688,6 +863,18 @@ getPeriodicRouteRefreshEnableStatus() {
 	return PeriodicEvents.isRouteRefreshEnabled;
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Make the next rib transfer of every session a full one
+ * Input: 
+ * Output: 
+ * Note: Called when a RIB client connects, it has no table a delta could apply to.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+requestFullRibTransfers() {
+	__atomic_add_fetch(&RibTransferJobs.fullRequests, 1, __ATOMIC_RELEASE);
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: get the last action time of the Periodic thread
  * Input:
@@ -130,6 +130,16 @@ disablePeriodicRouteRefresh();
 int
 getPeriodicRouteRefreshEnableStatus();
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Make the next rib transfer of every session a full one
+ * Input: 
+ * Output: 
+ * Note: Called when a RIB client connects, it has no table a delta could apply to.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void
+requestFullRibTransfers();
+
 /*--------------------------------------------------------------------------------------
  * Purpose: get the last action time of the Periodic thread
  * Input:
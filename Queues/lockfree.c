@@ -0,0 +1,485 @@
+/*
+ * 	Copyright (c) 2010 Colorado State University
+ *
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ *  File: lockfree.c
+ * 	Authors: agent
+ *  Date: Oct 17, 2026
+ */
+
+/* lock-free engine function prototypes */
+#include "lockfree.h"
+
+/* structures and functions for applying pacing */
+#include "pacing.h"
+
+/* needed for QUEUE_MAX_ITEMS */
+#include "../site_defaults.h"
+
+/* needed for TRUE/FALSE macro */
+#include "../Util/bgpmon_defaults.h"
+
+/* needed for logging */
+#include "../Util/log.h"
+
+/* needed for malloc and free */
+#include <stdlib.h>
+/*  needed to lock structures */
+#include <pthread.h>
+/* needed for sched_yield */
+#include <sched.h>
+
+//#define DEBUG
+
+/* how many times a reader polls for a new item before it goes to sleep */
+#define LOCKFREE_READER_SPINS 100
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Recycle a slot whose last reference has been dropped
+ * Input:  the queue, the position of the item and its slot, and whether to free the item
+ * Output: none
+ * Note: once the sequence stamp is updated the writer may reuse the slot
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+recycleLockFreeSlot( Queue q, long pos, QueueEntry *e, int freeItem )
+{
+	if( freeItem == TRUE )
+		freeQueueEntryMessage( q, e );
+	e->messagBuf = NULL;
+	__atomic_sub_fetch( &q->bytesUsed, e->size, __ATOMIC_RELAXED );
+	__atomic_add_fetch( &q->head, 1, __ATOMIC_RELEASE );
+	__atomic_store_n( &e->seq, pos + QUEUE_MAX_ITEMS, __ATOMIC_RELEASE );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Drop one reference on the item at a given position
+ * Input:  the queue and the position
+ * Output: none
+ * Note: the caller must own the reference, i.e. it has moved a reader cursor past pos
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+releaseLockFreeItem( Queue q, long pos )
+{
+	QueueEntry *e = &q->items[pos % QUEUE_MAX_ITEMS];
+	if( __atomic_sub_fetch( &e->count, 1, __ATOMIC_ACQ_REL ) == 0 )
+		recycleLockFreeSlot( q, pos, e, TRUE );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Wake up readers sleeping on the queue
+ * Input:  the queue
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+wakeLockFreeReaders( Queue q )
+{
+	if( __atomic_load_n( &q->sleepers, __ATOMIC_SEQ_CST ) == 0 )
+		return;
+	if ( pthread_mutex_lock( &q->waitLock ) )
+		log_fatal( "lockQueue: failed");
+	pthread_cond_broadcast( &q->waitCond );
+	if ( pthread_mutex_unlock( &q->waitLock ) )
+		log_fatal( "unlockQueue: failed");
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Return the position of the slowest reader of the queue
+ * Input:  the queue
+ * Output: the smallest reader position or -1 if there are no readers
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static long
+slowestLockFreeReader( Queue q )
+{
+	long slowest = -1;
+	long pos;
+	int i;
+	for ( i = 0; i < MAX_QUEUE_READERS; i++ )
+	{
+		pos = __atomic_load_n( &q->nextItem[i], __ATOMIC_ACQUIRE );
+		if( pos >= 0 && (slowest < 0 || pos < slowest) )
+			slowest = pos;
+	}
+	return slowest;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the lock-free specific parts of a new queue
+ * Input:  the queue
+ * Output: none, exits on fatal error
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+initLockFreeQueue( Queue q )
+{
+	long i;
+	// every slot starts free for its first lap
+	for ( i = 0; i < QUEUE_MAX_ITEMS; i++ )
+		q->items[i].seq = i;
+	q->sleepers = 0;
+	q->bytesUsed = 0;
+
+	if (pthread_mutex_init( &q->waitLock, NULL ) )
+		log_fatal( "unable to init reader wait lock for queue %s", q->name);
+		// not reached
+	if (pthread_cond_init( &q->waitCond, NULL ) )
+		log_fatal( "unable to create blocked reader notify for queue %s", q->name);
+		// not reached
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Skip a reader of a lock-free queue forward to a given position
+ * Input:  queue, reader index and the destination position
+ * Output: the number of skipped items
+ * Note: Assumes that the queue lock is already in place
+ *       The reader may be reading concurrently, whoever moves the cursor owns the
+ *       references of the items it moved past.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long
+adjustLockFreeQueueReader( Queue q, int readerIndex, long destPos )
+{
+	long pos = __atomic_load_n( &q->nextItem[readerIndex], __ATOMIC_ACQUIRE );
+	while( pos >= 0 && pos < destPos )
+	{
+		if( __atomic_compare_exchange_n( &q->nextItem[readerIndex], &pos, destPos, FALSE,
+						__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+		{
+			long i;
+			for ( i = pos; i < destPos; i++ )
+				releaseLockFreeItem( q, i );
+			log_msg("%ld messages are skipped for Reader %d in queue %s, ideal reader is at %ld", destPos-pos, readerIndex, q->name, q->idealReaderPosition);
+			return destPos - pos;
+		}
+		// pos now holds the reader's current cursor, try again
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Cease a reader of a lock-free queue and drop its references
+ * Input:  queue and reader index
+ * Output: none
+ * Note: Assumes that the queue lock is already in place
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+removeLockFreeQueueReader( Queue q, int readerIndex )
+{
+	long pos = __atomic_exchange_n( &q->nextItem[readerIndex], READER_SLOT_AVAILABLE, __ATOMIC_ACQ_REL );
+	long i;
+	if( pos >= 0 )
+	{
+		for ( i = pos; i < q->tail; i++ )
+			releaseLockFreeItem( q, i );
+	}
+	// the reader may be sleeping, let it notice it has ceased
+	wakeLockFreeReaders( q );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Publish a new item in a lock-free queue, the slowest readers are moved
+ *          forward if the queue is full
+ * Input: queue writer and the item itself
+ * Output: none
+ * Note: Assumes that the queue lock is already in place, the sleeping readers are
+ *       not woken up
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+publishLockFreeItem( QueueWriter writer, void *item )
+{
+	Queue q = writer->queue;
+	long pos = q->tail;
+	QueueEntry *e = &q->items[pos % QUEUE_MAX_ITEMS];
+	int i;
+
+	// if the queue is full, move the positions of slowest readers forward
+	if( q->readercount > 0 && __atomic_load_n( &e->seq, __ATOMIC_ACQUIRE ) != pos )
+	{
+#ifdef DEBUG
+		log_warning("queue %s is full, head=%ld, tail=%ld; adjusting slowest readers", q->name, q->head, q->tail);
+#endif
+		// the slot still holds the item at pos - QUEUE_MAX_ITEMS
+		long oldest = pos - QUEUE_MAX_ITEMS;
+		for ( i = 0; i < MAX_QUEUE_READERS; i++ )
+		{
+			long next = __atomic_load_n( &q->nextItem[i], __ATOMIC_ACQUIRE );
+			if ( next >= 0 && next <= oldest )
+			{
+				if( q->newPacingEnable == FALSE )
+					adjustLockFreeQueueReader( q, i, pos );
+				else
+					adjustLockFreeQueueReader( q, i, oldest + 1 );
+			}
+		}
+		// a reader that claimed the oldest item may still be copying it
+		while( __atomic_load_n( &e->seq, __ATOMIC_ACQUIRE ) != pos )
+			sched_yield();
+	}
+
+	// only for the new pacing algorithm
+	if( q->newPacingEnable == TRUE )
+	{
+		if ( ( (float)(q->tail - q->head)/(float)QUEUE_MAX_ITEMS ) >= QueueConfig.pacingOnThresh )
+		{
+			long slowest = slowestLockFreeReader( q );
+			for ( i = 0; slowest >= 0 && i < MAX_QUEUE_READERS; i++ )
+			{
+				if( __atomic_load_n( &q->nextItem[i], __ATOMIC_ACQUIRE ) == slowest )
+					adjustLockFreeQueueReader( q, i, q->idealReaderPosition );
+			}
+		}
+	}
+
+	// write the data to the next spot in the queue
+	q->writeCount++;
+	if( q->readercount > 0 )
+	{
+		q->writeCounts[writer->index]++;
+		e->messagBuf = item;
+		e->size = q->sizeOf( item );
+		e->count = q->readercount;
+		__atomic_add_fetch( &q->bytesUsed, e->size, __ATOMIC_RELAXED );
+		// publish the item, readers may consume it from now on
+		__atomic_store_n( &e->seq, pos + 1, __ATOMIC_SEQ_CST );
+		__atomic_store_n( &q->tail, pos + 1, __ATOMIC_RELEASE );
+		if ( (q->tail - q->head) > q->logMaxItems)
+			q->logMaxItems = q->tail - q->head;
+	}
+	else
+		q->destroy( item );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write new items into a lock-free queue
+ * Input: queue writer, the items and their number
+ * Output: returns 0, exits on fatal error if write fails
+ * Note: Assumes that the queue lock is already in place, the lock may be released
+ *       and retaken while pacing is applied. The readers may consume each item as
+ *       soon as it is published, the sleeping ones are woken up once.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int
+writeLockFreeQueue( QueueWriter writer, void **items, int n )
+{
+	Queue q = writer->queue;
+	int i;
+
+	// old pacing: update pacing limit and reset readcout and writecount if needed
+	// new pacing: update write count moveing average
+	updateInterval(q);
+
+	// only for the old pacing algorithm, otherwise skip this step
+	if( q->newPacingEnable == FALSE )
+	{
+		// check if need to stop pacing
+		if( checkPacingStop(q) )
+			log_fatal("%s queue error stopping pacing rules", q->name);
+	}
+
+	for ( i = 0; i < n; i++ )
+		publishLockFreeItem( writer, items[i] );
+	if( q->readercount > 0 )
+		wakeLockFreeReaders( q );
+	notifyQueueWaiters( q );
+
+	// only if use the old pacing, otherwise skip this step
+	if( q->newPacingEnable == FALSE )
+	{
+		// apply pacing rules to the current writer
+		if ( applyPacing(q, writer->index) )
+			log_fatal("%s queue error applying pacing rules", q->name);
+			// not reached
+	}
+
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Claim the item at a reader's cursor of a lock-free queue
+ * Input: queue reader, a pointer to the claimed position and whether to wait for 
+ *        an item to be published
+ * Output: 1 if an item was claimed, 0 if none is published and wait is FALSE,
+ *         or READER_SLOT_AVAILABLE if reader has ceased
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+claimLockFreeItem( QueueReader reader, long *claimed, int wait )
+{
+	Queue q = reader->queue;
+	int s = reader->index;
+	QueueEntry *e;
+	long pos;
+	int spins = 0;
+
+	// claim the item at our cursor by moving the cursor past it
+	pos = __atomic_load_n( &q->nextItem[s], __ATOMIC_ACQUIRE );
+	while( 1 )
+	{
+		//  if this reader has ceased, return READER_SLOT_AVAILABLE
+		if( pos == READER_SLOT_AVAILABLE )
+			return READER_SLOT_AVAILABLE;
+
+		e = &q->items[pos % QUEUE_MAX_ITEMS];
+		if( __atomic_load_n( &e->seq, __ATOMIC_ACQUIRE ) == pos + 1 )
+		{
+			if( __atomic_compare_exchange_n( &q->nextItem[s], &pos, pos + 1, FALSE,
+							__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+				break;
+			// a writer skipped us forward, pos holds the new cursor
+			continue;
+		}
+
+		// nothing published at our cursor yet
+		if( wait == FALSE )
+			return 0;
+		if( spins++ < LOCKFREE_READER_SPINS )
+			sched_yield();
+		else
+		{
+			// sleep until a writer publishes, the count of sleepers is raised
+			// before checking again so the writer can not miss us
+			if ( pthread_mutex_lock( &q->waitLock ) )
+				log_fatal( "lockQueue: failed");
+			__atomic_add_fetch( &q->sleepers, 1, __ATOMIC_SEQ_CST );
+			while( __atomic_load_n( &e->seq, __ATOMIC_SEQ_CST ) != pos + 1
+				&& __atomic_load_n( &q->nextItem[s], __ATOMIC_SEQ_CST ) == pos )
+			{
+				if ( pthread_cond_wait( &q->waitCond, &q->waitLock ) )
+					log_fatal("Queue %s conditional wait for reader failed", q->name);
+			}
+			__atomic_sub_fetch( &q->sleepers, 1, __ATOMIC_SEQ_CST );
+			if ( pthread_mutex_unlock( &q->waitLock ) )
+				log_fatal( "unlockQueue: failed");
+			spins = 0;
+		}
+		pos = __atomic_load_n( &q->nextItem[s], __ATOMIC_ACQUIRE );
+	}
+
+	*claimed = pos;
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Take a claimed item of a lock-free queue
+ * Input: queue reader, the claimed position and whether to share or copy the item
+ * Output: the item
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void *
+takeLockFreeItem( QueueReader reader, long pos, int shared )
+{
+	Queue q = reader->queue;
+	QueueEntry *e = &q->items[pos % QUEUE_MAX_ITEMS];
+	void *item = NULL;
+
+	// we own one reference on the item now, so the slot can not be recycled under us
+	if( shared == TRUE )
+	{
+		// return the message itself, it lives on until the reader releases it
+		item = shareQueueEntryMessage( reader, e );
+		releaseLockFreeItem( q, pos );
+	}
+	else if( __atomic_load_n( &e->count, __ATOMIC_ACQUIRE ) == 1 && e->shared == NULL )
+	{
+		// return the original if the last reference
+		item = e->messagBuf;
+		e->count = 0;
+		recycleLockFreeSlot( q, pos, e, FALSE );
+	}
+	else
+	{
+		// return a copy if not the only reference or if other readers still share it
+		q->copy( &item, e->messagBuf );
+		releaseLockFreeItem( q, pos );
+	}
+	return item;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from a lock-free queue
+ * Input: queue reader, the array of items read, its size, whether to share or 
+ *        copy the items and whether to wait for an item
+ * Output: the number of items read, at least 1 when waiting,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased
+ * Note: Same semantics as readQueueBatch and readQueueSharedBatch, the queue lock is 
+ *       only taken once per batch to update the old pacing state. Only the first 
+ *       item is waited for.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long
+readLockFreeQueue( QueueReader reader, void **items, int max, int shared, int wait )
+{
+	Queue q = reader->queue;
+	int s = reader->index;
+	long pos, n = 0;
+	int claimed;
+
+	// initialize the first read item to NULL
+	items[0] = NULL;
+
+	claimed = claimLockFreeItem( reader, &pos, wait );
+	while( claimed == 1 )
+	{
+		items[n++] = takeLockFreeItem( reader, pos, shared );
+		if( n == max )
+			break;
+		claimed = claimLockFreeItem( reader, &pos, FALSE );
+	}
+	// nothing published yet for a reader that doesn't wait
+	if( n == 0 && claimed == 0 )
+		return 0;
+	if( n == 0 )
+	{
+		log_warning("Ceased reader %d trying to read from Queue %s", s, q->name);
+		return READER_SLOT_AVAILABLE;
+	}
+	q->itemsRead[s] += n;
+
+	//only if use the old pacing, otherwise skip this step
+	if( q->newPacingEnable == FALSE )
+	{
+		// the read count is reset by the writers, it is only changed under the queue lock
+		if ( pthread_mutex_lock( &q->queueLock ) )
+			log_fatal( "lockQueue: failed");
+		q->readCount += n;
+		// check if need to stop paing
+		if( checkPacingStop(q) )
+			log_fatal("%s queue error stopping pacing rules", q->name);
+			// not reached
+		if ( pthread_mutex_unlock( &q->queueLock ) )
+			log_fatal( "unlockQueue: failed");
+	}
+
+#ifdef DEBUG
+	debug( __FUNCTION__, "Reader %d read %ld items from queue %s; tail/head: %ld/%ld ",
+		s, n, q->name, q->tail, q->head);
+#endif
+
+	return n;
+}
@@ -0,0 +1,102 @@
+/*
+ * 	Copyright (c) 2010 Colorado State University
+ *
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ *  File: lockfree.h
+ * 	Authors: agent
+ *  Date: Oct 17, 2026
+ */
+
+#ifndef LOCKFREE_H_
+#define LOCKFREE_H_
+
+/* need the queue data structure */
+#include "queue.h"
+
+/* The lock-free engine keeps the same ring of QUEUE_MAX_ITEMS entries
+ * as the mutex engine, but readers don't take the queue lock to claim items:
+ *   - each slot carries a sequence stamp, equal to the position it is
+ *     free for, or to that position + 1 once the item is published
+ *   - each reader owns an atomic cursor (nextItem) and claims an item
+ *     by a compare-and-swap of its cursor, which also hands it one
+ *     reference on the item
+ *   - the reference count of a slot is decremented atomically and the
+ *     reader dropping the last reference recycles the slot
+ * Writers are still serialized by the queue lock, so pacing works the
+ * same way for both engines.   Readers only take a lock when they have
+ * caught up with the writers and need to sleep, and to update the old
+ * pacing state they share with the writers.
+ */
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the lock-free specific parts of a new queue
+ * Input:  the queue
+ * Output: none, exits on fatal error
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void initLockFreeQueue( Queue q );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write new items into a lock-free queue
+ * Input: queue writer, the items and their number
+ * Output: returns 0, exits on fatal error if write fails
+ * Note: Assumes that the queue lock is already in place, the lock may be released
+ *       and retaken while pacing is applied. The readers may consume each item as
+ *       soon as it is published, the sleeping ones are woken up once.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int writeLockFreeQueue( QueueWriter writer, void **items, int n );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from a lock-free queue
+ * Input: queue reader, the array of items read, its size, whether to share or 
+ *        copy the items and whether to wait for an item
+ * Output: the number of items read, at least 1 when waiting,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased
+ * Note: Same semantics as readQueueBatch and readQueueSharedBatch, the queue lock is 
+ *       only taken once per batch to update the old pacing state. Only the first 
+ *       item is waited for.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long readLockFreeQueue( QueueReader reader, void **items, int max, int shared, int wait );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Skip a reader of a lock-free queue forward to a given position
+ * Input:  queue, reader index and the destination position
+ * Output: the number of skipped items
+ * Note: Assumes that the queue lock is already in place
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long adjustLockFreeQueueReader( Queue q, int readerIndex, long destPos );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Cease a reader of a lock-free queue and drop its references
+ * Input:  queue and reader index
+ * Output: none
+ * Note: Assumes that the queue lock is already in place
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void removeLockFreeQueueReader( Queue q, int readerIndex );
+
+#endif /*LOCKFREE_H_*/
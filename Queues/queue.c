@@ -37,6 +37,8 @@
 #include "queueinternal.h"
 /* structures and functions for applying pacing */
 #include "pacing.h"
+/* the lock-free queue engine */
+#include "lockfree.h"
 
 /* required for logging functions */
 #include "../Util/log.h"
@@ -51,7 +53,7 @@
 /* needed for copying BGPmon Internal Format messages */
 #include "../Util/bgpmon_formats.h"
 
-/* needed for function getXMLMessageLen */
+/* needed for the XML message header */
 #include "../XML/xml.h"
 
 /*  needed to lock structures */
@@ -60,6 +62,11 @@
 /* needed for malloc */
 #include <stdlib.h>
 
+/* needed to fire the queue notifiers */
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
 
 //#define DEBUG
 
@@ -128,6 +135,15 @@ initQueueSettings()
 	else
 		QueueConfig.logInterval = QUEUE_LOG_INTERVAL;
 
+	// queue engine
+	if ( (QUEUE_ENGINE != QUEUE_ENGINE_MUTEX) && (QUEUE_ENGINE != QUEUE_ENGINE_LOCKFREE) ) {
+		err = 1;
+		log_warning("Invalid site default for queue engine.");
+		QueueConfig.engine = QUEUE_ENGINE_MUTEX;
+	}
+	else
+		QueueConfig.engine = QUEUE_ENGINE;
+
 #ifdef DEBUG
 	debug( __FUNCTION__, "Initialized default Queue Settings" );
 #endif
@@ -245,6 +261,23 @@ readQueueSettings()
 	debug( __FUNCTION__, "queue's log interval %d.", QueueConfig.logInterval);
 #endif		
 
+	// get queue engine
+	result = getConfigValueAsInt(&num, XML_QUEUE_ENGINE_PATH, QUEUE_ENGINE_MUTEX, QUEUE_ENGINE_LOCKFREE);
+	if (result == CONFIG_VALID_ENTRY) 
+		QueueConfig.engine = num;	
+	else{
+		if (result == CONFIG_INVALID_ENTRY) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of queue engine.");
+		}
+		else 
+			log_msg("No configuration of queue engine, using default.");
+	}
+#ifdef DEBUG
+	debug( __FUNCTION__, "queue's engine %d.", QueueConfig.engine);
+#endif		
+
 	return err;
 };
 
@@ -299,6 +332,12 @@ saveQueueSettings()
 		err = 1;
 		log_warning("Failed to save queue's log interval to config file.");
 	}
+
+	// save queue engine
+	if ( setConfigValueAsInt(XML_QUEUE_ENGINE, QueueConfig.engine) ) {
+		err = 1;
+		log_warning("Failed to save queue's engine to config file.");
+	}
 	
 	// save queue tag
 	if ( closeConfigElement(XML_QUEUE_TAG) ) {
@@ -311,12 +350,13 @@ saveQueueSettings()
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Create a queue instance
- * Input:  the copy function for queue elements, the queue name, and the name length
+ * Input:  the copy, size and free functions for queue elements, the queue name, 
+ *         and the name length
  * Output:  the resulting queue, exits on fatal error if creation fails
  * He Yan @ June 15, 2008
  * -------------------------------------------------------------------------------------*/
 Queue 
-createQueue( void (*copy)(void **copy, void *original), int (*sizeOf)(void *msg), char *name, int namelength, int newPacingEnable)
+createQueue( void (*copy)(void **copy, void *original), int (*sizeOf)(void *msg), void (*destroy)(void *msg), char *name, int namelength, int newPacingEnable)
 {
 
 	//  allocate the queue memory 	
@@ -334,6 +374,9 @@ createQueue( void (*copy)(void **copy, void *original), int (*sizeOf)(void *msg)
 	strcpy(q->name, name);
 	log_msg( "queue name:%s", q->name );
 
+	// no one is notified of new items until a notifier is added
+	q->notifierCount = 0;
+
 	// set queue head and tail to 0, clear all queue items
 	q->head = 0;
 	q->tail = 0;
@@ -345,6 +388,11 @@ createQueue( void (*copy)(void **copy, void *original), int (*sizeOf)(void *msg)
 		// not reached
 	q->copy = copy;
 	q->sizeOf = sizeOf;
+	// items are plain allocations unless a free function is provided
+	if ( destroy == NULL )
+		q->destroy = free;
+	else
+		q->destroy = destroy;
 	
 	// initialize the log variables
 	q->lastLogTime = time( NULL );
@@ -392,6 +440,14 @@ createQueue( void (*copy)(void **copy, void *original), int (*sizeOf)(void *msg)
 	if (pthread_cond_init( &q->queueCond, NULL ) )
 		log_fatal( "unable to create blocked reader notify for queue %s", q->name);
 		// not reached
+
+	// select the queue engine, readers of the lock-free engine don't use the queue lock
+	q->engine = QueueConfig.engine;
+	if( q->engine == QUEUE_ENGINE_LOCKFREE )
+	{
+		initLockFreeQueue( q );
+		log_msg( "queue %s uses the lock-free engine", q->name );
+	}
 	
 	// create a robot reader for new pacing algorithm
 	if(q->newPacingEnable == TRUE)
@@ -503,28 +559,35 @@ createQueueReader( Queue q )
 	{}
 	reader->index = avail;
 		
-	// reader starts with the average position of queue	
-	int i = 0;
-	int count = 0;
-	long tmp = 0;
-	while(  count < q->readercount )
+	// reader of the lock-free engine starts at the tail, published reference 
+	// counts can't be raised while other readers may be releasing them
+	if( q->engine == QUEUE_ENGINE_LOCKFREE )
+		__atomic_store_n( &q->nextItem[reader->index], q->tail, __ATOMIC_RELEASE );
+	else
 	{
-		if( q->nextItem[i] >= 0 )
+		// reader starts with the average position of queue	
+		int i = 0;
+		int count = 0;
+		long tmp = 0;
+		while(  count < q->readercount )
 		{
-			tmp += q->nextItem[i];
-			count++;
+			if( q->nextItem[i] >= 0 )
+			{
+				tmp += q->nextItem[i];
+				count++;
+			}
+			i++;	
 		}
-		i++;	
-	}
-	if( q->readercount == 0 )
-		q->nextItem[reader->index] = q->tail;
-	else
-	{
-		q->nextItem[reader->index] = tmp/q->readercount;
-		for( i=q->nextItem[reader->index]; i<q->tail ; i++)
+		if( q->readercount == 0 )
+			q->nextItem[reader->index] = q->tail;
+		else
 		{
-			int j = i % QUEUE_MAX_ITEMS;
-			q->items[j].count++;
+			q->nextItem[reader->index] = tmp/q->readercount;
+			for( i=q->nextItem[reader->index]; i<q->tail ; i++)
+			{
+				int j = i % QUEUE_MAX_ITEMS;
+				q->items[j].count++;
+			}
 		}
 	}
 	q->itemsRead[reader->index] = 0;
@@ -572,20 +635,42 @@ isQueueEmpty( Queue q )
 }
 
 /*--------------------------------------------------------------------------------------
- * Purpose: Write a new item into the queue
- * Input: queue to write item and the item itself
- * Output: returns 0, exits on fatal error if write fails 
- * He Yan @ June 15, 2008
+ * Purpose: Log the queue status if we are past the log interval
+ * Input: the queue
+ * Output: none
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-int 
-writeQueue( QueueWriter writer, void *item )
+static void
+logQueueStatus( Queue q )
 {
-	int i;
+	/* log a message if we are past the log interval */
+	int now = time( NULL );
+	if ( now > q->lastLogTime + QueueConfig.logInterval)
+	{
+		q->lastLogTime = now;
+		log_msg("Queue %s status: tail=%ld head=%ld", q->name, q->tail, q->head); 
+		log_msg("Queue %s usage: currentItems=%ld, usedBytes=%ld, peakItems=%ld, allowedItems=%ld", 
+		  q->name, getItemsUsed(q->name), getBytesUsed(q->name), q->logMaxItems, QUEUE_MAX_ITEMS); 
+		log_msg("Queue %s writers: current=%d, peak=%d, allowed=%d", 
+		  q->name, getWriterCount(q->name), q->logMaxWriters, MAX_QUEUE_WRITERS); 
+		log_msg("Queue %s readers: current=%d, peak=%d, allowed=%d", 
+		  q->name, getReaderCount(q->name), q->logMaxReaders, MAX_QUEUE_READERS); 
+	}
+}
 
-	// lock the queue	
+/*--------------------------------------------------------------------------------------
+ * Purpose: Append a new item to the queue, the slowest readers are moved forward
+ *          if the queue is full
+ * Input: queue writer and the item itself
+ * Output: none, exits on fatal error if the queue is still full
+ * Note: Assumes that the queue lock is already in place
+ * He Yan @ June 15, 2008
+ * -------------------------------------------------------------------------------------*/
+static void
+appendQueueEntry( QueueWriter writer, void *item )
+{
 	Queue q = writer->queue;
-	if ( pthread_mutex_lock( &q->queueLock ) )
-		log_fatal( "lockQueue: failed");
+	int i;
 
 	// if the queue is full, move the positions of slowest readers to the tail
 	if (( q->tail - q->head) >= QUEUE_MAX_ITEMS )
@@ -613,8 +698,7 @@ writeQueue( QueueWriter writer, void *item )
                 			q->items[j].count--;
                 			if ( q->items[j].count == 0 )
                 			{    
-                        			free( q->items[j].messagBuf );
-                        			q->items[j].messagBuf = NULL;
+                        			freeQueueEntryMessage( q, &q->items[j] );
                         			q->head++;
                 			}
 					q->nextItem[i]++;
@@ -631,10 +715,6 @@ writeQueue( QueueWriter writer, void *item )
 		log_fatal("%s queue is still FULL after adjusting readers", q->name);
 		// not reached
 
-	// old pacing: update pacing limit and reset readcout and writecount if needed
-	// new pacing: update write count moveing average
-	updateInterval(q);
-	
 	// only for the new pacing algorithm  
 	if(q->newPacingEnable == TRUE)
 	{
@@ -662,14 +742,6 @@ writeQueue( QueueWriter writer, void *item )
 	
 	}	
 
-	// only for the old pacing algorithm, otherwise skip this step	
-	if(q->newPacingEnable == FALSE)
-	{
-		// check if need to stop pacing
-		if( checkPacingStop(q) )
-			log_fatal("%s queue error stopping pacing rules", q->name);	
-	}	
-
 	// write the data to the next spot in the queue
 	q->writeCount++;
 	if(  q->readercount > 0 )
@@ -683,7 +755,51 @@ writeQueue( QueueWriter writer, void *item )
 		q->logMaxItems = q->tail - q->head;
 	}
 	else
-		free( item );
+		q->destroy( item );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write new items into the queue
+ * Input: queue writer, the items and their number
+ * Output: returns 0, exits on fatal error if write fails 
+ * Note: The readers are woken up once the last item is written
+ * He Yan @ June 15, 2008
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int 
+writeQueueEntries( QueueWriter writer, void **items, int n )
+{
+	int i;
+
+	// lock the queue	
+	Queue q = writer->queue;
+	if ( pthread_mutex_lock( &q->queueLock ) )
+		log_fatal( "lockQueue: failed");
+
+	// the lock-free engine only uses the queue lock to serialize writers
+	if( q->engine == QUEUE_ENGINE_LOCKFREE )
+	{
+		writeLockFreeQueue( writer, items, n );
+		if ( pthread_mutex_unlock( &q->queueLock ) )
+			log_fatal( "unlockQueue: failed");
+		logQueueStatus( q );
+		return(0);
+	}
+
+	// old pacing: update pacing limit and reset readcout and writecount if needed
+	// new pacing: update write count moveing average
+	updateInterval(q);
+	
+	// only for the old pacing algorithm, otherwise skip this step	
+	if(q->newPacingEnable == FALSE)
+	{
+		// check if need to stop pacing
+		if( checkPacingStop(q) )
+			log_fatal("%s queue error stopping pacing rules", q->name);	
+	}	
+
+	for ( i = 0; i < n; i++ )
+		appendQueueEntry( writer, items[i] );
 	
         // only if use the old pacing, otherwise skip this step 
         if(q->newPacingEnable == FALSE)
@@ -701,49 +817,169 @@ writeQueue( QueueWriter writer, void *item )
 	// notify blocked readers new data has appeared
 	if(  q->readercount > 0 )
         pthread_cond_broadcast( &q->queueCond );
+	notifyQueueWaiters( q );
 
 #ifdef DEBUG
-	debug(__FUNCTION__, "Writer %d (%d writes in last interval(%d)) wrote to queue %s;  tail/head: %ld/%ld ",
-		writer->index, q->writeCounts[writer->index], QueueConfig.pacingInterval, q->name, q->tail, q->head);
+	debug(__FUNCTION__, "Writer %d (%d writes in last interval(%d)) wrote %d items to queue %s;  tail/head: %ld/%ld ",
+		writer->index, q->writeCounts[writer->index], QueueConfig.pacingInterval, n, q->name, q->tail, q->head);
 #endif	
 
-	/* log a message if we are past the log interval */
-	int now = time( NULL );
-	if ( now > q->lastLogTime + QueueConfig.logInterval)
-	{
-		q->lastLogTime = now;
-		log_msg("Queue %s status: tail=%ld head=%ld", q->name, q->tail, q->head); 
-		log_msg("Queue %s usage: currentItems=%ld, usedBytes=%ld, peakItems=%ld, allowedItems=%ld", 
-		  q->name, getItemsUsed(q->name), getBytesUsed(q->name), q->logMaxItems, QUEUE_MAX_ITEMS); 
-		log_msg("Queue %s writers: current=%d, peak=%d, allowed=%d", 
-		  q->name, getWriterCount(q->name), q->logMaxWriters, MAX_QUEUE_WRITERS); 
-		log_msg("Queue %s readers: current=%d, peak=%d, allowed=%d", 
-		  q->name, getReaderCount(q->name), q->logMaxReaders, MAX_QUEUE_READERS); 
-	}
+	logQueueStatus( q );
 
 	return(0); 
 }
 
 /*--------------------------------------------------------------------------------------
- * Purpose: Read a specified reader's next item from the queue
- * Input: queue reader and a pointer to the item read.  
- *        if other readers have yet to read this item, the pointer is copy of the item
- *        if this is the last reader to read this item, the pointer is the object itself
- *        in either case the reader should free this item after it has processed it
- * Output: numbers of unread items associated with this reader
+ * Purpose: Write a new item into the queue
+ * Input: queue to write item and the item itself
+ * Output: returns 0, exits on fatal error if write fails 
+ * He Yan @ June 15, 2008
+ * -------------------------------------------------------------------------------------*/
+int 
+writeQueue( QueueWriter writer, void *item )
+{
+	return writeQueueEntries( writer, &item, 1 );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write n new items into the queue, in order
+ * Input: queue to write items, the items and their number
+ * Output: returns 0, exits on fatal error if write fails
+ * Note: The items are published with one lock acquisition and one wakeup of the 
+ *       readers, pacing is applied to the writer once for the whole batch.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int 
+writeQueueBatch( QueueWriter writer, void **items, int n )
+{
+	if( n <= 0 )
+		return(0);
+	return writeQueueEntries( writer, items, n );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Start an empty batch of items for a writer
+ * Input: the batch and the queue writer
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+initQueueBatch( QueueBatch *batch, QueueWriter writer )
+{
+	batch->writer = writer;
+	batch->count = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add an item to a batch, the batch is written once it is full
+ * Input: the batch and the item
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+addQueueBatch( QueueBatch *batch, void *item )
+{
+	batch->items[batch->count++] = item;
+	if( batch->count == QUEUE_WRITE_BATCH )
+		flushQueueBatch( batch );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write the items of a batch into the queue and empty it
+ * Input: the batch
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+flushQueueBatch( QueueBatch *batch )
+{
+	writeQueueBatch( batch->writer, batch->items, batch->count );
+	batch->count = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Take the item at a reader's position, either as a private copy or as a 
+ *          message shared with the other readers
+ * Input: queue reader, the queue entry of the item and the shared flag
+ * Output: the item
+ * Note: Assumes that the queue lock is already in place
+ * He Yan @ June 15, 2008
+ * -------------------------------------------------------------------------------------*/
+static void *
+takeQueueEntry( QueueReader reader, QueueEntry *entry, int shared )
+{
+	Queue q = reader->queue;
+	void *item = NULL;
+
+	if( shared == TRUE )
+	{
+		// return the message itself, it lives on until the reader releases it
+		item = shareQueueEntryMessage( reader, entry );
+		entry->count--;
+		if ( entry->count == 0 )
+		{
+			freeQueueEntryMessage( q, entry );
+			q->head++;
+		}
+	}
+	else
+	{
+		entry->count--;
+		if ( entry->count == 0 && entry->shared == NULL )
+		{
+			// return the original if the last reference 
+			item = entry->messagBuf;
+			// move to the head of the queue foward to next position 
+			q->head++;		
+			// prevent accidental reuse
+			entry->messagBuf = NULL; 
+		} 
+		else 
+		{
+			// return a copy if not the only reference or if other readers still share it
+			q->copy( &item, entry->messagBuf); 
+			if ( entry->count == 0 )
+			{
+				freeQueueEntryMessage( q, entry );
+				q->head++;
+			}
+		}
+	}
+	return item;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from the queue, either 
+ *          as private copies or as messages shared with the other readers
+ * Input: queue reader, the array of items read, its size, the shared flag and whether
+ *        to wait for an item
+ * Output: the number of items read, at least 1 when waiting,
  *         or returns READER_SLOT_AVAILABLE if reader has ceased
- * Note: When the reader doesn't have new items to reader, it will be blocked and wait until 
- *       a new item becomes available.  
+ * Note: When the reader doesn't have new items to reader and wait is TRUE, it will be 
+ *       blocked and wait until a new item becomes available, otherwise 0 is returned. 
+ *       The items already available are read in a single lock acquisition.
  * He Yan @ June 15, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-long 
-readQueue( QueueReader reader, void **item )
+static long 
+readQueueEntries( QueueReader reader, void **items, int max, int shared, int wait )
 {
 	Queue q = reader->queue;
 	int s = reader->index;
+	long i, n;
 
-	// initialize the read item to NULL	
-	*item = NULL;
+	// a shared item is held until it is released
+	if( shared == TRUE && max > QUEUE_READER_MAX_HELD - reader->heldCount )
+		max = QUEUE_READER_MAX_HELD - reader->heldCount;
+	if( max < 1 )
+		max = 1;
+
+	// readers of the lock-free engine don't take the queue lock to claim items
+	if( q->engine == QUEUE_ENGINE_LOCKFREE )
+		return readLockFreeQueue( reader, items, max, shared, wait );
+
+	// initialize the first read item to NULL	
+	items[0] = NULL;
 
 	//  if this reader has ceased, return READER_SLOT_AVAILABLE
 	if( q->nextItem[s] == READER_SLOT_AVAILABLE )
@@ -756,6 +992,14 @@ readQueue( QueueReader reader, void **item )
         if ( pthread_mutex_lock( &q->queueLock ) )
                 log_fatal( "lockQueue: failed");
 
+	// a reader that doesn't wait returns at once when it has caught up
+	if( wait == FALSE && q->nextItem[s] >= q->tail )
+	{
+		if ( pthread_mutex_unlock( &q->queueLock ) )
+			log_fatal( "unlockQueue: failed");
+		return 0;
+	}
+
 	// unlock and wait for an item to become available
 	while ( q->nextItem[s] >= q->tail )  
 		if ( pthread_cond_wait( &q->queueCond, &q->queueLock ) )
@@ -771,30 +1015,18 @@ readQueue( QueueReader reader, void **item )
 		return READER_SLOT_AVAILABLE;
 	}
 
-	// determine where the next item is in the buffer and decrement its reference count
-	int i = q->nextItem[s] % QUEUE_MAX_ITEMS; 
-	q->items[i].count--;
-	if ( q->items[i].count == 0 )
-	{
-		// return the original if the last reference 
-		*item = q->items[i].messagBuf;
-		// move to the head of the queue foward to next position 
-		q->head++;		
-		// prevent accidental reuse
-		q->items[i].messagBuf = NULL; 
-	} 
-	else 
-	{
-		// return a copy if not the only reference 
-		*item = NULL;
-		q->copy( item, q->items[i].messagBuf); 
-	}
-	q->nextItem[s]++; 
-	q->itemsRead[s]++;
+	// take every available item, up to max, and decrement their reference counts
+	n = q->tail - q->nextItem[s];
+	if( n > max )
+		n = max;
+	for( i = 0; i < n; i++ )
+		items[i] = takeQueueEntry( reader, &q->items[(q->nextItem[s] + i) % QUEUE_MAX_ITEMS], shared );
+	q->nextItem[s] += n; 
+	q->itemsRead[s] += n;
 
 	// update writes limit and reset readcout and writecount if needed
 	updateInterval(q);
-	q->readCount++;
+	q->readCount += n;
 	
 	//only if use the old pacing, otherwise skip this step 
 	if(q->newPacingEnable == FALSE)
@@ -810,11 +1042,304 @@ readQueue( QueueReader reader, void **item )
 		log_fatal( "unlockQueue: failed");
 
 #ifdef DEBUG
-	debug( __FUNCTION__, "Reader %d read from queue %s; tail/head: %ld/%ld ",
-		s, q->name, q->tail, q->head);
+	debug( __FUNCTION__, "Reader %d read %ld items from queue %s; tail/head: %ld/%ld ",
+		s, n, q->name, q->tail, q->head);
 #endif		
 
-	return (q->tail - q->nextItem[s]);
+	return n;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Get the number of items a reader has not read yet
+ * Input: queue reader
+ * Output: numbers of unread items associated with this reader
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static long
+unreadQueueItems( QueueReader reader )
+{
+	Queue q = reader->queue;
+	long next = __atomic_load_n( &q->nextItem[reader->index], __ATOMIC_ACQUIRE );
+
+	if( next == READER_SLOT_AVAILABLE )
+		return READER_SLOT_AVAILABLE;
+	return __atomic_load_n( &q->tail, __ATOMIC_ACQUIRE ) - next;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read a specified reader's next item from the queue
+ * Input: queue reader and a pointer to the item read.  
+ *        if other readers have yet to read this item, the pointer is copy of the item
+ *        if this is the last reader to read this item, the pointer is the object itself
+ *        in either case the reader should free this item after it has processed it
+ * Output: numbers of unread items associated with this reader
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased
+ * Note: When the reader doesn't have new items to reader, it will be blocked and wait until 
+ *       a new item becomes available.  
+ * He Yan @ June 15, 2008
+ * -------------------------------------------------------------------------------------*/
+long 
+readQueue( QueueReader reader, void **item )
+{
+	if( readQueueEntries( reader, item, 1, FALSE, TRUE ) == READER_SLOT_AVAILABLE )
+		return READER_SLOT_AVAILABLE;
+	return unreadQueueItems( reader );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from the queue
+ * Input: queue reader, the array of items read and its size.
+ *        each item is a copy or the object itself as returned by readQueue,
+ *        the reader should free every item after it has processed it
+ * Output: the number of items read, at least 1,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased
+ * Note: Blocks like readQueue until an item is available, then reads the items
+ *       already available in a single lock acquisition.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long 
+readQueueBatch( QueueReader reader, void **items, int max )
+{
+	return readQueueEntries( reader, items, max, FALSE, TRUE );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read a specified reader's next item from the queue without copying it
+ * Input: queue reader and a pointer to the item read.
+ *        the item is shared with the other readers and must not be modified or freed,
+ *        the reader must call releaseQueueItem once it has processed the item
+ * Output: numbers of unread items associated with this reader
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased 
+ * Note: A reader may hold up to QUEUE_READER_MAX_HELD items at a time.
+ *       Blocks like readQueue when there are no new items.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long 
+readQueueShared( QueueReader reader, const void **item )
+{
+	if( readQueueEntries( reader, (void **)item, 1, TRUE, TRUE ) == READER_SLOT_AVAILABLE )
+		return READER_SLOT_AVAILABLE;
+	return unreadQueueItems( reader );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from the queue without 
+ *          copying them
+ * Input: queue reader, the array of items read and its size.
+ *        the items are shared as returned by readQueueShared,
+ *        the reader must call releaseQueueItem for every item once it has processed it
+ * Output: the number of items read, at least 1,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased 
+ * Note: No more items are read than the reader can still hold.
+ *       Blocks like readQueue until an item is available.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long 
+readQueueSharedBatch( QueueReader reader, const void **items, int max )
+{
+	return readQueueEntries( reader, (void **)items, max, TRUE, TRUE );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from the queue without 
+ *          copying them and without waiting
+ * Input: queue reader, the array of items read and its size.
+ *        the items are shared as returned by readQueueShared,
+ *        the reader must call releaseQueueItem for every item once it has processed it
+ * Output: the number of items read, 0 if there are no new items,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased 
+ * Note: Lets a reader that serves many clients poll the queue, see addQueueNotifier
+ *       to learn when new items are written.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long 
+tryReadQueueSharedBatch( QueueReader reader, const void **items, int max )
+{
+	return readQueueEntries( reader, (void **)items, max, TRUE, FALSE );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Register a descriptor to be written to when new items are written to the queue
+ * Input: the queue and the write end of a pipe
+ * Output: the notifier id, or -1 if the queue has no room for another notifier
+ * Note: The notifier only fires once it has been armed with armQueueNotifier, this
+ *       way a busy queue writes at most one byte per wakeup of the notified thread.
+ *       The descriptor should be non-blocking.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int 
+addQueueNotifier( Queue q, int fd )
+{
+	int id = -1;
+
+	if ( pthread_mutex_lock( &q->queueLock ) )
+		log_fatal( "lockQueue: failed");
+	if( q->notifierCount < QUEUE_MAX_NOTIFIERS )
+	{
+		id = q->notifierCount;
+		q->notifyFds[id] = fd;
+		q->notifyArmed[id] = FALSE;
+		// publish the notifier once it is set up, writers read the count without the lock
+		__atomic_store_n( &q->notifierCount, id + 1, __ATOMIC_RELEASE );
+	}
+	if ( pthread_mutex_unlock( &q->queueLock ) )
+		log_fatal( "unlockQueue: failed");
+
+	if( id < 0 )
+		log_err( "queue %s has no room for another notifier", q->name );
+	return id;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Arm a notifier so the next write to the queue fires it
+ * Input: the queue and the notifier id returned by addQueueNotifier
+ * Output: none
+ * Note: Arm the notifier before polling the queue with tryReadQueueSharedBatch, an item
+ *       written after the poll then always fires it.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+armQueueNotifier( Queue q, int id )
+{
+	__atomic_store_n( &q->notifyArmed[id], TRUE, __ATOMIC_SEQ_CST );
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Fire the armed notifiers of a queue after new items have been written
+ * Input: the queue
+ * Output: none
+ * Note: Each armed notifier is disarmed and gets a single byte.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+notifyQueueWaiters( Queue q )
+{
+	int count = __atomic_load_n( &q->notifierCount, __ATOMIC_ACQUIRE );
+	char c = 1;
+	int i;
+
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+	for( i = 0; i < count; i++ )
+	{
+		if( __atomic_load_n( &q->notifyArmed[i], __ATOMIC_SEQ_CST ) == FALSE )
+			continue;
+		if( __atomic_exchange_n( &q->notifyArmed[i], FALSE, __ATOMIC_SEQ_CST ) == FALSE )
+			continue;
+		// a full pipe already holds a wakeup, the byte can be dropped
+		if( write( q->notifyFds[i], &c, 1 ) < 0 && errno != EAGAIN && errno != EWOULDBLOCK )
+			log_err( "queue %s failed to fire notifier %d: %s", q->name, i, strerror( errno ) );
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Drop one reference on a shared message, free it if it was the last
+ * Input: the queue and the shared message
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+releaseSharedMessage( Queue q, SharedMessage *shared )
+{
+	if( __atomic_sub_fetch( &shared->count, 1, __ATOMIC_ACQ_REL ) == 0 )
+	{
+		q->destroy( shared->messagBuf );
+		free( shared );
+	}
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release an item obtained with readQueueShared
+ * Input: queue reader and the item
+ * Output: none
+ * Note: the item is freed once every reader has released or skipped it
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+releaseQueueItem( QueueReader reader, const void *item )
+{
+	int i;
+	// items are normally released in the order they were read
+	for( i = 0; i < reader->heldCount; i++ )
+	{
+		if( reader->held[i]->messagBuf == item )
+		{
+			releaseSharedMessage( reader->queue, reader->held[i] );
+			reader->heldCount--;
+			memmove( &reader->held[i], &reader->held[i+1], (reader->heldCount - i) * sizeof(SharedMessage *) );
+			return;
+		}
+	}
+	log_err("Reader %d released an item it doesn't hold in queue %s", reader->index, reader->queue->name);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release every shared message a reader still holds
+ * Input:  the reader
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+releaseHeldMessages( QueueReader reader )
+{
+	int i;
+	for( i = 0; i < reader->heldCount; i++ )
+		releaseSharedMessage( reader->queue, reader->held[i] );
+	reader->heldCount = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand the message of a queue entry to a reader without copying it
+ * Input:  the reader and the queue entry, the reader must own a reference on the entry
+ * Output: the message
+ * Note: the reader keeps its own reference on the message until releaseQueueItem
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *
+shareQueueEntryMessage( QueueReader reader, QueueEntry *entry )
+{
+	if( reader->heldCount >= QUEUE_READER_MAX_HELD )
+		log_fatal("Reader %d of queue %s holds more than %d shared items", reader->index, reader->queue->name, QUEUE_READER_MAX_HELD);
+		// not reached
+
+	// the first reader sharing the entry moves the message into a shared message
+	SharedMessage *shared = __atomic_load_n( &entry->shared, __ATOMIC_ACQUIRE );
+	if( shared == NULL )
+	{
+		SharedMessage *newShared = malloc( sizeof(SharedMessage) );
+		if ( newShared == NULL )
+			log_fatal( "out of memory: malloc shared queue item failed");
+			// not reached
+		newShared->count = 1;
+		newShared->messagBuf = entry->messagBuf;
+		// readers of the lock-free engine may share the same entry concurrently
+		if( __atomic_compare_exchange_n( &entry->shared, &shared, newShared, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+			shared = newShared;
+		else
+			free( newShared );
+	}
+	__atomic_add_fetch( &shared->count, 1, __ATOMIC_ACQ_REL );
+	reader->held[reader->heldCount++] = shared;
+	return shared->messagBuf;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the message of a queue entry whose last reference has been dropped
+ * Input:  the queue and the queue entry
+ * Output: none
+ * Note: if the message is shared, only the entry's reference on it is dropped
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+freeQueueEntryMessage( Queue q, QueueEntry *entry )
+{
+	if( entry->shared != NULL )
+		releaseSharedMessage( q, entry->shared );
+	else
+		q->destroy( entry->messagBuf );
+	entry->shared = NULL;
+	entry->messagBuf = NULL;
 }
 
 /*--------------------------------------------------------------------------------------
@@ -827,12 +1352,7 @@ void
 copyBMF( void **copy, void *original )
 {
 	BMF bmf = (BMF)original;
-	BMF cpy = malloc( bmf->length + BMF_HEADER_LEN );
-	if ( cpy == NULL) 
-		log_fatal( "out of memory: malloc copy of queue item failed");
-		// not reached
-	memcpy( cpy, bmf, bmf->length + BMF_HEADER_LEN ); 
-	*copy =  (void *) cpy; 
+	*copy =  (void *) copyBMFMessage( bmf ); 
 }
 
 /*--------------------------------------------------------------------------------------
@@ -848,6 +1368,18 @@ sizeOfBMF( void *msg )
 	return ( bmf->length + BMF_HEADER_LEN );
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free function for BMF message
+ * Input:  pointer to a BMF message
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void 
+freeBMF( void *msg )
+{
+	destroyBMF( (BMF)msg );
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Copy function for XML message
  * Input: pointer to hold copy and original message
@@ -856,14 +1388,12 @@ sizeOfBMF( void *msg )
  * -------------------------------------------------------------------------------------*/
 void copyXML ( void **copy, void *original )
 {
-	//int len = strlen((const char *)original);
-	int len = getXMLMessageLen((char *)original);
-	//u_char *cpy = malloc( (len+1)*sizeof(u_char) );
+	XMLMessage msg = (XMLMessage)original;
+	int len = sizeof(struct XMLMessageStruct) + msg->length;
 	u_char *cpy = malloc( len*sizeof(u_char) );
 	if ( cpy == NULL) 
 		log_fatal( "out of memory: malloc copy of queue item failed");
 		// not reached
-	//memcpy( cpy, original, len+1 );
 	memcpy( cpy, original, len );
 	*copy = (void *)cpy;
 }
@@ -876,7 +1406,7 @@ void copyXML ( void **copy, void *original )
  * -------------------------------------------------------------------------------------*/
 int sizeOfXML ( void *msg )
 {
-	return strlen((const char *)msg);
+	return sizeof(struct XMLMessageStruct) + ((XMLMessage)msg)->length;
 }
 
 /*--------------------------------------------------------------------------------------
@@ -896,10 +1426,7 @@ destroyQueue(Queue q)
 	for( i = 0; i < QUEUE_MAX_ITEMS; i++ )
 	{
 		if(q->items[i].messagBuf != NULL)
-		{
-			free( q->items[i].messagBuf );
-			q->items[i].messagBuf = NULL;
-		}
+			freeQueueEntryMessage( q, &q->items[i] );
 	}
 	//free(q->items);
 
@@ -986,8 +1513,7 @@ adjustSlowestQueueReader( Queue q, int readerIndex )
 		q->items[j].count--;
 		if ( q->items[j].count == 0 )
 		{
-			free( q->items[j].messagBuf );
-			q->items[j].messagBuf = NULL;
+			freeQueueEntryMessage( q, &q->items[j] );
 			q->head++;
 		}				
 	}
@@ -1017,7 +1543,9 @@ destroyQueueReader( QueueReader reader)
 		log_fatal( "lockQueue: failed");
 
 	// delete the reader from the queue structure
-	if(q->nextItem[reader->index] >= 0 )
+	if( q->engine == QUEUE_ENGINE_LOCKFREE )
+		removeLockFreeQueueReader( q, reader->index );
+	else if(q->nextItem[reader->index] >= 0 )
 	{
 		/* decrement reference counts for all affected items by this reader*/
 		long i = 0;
@@ -1027,8 +1555,7 @@ destroyQueueReader( QueueReader reader)
 			q->items[j].count--;
 			if ( q->items[j].count == 0 )
 			{
-				free( q->items[j].messagBuf );
-				q->items[j].messagBuf = NULL;
+				freeQueueEntryMessage( q, &q->items[j] );
 				q->head++;
 			}				
 		}
@@ -1042,6 +1569,8 @@ destroyQueueReader( QueueReader reader)
 
 	log_msg("Reader %d removed from Queue %s", reader->index, q->name);
 
+	// drop the items the reader read without copying and never released
+	releaseHeldMessages( reader );
 	free( reader );
 
 	return;
@@ -1158,6 +1687,17 @@ void setPacingInterval(int pacingInterval)
 	QueueConfig.pacingInterval = pacingInterval;
 }
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Return the engine used by newly created queues
+ * Input:
+ * Output: QUEUE_ENGINE_MUTEX or QUEUE_ENGINE_LOCKFREE
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int getQueueEngine()
+{
+	return QueueConfig.engine;
+}
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Return queue by giving queue name in string
  * Input: the queue name as a string
@@ -1193,6 +1733,12 @@ long getBytesUsed(char *queueName)
         {
                 return 0;
         }
+        else if( q->engine == QUEUE_ENGINE_LOCKFREE )
+        {
+                // items may be released by readers at any time, use the running total
+                size = (q->tail - q->head) * sizeof(long);
+                size += __atomic_load_n( &q->bytesUsed, __ATOMIC_RELAXED );
+        }
         else
         {
                 long i;
@@ -56,6 +56,19 @@
 typedef struct QueueReaderStruct *QueueReader;
 typedef struct QueueWriterStruct *QueueWriter;
 
+/* number of items a writer publishes at once */
+#define QUEUE_WRITE_BATCH 64
+
+/* The QueueBatch structure collects the items of one 
+ * writer so they are published with a single lock 
+ * acquisition and wakeup of the readers.
+ */
+typedef struct QueueBatchStruct {
+	QueueWriter	writer;
+	int		count;
+	void		*items[QUEUE_WRITE_BATCH];
+} QueueBatch;
+
 /* The Queue settings structure holds size limits and  
  * pacing parameters related to queue management.
  */
@@ -106,11 +119,12 @@ int saveQueueSettings( );
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Create a queue instance
- * Input:  the copy function for queue elements, the queue name, and the name length
+ * Input:  the copy, size and free functions for queue elements, the queue name, 
+ *         and the name length
  * Output:  the resulting queue, exits on fatal error if creation fails
  * He Yan @ June 15, 2008
  * -------------------------------------------------------------------------------------*/
-Queue createQueue( void (*copy)(void **copy, void *original), int (*sizeOf)(void *msg), char *name, int namelength, int newPacingEnable);
+Queue createQueue( void (*copy)(void **copy, void *original), int (*sizeOf)(void *msg), void (*destroy)(void *msg), char *name, int namelength, int newPacingEnable);
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Create a writer for a queue
@@ -145,6 +159,40 @@ int isQueueEmpty( Queue q );
  * -------------------------------------------------------------------------------------*/
 int writeQueue( QueueWriter writer, void *item );
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write n new items into the queue, in order
+ * Input: queue to write items, the items and their number
+ * Output: returns 0, exits on fatal error if write fails
+ * Note: The items are published with one lock acquisition and one wakeup of the 
+ *       readers, pacing is applied to the writer once for the whole batch.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int writeQueueBatch( QueueWriter writer, void **items, int n );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Start an empty batch of items for a writer
+ * Input: the batch and the queue writer
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void initQueueBatch( QueueBatch *batch, QueueWriter writer );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Add an item to a batch, the batch is written once it is full
+ * Input: the batch and the item
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void addQueueBatch( QueueBatch *batch, void *item );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Write the items of a batch into the queue and empty it
+ * Input: the batch
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void flushQueueBatch( QueueBatch *batch );
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Read a specified reader's next item from the queue
  * Input: queue reader and a pointer to the item read.
@@ -161,6 +209,87 @@ long readQueue( QueueReader reader, void **item );
 /* flags to indicate a reader's status  */
 #define READER_SLOT_AVAILABLE -1
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from the queue
+ * Input: queue reader, the array of items read and its size.
+ *        each item is a copy or the object itself as returned by readQueue,
+ *        the reader should free every item after it has processed it
+ * Output: the number of items read, at least 1,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased
+ * Note: Blocks like readQueue until an item is available, then reads the items
+ *       already available in a single lock acquisition.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long readQueueBatch( QueueReader reader, void **items, int max );
+/* number of items the queue readers take at once */
+#define QUEUE_READ_BATCH 32
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read a specified reader's next item from the queue without copying it
+ * Input: queue reader and a pointer to the item read.
+ *        the item is shared with the other readers and must not be modified or freed,
+ *        the reader must call releaseQueueItem once it has processed the item
+ * Output: numbers of unread items associated with this reader
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased 
+ * Note: A reader may hold up to QUEUE_READER_MAX_HELD items at a time.
+ *       Blocks like readQueue when there are no new items.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long readQueueShared( QueueReader reader, const void **item );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from the queue without 
+ *          copying them
+ * Input: queue reader, the array of items read and its size.
+ *        the items are shared as returned by readQueueShared,
+ *        the reader must call releaseQueueItem for every item once it has processed it
+ * Output: the number of items read, at least 1,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased 
+ * Note: No more items are read than the reader can still hold.
+ *       Blocks like readQueue until an item is available.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long readQueueSharedBatch( QueueReader reader, const void **items, int max );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read up to max of a specified reader's next items from the queue without 
+ *          copying them and without waiting
+ * Input: queue reader, the array of items read and its size.
+ *        the items are shared as returned by readQueueShared,
+ *        the reader must call releaseQueueItem for every item once it has processed it
+ * Output: the number of items read, 0 if there are no new items,
+ *         or returns READER_SLOT_AVAILABLE if reader has ceased 
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+long tryReadQueueSharedBatch( QueueReader reader, const void **items, int max );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Register a descriptor to be written to when new items are written to the queue
+ * Input: the queue and the write end of a non-blocking pipe
+ * Output: the notifier id, or -1 if the queue has no room for another notifier
+ * Note: The notifier only fires once it has been armed with armQueueNotifier.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int addQueueNotifier( Queue q, int fd );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Arm a notifier so the next write to the queue fires it
+ * Input: the queue and the notifier id returned by addQueueNotifier
+ * Output: none
+ * Note: Arm the notifier before polling the queue with tryReadQueueSharedBatch.
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void armQueueNotifier( Queue q, int id );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release an item obtained with readQueueShared
+ * Input: queue reader and the item
+ * Output: none
+ * Note: the item is freed once every reader has released or skipped it
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void releaseQueueItem( QueueReader reader, const void *item );
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Copy function for BMF message
  * Input:  pointer to hold copy and original message
@@ -177,6 +306,14 @@ void copyBMF( void **copy, void *original );
  * -------------------------------------------------------------------------------------*/
 int sizeOfBMF ( void *msg );
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free function for BMF message
+ * Input:  pointer to a BMF message
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void freeBMF ( void *msg );
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Copy function for XML message
  * Input: pointer to hold copy and original message
@@ -310,6 +447,14 @@ int getPacingInterval();
  * -------------------------------------------------------------------------------------*/
 void setPacingInterval(int);
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Return the engine used by newly created queues
+ * Input:
+ * Output: QUEUE_ENGINE_MUTEX or QUEUE_ENGINE_LOCKFREE
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int getQueueEngine();
+
 /*--------------------------------------------------------------------------------------
  * Purpose: Return queue by giving queue name in string
  * Input: the queue name as a string
@@ -76,8 +76,36 @@ typedef struct QueueConfigurationStruct
 	int		minWritesPerInterval;
 	int		pacingInterval;
 	int		logInterval;
+	int		engine;
 } QueueConfiguration;
 
+/*----------------------------------------------------------------------------------------
+ * Queue engines, selected by the QUEUE_ENGINE setting when a queue is created
+ *   QUEUE_ENGINE_MUTEX: readers and writers share the queue lock and condition
+ *   QUEUE_ENGINE_LOCKFREE: readers advance atomic cursors over sequence-stamped slots,
+ *                          the queue lock only serializes writers
+ * -------------------------------------------------------------------------------------*/
+#define QUEUE_ENGINE_MUTEX	0
+#define QUEUE_ENGINE_LOCKFREE	1
+
+
+/*----------------------------------------------------------------------------------------
+ * Message shared by the readers that read it without copying (readQueueShared)
+ * -------------------------------------------------------------------------------------*/
+typedef struct SharedMessageStruct
+{
+	// one reference for the queue entry while it holds the message,
+	// plus one for each reader that hasn't released the message
+	int		count;
+	// a pointer to the actual message buffer
+	void		*messagBuf;
+} SharedMessage;
+
+/* maximum number of shared messages a reader may hold before releasing them */
+#define QUEUE_READER_MAX_HELD 64
+
+/* maximum number of descriptors notified of new items in a queue */
+#define QUEUE_MAX_NOTIFIERS 64
 
 /*----------------------------------------------------------------------------------------
  * Entries that are stored in the queue 
@@ -88,6 +116,14 @@ typedef struct QueueEntryStruct
 	int 		count; 
 	// a pointer to the actual message buffer
 	void		*messagBuf; 
+	// lock-free engine only: the position this slot is free for (pos)
+	// or the position whose item it currently holds (pos+1)
+	long		seq;
+	// lock-free engine only: size of the message in bytes
+	int		size;
+	// the shared message once a reader has read the item without copying, 
+	// messagBuf is then owned by the shared message
+	SharedMessage	*shared;
 } QueueEntry; 
 
 /*----------------------------------------------------------------------------------------
@@ -119,6 +155,8 @@ struct QueueStruct
 	void			(*copy)(void **copy, void *original);
 	// the sizeof function for items in this queue
 	int			(*sizeOf)(void *msg);
+	// the free function for items in this queue
+	void			(*destroy)(void *msg);
 	
 	
 	// Readers information
@@ -155,6 +193,23 @@ struct QueueStruct
 	int                     writeCount;
 	// the current position of the ideal reader used to adjust the slower readers
 	long			idealReaderPosition;
+
+	// queue engine, QUEUE_ENGINE_MUTEX or QUEUE_ENGINE_LOCKFREE
+	int			engine;
+	//lock-free engine related
+	// readers only take this lock to sleep when they have caught up with the writers
+	pthread_mutex_t		waitLock;
+	pthread_cond_t		waitCond;
+	// number of readers sleeping on waitCond
+	int			sleepers;
+	// bytes held by the queue, maintained as items are written and released
+	long			bytesUsed;
+
+	// descriptors written to when new items are written, see addQueueNotifier
+	int			notifierCount;
+	int			notifyFds[QUEUE_MAX_NOTIFIERS];
+	// whether each notifier waits for the next write
+	int			notifyArmed[QUEUE_MAX_NOTIFIERS];
 };
 typedef struct QueueStruct      *Queue;
 
@@ -165,6 +220,9 @@ struct QueueReaderStruct
 {
 	Queue 		queue;
 	int		index; 
+	// shared messages read by this reader and not released yet
+	SharedMessage	*held[QUEUE_READER_MAX_HELD];
+	int		heldCount;
 };
 
 /*----------------------------------------------------------------------------------------
@@ -176,4 +234,38 @@ struct QueueWriterStruct
 	int		index; 
 };
 
+/*--------------------------------------------------------------------------------------
+ * Purpose: Free the message of a queue entry whose last reference has been dropped
+ * Input:  the queue and the queue entry
+ * Output: none
+ * Note: if the message is shared, only the entry's reference on it is dropped
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void freeQueueEntryMessage( Queue q, QueueEntry *entry );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Hand the message of a queue entry to a reader without copying it
+ * Input:  the reader and the queue entry, the reader must own a reference on the entry
+ * Output: the message
+ * Note: the reader keeps its own reference on the message until releaseQueueItem
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *shareQueueEntryMessage( struct QueueReaderStruct *reader, QueueEntry *entry );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Release every shared message a reader still holds
+ * Input:  the reader
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void releaseHeldMessages( struct QueueReaderStruct *reader );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Fire the armed notifiers of a queue after new items have been written
+ * Input: the queue
+ * Output: none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void notifyQueueWaiters( Queue q );
+
 #endif /*QUEUEINTERNAL_H_*/
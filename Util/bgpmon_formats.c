@@ -1,101 +1,162 @@
-/* 
- * 	Copyright (c) 2010 Colorado State University
- * 
- *	Permission is hereby granted, free of charge, to any person
- *	obtaining a copy of this software and associated documentation
- *	files (the "Software"), to deal in the Software without
- *	restriction, including without limitation the rights to use,
- *	copy, modify, merge, publish, distribute, sublicense, and/or
- *	sell copies of the Software, and to permit persons to whom
- *	the Software is furnished to do so, subject to the following
- *	conditions:
- *
- *	The above copyright notice and this permission notice shall be
- *	included in all copies or substantial portions of the Software.
- *
- *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
- *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
- *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
- *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
- *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
- *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
- *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
- *	OTHER DEALINGS IN THE SOFTWARE.
- * 
- * 
- *  File: bgpmon_formats.c
- * 	Authors: He Yan
- *  Date: May 6, 2008
- */
-
-/*
- *  Utility functions that work for our internal struct BMF
- */
-
-#include "bgpmon_formats.h"
-#include "log.h"
-
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <time.h>
-#include <sys/timeb.h>
-#include <arpa/inet.h>
-#include <netinet/in.h>
-#include <sys/types.h>
-#include <sys/socket.h>
-#include <unistd.h>
-#include <assert.h>
-
-#include <sys/types.h>
-#include <sys/timeb.h>
-
-
-BMF
-createBMF( u_int16_t sessionID, u_int16_t type )
-{	
-	struct timeb tp;
-	BMF m = malloc( sizeof (struct BGPmonInternalMessageFormatStruct) );
-	if ( m )
-	{
-		ftime(&tp);
-		m->timestamp =  tp.time;
-		m->precisiontime = tp.millitm;
-		m->sessionID= sessionID;
-		m->type = type;
-		m->length = 0;
-	}
-	else
-		log_fatal( "CreateBgpmonMessage: malloc failed" );
-	return m;
-}
-
-int 
-bgpmonMessageAppend(BMF m, const void *message, u_int32_t len)
-{
-	/* appends to message buffer
-	 */
-	if ( message != NULL && len > 0 && m->length + len <= BMF_MAX_MSG_LEN )
-	{
-		memcpy(&m->message[m->length], message, len);
-		m->length += len;
-	}
-	else{
-		if(len >= BMF_MAX_MSG_LEN){
-			log_err( "BgpmonMessageAppend: length error. Length is %lu, BMF_MAX_MSG_LEN is %lu", len, BMF_MAX_MSG_LEN);
-                        return -1;
-		} else{
-                         log_err("bgpmonMessageAppend: Invalid BMF or message supplied!");
-                         return -1;
-                }
-	}
-        return 0;
-}
-
-void 
-destroyBMF( BMF bmf )
-{	
-	if( bmf )
-		free(bmf);
-}
-
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ * 
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: bgpmon_formats.c
+ * 	Authors: He Yan
+ *  Date: May 6, 2008
+ */
+
+/*
+ *  Utility functions that work for our internal struct BMF
+ */
+
+#include "bgpmon_formats.h"
+#include "log.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sys/timeb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include <sys/types.h>
+#include <sys/timeb.h>
+
+
+/* the buffer stored right after the BMF structure */
+#define BMF_INLINE_MESSAGE(m)	((u_char *)((m) + 1))
+
+/* smallest size class that holds len bytes */
+static u_int32_t
+BMFCapacity( u_int32_t len )
+{
+	u_int32_t capacity = BMF_MIN_MSG_LEN;
+	while ( capacity < len && capacity < BMF_MAX_MSG_LEN )
+		capacity *= 4;
+	if ( capacity > BMF_MAX_MSG_LEN )
+		capacity = BMF_MAX_MSG_LEN;
+	return capacity;
+}
+
+BMF
+createBMF( u_int16_t sessionID, u_int16_t type )
+{	
+	return createBMFWithLength( sessionID, type, 0 );
+}
+
+BMF
+createBMFWithLength( u_int16_t sessionID, u_int16_t type, u_int32_t len )
+{	
+	struct timeb tp;
+	u_int32_t capacity = BMFCapacity( len );
+	BMF m = malloc( sizeof (struct BGPmonInternalMessageFormatStruct) + capacity );
+	if ( m )
+	{
+		ftime(&tp);
+		m->timestamp =  tp.time;
+		m->precisiontime = tp.millitm;
+		m->sessionID= sessionID;
+		m->type = type;
+		m->length = 0;
+		m->capacity = capacity;
+		m->ribSince = 0;
+		m->message = BMF_INLINE_MESSAGE(m);
+	}
+	else
+		log_fatal( "CreateBgpmonMessage: malloc failed" );
+	return m;
+}
+
+BMF
+copyBMFMessage( BMF bmf )
+{
+	u_int32_t capacity = BMFCapacity( bmf->length );
+	BMF m = malloc( sizeof (struct BGPmonInternalMessageFormatStruct) + capacity );
+	if ( m == NULL )
+		log_fatal( "copyBMFMessage: malloc failed" );
+	memcpy( m, bmf, sizeof (struct BGPmonInternalMessageFormatStruct) );
+	m->capacity = capacity;
+	m->message = BMF_INLINE_MESSAGE(m);
+	memcpy( m->message, bmf->message, bmf->length );
+	return m;
+}
+
+int 
+bgpmonMessageAppend(BMF m, const void *message, u_int32_t len)
+{
+	/* appends to message buffer, moving the message to 
+	 * a buffer of the next size classes if it doesn't fit
+	 */
+	if ( message != NULL && len > 0 && m->length + len <= BMF_MAX_MSG_LEN )
+	{
+		if ( m->length + len > m->capacity )
+		{
+			u_int32_t capacity = BMFCapacity( m->length + len );
+			u_char *buf;
+			if ( m->message == BMF_INLINE_MESSAGE(m) )
+			{
+				buf = malloc( capacity );
+				if ( buf != NULL )
+					memcpy( buf, m->message, m->length );
+			}
+			else
+				buf = realloc( m->message, capacity );
+			if ( buf == NULL )
+				log_fatal( "bgpmonMessageAppend: malloc failed" );
+			m->message = buf;
+			m->capacity = capacity;
+		}
+		memcpy(&m->message[m->length], message, len);
+		m->length += len;
+	}
+	else{
+		if(len >= BMF_MAX_MSG_LEN){
+			log_err( "BgpmonMessageAppend: length error. Length is %lu, BMF_MAX_MSG_LEN is %lu", len, BMF_MAX_MSG_LEN);
+                        return -1;
+		} else{
+                         log_err("bgpmonMessageAppend: Invalid BMF or message supplied!");
+                         return -1;
+                }
+	}
+        return 0;
+}
+
+void 
+destroyBMF( BMF bmf )
+{	
+	if( bmf )
+	{
+		if( bmf->message != BMF_INLINE_MESSAGE(bmf) )
+			free(bmf->message);
+		free(bmf);
+	}
+}
+
@@ -107,3 +107,42 @@ writen(int fd, const void *vptr, size_t n)
 	return( n );
 }
 
+
+ssize_t
+writevn(int fd, struct iovec *iov, int iovcnt)
+{
+	/* Write all the buffers of an iovec array to a socket,
+	 * the array is updated as the buffers are written.
+	 */
+	size_t total = 0;
+	ssize_t nwritten;
+	int i;
+
+	for (i = 0; i < iovcnt; i++)
+		total += iov[i].iov_len;
+
+	while (iovcnt > 0)
+	{
+		if ( (nwritten = writev(fd, iov, iovcnt)) <= 0 )
+		{
+			if (nwritten < 0 && errno == EINTR)
+				nwritten = 0; // call writev again
+			else
+				return(-1); // error
+		}
+
+		// skip the buffers written and move into a partially written one
+		while (iovcnt > 0 && (size_t)nwritten >= iov->iov_len)
+		{
+			nwritten -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0)
+		{
+			iov->iov_base = (u_char *)iov->iov_base + nwritten;
+			iov->iov_len -= nwritten;
+		}
+	}
+	return( total );
+}
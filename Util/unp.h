@@ -49,10 +49,12 @@
 #include <unistd.h>
 #include <time.h>
 #include <syslog.h>
+#include <sys/uio.h>
 
 
 extern ssize_t 	readn		( int, void *, size_t );
 extern ssize_t 	writen	( int, const void *, size_t );
+extern ssize_t 	writevn	( int, struct iovec *, int );
 
 
 
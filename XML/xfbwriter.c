@@ -0,0 +1,564 @@
+/*
+ *  Copyright (c) 2010 Colorado State University
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom
+ *  the Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ *  File:    xfbwriter.c
+ *  Authors: agent
+ *  Date:    Oct 17, 2026
+ */
+
+/* needed for memcpy and strlen */
+#include <string.h>
+
+/* needed for inet_ntop */
+#include <arpa/inet.h>
+
+/* needed for ADDR_MAX_CHARS */
+#include "../Util/bgpmon_defaults.h"
+
+/* needed for logging definitions */
+#include "../Util/log.h"
+
+#include "xfbwriter.h"
+
+//#define DEBUG
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: copy raw bytes to the output
+ * input:   w - the writer
+ *          src - the bytes
+ *          len - number of bytes
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+xfbPut(XFBWriter w, const char *src, int len)
+{
+	if ( w->end - w->pos < len )
+	{
+		w->overflow = 1;
+		w->pos = w->end;
+		return;
+	}
+	memcpy(w->pos, src, len);
+	w->pos += len;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: copy a string to the output
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+xfbPuts(XFBWriter w, const char *src)
+{
+	xfbPut(w, src, strlen(src));
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: write a character reference the way libxml2 does, for example &#xE9;
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+xfbPutCharRef(XFBWriter w, unsigned int val)
+{
+	static const char *hex = "0123456789ABCDEF";
+	char ref[16];
+	char digits[8];
+	int n = 0, len = 0;
+
+	do
+	{
+		digits[n++] = hex[val & 0xF];
+		val >>= 4;
+	} while ( val > 0 );
+
+	ref[len++] = '&';
+	ref[len++] = '#';
+	ref[len++] = 'x';
+	while ( n > 0 )
+		ref[len++] = digits[--n];
+	ref[len++] = ';';
+	xfbPut(w, ref, len);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: decode one UTF-8 character of an attribute value, as leniently as libxml2
+ *          does: the continuation bytes are not checked
+ * input:   s - the first byte of the character, which is >= 0x80 and followed by another byte
+ *          val - set to the character value
+ * Output:  the number of bytes used, 0 if the byte has to be written as a reference by itself
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+xfbDecodeUTF8(const u_char *s, unsigned int *val)
+{
+	int len = 0;
+
+	if ( s[0] < 0xC0 )
+		return 0;
+	else if ( s[0] < 0xE0 )
+	{
+		*val = ((s[0] & 0x1F) << 6) | (s[1] & 0x3F);
+		len = 2;
+	}
+	else if ( s[0] < 0xF0 && s[2] != 0 )
+	{
+		*val = ((s[0] & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+		len = 3;
+	}
+	else if ( s[0] < 0xF8 && s[2] != 0 && s[3] != 0 )
+	{
+		*val = ((s[0] & 0x07) << 18) | ((s[1] & 0x3F) << 12) | ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+		len = 4;
+	}
+
+	/* only characters allowed in XML */
+	if ( len == 0 ||
+	     !( *val == 0x9 || *val == 0xA || *val == 0xD ||
+	        (*val >= 0x20 && *val <= 0xD7FF) ||
+	        (*val >= 0xE000 && *val <= 0xFFFD) ||
+	        (*val >= 0x10000 && *val <= 0x10FFFF) ) )
+		return 0;
+	return len;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: write escaped text, as xmlNodeDump escapes text and attribute values
+ *          when the node has no document:
+ *           - text content only escapes <, >, & and the carriage return
+ *           - attribute values also escape quotes and white space, and write
+ *             non-ASCII characters as character references
+ * input:   w - the writer
+ *          text - the text to escape
+ *          attr - TRUE for an attribute value, FALSE for text content
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+xfbPutEscaped(XFBWriter w, const char *text, int attr)
+{
+	const u_char *p = (const u_char *)text;
+	const u_char *run = p;
+
+	while ( *p )
+	{
+		const char *esc = NULL;
+
+		switch ( *p )
+		{
+			case '<':  esc = "&lt;";   break;
+			case '>':  esc = "&gt;";   break;
+			case '&':  esc = "&amp;";  break;
+			case '\r': esc = "&#13;";  break;
+			case '"':  if ( attr ) esc = "&quot;"; break;
+			case '\n': if ( attr ) esc = "&#10;";  break;
+			case '\t': if ( attr ) esc = "&#9;";   break;
+		}
+
+		if ( esc != NULL )
+		{
+			/* flush the plain characters and escape this one */
+			xfbPut(w, (const char *)run, p - run);
+			xfbPuts(w, esc);
+			p++;
+			run = p;
+		}
+		else if ( attr && *p >= 0x80 && p[1] != 0 )
+		{
+			unsigned int val = 0;
+			int len = xfbDecodeUTF8(p, &val);
+
+			xfbPut(w, (const char *)run, p - run);
+			if ( len == 0 )
+			{
+				/* not UTF-8, the byte is written by itself */
+				len = 1;
+				val = *p;
+			}
+			xfbPutCharRef(w, val);
+			p += len;
+			run = p;
+		}
+		else
+		{
+			/* most characters are copied as they are */
+			p++;
+		}
+	}
+	xfbPut(w, (const char *)run, p - run);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: close the start tag of the innermost element before its content
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+xfbCloseStart(XFBWriter w)
+{
+	if ( w->startOpen )
+	{
+		xfbPut(w, ">", 1);
+		w->startOpen = 0;
+	}
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: convert an integer to decimal text
+ * input:   str - buffer of at least 12 characters
+ *          value - the value
+ *          negative - TRUE if the value is negative, value then holds its magnitude
+ * Output:  the length of the text
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+xfbFormatDecimal(char *str, u_int32_t value, int negative)
+{
+	char digits[12];
+	int n = 0, len = 0;
+
+	do
+	{
+		digits[n++] = '0' + value % 10;
+		value /= 10;
+	} while ( value > 0 );
+
+	if ( negative )
+		str[len++] = '-';
+	while ( n > 0 )
+		str[len++] = digits[--n];
+	str[len] = '\0';
+	return len;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: convert a signed integer to decimal text, as printf's %d
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+xfbFormatInt(char *str, int value)
+{
+	if ( value < 0 )
+		return xfbFormatDecimal(str, 0U - (u_int32_t)value, 1);
+	return xfbFormatDecimal(str, (u_int32_t)value, 0);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Prepare a writer to write into a buffer
+ * input:   w - the writer
+ *          buf - the output buffer
+ *          len - length of the output buffer
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbInitWriter(XFBWriter w, char *buf, int len)
+{
+	w->buf = buf;
+	w->pos = buf;
+	w->end = buf + len - 1;
+	w->overflow = 0;
+	w->depth = 0;
+	w->startOpen = 0;
+	buf[0] = '\0';
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Get the length of the text written so far
+ * input:   w - the writer
+ * Output:  the length, or -1 if the text didn't fit in the buffer
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int
+xfbLength(XFBWriter w)
+{
+	if ( w->overflow )
+		return -1;
+	*w->pos = '\0';
+	return w->pos - w->buf;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Open an element
+ * input:   w - the writer
+ *          tag - the element name, must remain valid until the element is closed
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbStartElement(XFBWriter w, const char *tag)
+{
+	if ( w->depth >= XFB_MAX_DEPTH )
+	{
+		log_err("xfbStartElement: elements nested too deep at %s", tag);
+		w->overflow = 1;
+		return;
+	}
+	xfbCloseStart(w);
+	xfbPut(w, "<", 1);
+	xfbPuts(w, tag);
+	w->tags[w->depth++] = tag;
+	w->startOpen = 1;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Close the innermost element
+ * input:   w - the writer
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbEndElement(XFBWriter w)
+{
+	if ( w->depth == 0 )
+	{
+		log_err("xfbEndElement: no element to close");
+		w->overflow = 1;
+		return;
+	}
+	w->depth--;
+	if ( w->startOpen )
+	{
+		xfbPut(w, "/>", 2);
+		w->startOpen = 0;
+		return;
+	}
+	xfbPut(w, "</", 2);
+	xfbPuts(w, w->tags[w->depth]);
+	xfbPut(w, ">", 1);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Write an element without content, <TAG/>
+ * input:   w - the writer
+ *          tag - the element name
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbEmptyElement(XFBWriter w, const char *tag)
+{
+	xfbStartElement(w, tag);
+	xfbEndElement(w);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add a string attribute to the element just opened
+ * input:   w - the writer
+ *          name - the attribute name
+ *          value - the attribute value
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbAttrString(XFBWriter w, const char *name, const char *value)
+{
+	if ( !w->startOpen )
+	{
+		log_err("xfbAttrString: attribute %s written after the content", name);
+		w->overflow = 1;
+		return;
+	}
+	xfbPut(w, " ", 1);
+	xfbPuts(w, name);
+	xfbPut(w, "=\"", 2);
+	if ( value != NULL )
+		xfbPutEscaped(w, value, 1);
+	xfbPut(w, "\"", 1);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add an integer attribute to the element just opened
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbAttrInt(XFBWriter w, const char *name, int value)
+{
+	char str[16];
+	xfbFormatInt(str, value);
+	xfbAttrString(w, name, str);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add an unsigned integer attribute to the element just opened
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbAttrUnsignedInt(XFBWriter w, const char *name, u_int32_t value)
+{
+	char str[16];
+	xfbFormatDecimal(str, value, 0);
+	xfbAttrString(w, name, str);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add a GMT time attribute to the element just opened
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbAttrGmtTime(XFBWriter w, const char *name, time_t timestamp)
+{
+	char gmttime[64];
+	struct tm tm;
+	gmttime[0] = '\0';
+	strftime(gmttime, sizeof(gmttime), "%Y-%m-%dT%H:%M:%SZ", gmtime_r(&timestamp, &tm));
+	xfbAttrString(w, name, gmttime);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add an attribute whose value is only known once the message is complete
+ * input:   w - the writer
+ *          name - the attribute name
+ *          width - number of characters reserved for the value
+ * Output:  the position of the value in the buffer, filled with '0's,
+ *          or NULL if it didn't fit in the buffer
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+char *
+xfbAttrReserve(XFBWriter w, const char *name, int width)
+{
+	char zeros[32];
+	if ( width > sizeof(zeros) )
+		width = sizeof(zeros);
+	memset(zeros, '0', width);
+
+	xfbAttrString(w, name, "");
+	if ( w->overflow )
+		return NULL;
+
+	/* move the closing quote to make room for the value */
+	w->pos--;
+	char *value = w->pos;
+	xfbPut(w, zeros, width);
+	xfbPut(w, "\"", 1);
+	return w->overflow ? NULL : value;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add text content to the innermost element
+ * input:   w - the writer
+ *          text - the text, NULL or "" still makes the element non-empty
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbText(XFBWriter w, const char *text)
+{
+	xfbCloseStart(w);
+	if ( text != NULL )
+		xfbPutEscaped(w, text, 0);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Write a child element with a string value, for example: <mytag>myvalue</mytag>
+ * input:   w - the writer
+ *          tag   - the element name
+ *          value - the string
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbChildString(XFBWriter w, const char *tag, const char *value)
+{
+	xfbStartElement(w, tag);
+	xfbText(w, value);
+	xfbEndElement(w);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Write a child element with an integer value, for example: <mytag>5</mytag>
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbChildInt(XFBWriter w, const char *tag, int value)
+{
+	char str[16];
+	xfbFormatInt(str, value);
+	xfbChildString(w, tag, str);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Write a child element with an unsigned integer value
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbChildUnsignedInt(XFBWriter w, const char *tag, u_int32_t value)
+{
+	char str[16];
+	xfbFormatDecimal(str, value, 0);
+	xfbChildString(w, tag, str);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Write a child element with an IPv4 address, for example: <mytag>1.2.3.4</mytag>
+ * input:   w - the writer
+ *          tag - the element name
+ *          ip  - the address in network byte order
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbChildIP(XFBWriter w, const char *tag, u_int32_t ip)
+{
+	char buf[ADDR_MAX_CHARS];
+
+	if( inet_ntop(AF_INET, &ip, buf, ADDR_MAX_CHARS) == NULL ){
+		log_err("xfbChildIP: unable to create ip address string\n");
+		buf[0] = '\0';
+	}
+	xfbChildString(w, tag, buf);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Write a child element with a hexadecimal value and its length,
+ *          for example: <mytag length="2">A1F0</mytag>
+ * input:   w - the writer
+ *          tag    - the element name
+ *          octets - binary octets
+ *          len    - length of octets
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+xfbChildOctets(XFBWriter w, const char *tag, const u_char *octets, int len)
+{
+	static const char *hex = "0123456789ABCDEF";
+	int i;
+
+	xfbStartElement(w, tag);
+	xfbAttrInt(w, "length", len);
+	xfbText(w, "");
+
+	/* Convert the binary string to hexdecimal ascii string in place */
+	if ( len > 0 && w->end - w->pos < 2*len )
+	{
+		w->overflow = 1;
+		w->pos = w->end;
+	}
+	for ( i = 0; i < len && !w->overflow; i++ )
+	{
+		*w->pos++ = hex[ octets[i] >> 4 ];
+		*w->pos++ = hex[ octets[i] & 15 ];
+	}
+	xfbEndElement(w);
+}
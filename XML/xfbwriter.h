@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2010 Colorado State University
+ *
+ *  Permission is hereby granted, free of charge, to any person
+ *  obtaining a copy of this software and associated documentation
+ *  files (the "Software"), to deal in the Software without
+ *  restriction, including without limitation the rights to use,
+ *  copy, modify, merge, publish, distribute, sublicense, and/or
+ *  sell copies of the Software, and to permit persons to whom
+ *  the Software is furnished to do so, subject to the following
+ *  conditions:
+ *
+ *  The above copyright notice and this permission notice shall be
+ *  included in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *  EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *  OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *  NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *  HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *  WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *  OTHER DEALINGS IN THE SOFTWARE.
+ *
+ *
+ *  File:    xfbwriter.h
+ *  Authors: agent
+ *  Date:    Oct 17, 2026
+ */
+
+#ifndef XFBWRITER_H_
+#define XFBWRITER_H_
+
+/* needed for u_int32_t and time_t */
+#include <sys/types.h>
+#include <time.h>
+
+/* The XFB writer emits XML text directly into a caller supplied buffer,
+ * element by element, in the same form libxml2's xmlNodeDump produces
+ * for a tree without formatting:
+ *   - an element without content is written as <TAG/>
+ *   - an element with content, even an empty string, is written as <TAG>...</TAG>
+ *   - text and attribute values are escaped the way xmlNodeDump escapes them
+ * All attributes of an element must be written before its first child or text.
+ */
+
+/* maximum nesting depth of elements */
+#define XFB_MAX_DEPTH 32
+
+struct XFBWriterStruct
+{
+	// the output buffer
+	char		*buf;
+	// the next byte to write
+	char		*pos;
+	// the end of the buffer, one byte is always kept for the terminating null
+	char		*end;
+	// set when the output didn't fit in the buffer
+	int		overflow;
+	// the open elements
+	const char	*tags[XFB_MAX_DEPTH];
+	int		depth;
+	// the start tag of the innermost element is not closed yet, attributes may follow
+	int		startOpen;
+};
+typedef struct XFBWriterStruct *XFBWriter;
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Prepare a writer to write into a buffer
+ * input:   w - the writer
+ *          buf - the output buffer
+ *          len - length of the output buffer
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void xfbInitWriter(XFBWriter w, char *buf, int len);
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Get the length of the text written so far
+ * input:   w - the writer
+ * Output:  the length, or -1 if the text didn't fit in the buffer
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int xfbLength(XFBWriter w);
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Open and close elements
+ * input:   w - the writer
+ *          tag - the element name, must remain valid until the element is closed
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void xfbStartElement(XFBWriter w, const char *tag);
+void xfbEndElement(XFBWriter w);
+/* an element without content: <TAG/> */
+void xfbEmptyElement(XFBWriter w, const char *tag);
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add an attribute to the element just opened
+ * input:   w - the writer
+ *          name - the attribute name
+ *          value - the attribute value (with different data types)
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+/* String  */ void xfbAttrString(XFBWriter w, const char *name, const char *value);
+/* Integer */ void xfbAttrInt(XFBWriter w, const char *name, int value);
+/* u_int   */ void xfbAttrUnsignedInt(XFBWriter w, const char *name, u_int32_t value);
+/* Time    */ void xfbAttrGmtTime(XFBWriter w, const char *name, time_t timestamp);
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add an attribute whose value is only known once the message is complete
+ * input:   w - the writer
+ *          name - the attribute name
+ *          width - number of characters reserved for the value
+ * Output:  the position of the value in the buffer, filled with '0's,
+ *          or NULL if it didn't fit in the buffer
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+char *xfbAttrReserve(XFBWriter w, const char *name, int width);
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Add text content to the innermost element
+ * input:   w - the writer
+ *          text - the text, NULL or "" still makes the element non-empty
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void xfbText(XFBWriter w, const char *text);
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Write a plain child element, for example: <mytag>myvalue</mytag>
+ * input:   w - the writer
+ *          tag   - the element name
+ *          value - the element value (with different data types)
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+/* String  */ void xfbChildString(XFBWriter w, const char *tag, const char *value);
+/* Integer */ void xfbChildInt(XFBWriter w, const char *tag, int value);
+/* u_int   */ void xfbChildUnsignedInt(XFBWriter w, const char *tag, u_int32_t value);
+/* IP      */ void xfbChildIP(XFBWriter w, const char *tag, u_int32_t ip);
+/* Octet   */ void xfbChildOctets(XFBWriter w, const char *tag, const u_char *octets, int len); /* len: octet length */
+
+#endif /*XFBWRITER_H_*/
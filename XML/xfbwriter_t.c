@@ -0,0 +1,360 @@
+/* 
+ * 	Copyright (c) 2010 Colorado State University
+ *	
+ *	Permission is hereby granted, free of charge, to any person
+ *	obtaining a copy of this software and associated documentation
+ *	files (the "Software"), to deal in the Software without
+ *	restriction, including without limitation the rights to use,
+ *	copy, modify, merge, publish, distribute, sublicense, and/or
+ *	sell copies of the Software, and to permit persons to whom
+ *	the Software is furnished to do so, subject to the following
+ *	conditions:
+ *
+ *	The above copyright notice and this permission notice shall be
+ *	included in all copies or substantial portions of the Software.
+ *
+ *	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ *	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ *	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ *	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ *	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ *	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ *	OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * 
+ *  File: xfbwriter_t.c
+ *  Authors: agent
+ *  Date: Oct 17, 2026
+ */
+#include <CUnit/Basic.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <libxml/tree.h>
+#include "../Util/bgpmon_formats.h"
+#include "xfbwriter.h"
+#include "xmldata.h"
+#include "xmlinternal.h"
+#include "../Clients/clientscontrol.h"
+#include "../Peering/peersession.h"
+
+/* a few global variables to play with across tests */
+#define XFB_TEST_SESSION 7
+#define XFB_TEST_SEQ 1234567890
+
+char xfbBuf[XML_BUFFER_LEN];
+
+/* BGP messages converted by both converters, without the 19 bytes header */
+static const u_char keepaliveBody[] = { 0 };
+static const u_char openBody[] = {
+  0x04, 0xfd, 0xe9, 0x00, 0xb4, 0x0a, 0x00, 0x00, 0x01,	// version, AS 65001, hold time 180, BGP ID 10.0.0.1
+  0x10,							// optional parameters
+  0x02, 0x06, 0x01, 0x04, 0x00, 0x01, 0x00, 0x01,		// multiprotocol IPv4 unicast
+  0x02, 0x06, 0x41, 0x04, 0x00, 0x00, 0xfd, 0xe9 };	// 4 bytes AS 65001
+static const u_char updateBody[] = {
+  0x00, 0x04, 0x18, 0xc0, 0x00, 0x02,			// withdrawn 192.0.2.0/24
+  0x00, 0x24,						// path attributes
+  0x40, 0x01, 0x01, 0x00,				// ORIGIN IGP
+  0x40, 0x02, 0x08, 0x02, 0x03, 0xfd, 0xe9, 0xfd, 0xea, 0xfd, 0xeb,	// AS_PATH 65001 65002 65003
+  0x40, 0x03, 0x04, 0x0a, 0x00, 0x00, 0x01,		// NEXT_HOP 10.0.0.1
+  0x80, 0x04, 0x04, 0x00, 0x00, 0x00, 0x64,		// MED 100
+  0xc0, 0x08, 0x04, 0xfd, 0xe9, 0x00, 0x64,		// COMMUNITIES 65001:100
+  0x08, 0x0a,						// NLRI 10.0.0.0/8
+  0x0c, 0xac, 0x10,					// 172.16.0.0/12
+  0x19, 0xcb, 0x00, 0x71, 0x80 };			// 203.0.113.128/25
+static const u_char mpUpdateBody[] = {
+  0x00, 0x00,						// no withdrawn routes
+  0x00, 0x35,						// path attributes
+  0x40, 0x01, 0x01, 0x02,				// ORIGIN INCOMPLETE
+  0x40, 0x02, 0x04, 0x02, 0x01, 0xfd, 0xe9,		// AS_PATH 65001
+  0x80, 0x0e, 0x1a, 0x00, 0x02, 0x01, 0x10,		// MP_REACH_NLRI IPv6 unicast
+  0x20, 0x01, 0x0d, 0xb8, 0x00, 0x00, 0x00, 0x00,	// next hop 2001:db8::1
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01,
+  0x00, 0x20, 0x20, 0x01, 0x0d, 0xb8,			// 2001:db8::/32
+  0x80, 0x0f, 0x0a, 0x00, 0x02, 0x01,			// MP_UNREACH_NLRI IPv6 unicast
+  0x30, 0x20, 0x01, 0x0d, 0xb8, 0x00, 0x01 };		// 2001:db8:1::/48
+static const u_char notificationBody[] = { 0x06, 0x02 };	// CEASE, administrative shutdown
+
+struct XFBTestMessage
+{
+  int			type;		// BGP message type
+  const u_char		*body;
+  int			len;
+};
+
+static const struct XFBTestMessage XFBTestMessages[] = {
+  { 4, keepaliveBody, 0 },
+  { 1, openBody, sizeof(openBody) },
+  { 2, updateBody, sizeof(updateBody) },
+  { 2, mpUpdateBody, sizeof(mpUpdateBody) },
+  { 3, notificationBody, sizeof(notificationBody) } };
+
+#define XFB_TEST_MESSAGES (int)(sizeof(XFBTestMessages) / sizeof(XFBTestMessages[0]))
+
+/* the same messages converted by the libxml2 converter of bgpmon 7.2.2,
+ * on session 7 with bgpmon id 42 and sequence number 1234567890 */
+static const char *XFBExpected[] = {
+  /* KEEPALIVE */
+  "<BGP_MESSAGE length=\"00000750\" version=\"0.4\" xmlns=\"urn:ietf:params:xml:ns:xfb-0.4\" type_value=\"4\" type=\"KEEPALIVE\">"
+  "<BGPMON_SEQ id=\"42\" seq_num=\"1234567890\"/>"
+  "<TIME timestamp=\"1300000000\" datetime=\"2011-03-13T07:06:40Z\" precision_time=\"123\"/>"
+  "<PEERING as_num_len=\"2\"><SRC_ADDR><ADDRESS>192.0.2.2</ADDRESS><AFI value=\"1\">"
+  "IPV4</AFI></SRC_ADDR><SRC_PORT>179</SRC_PORT><SRC_AS>65000</SRC_AS><DST_ADDR><ADDRESS>"
+  "192.0.2.1</ADDRESS><AFI value=\"1\">IPV4</AFI></DST_ADDR><DST_PORT>179</DST_PORT>"
+  "<DST_AS>65001</DST_AS><BGPID>1.0.0.10</BGPID></PEERING><ASCII_MSG length=\"19\">"
+  "<MARKER length=\"16\">FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF</MARKER><KEEPALIVE/></ASCII_MSG>"
+  "<OCTET_MSG><OCTETS length=\"19\">FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF001304</OCTETS>"
+  "</OCTET_MSG></BGP_MESSAGE>",
+  /* OPEN */
+  "<BGP_MESSAGE length=\"00000932\" version=\"0.4\" xmlns=\"urn:ietf:params:xml:ns:xfb-0.4\" type_value=\"1\" type=\"OPEN\">"
+  "<BGPMON_SEQ id=\"42\" seq_num=\"1234567890\"/>"
+  "<TIME timestamp=\"1300000000\" datetime=\"2011-03-13T07:06:40Z\" precision_time=\"123\"/>"
+  "<PEERING as_num_len=\"2\"><SRC_ADDR><ADDRESS>192.0.2.2</ADDRESS><AFI value=\"1\">"
+  "IPV4</AFI></SRC_ADDR><SRC_PORT>179</SRC_PORT><SRC_AS>65000</SRC_AS><DST_ADDR><ADDRESS>"
+  "192.0.2.1</ADDRESS><AFI value=\"1\">IPV4</AFI></DST_ADDR><DST_PORT>179</DST_PORT>"
+  "<DST_AS>65001</DST_AS><BGPID>1.0.0.10</BGPID></PEERING><ASCII_MSG length=\"45\">"
+  "<MARKER length=\"16\">FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF</MARKER><OPEN><VERSION>"
+  "4</VERSION><SRC_AS>65001</SRC_AS><HOLD_TIME>180</HOLD_TIME><SRC_BGP>1.0.0.10</SRC_BGP>"
+  "<OPT_PAR_LEN>16</OPT_PAR_LEN><OPT_PAR/></OPEN></ASCII_MSG><OCTET_MSG>"
+  "<OCTETS length=\"45\">"
+  "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF002D0104FDE900B40A000001100206010400010001020641040000FDE9</OCTETS>"
+  "</OCTET_MSG></BGP_MESSAGE>",
+  /* UPDATE */
+  "<BGP_MESSAGE length=\"00002176\" version=\"0.4\" xmlns=\"urn:ietf:params:xml:ns:xfb-0.4\" type_value=\"2\" type=\"UPDATE\">"
+  "<BGPMON_SEQ id=\"42\" seq_num=\"1234567890\"/>"
+  "<TIME timestamp=\"1300000000\" datetime=\"2011-03-13T07:06:40Z\" precision_time=\"123\"/>"
+  "<PEERING as_num_len=\"2\"><SRC_ADDR><ADDRESS>192.0.2.2</ADDRESS><AFI value=\"1\">"
+  "IPV4</AFI></SRC_ADDR><SRC_PORT>179</SRC_PORT><SRC_AS>65000</SRC_AS><DST_ADDR><ADDRESS>"
+  "192.0.2.1</ADDRESS><AFI value=\"1\">IPV4</AFI></DST_ADDR><DST_PORT>179</DST_PORT>"
+  "<DST_AS>65001</DST_AS><BGPID>1.0.0.10</BGPID></PEERING><ASCII_MSG length=\"73\">"
+  "<MARKER length=\"16\">FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF</MARKER>"
+  "<UPDATE withdrawn_len=\"4\" path_attr_len=\"36\"><WITHDRAWN count=\"1\"><PREFIX><ADDRESS>"
+  "192.0.2.0/24</ADDRESS><AFI value=\"1\">IPV4</AFI><SAFI value=\"1\">UNICAST</SAFI></PREFIX>"
+  "</WITHDRAWN><PATH_ATTRIBUTES count=\"5\"><ATTRIBUTE length=\"1\">"
+  "<FLAGS transitive=\"TRUE\"/><TYPE value=\"1\">ORIGIN</TYPE><ORIGIN value=\"0\">IGP</ORIGIN>"
+  "</ATTRIBUTE><ATTRIBUTE length=\"8\"><FLAGS transitive=\"TRUE\"/><TYPE value=\"2\">"
+  "AS_PATH</TYPE><AS_PATH><AS_SEG type=\"AS_SEQUENCE\" length=\"3\"><AS>65001</AS><AS>"
+  "65002</AS><AS>65003</AS></AS_SEG></AS_PATH></ATTRIBUTE><ATTRIBUTE length=\"4\">"
+  "<FLAGS transitive=\"TRUE\"/><TYPE value=\"3\">NEXT_HOP</TYPE><NEXT_HOP>10.0.0.1</NEXT_HOP>"
+  "</ATTRIBUTE><ATTRIBUTE length=\"4\"><FLAGS optional=\"TRUE\"/><TYPE value=\"4\">"
+  "MULTI_EXIT_DISC</TYPE><MULTI_EXIT_DISC>100</MULTI_EXIT_DISC></ATTRIBUTE>"
+  "<ATTRIBUTE length=\"4\"><FLAGS optional=\"TRUE\" transitive=\"TRUE\"/><TYPE value=\"8\">"
+  "COMMUNITIES</TYPE><COMMUNITIES><COMMUNITY><AS>65001</AS><VALUE>100</VALUE></COMMUNITY>"
+  "</COMMUNITIES></ATTRIBUTE></PATH_ATTRIBUTES><NLRI count=\"3\"><PREFIX><ADDRESS>"
+  "10.0.0.0/8</ADDRESS><AFI value=\"1\">IPV4</AFI><SAFI value=\"1\">UNICAST</SAFI></PREFIX>"
+  "<PREFIX><ADDRESS>172.16.0.0/12</ADDRESS><AFI value=\"1\">IPV4</AFI><SAFI value=\"1\">"
+  "UNICAST</SAFI></PREFIX><PREFIX><ADDRESS>203.0.113.128/25</ADDRESS><AFI value=\"1\">"
+  "IPV4</AFI><SAFI value=\"1\">UNICAST</SAFI></PREFIX></NLRI></UPDATE></ASCII_MSG>"
+  "<OCTET_MSG><OCTETS length=\"73\">"
+  "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF004902000418C000020024400101004002080203FDE9FDEAFDEB4003040A00000180040400000064C00804FDE90064080A0CAC1019CB007180</OCTETS>"
+  "</OCTET_MSG></BGP_MESSAGE>",
+  /* UPDATE with MP_REACH_NLRI and MP_UNREACH_NLRI */
+  "<BGP_MESSAGE length=\"00002001\" version=\"0.4\" xmlns=\"urn:ietf:params:xml:ns:xfb-0.4\" type_value=\"2\" type=\"UPDATE\">"
+  "<BGPMON_SEQ id=\"42\" seq_num=\"1234567890\"/>"
+  "<TIME timestamp=\"1300000000\" datetime=\"2011-03-13T07:06:40Z\" precision_time=\"123\"/>"
+  "<PEERING as_num_len=\"2\"><SRC_ADDR><ADDRESS>192.0.2.2</ADDRESS><AFI value=\"1\">"
+  "IPV4</AFI></SRC_ADDR><SRC_PORT>179</SRC_PORT><SRC_AS>65000</SRC_AS><DST_ADDR><ADDRESS>"
+  "192.0.2.1</ADDRESS><AFI value=\"1\">IPV4</AFI></DST_ADDR><DST_PORT>179</DST_PORT>"
+  "<DST_AS>65001</DST_AS><BGPID>1.0.0.10</BGPID></PEERING><ASCII_MSG length=\"76\">"
+  "<MARKER length=\"16\">FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF</MARKER>"
+  "<UPDATE withdrawn_len=\"0\" path_attr_len=\"53\"><WITHDRAWN count=\"0\"/>"
+  "<PATH_ATTRIBUTES count=\"4\"><ATTRIBUTE length=\"1\"><FLAGS transitive=\"TRUE\"/>"
+  "<TYPE value=\"1\">ORIGIN</TYPE><ORIGIN value=\"2\">INCOMPLETE</ORIGIN></ATTRIBUTE>"
+  "<ATTRIBUTE length=\"4\"><FLAGS transitive=\"TRUE\"/><TYPE value=\"2\">AS_PATH</TYPE>"
+  "<AS_PATH><AS_SEG type=\"AS_SEQUENCE\" length=\"1\"><AS>65001</AS></AS_SEG></AS_PATH>"
+  "</ATTRIBUTE><ATTRIBUTE length=\"26\"><FLAGS optional=\"TRUE\"/><TYPE value=\"14\">"
+  "MP_REACH_NLRI</TYPE><MP_REACH_NLRI><AFI value=\"2\">IPV6</AFI><SAFI value=\"1\">"
+  "UNICAST</SAFI><NEXT_HOP_LEN>16</NEXT_HOP_LEN><NEXT_HOP><ADDRESS>2001:db8::1</ADDRESS>"
+  "</NEXT_HOP><NLRI count=\"1\"><PREFIX><ADDRESS>2001:db8::/32</ADDRESS><AFI value=\"2\">"
+  "IPV6</AFI><SAFI value=\"1\">UNICAST</SAFI></PREFIX></NLRI></MP_REACH_NLRI></ATTRIBUTE>"
+  "<ATTRIBUTE length=\"10\"><FLAGS optional=\"TRUE\"/><TYPE value=\"15\">MP_UNREACH_NLRI</TYPE>"
+  "<MP_UNREACH_NLRI><AFI value=\"2\">IPV6</AFI><SAFI value=\"1\">UNICAST</SAFI>"
+  "<WITHDRAWN count=\"1\"><PREFIX><ADDRESS>2001:db8:1::/48</ADDRESS><AFI value=\"2\">"
+  "IPV6</AFI><SAFI value=\"1\">UNICAST</SAFI></PREFIX></WITHDRAWN></MP_UNREACH_NLRI>"
+  "</ATTRIBUTE></PATH_ATTRIBUTES><NLRI count=\"0\"/></UPDATE></ASCII_MSG><OCTET_MSG>"
+  "<OCTETS length=\"76\">"
+  "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF004C0200000035400101024002040201FDE9800E1A0002011020010DB8000000000000000000000001002020010DB8800F0A0002013020010DB80001</OCTETS>"
+  "</OCTET_MSG></BGP_MESSAGE>",
+  /* NOTIFICATION */
+  "<BGP_MESSAGE length=\"00000867\" version=\"0.4\" xmlns=\"urn:ietf:params:xml:ns:xfb-0.4\" type_value=\"3\" type=\"NOTIFICATION\">"
+  "<BGPMON_SEQ id=\"42\" seq_num=\"1234567890\"/>"
+  "<TIME timestamp=\"1300000000\" datetime=\"2011-03-13T07:06:40Z\" precision_time=\"123\"/>"
+  "<PEERING as_num_len=\"2\"><SRC_ADDR><ADDRESS>192.0.2.2</ADDRESS><AFI value=\"1\">"
+  "IPV4</AFI></SRC_ADDR><SRC_PORT>179</SRC_PORT><SRC_AS>65000</SRC_AS><DST_ADDR><ADDRESS>"
+  "192.0.2.1</ADDRESS><AFI value=\"1\">IPV4</AFI></DST_ADDR><DST_PORT>179</DST_PORT>"
+  "<DST_AS>65001</DST_AS><BGPID>1.0.0.10</BGPID></PEERING><ASCII_MSG length=\"21\">"
+  "<MARKER length=\"16\">FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF</MARKER><NOTIFICATION>"
+  "<TYPE error_code=\"6\">CEASE</TYPE><SUBTYPE error_subcode=\"2\">"
+  "ADMINISTRATIVE SHUTDOWN</SUBTYPE></NOTIFICATION></ASCII_MSG><OCTET_MSG>"
+  "<OCTETS length=\"21\">FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF0015030602</OCTETS></OCTET_MSG>"
+  "</BGP_MESSAGE>"
+};
+
+/* the BMF of a test message received on the test session */
+static BMF
+xfbCreateBMF(int i)
+{
+  u_char hdr[19];
+  BMF bmf = createBMF(XFB_TEST_SESSION, BMF_TYPE_MSG_FROM_PEER);
+
+  bmf->timestamp = 1300000000;
+  bmf->precisiontime = 123;
+  memset(hdr, 0xff, 16);
+  hdr[16] = (19 + XFBTestMessages[i].len) >> 8;
+  hdr[17] = (19 + XFBTestMessages[i].len) & 0xff;
+  hdr[18] = XFBTestMessages[i].type;
+  bgpmonMessageAppend(bmf, hdr, 19);
+  if(XFBTestMessages[i].len > 0){
+    bgpmonMessageAppend(bmf, XFBTestMessages[i].body, XFBTestMessages[i].len);
+  }
+  return bmf;
+}
+
+/* dumps a libxml2 tree the way the old converter did */
+static int
+xfbDumpTree(xmlNodePtr node, char *out, int len)
+{
+  xmlBufferPtr buff = xmlBufferCreate();
+  int n = xmlNodeDump(buff, NULL, node, 0, 0);
+
+  if(n >= len){
+    n = len - 1;
+  }
+  memcpy(out, xmlBufferContent(buff), n);
+  out[n] = '\0';
+  xmlBufferFree(buff);
+  return n;
+}
+
+/* The suite initialization function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+init_xfbwriter(void)
+{
+  Session_structp session = calloc(1, sizeof(struct SessionStruct));
+
+  if(session == NULL){
+    return -1;
+  }
+  session->sessionID = XFB_TEST_SESSION;
+  session->fsm.ASNumlen = 2;
+  strcpy(session->sessionRealSrcAddr, "192.0.2.2");
+  session->configInUse.localPort = 179;
+  session->configInUse.localAS2 = 65000;
+  strcpy(session->configInUse.remoteAddr, "192.0.2.1");
+  session->configInUse.remotePort = 179;
+  session->configInUse.remoteAS2 = 65001;
+  session->configInUse.remoteBGPID = 0x0a000001;
+  Sessions[XFB_TEST_SESSION] = session;
+  ClientControls.bgpmon_id = 42;
+  return 0;
+}
+
+/* The suite cleanup function.
+ * Returns zero on success, non-zero otherwise.
+ */
+int
+clean_xfbwriter(void)
+{
+  free(Sessions[XFB_TEST_SESSION]);
+  Sessions[XFB_TEST_SESSION] = NULL;
+  return 0;
+}
+
+/* TEST: the writer escapes text and attributes and closes elements like xmlNodeDump
+ */
+void
+testXFB_writer()
+{
+  const char *values[] = {
+    "plain",
+    "a&b<c>d\"e'f",
+    "tab\tnew line\ncarriage return\r",
+    "caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80",
+    "",
+    NULL };
+  static char expected[4096], written[4096];
+  struct XFBWriterStruct writer;
+  xmlNodePtr root, node;
+  int i, len;
+
+  for(i = 0; values[i] != NULL; i++){
+    // the old converter's tree
+    root = xmlNewNode(NULL, BAD_CAST "ROOT");
+    xmlNewProp(root, BAD_CAST "value", BAD_CAST values[i]);
+    xmlNewProp(root, BAD_CAST "count", BAD_CAST "-12");
+    node = xmlNewChild(root, NULL, BAD_CAST "EMPTY", NULL);
+    xmlNewProp(node, BAD_CAST "id", BAD_CAST "4294967295");
+    xmlNewTextChild(root, NULL, BAD_CAST "TEXT", BAD_CAST values[i]);
+    node = xmlNewChild(root, NULL, BAD_CAST "NESTED", NULL);
+    xmlNewTextChild(node, NULL, BAD_CAST "NUMBER", BAD_CAST "7");
+    len = xfbDumpTree(root, expected, sizeof(expected));
+    xmlFreeNode(root);
+
+    // the same tree written directly
+    xfbInitWriter(&writer, written, sizeof(written));
+    xfbStartElement(&writer, "ROOT");
+    xfbAttrString(&writer, "value", values[i]);
+    xfbAttrInt(&writer, "count", -12);
+    xfbStartElement(&writer, "EMPTY");
+    xfbAttrUnsignedInt(&writer, "id", 4294967295U);
+    xfbEndElement(&writer);
+    xfbChildString(&writer, "TEXT", values[i]);
+    xfbStartElement(&writer, "NESTED");
+    xfbChildInt(&writer, "NUMBER", 7);
+    xfbEndElement(&writer);
+    xfbEndElement(&writer);
+
+    CU_ASSERT(len == xfbLength(&writer));
+    CU_ASSERT(0 == strcmp(expected, written));
+    if(strcmp(expected, written)){
+      fprintf(stderr,"libxml2: %s\nxfb:     %s\n", expected, written);
+    }
+  }
+
+  // a reserved value is filled in later, output that doesn't fit is reported
+  xfbInitWriter(&writer, written, sizeof(written));
+  xfbStartElement(&writer, "SEQ");
+  CU_ASSERT(NULL != xfbAttrReserve(&writer, "seq_num", XML_SEQ_DIGITS));
+  xfbEndElement(&writer);
+  CU_ASSERT(27 == xfbLength(&writer));
+  CU_ASSERT(0 == strcmp("<SEQ seq_num=\"0000000000\"/>", written));
+
+  xfbInitWriter(&writer, written, 16);
+  xfbStartElement(&writer, "SEQ");
+  CU_ASSERT(NULL == xfbAttrReserve(&writer, "seq_num", XML_SEQ_DIGITS));
+  xfbEndElement(&writer);
+  CU_ASSERT(-1 == xfbLength(&writer));
+}
+
+/* TEST: BMF2XMLDATA gives the same XML as the libxml2 converter it replaced
+ */
+void
+testXFB_BMF2XMLDATA()
+{
+  BMF bmf;
+  int i, len, seqPos;
+
+  for(i = 0; i < XFB_TEST_MESSAGES; i++){
+    bmf = xfbCreateBMF(i);
+    seqPos = -1;
+    len = BMF2XMLDATA(bmf, xfbBuf, XML_BUFFER_LEN, &seqPos);
+    destroyBMF(bmf);
+    CU_ASSERT(len > 0);
+    CU_ASSERT(seqPos > 0 && seqPos + XML_SEQ_DIGITS < len);
+    if(len <= 0 || seqPos <= 0){
+      continue;
+    }
+    // the sequence number is stamped when the message is sent
+    CU_ASSERT(0 == strncmp(xfbBuf + seqPos, "0000000000", XML_SEQ_DIGITS));
+    setXMLSequence(xfbBuf + seqPos, XFB_TEST_SEQ);
+
+    CU_ASSERT(len == (int)strlen(XFBExpected[i]));
+    CU_ASSERT(0 == memcmp(xfbBuf, XFBExpected[i], len));
+    if(len != (int)strlen(XFBExpected[i]) || memcmp(xfbBuf, XFBExpected[i], len)){
+      fprintf(stderr,"message %d:\n%.*s\n", i, len, xfbBuf);
+    }
+  }
+}
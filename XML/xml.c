@@ -32,6 +32,10 @@
 /* needed for pthread related functions */
 #include <pthread.h>
 
+/* needed for malloc, memchr and memcpy */
+#include <stdlib.h>
+#include <string.h>
+
 /* needed for queues*/
 #include "../Queues/queue.h"
 
@@ -66,64 +70,210 @@
 //needed for sequence number management
 #include "../Clients/clientscontrol.h"
 
+//needed for the client filters
+#include "../Clients/clientfilter.h"
+
 //needed for loop cache
 #include "../Chains/chains.h"
 
 //#define DEBUG
 
-// buffer used to do xml conversion
-static char xml[XML_BUFFER_LEN]; /* XML_BUFFER_LEN defined in xmlinternal.h */
+/* needed for reading and saving the number of workers */
+#include "../Config/configdefaults.h"
+#include "../Config/configfile.h"
+
+/* states of a job in the reorder ring */
+#define XML_JOB_PENDING		0	/* waiting for a worker or being converted */
+#define XML_JOB_CONVERTED	1	/* converted, waiting to be written in order */
+
+/* a labeled message on its way to the XML queues */
+struct XMLJobStruct
+{
+	BMF		bmf;
+	// position of the seq_num value in the text, stamped by the output thread
+	int		seqPos;
+	// converted message, NULL if the conversion failed
+	XMLMessage	xmlData;
+	int		state;
+};
+
+/*----------------------------------------------------------------------------------------
+ * Jobs are kept in labeled queue order in a ring: the xml thread adds them at head,
+ * workers take them from next and convert them in any order, and the output thread
+ * writes them from tail once converted, so the XML queues see the labeled queue order.
+ * The counters only grow, a job's slot is its counter modulo XML_REORDER_WINDOW.
+ * -------------------------------------------------------------------------------------*/
+static struct
+{
+	struct XMLJobStruct	jobs[XML_REORDER_WINDOW];
+	u_int64_t		head;
+	u_int64_t		next;
+	u_int64_t		tail;
+	// set once the xml thread stops adding jobs
+	int			done;
+	pthread_mutex_t		lock;
+	// a job was added, or done was set
+	pthread_cond_t		jobAdded;
+	// the job at tail was converted, or done was set
+	pthread_cond_t		jobConverted;
+	// the job at tail was written
+	pthread_cond_t		jobWritten;
+} XMLReorder;
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the default XML conversion settings
+ * Input:   none
+ * Output:  returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int initXMLSettings()
+{
+	int err = 0;
+
+	// number of conversion threads
+	if ( (XML_WORKERS < 1) || (XML_WORKERS > XML_MAX_WORKERS) ) {
+		err = 1;
+		log_warning("Invalid site default for xml workers.");
+		XMLControls.workers = 1;
+	}
+	else
+		XMLControls.workers = XML_WORKERS;
+
+#ifdef DEBUG
+	debug( __FUNCTION__, "Initialized default XML Settings" );
+#endif
+
+	return err;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read the XML conversion settings from the config file
+ * Input:   none
+ * Output:  returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int readXMLSettings()
+{
+	int err = 0;
+	int result;
+	int num;
+
+	// get number of workers
+	result = getConfigValueAsInt(&num, XML_CONVERTER_WORKERS_PATH, 1, XML_MAX_WORKERS);
+	if (result == CONFIG_VALID_ENTRY) 
+		XMLControls.workers = num;
+	else{
+		if (result == CONFIG_INVALID_ENTRY) 
+		{
+			err = 1;
+			log_warning("Invalid configuration of xml workers.");
+		}
+		else 
+			log_msg("No configuration of xml workers, using default.");
+	}
+#ifdef DEBUG
+	debug( __FUNCTION__, "xml workers %d.", XMLControls.workers);
+#endif
+
+	return err;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Save the XML conversion settings to the config file
+ * Input:   none
+ * Output:  returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int saveXMLSettings()
+{
+	int err = 0;
+
+	// save xml tag
+	if ( openConfigElement(XML_CONVERTER_TAG) ) {
+		err = 1;
+		log_warning("Failed to save xml to config file.");
+	}
+
+	// save number of workers
+	if ( setConfigValueAsInt(XML_CONVERTER_WORKERS, XMLControls.workers) ) {
+		err = 1;
+		log_warning("Failed to save xml workers to config file.");
+	}
+
+	// save xml tag
+	if ( closeConfigElement(XML_CONVERTER_TAG) ) {
+		err = 1;
+		log_warning("Failed to save xml to config file.");
+	}
+
+	return err;
+}
 
 /*----------------------------------------------------------------------------------------
  * Purpose: get the length of a XML message,
  *          assuming that there exists a "length" attribute in the root element 
- * Input:   pointer to the XML message or partial XML message
- * Output:  length of the message
+ * Input:   pointer to the XML message or partial XML message and the number
+ *          of bytes available, the text need not be null terminated
+ * Output:  length of the message, 0 if the root element has no length
+ * Note:    only the open tag of the root element is scanned, the message is
+ *          neither copied nor parsed
  * Pei-chun Cheng @ Dec 20, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-int getXMLMessageLen( char *xmlMsg )
+int getXMLMessageLen( const char *xmlMsg, int maxLen )
 {
-    char *p;
-    int  len = 0;
-    int  xmllen = strlen(xmlMsg);
-
-    char * xml_preamble = malloc(sizeof(char) * (xmllen+1));
-    memset(xml_preamble, '\0', xmllen);
-    strncpy(xml_preamble, xmlMsg, xmllen);
-
-    /* 
-     * Find the open tag for the root element and enclose it 
-     * The enclosed element would be in the form <TAG .... length="?" ..../>
-     */
-    p = strtok (xml_preamble,">");
-    if (p)
-    {
-        strcat(p, "/>");
-    }
+	/* The open tag of the root element is in the form <TAG .... length="?" ....> */
+	const char *end = memchr(xmlMsg, '>', maxLen);
+	if ( end == NULL )
+		end = xmlMsg + maxLen;
 
-    xmlDocPtr  header_doc  = xmlReadMemory(p, strlen(p), "getXMLMessageLen.xml", NULL, 0);
-    xmlNodePtr header_node = xmlDocGetRootElement(header_doc); /* Get the root element node */
+	const char *p;
+	for ( p = xmlMsg; p < end; p++ )
+	{
+		if ( *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' )
+			continue;
 
-    /* Retrieve the value of "length" attribute */
-    char * len_str = (char *)xmlGetProp(header_node, BAD_CAST "length");
-    if ( len_str == NULL )
-    {
-        // In order to be compatible with v5 message
-        len_str = (char *)xmlGetProp(header_node, BAD_CAST "len");
-    }
+		/* Look for the "length" attribute, or "len" to be compatible with v5 message */
+		const char *value = NULL;
+		if ( end - (p+1) > 7 && strncmp(p+1, "length=", 7) == 0 )
+			value = p+8;
+		else if ( end - (p+1) > 4 && strncmp(p+1, "len=", 4) == 0 )
+			value = p+5;
+		if ( value == NULL || (*value != '"' && *value != '\'') )
+			continue;
 
-    /* Convert ascii length to numberic value */
-    if ( len_str != NULL )
-    {
-        len = atoi(len_str);
-	    free(len_str);
-    }
+		/* Convert ascii length to numberic value */
+		int len = 0;
+		for ( value++; value < end && *value >= '0' && *value <= '9'; value++ )
+			len = len*10 + (*value - '0');
+		return len;
+	}
 
-    /* Clean up */
-    xmlFreeDoc(header_doc);  /* Free the xml data */
-    free(xml_preamble);
+	return 0;
+}
 
-    return len;
+/*--------------------------------------------------------------------------------------
+ * Purpose: Create an XML queue item
+ * Input:   the XML text (or NULL to leave the text for the caller to fill in),
+ *          its length, the BMF type and the sequence number
+ * Output:  the new item, exits on fatal error if out of memory
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+XMLMessage createXMLMessage( const char *text, int length, int type, u_int32_t seq )
+{
+	XMLMessage msg = malloc( sizeof(struct XMLMessageStruct) + length );
+	if ( msg == NULL )
+		log_fatal( "out of memory: malloc XML message failed" );
+		// not reached
+	msg->length = length;
+	msg->type = type;
+	msg->seq = seq;
+	msg->filters = 0;
+	msg->filterGeneration = 0;
+	msg->ribSince = 0;
+	if ( text != NULL )
+		memcpy( msg->text, text, length );
+	return msg;
 }
 
 /*--------------------------------------------------------------------------------------
@@ -182,10 +332,15 @@ int getMsgIdSeq(char* msg,int msglen,u_int32_t *id,u_int32_t *seq)
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: Entry function of xml thread
+ * Purpose: Entry function of xml thread, hands the labeled messages to the workers
+ *          in order
  * Input:
  * Output:
+ * Note:    a state change that closes a session waits until every message before
+ *          it is written and the session is destroyed, so no worker converts a
+ *          message of a session that is being destroyed
  * He Yan @ Jun 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 void * 
 xmlThread( void *arg )
@@ -195,36 +350,164 @@ xmlThread( void *arg )
 	XMLControls.shutdown = FALSE;
 	
 	QueueReader labeledQueueReader =  createQueueReader( labeledQueue );
-	QueueWriter xmlUQueueWriter = createQueueWriter( xmlUQueue );
-	QueueWriter xmlRQueueWriter = createQueueWriter( xmlRQueue );	
 
 	while( XMLControls.shutdown==FALSE )
 	{
-		BMF bmf = NULL;	
-		readQueue( labeledQueueReader, (void **)&bmf );
+		BMF bmfs[QUEUE_READ_BATCH];
+		long i, n;
+		n = readQueueBatch( labeledQueueReader, (void **)bmfs, QUEUE_READ_BATCH );
 	
 		// update time - make sure thread is alive
 		XMLControls.lastAction = time(NULL);
-	
-        /* Reset xml buffer */
-		xml[0] = '\0';
-		char *xmlp = xml;
-		int  len   = 0;
-
-        /* Convert BMF internal structure to XMl text string */
-		len = BMF2XMLDATA( bmf, xmlp, XML_BUFFER_LEN );
-		if(len > 0)
+
+		pthread_mutex_lock( &XMLReorder.lock );
+
+		for( i = 0; i < n; i++ )
 		{
+			BMF bmf = bmfs[i];
+
+			// wait for a free slot
+			while( XMLReorder.head - XMLReorder.tail >= XML_REORDER_WINDOW )
+				pthread_cond_wait( &XMLReorder.jobWritten, &XMLReorder.lock );
+
+			struct XMLJobStruct *job = &XMLReorder.jobs[XMLReorder.head % XML_REORDER_WINDOW];
+			job->bmf = bmf;
+			job->xmlData = NULL;
+			job->state = XML_JOB_PENDING;
+			XMLReorder.head++;
+			pthread_cond_signal( &XMLReorder.jobAdded );
+
+			/* the session is destroyed once this message is written */
+			if( bmf->type == BMF_TYPE_FSM_STATE_CHANGE && checkStateChangeMessage(bmf) )
+			{
+				while( XMLReorder.tail != XMLReorder.head )
+					pthread_cond_wait( &XMLReorder.jobWritten, &XMLReorder.lock );
+			}
+		}
+
+		pthread_mutex_unlock( &XMLReorder.lock );
+    }
+
+	// let the workers and the output thread finish the remaining jobs
+	pthread_mutex_lock( &XMLReorder.lock );
+	XMLReorder.done = TRUE;
+	pthread_cond_broadcast( &XMLReorder.jobAdded );
+	pthread_cond_signal( &XMLReorder.jobConverted );
+	pthread_mutex_unlock( &XMLReorder.lock );
+
+	destroyQueueReader(labeledQueueReader);
+    log_warning( "XML thread exiting" );
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Entry function of the xml worker threads, converts messages to XML
+ * Input:   arg - not used
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *
+xmlWorkerThread( void *arg )
+{
+	// buffer used to do xml conversion, XML_BUFFER_LEN defined in xmlinternal.h
+	char *xml = malloc( XML_BUFFER_LEN );
+	if( xml == NULL )
+		log_fatal( "xmlWorkerThread: malloc failed" );
+
+	pthread_mutex_lock( &XMLReorder.lock );
+	while( TRUE )
+	{
+		while( XMLReorder.next == XMLReorder.head && XMLReorder.done == FALSE )
+			pthread_cond_wait( &XMLReorder.jobAdded, &XMLReorder.lock );
+		if( XMLReorder.next == XMLReorder.head )
+			break;
+
+		u_int64_t n = XMLReorder.next++;
+		struct XMLJobStruct *job = &XMLReorder.jobs[n % XML_REORDER_WINDOW];
+		pthread_mutex_unlock( &XMLReorder.lock );
+
+		/* Convert BMF internal structure to XMl text string */
+		int len = BMF2XMLDATA( job->bmf, xml, XML_BUFFER_LEN, &job->seqPos );
+		if( len > 0 )
+		{
+			job->xmlData = createXMLMessage( xml, len, job->bmf->type, 0 );
+			/* evaluate the client filters once for all the clients */
+			job->xmlData->filters = matchClientFilters( job->bmf, &job->xmlData->filterGeneration );
+			job->xmlData->ribSince = job->bmf->ribSince;
+		}
+
+		pthread_mutex_lock( &XMLReorder.lock );
+		job->state = XML_JOB_CONVERTED;
+		if( n == XMLReorder.tail )
+			pthread_cond_signal( &XMLReorder.jobConverted );
+	}
+	pthread_mutex_unlock( &XMLReorder.lock );
+
+	free( xml );
+	return NULL;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Entry function of the xml output thread, writes the converted messages
+ *          to the XML queues in labeled queue order and stamps their sequence numbers
+ * Input:   arg - not used
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void *
+xmlOutputThread( void *arg )
+{
+	QueueWriter xmlUQueueWriter = createQueueWriter( xmlUQueue );
+	QueueWriter xmlRQueueWriter = createQueueWriter( xmlRQueue );	
+	QueueBatch xmlUBatch, xmlRBatch;
+	initQueueBatch( &xmlUBatch, xmlUQueueWriter );
+	initQueueBatch( &xmlRBatch, xmlRQueueWriter );
+
+	pthread_mutex_lock( &XMLReorder.lock );
+	while( TRUE )
+	{
+		// write the batched messages before waiting for the next one
+		if( (XMLReorder.tail == XMLReorder.head ||
+		     XMLReorder.jobs[XMLReorder.tail % XML_REORDER_WINDOW].state != XML_JOB_CONVERTED) &&
+		    (xmlUBatch.count > 0 || xmlRBatch.count > 0) )
+		{
+			pthread_mutex_unlock( &XMLReorder.lock );
+			flushQueueBatch( &xmlUBatch );
+			flushQueueBatch( &xmlRBatch );
+			pthread_mutex_lock( &XMLReorder.lock );
+		}
+
+		while( (XMLReorder.tail == XMLReorder.head && XMLReorder.done == FALSE) ||
+		       (XMLReorder.tail != XMLReorder.head &&
+		        XMLReorder.jobs[XMLReorder.tail % XML_REORDER_WINDOW].state != XML_JOB_CONVERTED) )
+			pthread_cond_wait( &XMLReorder.jobConverted, &XMLReorder.lock );
+		if( XMLReorder.tail == XMLReorder.head )
+			break;
+
+		struct XMLJobStruct *job = &XMLReorder.jobs[XMLReorder.tail % XML_REORDER_WINDOW];
+		pthread_mutex_unlock( &XMLReorder.lock );
+
+		BMF bmf = job->bmf;
+		XMLMessage xmlData = job->xmlData;
+		if( xmlData != NULL )
+		{
+			// only the converted messages take a sequence number, in labeled queue order
+			setXMLSequence( xmlData->text + job->seqPos, ClientControls.seq_num );
+			xmlData->seq = ClientControls.seq_num;
+			//increment sequence number, wrap around if necessary
+			if(ClientControls.seq_num != UINT_MAX)
+				ClientControls.seq_num++;
+			else ClientControls.seq_num = 0;
+
 			switch ( bmf->type )
 			{
-				//write out newly-generated messages and increment sequence number
+				//write out newly-generated messages
 				case BMF_TYPE_MSG_TO_PEER:
 				case BMF_TYPE_MSG_LABELED:
 				case BMF_TYPE_MSG_FROM_PEER:
 					{	
-						u_char *xmlData = malloc(len);
-						memcpy(xmlData, xml, len);
-						writeQueue( xmlUQueueWriter, xmlData );
+						addQueueBatch( &xmlUBatch, xmlData );
 						break;
 					}
 				case BMF_TYPE_TABLE_TRANSFER:
@@ -232,9 +515,7 @@ xmlThread( void *arg )
 				case BMF_TYPE_TABLE_STOP:
 				case BMF_TYPE_FSM_STATE_CHANGE:
 					{
-						u_char *xmlData = malloc(len);
-						memcpy(xmlData, xml, len);
-						writeQueue( xmlRQueueWriter, xmlData );
+						addQueueBatch( &xmlRBatch, xmlData );
 						break;
 					}
 
@@ -245,26 +526,22 @@ xmlThread( void *arg )
 				case BMF_TYPE_BGPMON_START:
 				case BMF_TYPE_BGPMON_STOP:
 					{
-						u_char *UxmlData = malloc(len);
-						u_char *RxmlData = malloc(len);
-						memcpy(UxmlData, xml, len);
-						memcpy(RxmlData, xml, len);
-						writeQueue( xmlUQueueWriter, UxmlData );
-						writeQueue( xmlRQueueWriter, RxmlData );
+						XMLMessage RxmlData = createXMLMessage(xmlData->text, xmlData->length, xmlData->type, xmlData->seq);
+						RxmlData->filters = xmlData->filters;
+						RxmlData->filterGeneration = xmlData->filterGeneration;
+						addQueueBatch( &xmlUBatch, xmlData );
+						addQueueBatch( &xmlRBatch, RxmlData );
 						break;    	
 					}
 
 				default:
 					{
 						log_err ("BMF2XML: unknown type!!!!!!!!!!!!!!!");
+						free( xmlData );
 						break;
 					}
 
 			}
-			//increment sequence number, wrap around if necessary
-			if(ClientControls.seq_num != UINT_MAX)
-				ClientControls.seq_num++;
-			else ClientControls.seq_num = 0;
 		}
 		
 		/* delete the session structure of closed session */
@@ -272,6 +549,9 @@ xmlThread( void *arg )
 		{
 			if( checkStateChangeMessage(bmf) )
 			{
+				// the messages of the session are written before it is destroyed
+				flushQueueBatch( &xmlUBatch );
+				flushQueueBatch( &xmlRBatch );
 				destroySession(bmf->sessionID);
 				log_msg( "Successfully destroy the session %d!", bmf->sessionID);
 			}
@@ -279,33 +559,61 @@ xmlThread( void *arg )
 
 		/* Delete bmf structure */
 		destroyBMF( bmf );
-    }
-	destroyQueueReader(labeledQueueReader);
+
+		pthread_mutex_lock( &XMLReorder.lock );
+		XMLReorder.tail++;
+		pthread_cond_signal( &XMLReorder.jobWritten );
+	}
+	pthread_mutex_unlock( &XMLReorder.lock );
+
 	destroyQueueWriter(xmlUQueueWriter);
 	destroyQueueWriter(xmlRQueueWriter);
-    log_warning( "XML thread exiting" );
+	log_warning( "XML output thread exiting" );
 
-    return NULL;
+	return NULL;
 }
 
 /*--------------------------------------------------------------------------------------
- * Purpose: launch xml converter thread, called by main.c
+ * Purpose: launch xml converter threads, called by main.c
  * Input:   none
  * Output:  none
  * He Yan @ July 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
 void launchXMLThread()
 {
     int error;
+    int i;
     
     pthread_t XMLThreadID;
 
+    XMLReorder.head = XMLReorder.next = XMLReorder.tail = 0;
+    XMLReorder.done = FALSE;
+    if ((error = pthread_mutex_init(&XMLReorder.lock, NULL)) > 0 )
+        log_fatal("Failed to init XML reorder lock: %s\n", strerror(error));
+    if ((error = pthread_cond_init(&XMLReorder.jobAdded, NULL)) > 0 ||
+        (error = pthread_cond_init(&XMLReorder.jobConverted, NULL)) > 0 ||
+        (error = pthread_cond_init(&XMLReorder.jobWritten, NULL)) > 0 )
+        log_fatal("Failed to init XML reorder condition: %s\n", strerror(error));
+
+    if ((error = pthread_create(&XMLControls.outputThread, NULL, xmlOutputThread, NULL)) > 0 )
+        log_fatal("Failed to create XML output thread: %s\n", strerror(error));
+
+    XMLControls.workerThreads = malloc(XMLControls.workers * sizeof(pthread_t));
+    if (XMLControls.workerThreads == NULL)
+        log_fatal("launchXMLThread: malloc failed");
+    for (i = 0; i < XMLControls.workers; i++)
+    {
+        if ((error = pthread_create(&XMLControls.workerThreads[i], NULL, xmlWorkerThread, NULL)) > 0 )
+            log_fatal("Failed to create XML worker thread: %s\n", strerror(error));
+    }
+
     if ((error = pthread_create(&XMLThreadID, NULL, xmlThread, NULL)) > 0 )
         log_fatal("Failed to create XML thread: %s\n", strerror(error));
 
     XMLControls.xmlThread = XMLThreadID;
 
-    debug(__FUNCTION__, "Created XML thread!");
+    debug(__FUNCTION__, "Created XML thread and %d workers!", XMLControls.workers);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -340,7 +648,16 @@ void waitForXMLShutdown()
 {
 	void * status = NULL;
 
+	int i;
+
 	// wait for xml control thread exit
 	pthread_join(XMLControls.xmlThread, status);
+
+	// the workers and the output thread exit once the remaining jobs are written
+	for (i = 0; i < XMLControls.workers; i++)
+		pthread_join(XMLControls.workerThreads[i], status);
+	pthread_join(XMLControls.outputThread, status);
+	free(XMLControls.workerThreads);
+	XMLControls.workerThreads = NULL;
 }
 
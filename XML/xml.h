@@ -32,16 +32,83 @@
 #ifndef XML_H_
 #define XML_H_
 
+/* needed for u_int32_t */
+#include <sys/types.h>
+
 /* label thread last action time */
 struct XMLControls_struct_st {
 	time_t		lastAction;
 	pthread_t 	xmlThread;
 	int		    shutdown;
+	// number of threads converting messages to XML
+	int		workers;
+	pthread_t	*workerThreads;
+	// thread writing the converted messages in order
+	pthread_t	outputThread;
 };
 typedef struct XMLControls_struct_st XMLControls_struct;
 
 XMLControls_struct XMLControls;
 
+/*----------------------------------------------------------------------------------------
+ * Items of the XML queues: the XML text preceded by a small header that is filled in
+ * once when the item is created, so readers never parse the text to learn its length
+ * -------------------------------------------------------------------------------------*/
+struct XMLMessageStruct
+{
+	// length of the XML text in bytes, the text is not null terminated
+	u_int32_t	length;
+	// BMF type the text was generated from, XML_MSG_TYPE_RELAYED for chain messages
+	u_int32_t	type;
+	// BGPmon sequence number stamped in the text
+	u_int32_t	seq;
+	// client filter groups the message matches, bit g for group g
+	u_int64_t	filters;
+	// filter generation the groups had when the message was matched
+	u_int64_t	filterGeneration;
+	// version the delta rib transfer of the message starts from, 0 otherwise
+	u_int64_t	ribSince;
+	// the XML text
+	char		text[];
+};
+typedef struct XMLMessageStruct *XMLMessage;
+
+/* type of the messages relayed from a chain, the BMF type is not known */
+#define XML_MSG_TYPE_RELAYED	0
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Create an XML queue item
+ * Input:   the XML text (or NULL to leave the text for the caller to fill in),
+ *          its length, the BMF type and the sequence number
+ * Output:  the new item, exits on fatal error if out of memory
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+XMLMessage createXMLMessage( const char *text, int length, int type, u_int32_t seq );
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Initialize the default XML conversion settings
+ * Input:   none
+ * Output:  returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int initXMLSettings();
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Read the XML conversion settings from the config file
+ * Input:   none
+ * Output:  returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int readXMLSettings();
+
+/*--------------------------------------------------------------------------------------
+ * Purpose: Save the XML conversion settings to the config file
+ * Input:   none
+ * Output:  returns 0 on success, 1 on failure
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+int saveXMLSettings();
+
 /*--------------------------------------------------------------------------------------
  * Purpose: launch xml converter thread, called by main.c
  * Input:   none
@@ -52,12 +119,13 @@ void launchXMLThread();
 
 /*----------------------------------------------------------------------------------------
  * Purpose: get the length of a XML message (from the attribute "length")
- * Input:   pointer to the XML message or partial XML message
- * Output:  length of the message
+ * Input:   pointer to the XML message or partial XML message and the number
+ *          of bytes available, the text need not be null terminated
+ * Output:  length of the message, 0 if the root element has no length
  * He Yan @ Jun 22, 2008
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-int getXMLMessageLen(char *xmlMsg);
+int getXMLMessageLen(const char *xmlMsg, int maxLen);
 
 /*--------------------------------------------------------------------------------------
  * Purpose: Get the BGPmon ID and sequence number from incoming message
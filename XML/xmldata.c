@@ -26,14 +26,16 @@
  *  File:    xmldata.c
  *  Authors: Pei-chun Cheng (Modified from xml.c by He Yan)
  *          Jason Bartlett
+ *          agent
  *  Date:    Dec 20, 2008
  *
  */
 
  /*
- * The purpose of xmldata.c is to convert an internal BMF to a xml tree or string.
- * We may further export the xml tree with different formats.
- * Currely, we only export plain xml string.
+ * The purpose of xmldata.c is to convert an internal BMF to a xml string.
+ * The XML text is written directly into the output buffer by the XFB writer,
+ * element by element, no document tree is built.   The output is the same
+ * text xmlNodeDump produced for the tree the previous generator built.
  */
 
 /* needed for malloc and free */
@@ -51,10 +53,6 @@
 #include <stdio.h>
 #include <limits.h>
 
-/* needed for xml operation tring and math operation */
-#include <libxml/parser.h>
-#include <libxml/tree.h>
-
 /* needed for queues*/
 #include "../Queues/queue.h"
 
@@ -90,6 +88,9 @@
 /* needed for interanl functions */
 #include "xmlinternal.h"
 
+/* needed to write the XML text */
+#include "xfbwriter.h"
+
 #include "xmldata.h"
 
 //#define DEBUG
@@ -99,15 +100,10 @@
 static char* _VERSION = XFB_VERSION;  /* The implemented XFB version,    specified in xmldata.h */
 static char* _XMLNS   = XFB_NS;       /* The implemented XFB name space, specified in xmldata.h */
 
-/* buffer used for xml conversion */
-static char _XML[XML_BUFFER_LEN];    /* Global xml buffer, XML_BUFFER_LEN defined in xmlinternal.h */
 static int  _XML_LEN_DIGITS = 0;     /* Global variable, number of digits for XML message length,
-                                        would be calculated by ceil(log10(XML_BUFFER_LEN)) 
+                                        would be calculated by ceil(log10(XML_BUFFER_LEN))
                                       */
 
-/* for improving perfomance */
-//static xmlNodePtr static_marker_node = NULL;
-
 /* placeholder struct for STATE report data, only for internal use */
 typedef struct
 {
@@ -118,7 +114,7 @@ typedef struct
     long max;
     long accu;
     long limit;
-} stat_data_t; 
+} stat_data_t;
 
 /* placeholder struct for TIME report data, only for internal use */
 typedef struct
@@ -130,18 +126,18 @@ typedef struct
     long last_down;
     long first_action;
     long last_action;
-} time_data_t; 
+} time_data_t;
 
 /*----------------------------------------------------------------------------------------
- * Purpose: add an afi child with value attribute to an xml node
- * input:   node  - pointer to the xml node
+ * Purpose: write an afi child with value attribute
+ * input:   w     - the xml writer
  *          afi   - an afi number
- * Output:  the xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * Jason Bartlett @ 14 Oct 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewChildAFI(xmlNodePtr node, int afi)
+void
+xfbChildAFI(XFBWriter w, int afi)
 {
     char *afi_str   = ""; /* null string */
 
@@ -152,22 +148,22 @@ xmlNewChildAFI(xmlNodePtr node, int afi)
         default:            afi_str = "OTHER"; break;
     }
 
-    xmlNodePtr afi_node = xmlNewChildString(node,"AFI",afi_str);    //human-readable
-    xmlNewPropInt(afi_node,"value",afi);                            //machine-readable
-
-    return node;
+    xfbStartElement(w, "AFI");
+    xfbAttrInt(w, "value", afi);                                    //machine-readable
+    xfbText(w, afi_str);                                            //human-readable
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: add a safi child with value attribute to an xml node
- * input:   node  - pointer to the xml node
+ * Purpose: write a safi child with value attribute
+ * input:   w     - the xml writer
  *          safi  - a  safi number
- * Output:  the xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * Jason Bartlett @ 14 Oct 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewChildSAFI(xmlNodePtr node, int safi)
+void
+xfbChildSAFI(XFBWriter w, int safi)
 {
     char *safi_str   = ""; /* null string */
 
@@ -180,68 +176,55 @@ xmlNewChildSAFI(xmlNodePtr node, int safi)
         default: safi_str = "OTHER";     break;
     }
 
-    xmlNodePtr safi_node = xmlNewChildString(node,"SAFI",safi_str); //human readable
-    xmlNewPropInt(safi_node,"value",safi);                          //machine readable
-
-    return node;
+    xfbStartElement(w, "SAFI");
+    xfbAttrInt(w, "value", safi);                                   //machine readable
+    xfbText(w, safi_str);                                           //human readable
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate a xml node with a BGPID
- * input:   tag   - tag string
+ * Purpose: write a BGPID child
+ * input:   w     - the xml writer
+ *          tag   - tag string
  *          ip    - a long long integer for ip address
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  *
  * Ex:
  *     <BGPID>128.223.51.102</BGPID>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewNodeBGPID(char *tag, long long ip)
+void
+xfbChildBGPID(XFBWriter w, char *tag, long long ip)
 {
-    static char buff[XML_TEMP_BUFFER_LEN];
+    char buff[XML_TEMP_BUFFER_LEN];
     memset(buff, 0, XML_TEMP_BUFFER_LEN);
     buff[0] = '\0';
 
     if (ip > LONG_MAX) { inet_ntop(AF_INET6, &ip, buff, XML_TEMP_BUFFER_LEN); } /* >  4 bytes */
     else               { inet_ntop(AF_INET,  &ip, buff, XML_TEMP_BUFFER_LEN); } /* <= 4 bytes */
 
-    return xmlNewNodeString(tag, buff);
-}
-
-/*----------------------------------------------------------------------------------------
- * Purpose: add a BGPID child node to a xml node
- * input:   parent_node - parent xml node
- *          tag   - tag string for the child node
- *          ip    - a "long long" integer ip for the child node
- * Output:  the child node
- * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewChildBGPID(xmlNodePtr parent_node, char *tag, long long ip)
-{
-    return xmlAddChild(parent_node, xmlNewNodeBGPID(tag, ip));
+    xfbChildString(w, tag, buff);
 }
 
-
 /*----------------------------------------------------------------------------------------
- * Purpose: generate a xml node with general network address, could be v4 or v6
- * input:   tag  - tag string
+ * Purpose: write a child with general network address, could be v4 or v6
+ * input:   w    - the xml writer
+ *          tag  - tag string
  *          addr - pointer to the address data
  *          len  - length of the address data
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewNodeNetAddr(char *tag, u_char *addr, int len)
+void
+xfbChildNetAddr(XFBWriter w, char *tag, u_char *addr, int len)
 {
     char *stag = "";
     int  i;
 
-    static char netaddr_str[XML_TEMP_BUFFER_LEN];
-    static char str[XML_TEMP_BUFFER_LEN];
+    char netaddr_str[XML_TEMP_BUFFER_LEN];
+    char str[XML_TEMP_BUFFER_LEN];
     netaddr_str[0] = '\0';
 
     for ( i = 0; i < len; i++ )
@@ -252,47 +235,52 @@ xmlNewNodeNetAddr(char *tag, u_char *addr, int len)
         stag = ".";
     }
 
-   return xmlNewNodeString( tag, netaddr_str );
+    xfbChildString( w, tag, netaddr_str );
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: add a network address child node to a xml node
- * input:   parent_node - parent xml node
- *          addr - pointer to the address data
- *          len  - length of the address data
- * Output:  the child node
- * Pei-chun Cheng @ Dec 20, 2008
+ * Purpose: count the prefixes in a list of prefixes
+ * input:   prefix - pointer to the prefix
+ *          len    - length of prefix
+ * Output:  the number of prefixes
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewChildNetAddr(xmlNodePtr parent_node, char *tag, u_char *addr, int len)
+static int
+countPrefixes(u_char *prefix, int len)
 {
-    return xmlAddChild(parent_node, xmlNewNodeNetAddr(tag, addr, len));
+    int i = 0, l = 0;
+    int count = 0;
+
+    for ( i = 0; i < len; i = i + 1 + l )
+    {
+        l = (prefix[i] + 7)/8;
+        count++;
+    }
+    return count;
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: add PREFIX child nodes to a xml node
- * input:   parent_node - parent xml node
+ * Purpose: write PREFIX child nodes
+ * input:   w      - the xml writer
  *          prefix - pointer to the prefix
  *          len    - length of prefix
  *          afi    - address family of the prefix
  *          safi   - sub address family of the prefix
  *          lt     - pointer to an array of labels. it could be NULL.
- * Output:  the child node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 14 Oct 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewChildPrefixes(xmlNodePtr parent_node, u_char *prefix, int len, u_int16_t afi, u_int8_t safi, u_char **lt )
+void
+xfbChildPrefixes(XFBWriter w, u_char *prefix, int len, u_int16_t afi, u_int8_t safi, u_char **lt )
 {
-	xmlNodePtr prefix_node = NULL;
-
 	//char *stag = "";
 	int i = 0, l = 0;
 	int bits = 0;
-	static char prefix_str[XML_TEMP_BUFFER_LEN];
-	static char str[XML_TEMP_BUFFER_LEN];
-	
+	char prefix_str[XML_TEMP_BUFFER_LEN];
+	char str[XML_TEMP_BUFFER_LEN];
+
 	u_int8_t  prefix_value[16];
 
 
@@ -303,14 +291,14 @@ xmlNewChildPrefixes(xmlNodePtr parent_node, u_char *prefix, int len, u_int16_t a
 	        bits = prefix[i];
 	        l = (bits + 7)/8;
 		memset(prefix_value, 0, 16);
-		memcpy(prefix_value, &prefix[i+1], l);	
-		// IPv4 
+		memcpy(prefix_value, &prefix[i+1], l);
+		// IPv4
 		if (afi == 1)
 		{
 			if( inet_ntop(AF_INET, prefix_value, str, ADDR_MAX_CHARS) == NULL )
 			{
-				log_err("xmlNewChildPrefixes, could not convert IPv4 prefix");
-				strcat(prefix_str, "0");
+				log_err("xfbChildPrefixes, could not convert IPv4 prefix");
+				strcpy(str, "0");
 			}
 		}
 		else // IPv6
@@ -318,20 +306,19 @@ xmlNewChildPrefixes(xmlNodePtr parent_node, u_char *prefix, int len, u_int16_t a
 		{
 			if( inet_ntop(AF_INET6, prefix_value, str, ADDR_MAX_CHARS) == NULL )
 			{
-				log_err("xmlNewChildPrefixes, could not convert IPv6 prefix");
-				strcat(prefix_str, "0");
+				log_err("xfbChildPrefixes, could not convert IPv6 prefix");
+				strcpy(str, "0");
 			}
 		}
 	        else
 		{
-			strcat(prefix_str, "0");
-		}	
+			strcpy(str, "0");
+		}
         	snprintf(prefix_str , XML_TEMP_BUFFER_LEN, "%s", str );
 	        snprintf(prefix_str+strlen(str) , XML_TEMP_BUFFER_LEN, "/%d", bits );
 
-        	/* generate prefix node */
-	        prefix_node = xmlNewNode(NULL,BAD_CAST "PREFIX");
-        	xmlNewChild(prefix_node,NULL,BAD_CAST "ADDRESS",BAD_CAST prefix_str);
+        	/* write prefix node */
+	        xfbStartElement(w, "PREFIX");
 
 	        /* add label */
         	if (*lt != NULL) // add label
@@ -345,7 +332,7 @@ xmlNewChildPrefixes(xmlNodePtr parent_node, u_char *prefix, int len, u_int16_t a
 				case BGPMON_LABEL_NULL:                label_str = "NULL";    break;
 				case BGPMON_LABEL_WITHDRAW:            label_str = "WITH";    break;
 				case BGPMON_LABEL_WITHDRAW_DUPLICATE:  label_str = "DUPW";
-                                  log_msg("xmlNewChildPrefixes: duplicate withdrawl");
+                                  log_msg("xfbChildPrefixes: duplicate withdrawl");
                                   break;
 				case BGPMON_LABEL_ANNOUNCE_NEW:        label_str = "NANN";    break;
 				case BGPMON_LABEL_ANNOUNCE_DUPLICATE:  label_str = "DANN";    break;
@@ -353,307 +340,175 @@ xmlNewChildPrefixes(xmlNodePtr parent_node, u_char *prefix, int len, u_int16_t a
 				case BGPMON_LABEL_ANNOUNCE_SPATH:      label_str = "SPATH";   break;
 				default: label_str = "UNKNOWN"; break;
 			}
-			xmlNewProp(prefix_node, BAD_CAST "label", BAD_CAST label_str);
+			xfbAttrString(w, "label", label_str);
 		}
-		xmlNewChildAFI(prefix_node,  afi);
-		xmlNewChildSAFI(prefix_node, safi);
-		xmlAddChild(parent_node, prefix_node);
+        	xfbChildString(w, "ADDRESS", prefix_str);
+		xfbChildAFI(w,  afi);
+		xfbChildSAFI(w, safi);
+		xfbEndElement(w);
 	}
-
-	return prefix_node;
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate a xml node for state report 
- * input:   tag       - tag string
+ * Purpose: write a child for state report
+ * input:   w         - the xml writer
+ *          tag       - tag string
  *          stat_data - stat_data structure
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewNodeStat(char *tag, stat_data_t *stat_data)
+void
+xfbChildStat(XFBWriter w, char *tag, stat_data_t *stat_data)
 {
-    xmlNodePtr node = NULL;
+    char str[XML_TEMP_BUFFER_LEN];
+    snprintf(str, XML_TEMP_BUFFER_LEN, "%d", (int)stat_data->current);
 
-    /* Current value */
-    node = xmlNewNodeInt(tag, stat_data->current);
+    xfbStartElement(w, tag);
 
     /* Currently only report the max and limit value */
-    xmlNewPropInt(node, "max", stat_data->max);
-    xmlNewPropInt(node, "limit", stat_data->limit);
-
-    return node;
-}
+    xfbAttrInt(w, "max", stat_data->max);
+    xfbAttrInt(w, "limit", stat_data->limit);
 
-/*----------------------------------------------------------------------------------------
- * Purpose: add a child a xml node for state report 
- * input:   tag       - tag string
- *          stat_data - stat_data structure
- * Output:  the new xml node
- * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/
-inline xmlNodePtr
-xmlNewChildStat(xmlNodePtr parent_node,  char *tag, stat_data_t *stat_data)
-{
-    return xmlAddChild(parent_node, xmlNewNodeStat(tag, stat_data));
+    /* Current value */
+    xfbText(w, str);
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate a xml node for time report 
- * input:   tag       - tag string
+ * Purpose: write a child for time report
+ * input:   w         - the xml writer
+ *          tag       - tag string
  *          time_data - time_data structure
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-xmlNewNodeTime(char *tag, time_data_t *time_data)
+void
+xfbChildTime(XFBWriter w, char *tag, time_data_t *time_data)
 {
-    xmlNodePtr node = NULL;
+    char str[XML_TEMP_BUFFER_LEN];
+    snprintf(str, XML_TEMP_BUFFER_LEN, "%d", (int)time_data->current);
 
-    /* Current value */
-    node = xmlNewNodeInt(tag, time_data->current);
+    xfbStartElement(w, tag);
 
     /* Currently only report the last_down and last_action time */
-    xmlNewPropInt(node, "last_down",   time_data->last_down);
-    xmlNewPropInt(node, "last_action", time_data->last_action);
+    xfbAttrInt(w, "last_down",   time_data->last_down);
+    xfbAttrInt(w, "last_action", time_data->last_action);
 
-    return node;
-}
-
-/*----------------------------------------------------------------------------------------
- * Purpose: add a child xml node for time report 
- * input:   tag       - tag string
- *          time_data - time_data structure
- * Output:  the new xml node
- * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/
-inline xmlNodePtr
-xmlNewChildTime(xmlNodePtr parent_node,  char *tag, time_data_t *time_data)
-{
-    return xmlAddChild(parent_node, xmlNewNodeTime(tag, time_data));
+    /* Current value */
+    xfbText(w, str);
+    xfbEndElement(w);
 }
 
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the OPT_PARAMETER node with child AUTHENTICATION/CAPABILITY node
- * input:    parms - parameters           
-             len   - number of parameters 
- * Output:  the new xml node
+ * Purpose: write the OPT_PAR node
+ * input:    w     - the xml writer
+ *           parms - parameters
+             len   - number of parameters
+ * Output:  none
+ * Note:    the PARAMETER nodes decoded from the parameters were never attached to
+ *          the OPT_PAR node, so XFB has always carried an empty OPT_PAR element and
+ *          the parameters only in the OCTET_MSG. The element is kept as it was.
  * Pei-chun Cheng @ Dec 20, 2008
  * Jason Bartlett @ 14 Oct 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpOpenOptionalParameterNode(u_char *parms, int len )
+void
+genBgpOpenOptionalParameterNode(XFBWriter w, u_char *parms, int len )
 {
-
-    xmlNodePtr node       = NULL;
-
     if ( len > 0 )
     {
         /* OPT_PAR Node */
-        node = xmlNewNode(NULL, BAD_CAST "OPT_PAR");
-
-        /* Child nodes */
-        int i;
-        int l = 0;
-        int type;
-        for ( i = 0; i<len ; i = i + 2 + l )
-        {
-            xmlNodePtr par_node       = xmlNewNode(NULL, BAD_CAST "PARAMETER");
-            xmlNodePtr cap_node       = NULL;
-
-            type = parms[i];
-            l    = parms[i+1];
-
-
-            switch ( type )
-            {
-                case BGP_OPEN_OPT_AUTH: // 1: authentication
-                {
-                    char *atag = "AUTHENTICATION";
-                    xmlNewChildString(par_node,"TYPE",atag);
-                    xmlNewChildOctets(par_node,"DATA",parms + i + 2,l - 2);
-                    //Actual authentication data is added as octets
-                    break;
-                }
-                case BGP_OPEN_OPT_CAP:  // 2: capabilities
-                {
-                    char *atag = "CAPABILITIES";
-                    xmlNewChildString(par_node,"TYPE",atag);
-                    cap_node  = xmlAddChild(par_node, xmlNewNode(NULL, BAD_CAST "CAP"));
-
-                    int capType = parms[i+1+1];
-                    int capl    = parms[i+1+1+1];
-                    switch ( capType ) /* Defined in bgppacket.h */
-                    {
-                        case multiprotocolCapability:
-                        {
-                            /* MULTIPROTOCOL */
-                            char *atag = "MULTIPROTOCOL";
-                            xmlNewChildString(cap_node,"TYPE",atag);
-
-                            xmlNodePtr mp_node = xmlNewChildString(cap_node, "MULTIPROTOCOL", "");
-                            u_int16_t afi = ntohs( *((u_int16_t *) (parms+i+2+2) ) );
-                            u_int8_t safi = parms[i+5+2];
-                            xmlNewChildUnsignedInt(mp_node,"AFI",afi);
-                            xmlNewChildInt(mp_node,"SAFI",safi);
-                            break;
-                        }
-                        case routeRefreshCapability:
-                        {
-                            /* ROUTE_REFRESH */
-                            char *atag = "ROUTE_REFRESH";
-                            xmlNewChildString(cap_node,"TYPE",atag);
-                            xmlNewChildString(cap_node, "ROUTE_REFRESH", "");
-                            break;
-                        }
-                        // [EXTEND] additional capabilities
-                        default:
-                        {
-                            char *atag = "OTHER";
-                            xmlNewChildString(cap_node,"TYPE",atag);
-                            xmlNodePtr unknown_node = xmlNewChildString(cap_node, "OTHER", "");
-                            if ( capl > 0 )
-                            {
-                                xmlNewChildOctets(unknown_node, "OCTETS", (parms+i+2+2), capl);
-                            }
-                            break;
-                        }
-                    }
-                    xmlNewPropInt(cap_node, "value", capType);
-                    break;
-                }
-                default:
-                {
-                    char *atag = "UNKNOWN";
-                    xmlNewChildString(par_node,"TYPE",atag);
-                    xmlNodePtr unknown_node = xmlNewChildString(par_node, "UNKNOWN", "");
-                    if ( l > 0 )
-                    {
-                        xmlNewChildOctets(unknown_node, "OCTETS", (parms+i+1+1), l);
-                    }
-                    log_err("Unknown open parameter type!");
-                    break;
-                }
-            }
-            xmlNewPropInt(par_node, "value", type);
-
-        }
+        xfbEmptyElement(w, "OPT_PAR");
     }
-
-    return node;
 }
 
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the WITHDRAWN node with child PREFIX nodes
- * input:   prefix  - pointer to the first prefix node
+ * Purpose: write the WITHDRAWN node with child PREFIX nodes
+ * input:   w       - the xml writer
+ *          prefix  - pointer to the first prefix node
  *          afi     - afi value
  *          safi    - safi value
  *          lt      - pointer to an array of labels. it could be NULL
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genUpdateWithdrawnNode(u_char *prefix, int len, u_int16_t afi, u_int8_t safi, u_char **lt )
+void
+genUpdateWithdrawnNode(XFBWriter w, u_char *prefix, int len, u_int16_t afi, u_int8_t safi, u_char **lt )
 {
-    xmlNodePtr child_node = NULL;
-    int count = 0;
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "WITHDRAWN");
-    xmlNewChildPrefixes(node, prefix, len, afi, safi, lt);
-    if(node == NULL){
-      log_err("genUpdateWithdrawnNode: possible memory error\n");
-      return NULL;
-    }
-    for (child_node=node->children; child_node!= NULL; child_node=child_node->next)
-    {
-        if (child_node->name && (strcmp((char*)child_node->name,"PREFIX") == 0))
-        {
-            count++;
-        }
-    }
-    /* update the count of prefixes */
-    xmlNewPropInt(node, "count", count);
-
-    return node;
+    xfbStartElement(w, "WITHDRAWN");
+    /* the count of prefixes */
+    xfbAttrInt(w, "count", countPrefixes(prefix, len));
+    xfbChildPrefixes(w, prefix, len, afi, safi, lt);
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the NLRI node with child PREFIX nodes
- * input:   prefix  - pointer to the first prefix node
+ * Purpose: write the NLRI node with child PREFIX nodes
+ * input:   w       - the xml writer
+ *          prefix  - pointer to the first prefix node
  *          afi     - afi value
  *          safi    - safi value
  *          lt      - pointer to an array of labels. it could be NULL
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genUpdateNlriNode(u_char *prefix, int len, u_int16_t afi, u_int8_t safi, u_char **lt )
+void
+genUpdateNlriNode(XFBWriter w, u_char *prefix, int len, u_int16_t afi, u_int8_t safi, u_char **lt )
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "NLRI");
-    xmlNewChildPrefixes(node, prefix, len, afi, safi, lt);
-    xmlNodePtr child_node = NULL;
-    int count = 0;
-    for (child_node=node->children; child_node!= NULL; child_node=child_node->next)
-    {
-        if (child_node->name && (strcmp((char*)child_node->name,"PREFIX") == 0))
-        {
-            count++;
-        }
-    }
-    /* update the count of prefixes */
-    xmlNewPropInt(node, "count", count);
-    return node;
+    xfbStartElement(w, "NLRI");
+    /* the count of prefixes */
+    xfbAttrInt(w, "count", countPrefixes(prefix, len));
+    xfbChildPrefixes(w, prefix, len, afi, safi, lt);
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the flag node for an attribute
- * input:   flags   - flags in an interger
- * Output:  the new xml node with indicated flags as boolean attributes
+ * Purpose: write the flag node for an attribute
+ * input:   w       - the xml writer
+ *          flags   - flags in an interger
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 15 Sep 2010
  *
  * Ex:  <FLAGS optional="TRUE" transitive="TRUE"/>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genAttributeFlagNode(int flags)
+void
+genAttributeFlagNode(XFBWriter w, int flags)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "FLAGS");
+    xfbStartElement(w, "FLAGS");
     if ( (flags & BGP_ATTR_FLAG_OPTIONAL) > 0 ) {
-        xmlNewProp(node,BAD_CAST "optional",BAD_CAST "TRUE");
+        xfbAttrString(w,"optional","TRUE");
     }
-    if ( (flags & BGP_ATTR_FLAG_TRANS)    > 0 ) { 
-        xmlNewProp(node,BAD_CAST "transitive",BAD_CAST "TRUE");
+    if ( (flags & BGP_ATTR_FLAG_TRANS)    > 0 ) {
+        xfbAttrString(w,"transitive","TRUE");
     }
-    if ( (flags & BGP_ATTR_FLAG_PARTIAL)  > 0 ) {   
-        xmlNewProp(node,BAD_CAST "partial",BAD_CAST "TRUE");
+    if ( (flags & BGP_ATTR_FLAG_PARTIAL)  > 0 ) {
+        xfbAttrString(w,"partial","TRUE");
     }
     if ( (flags & BGP_ATTR_FLAG_EXT_LEN) > 0 ) {
-        xmlNewProp(node,BAD_CAST "extended",BAD_CAST "TRUE");
+        xfbAttrString(w,"extended","TRUE");
     }
-
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the ORIGIN attribute node
- * input:   origin  - origin value in an interger
- * Output:  the new xml node
+ * Purpose: write the ORIGIN attribute node
+ * input:   w       - the xml writer
+ *          origin  - origin value in an interger
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 14 Oct 2010
  *
  * Ex:  <ORIGIN value="0">IGP</ORIGIN>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpOriginNode(BMF bmf, int origin)
+void
+genBgpOriginNode(XFBWriter w, BMF bmf, int origin)
 {
     char *otag;
-    int strlen = XML_TEMP_BUFFER_LEN;
-    char str[strlen];
 
-    snprintf( str, strlen, "%d", origin );
     switch ( origin )
     {
         case BGP_ORIGIN_IGP:
@@ -669,26 +524,24 @@ genBgpOriginNode(BMF bmf, int origin)
             otag = "OTHER";
             break;
     }
-    xmlNodePtr node = xmlNewNode(NULL,BAD_CAST "ORIGIN");
-    xmlNodeAddContent(node,BAD_CAST otag);
-    xmlNewPropInt(node, "value", origin);
-
-    return node;
+    xfbStartElement(w, "ORIGIN");
+    xfbAttrInt(w, "value", origin);
+    xfbText(w, otag);
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the AS_SEG node
- * input:   value  - pointer to AS Segment data
+ * Purpose: write the AS_SEG node
+ * input:   w      - the xml writer
+ *          value  - pointer to AS Segment data
  *          as_len - length of single AS number in bytes
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpASSegNode(u_char *value, int as_len)
+void
+genBgpASSegNode(XFBWriter w, u_char *value, int as_len)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "AS_SEG");
-
-    static char str[XML_TEMP_BUFFER_LEN]; /* buffer for one single AS number */
+    char str[XML_TEMP_BUFFER_LEN]; /* buffer for one single AS number */
 
     /* For each AS Segment */
     char *tag = NULL;
@@ -704,8 +557,9 @@ genBgpASSegNode(u_char *value, int as_len)
     else if ( type == 4 ) tag = "AS_CONFED_SET";
     else                  tag = "OTHER";
 
-    xmlNewPropString(node,  "type",   tag);
-    xmlNewPropInt(node,     "length", l);
+    xfbStartElement(w, "AS_SEG");
+    xfbAttrString(w, "type",   tag);
+    xfbAttrInt(w,    "length", l);
 
     /* AS */
     for ( i = 0 ; i < l ; i = i + 1 )
@@ -716,7 +570,7 @@ genBgpASSegNode(u_char *value, int as_len)
         else if (as_len == 4) as += ntohl(*((u_int32_t *) (as_value))); /* 4-byte AS */
         else                  as += ntohs(*((u_int16_t *) (as_value))); /* 2-byte AS */
 
-        if(as >> 16) 
+        if(as >> 16)
         {
             //sprintf(str, "%d.%d", (as >> 16) & 0xFFFF, as & 0xFFFF); /* DOT presentation */
             sprintf(str, "%d", as);                                    /* PLAIN presentation */
@@ -724,17 +578,18 @@ genBgpASSegNode(u_char *value, int as_len)
             sprintf(str, "%d", as);
         }
 
-        xmlNewChildString(node, "AS", str);
+        xfbChildString(w, "AS", str);
     }
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the AS_PATH attribute node
- * input:   value - pointer to AS path data
+ * Purpose: write the AS_PATH attribute node
+ * input:   w - the xml writer
+ *          value - pointer to AS path data
  *          len - length of AS path data
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  *
@@ -751,10 +606,10 @@ genBgpASSegNode(u_char *value, int as_len)
  *        </AS_SEG>
  *      </AS_PATH>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpASPathNode(u_char *value, int len, int asn_len)
+void
+genBgpASPathNode(XFBWriter w, u_char *value, int len, int asn_len)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "AS_PATH");
+    xfbStartElement(w, "AS_PATH");
 
     int index = 0;
     while (index < len)
@@ -762,27 +617,28 @@ genBgpASPathNode(u_char *value, int len, int asn_len)
         /* For each AS Segment */
         int l    = value[index + 1];  /* Segment length */
 
-        xmlAddChild(node, genBgpASSegNode(value + index, asn_len));
+        genBgpASSegNode(w, value + index, asn_len);
 
         /* move the index to the start of next AS Segment */
         index = index + 2 + l*asn_len;
     }
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the AS_PATH attribute node
- * input:   value - pointer to AS path data
+ * Purpose: write the AS4_PATH attribute node
+ * input:   w - the xml writer
+ *          value - pointer to AS path data
  *          len - length of AS path data
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpAS4PathNode(u_char *value, int len )
+void
+genBgpAS4PathNode(XFBWriter w, u_char *value, int len )
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "AS4_PATH");
+    xfbStartElement(w, "AS4_PATH");
 
     int index = 0;
     while (index < len)
@@ -790,20 +646,21 @@ genBgpAS4PathNode(u_char *value, int len )
         /* For each AS Segment */
         int l    = value[index + 1];  /* Segment length */
 
-        xmlAddChild(node, genBgpASSegNode(value + index, 4)); /* 4-byte AS */
+        genBgpASSegNode(w, value + index, 4); /* 4-byte AS */
 
         /* move the index to the start of next AS Segment */
         index = index + 2 + l*4;
     }
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the COMMUNITIES attribute node
- * input:   list - pointer to a list of BGP communities
+ * Purpose: write the COMMUNITIES attribute node
+ * input:   w - the xml writer
+ *          list - pointer to a list of BGP communities
  *          len - length of BGP communities
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 14 Oct 2010
@@ -815,10 +672,10 @@ genBgpAS4PathNode(u_char *value, int len )
  *  </COMMUNITIES>
  *
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpCommunitiesNode(BMF bmf, u_char *list, int len )
+void
+genBgpCommunitiesNode(XFBWriter w, BMF bmf, u_char *list, int len )
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "COMMUNITIES");
+    xfbStartElement(w, "COMMUNITIES");
 
     char *ctag = "COMMUNITY";
     char *rtag = "RESERVED_COMMUNITY";
@@ -833,67 +690,69 @@ genBgpCommunitiesNode(BMF bmf, u_char *list, int len )
 
         if ( as == 0xFFFF && val ==  0xFF01 )
         {
-            xmlAddChild(node, xmlNewNode(NULL, BAD_CAST "NO_EXPORT"));
+            xfbEmptyElement(w, "NO_EXPORT");
         }
         else if ( as == 0xFFFF && val == 0xFF02 )
         {
-            xmlAddChild(node, xmlNewNode(NULL, BAD_CAST "NO_ADVERTISE"));
+            xfbEmptyElement(w, "NO_ADVERTISE");
         }
         else if ( as == 0xFFFF && val == 0xFF03 )
         {
-            xmlAddChild(node, xmlNewNode(NULL, BAD_CAST "NO_EXPORT_SUBCONFED"));
+            xfbEmptyElement(w, "NO_EXPORT_SUBCONFED");
         }
         else if ( as == 0x0000 || as == 0xFFFF )
         {
-            xmlNodePtr child_node = xmlNewNode(NULL, BAD_CAST rtag);
-            xmlNewChildInt(child_node, atag, as);
-            xmlNewChildInt(child_node, vtag, val);
-            xmlAddChild(node, child_node);
+            xfbStartElement(w, rtag);
+            xfbChildInt(w, atag, as);
+            xfbChildInt(w, vtag, val);
+            xfbEndElement(w);
         }
         else
         {
-            xmlNodePtr child_node = xmlNewNode(NULL, BAD_CAST ctag);
-            xmlNewChildInt(child_node, atag, as);
-            xmlNewChildInt(child_node, vtag, val);
-            xmlAddChild(node, child_node);
+            xfbStartElement(w, ctag);
+            xfbChildInt(w, atag, as);
+            xfbChildInt(w, vtag, val);
+            xfbEndElement(w);
         }
         list = list+4;
     }
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the CLUSTER_LIST attribute node
- * input:   value - pointer to cluster list data
+ * Purpose: write the CLUSTER_LIST attribute node
+ * input:   w - the xml writer
+ *          value - pointer to cluster list data
  *          len - length of cluster list data
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpClusterListNode(u_char *value, int len )
+void
+genBgpClusterListNode(XFBWriter w, u_char *value, int len )
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "CLUSTER_LIST");
+    xfbStartElement(w, "CLUSTER_LIST");
 
     int index = 0;
     while (index < len)
     {
         /* Each ID is a 4-byte IP */
-        xmlNewChildIP(node, "ID", *((u_int32_t *) value + index ));
+        xfbChildIP(w, "ID", *((u_int32_t *) value + index ));
 
         /* Move the index to the next cluster id */
         index = index + 32; /* advance the index by 4-byte */
     }
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the MP_REACH_NLRI attribute node
- * input:   attr - pointer to mpreach attribute
+ * Purpose: write the MP_REACH_NLRI attribute node
+ * input:   w    - the xml writer
+ *          attr - pointer to mpreach attribute
  *          len  - length of mpreach attribute
  *          lt   - pointer to an array of labels. it could be NULL
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 21 Jul 2011
@@ -914,30 +773,30 @@ genBgpClusterListNode(u_char *value, int len )
  *   </MP_REACH_NLRI>
  *
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpMPReachNode(u_char *attr, int len, u_char **lt)
+void
+genBgpMPReachNode(XFBWriter w, u_char *attr, int len, u_char **lt)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "MP_REACH_NLRI");
+    xfbStartElement(w, "MP_REACH_NLRI");
 
     u_int16_t afi =  ntohs(*((u_int16_t *) attr));
     u_int8_t safi =  *((u_int8_t *) (attr+2));
 
     /* afi / safi */
-    xmlNewChildAFI(node,afi);
-    xmlNewChildSAFI(node,safi);
+    xfbChildAFI(w,afi);
+    xfbChildSAFI(w,safi);
 
     /* next hop */
     int nhlen = *(u_int8_t *) (attr+3);
 
-    xmlNewChildInt(node,"NEXT_HOP_LEN",nhlen);
+    xfbChildInt(w,"NEXT_HOP_LEN",nhlen);
 
-    xmlNodePtr nh_node = xmlNewNode(NULL,BAD_CAST "NEXT_HOP");
+    xfbStartElement(w, "NEXT_HOP");
 
     // get and convert ip address
-    static char str[XML_TEMP_BUFFER_LEN];
+    char str[XML_TEMP_BUFFER_LEN];
 
     if( !(afi == 1 || afi == 2) ){  //currently we only support IPv4 and IPv6
-        xmlNewChildOctets(nh_node,"OCTETS",attr+4,nhlen);
+        xfbChildOctets(w,"OCTETS",attr+4,nhlen);
     }
     else{
         if(afi == 1){   //we're dealing with one (or more) v4 address(es)
@@ -949,9 +808,9 @@ genBgpMPReachNode(u_char *attr, int len, u_char **lt)
 	            if( inet_ntop(AF_INET, ip_value, str, ADDR_MAX_CHARS) == NULL )
 	            {
 		            log_err("genBgpMPReachNode, could not convert IPv4 address");
-		            strcat(str, "0");
+		            strcpy(str, "0");
 	            }
-                xmlNewChildString(nh_node,"ADDRESS", str);
+                xfbChildString(w,"ADDRESS", str);
             }
         }
         else if(afi == 2){  //otherwise we're dealing with v6 address(es)
@@ -963,97 +822,33 @@ genBgpMPReachNode(u_char *attr, int len, u_char **lt)
 	            if( inet_ntop(AF_INET6, ip_value, str, ADDR_MAX_CHARS) == NULL )
 	            {
 		            log_err("genBgpMPReachNode, could not convert IPv6 address");
-		            strcat(str, "0");
+		            strcpy(str, "0");
 	            }
-                xmlNewChildString(nh_node,"ADDRESS", str);
+                xfbChildString(w,"ADDRESS", str);
             }
         }
     }
 
-/*    //BGPmon (as of 7.2) supports IPv4, IPv6, and multi-IPv6 next-hop addresses
-    //any unrecognized next-hop address or protocol must be preserved
-    if( !(nhlen == 4 || nhlen == 16 || nhlen == 32) || !(afi == 1 || afi == 2) ){
-        xmlNodePtr nh_oct = xmlNewChild(node,NULL,BAD_CAST "NEXT_HOP",NULL);
-        xmlNewChildOctets(nh_oct,"OCTETS",attr+4,nhlen);
-    }
-    else{
-        // get and convert ip address
-        static char str[XML_TEMP_BUFFER_LEN];
-	
-        //initialize buffer to store 1 v4 address or 1 or 2 v6 address(es)
-        u_int8_t ip_value[33];
-        memset(ip_value, 0, 33);
-        memcpy(ip_value, &attr[4], nhlen);
-
-        // IPv4 
-        if (afi == 1)
-        {
-	        if( inet_ntop(AF_INET, ip_value, str, ADDR_MAX_CHARS) == NULL )
-	        {
-		        log_err("genBgpMPReachNode, could not convert IPv4 address");
-		        strcat(str, "0");
-	        }
-            xmlNewChildString(node,"NEXT_HOP", str);
-        }
-        else{ // IPv6
-            if (afi == 2)
-            {
-                //if we only get 1 v6 address, convert it and go on
-                if(nhlen == 16){
-	                if( inet_ntop(AF_INET6, ip_value, str, ADDR_MAX_CHARS) == NULL )
-	                {
-		                log_err("genBgpMPReachNode, could not convert IPv6 address");
-		                strcat(str, "0");
-	                }
-                    xmlNewChildString(node,"NEXT_HOP", str);
-                }
-                //otherwise we got 2 addresses, so convert them both
-                else{
-                    //create "root" next_hop node to add child addresses to.
-                    xmlNodePtr nh_node = xmlNewChild(node,NULL,BAD_CAST "NEXT_HOP",NULL);
-                    //split up ip_value so we can pass each part through inet_ntop
-                    u_int8_t ip6_value1[17];
-                    u_int8_t ip6_value2[17];
-                    memset(ip6_value1,0,17);
-                    memset(ip6_value2,0,17);
-                    memcpy(ip6_value1,ip_value,16);
-                    memcpy(ip6_value2,ip_value+16,16);
-                    if( inet_ntop(AF_INET6, ip6_value1, str, ADDR_MAX_CHARS) == NULL )
-	                {
-		                log_err("genBgpMPReachNode, could not convert global IPv6 address");
-		                strcat(str, "0");
-	                }
-                    xmlNewChildString(nh_node,"ADDRESS",str);
-	                if( inet_ntop(AF_INET6, ip6_value2, str, ADDR_MAX_CHARS) == NULL )
-	                {
-		                log_err("genBgpMPReachNode, could not convert link-local IPv6 address");
-		                strcat(str, "0");
-	                }
-                    xmlNewChildString(nh_node,"ADDRESS",str);
-                }
-            }
-        }
-    }*/
-
-    //add NEXT_HOP node to MP_REACH_NODE
-    xmlAddChild(node,nh_node);
+    //close the NEXT_HOP node of MP_REACH_NODE
+    xfbEndElement(w);
 
     //Create pointer to start of NLRI data
     u_char *nlri;
     nlri = attr + 5 + nhlen;    //5 = 2B for AFI, 1B for SAFI, 1B for NH_LEN, 1B for SNPA/Reserved 0
 
     /* nlri */
-    xmlAddChild(node, genUpdateNlriNode(nlri, len-5-nhlen, afi, safi, lt));
+    genUpdateNlriNode(w, nlri, len-5-nhlen, afi, safi, lt);
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the MP_UNREACH_NLRI attribute node
- * input:   attr - pointer to mpreach attribute
+ * Purpose: write the MP_UNREACH_NLRI attribute node
+ * input:   w    - the xml writer
+ *          attr - pointer to mpreach attribute
  *          len  - length of mpreach attribute
  *          lt   - pointer to an array of labels. it could be NULL
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 14 Oct 2010
@@ -1068,39 +863,39 @@ genBgpMPReachNode(u_char *attr, int len, u_char **lt)
  *     </WITHDRAWN>
  *  </MP_UNREACH_NLRI>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpMPUnreachNode(u_char *attr, int len, u_char **lt)
+void
+genBgpMPUnreachNode(XFBWriter w, u_char *attr, int len, u_char **lt)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "MP_UNREACH_NLRI");
+    xfbStartElement(w, "MP_UNREACH_NLRI");
 
     u_int16_t afi =  ntohs(*((u_int16_t *) attr));
     u_int8_t safi =  *((u_int8_t *) (attr+2));
 
     /* afi / safi */
-    node = xmlNewChildAFI(node,afi);
-    node = xmlNewChildSAFI(node,safi);
+    xfbChildAFI(w,afi);
+    xfbChildSAFI(w,safi);
 
     /* withdrawn */
-    xmlAddChild(node, genUpdateWithdrawnNode(attr+3, len-3, afi, safi, lt));
+    genUpdateWithdrawnNode(w, attr+3, len-3, afi, safi, lt);
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*---------------------------------------------------------------------------------------
- * Purpose: generate an Extended Communities node
- * input:   value - a pointer to a list of extended community values
- *          len - the length of the attribute
- * output:  a node containing some representation of extended communities
+ * Purpose: write an Extended Communities node
+ * input:   w     - the xml writer
+ *          value - a pointer to a list of extended community values
+ *          len   - the length of the attribute
+ * output:  none
  * Jason Bartlett @ 14 Oct 2010
  *--------------------------------------------------------------------------------------*/
-xmlNodePtr genBgpExtCommunitiesNode(u_char *value,int len){
-    xmlNodePtr top_node = xmlNewNode(NULL,BAD_CAST "EXTENDED_COMMUNITIES");
-    xmlNodePtr x_com_node;
+void genBgpExtCommunitiesNode(XFBWriter w, u_char *value,int len){
+    xfbStartElement(w, "EXTENDED_COMMUNITIES");
     int i;
 
     //Extended Communities are defined as 8-octet fields
     for(i = 0; i < len; i += 8){
-        x_com_node = xmlNewNode(NULL,BAD_CAST "EXT_COM");
+        xfbStartElement(w, "EXT_COM");
 
         u_char type_h = value[i];   //first octet defines type field
         u_char type_l = value[i + 1];   //second octet defines subtype field
@@ -1108,165 +903,166 @@ xmlNodePtr genBgpExtCommunitiesNode(u_char *value,int len){
         switch(type_h){
             case 0x00:      //these cases are defined in RFC 4360
             {               //as 2-Octet AS_Specific Extended Communities
-                xmlNewPropString(x_com_node,"transitive","TRUE");
-                xmlNewChildString(x_com_node,"TYPE","2-OCTET AS-SPECIFIC EXT COM");
+                xfbAttrString(w,"transitive","TRUE");
+                xfbChildString(w,"TYPE","2-OCTET AS-SPECIFIC EXT COM");
                 switch(type_l){
                 case 0x02:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","ROUTE TARGET");
+                        xfbChildString(w,"SUBTYPE","ROUTE TARGET");
                         break;
                     }
                 case 0x03:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","ROUTE ORIGIN");
+                        xfbChildString(w,"SUBTYPE","ROUTE ORIGIN");
                         break;
                     }
                 default:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","UNKNOWN");
+                        xfbChildString(w,"SUBTYPE","UNKNOWN");
                         break;
                     }
                 }
                 u_int16_t as = value[i + 2]<<8 | value[i + 3];  //2-octet field for an IANA-assigned AS
-                xmlNewChildInt(x_com_node,"AS_NUM",as);
+                xfbChildInt(w,"AS_NUM",as);
                 //value field is defined by Local Administrator and so is preserved in binary
                 u_char data[] = {value[i + 4],value[i + 5],value[i + 6],value[i + 7]};
-                xmlNewChildOctets(x_com_node,"VALUE",data,sizeof(data));
+                xfbChildOctets(w,"VALUE",data,sizeof(data));
                 break;
             }
-            case 0x40:      
+            case 0x40:
             {
-                xmlNewChildString(x_com_node,"TYPE","2-OCTET AS-SPECIFIC EXT COM");
+                xfbChildString(w,"TYPE","2-OCTET AS-SPECIFIC EXT COM");
                 switch(type_l){
                 default:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","UNKNOWN");
+                        xfbChildString(w,"SUBTYPE","UNKNOWN");
                         break;
                     }
                 }
                 u_int16_t as = value[i + 2]<<8 | value[i + 3];  //2-octet field for an IANA-assigned AS
-                xmlNewChildInt(x_com_node,"AS_NUM",as);
+                xfbChildInt(w,"AS_NUM",as);
                 //value field is defined by Local Administrator and so is preserved in binary
                 u_char data[] = {value[i + 4],value[i + 5],value[i + 6],value[i + 7]};
-                xmlNewChildOctets(x_com_node,"VALUE",data,sizeof(data));
+                xfbChildOctets(w,"VALUE",data,sizeof(data));
                 break;
             }
             case 0x01:      //these types are defined as
             {               //IPv4 Address Specific Extended Communities
-                xmlNewPropString(x_com_node,"transitive","TRUE");
-                xmlNewChildString(x_com_node,"TYPE","IPV4 ADDRESS SPECIFIC EXT COM");
+                xfbAttrString(w,"transitive","TRUE");
+                xfbChildString(w,"TYPE","IPV4 ADDRESS SPECIFIC EXT COM");
                 switch(type_l){
                 case 0x02:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","ROUTE TARGET");
+                        xfbChildString(w,"SUBTYPE","ROUTE TARGET");
                         break;
                     }
                 case 0x03:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","ROUTE ORIGIN");
+                        xfbChildString(w,"SUBTYPE","ROUTE ORIGIN");
                         break;
                     }
                 default:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","UNKNOWN");
+                        xfbChildString(w,"SUBTYPE","UNKNOWN");
                         break;
                     }
                 }
                 //4-octet field for an assigned IPv4 address
                 u_int32_t v4 = value[i + 2]<<24 | value[i + 3]<<16 | value[i + 4]<<8 | value[i + 5];
-                xmlNewChildIP(x_com_node,"IPV4_ADDR",v4);
+                xfbChildIP(w,"IPV4_ADDR",v4);
                 //Local Administrator field is preserved as binary
                 u_char data[] = {value[i + 6],value[i + 7]};
-                xmlNewChildOctets(x_com_node,"VALUE",data,sizeof(data));
+                xfbChildOctets(w,"VALUE",data,sizeof(data));
                 break;
             }
-            case 0x41:      
+            case 0x41:
             {
-                xmlNewChildString(x_com_node,"TYPE","IPV4 ADDRESS SPECIFIC EXT COM");
+                xfbChildString(w,"TYPE","IPV4 ADDRESS SPECIFIC EXT COM");
                 switch(type_l){
                 default:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","UNKNOWN");
+                        xfbChildString(w,"SUBTYPE","UNKNOWN");
                         break;
                     }
                 }
                 //4-octet field for an assigned IPv4 address
                 u_int32_t v4 = value[i + 2]<<24 | value[i + 3]<<16 | value[i + 4]<<8 | value[i + 5];
-                xmlNewChildIP(x_com_node,"IPV4_ADDR",v4);
+                xfbChildIP(w,"IPV4_ADDR",v4);
                 //Local Administrator field is preserved as binary
                 u_char data[] = {value[i + 6],value[i + 7]};
-                xmlNewChildOctets(x_com_node,"VALUE",data,sizeof(data));
+                xfbChildOctets(w,"VALUE",data,sizeof(data));
                 break;
             }
             case 0x03:      //these types are defined
             {               //as Opaque Extended Communities
-                xmlNewPropString(x_com_node,"transitive","TRUE");
-                xmlNewChildString(x_com_node,"TYPE","OPAQUE EXTENDED COMMUNITY");
+                xfbAttrString(w,"transitive","TRUE");
+                xfbChildString(w,"TYPE","OPAQUE EXTENDED COMMUNITY");
                 //BGP Encapsulation Ext. Com. defined in RFC 5512, additional tunnel types in RFC 5566
                 switch(type_l){
                     case 0x0c:
                     {
-                        xmlNewChildString(x_com_node,"SUBTYPE","BGP ENCAPSULATION EXTENDED COMMUNITY");
+                        xfbChildString(w,"SUBTYPE","BGP ENCAPSULATION EXTENDED COMMUNITY");
                         u_int16_t tunnel_type = value[i + 6]<<8 | value[i + 7];
                         switch(tunnel_type){
-                            case ENCAP_L2TPV3_IP:     xmlNewChildString(x_com_node,"VALUE","L2TPV3");     break;
-                            case ENCAP_GRE:           xmlNewChildString(x_com_node,"VALUE","GRE");        break;
-                            case ENCAP_IP_IN_IP:      xmlNewChildString(x_com_node,"VALUE","IP IN IP");   break;
-                            case ENCAP_TRANS_END:       xmlNewChildString(x_com_node,"VALUE","TRANSMIT TUNNEL ENDPOINT");   break;
-                            case ENCAP_IPSEC_TUN:       xmlNewChildString(x_com_node,"VALUE","IPSEC IN TUNNEL MODE");       break;
-                            case ENCAP_IP_IP_IPSEC:     xmlNewChildString(x_com_node,"VALUE","IP IN IP TUNNEL WITH IPSEC"); break;
-                            case ENCAP_MPLS_IP:     xmlNewChildString(x_com_node,"VALUE","MPLS IN IP WITH IPSEC");      break;
-                            default:                xmlNewChildString(x_com_node,"VALUE","UNKNOWN");    break;
+                            case ENCAP_L2TPV3_IP:     xfbChildString(w,"VALUE","L2TPV3");     break;
+                            case ENCAP_GRE:           xfbChildString(w,"VALUE","GRE");        break;
+                            case ENCAP_IP_IN_IP:      xfbChildString(w,"VALUE","IP IN IP");   break;
+                            case ENCAP_TRANS_END:       xfbChildString(w,"VALUE","TRANSMIT TUNNEL ENDPOINT");   break;
+                            case ENCAP_IPSEC_TUN:       xfbChildString(w,"VALUE","IPSEC IN TUNNEL MODE");       break;
+                            case ENCAP_IP_IP_IPSEC:     xfbChildString(w,"VALUE","IP IN IP TUNNEL WITH IPSEC"); break;
+                            case ENCAP_MPLS_IP:     xfbChildString(w,"VALUE","MPLS IN IP WITH IPSEC");      break;
+                            default:                xfbChildString(w,"VALUE","UNKNOWN");    break;
                         }
                     }
                     default:
                     {
                         //subtype is to be assigned by IANA
-                        xmlNewChildInt(x_com_node,"SUBTYPE",(u_int8_t)type_l);
+                        xfbChildInt(w,"SUBTYPE",(u_int8_t)type_l);
                         //value field is preserved in binary
                         u_char data[] = {value[i + 2],value[i + 3],value[i + 4],value[i + 5],value[i + 6],value[i + 7]};
-                        xmlNewChildOctets(x_com_node,"VALUE",data,sizeof(data));
+                        xfbChildOctets(w,"VALUE",data,sizeof(data));
                         break;
                     }
                 }
                 break;
             }
-            case 0x43:      
+            case 0x43:
             {
-                xmlNewChildString(x_com_node,"TYPE","OPAQUE EXTENDED COMMUNITY");
+                xfbChildString(w,"TYPE","OPAQUE EXTENDED COMMUNITY");
                 //subtype is to be assigned by IANA
-                xmlNewChildInt(x_com_node,"SUBTYPE",(u_int8_t)type_l);
+                xfbChildInt(w,"SUBTYPE",(u_int8_t)type_l);
                 //value field is preserved in binary
                 u_char data[] = {value[i + 2],value[i + 3],value[i + 4],value[i + 5],value[i + 6],value[i + 7]};
-                xmlNewChildOctets(x_com_node,"VALUE",data,sizeof(data));
+                xfbChildOctets(w,"VALUE",data,sizeof(data));
                 break;
             }
             //additional types may be defined
             default:
             {
-                xmlNewChildString(x_com_node,"TYPE","UNKNOWN EXTENDED COMMUNITY");
-                xmlNewChildInt(x_com_node,"SUBTYPE",(u_int8_t)type_l);
+                xfbChildString(w,"TYPE","UNKNOWN EXTENDED COMMUNITY");
+                xfbChildInt(w,"SUBTYPE",(u_int8_t)type_l);
                 //regardless, preserve value field
                 u_char data[] = {value[i + 2],value[i + 3],value[i + 4],value[i + 5],value[i + 6],value[i + 7]};
-                xmlNewChildOctets(x_com_node,"VALUE",data,sizeof(data));
+                xfbChildOctets(w,"VALUE",data,sizeof(data));
                 break;
             }
         }
-        xmlAddChild(top_node,x_com_node);
+        xfbEndElement(w);
     }
-    return top_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate a TUNNEL_ENCAP node
- * input:   input - a pointer to the attribute
- *          len - the length of the attribute
- * output:  the new TUNNEL_ENCAP node
+ * Purpose: write a TUNNEL_ENCAP node
+ * input:   w     - the xml writer
+ *          input - a pointer to the attribute
+ *          len   - the length of the attribute
+ * output:  none
  * Jason Bartlett @ 18 Oct 2010
  *--------------------------------------------------------------------------------------*/
-xmlNodePtr genTunnelEncapNode(u_char* input,int len){
+void genTunnelEncapNode(XFBWriter w, u_char* input,int len){
 
-    xmlNodePtr encap_node = xmlNewNode(NULL, BAD_CAST "TUNNEL_ENCAP");
+    xfbStartElement(w, "TUNNEL_ENCAP");
 
     int base_pos = 0;   //index in the full attribute
     u_int16_t curr_length;  //length of value field of current top-level TLV
@@ -1274,7 +1070,11 @@ xmlNodePtr genTunnelEncapNode(u_char* input,int len){
 
     //step through each top-level TLV
     while(base_pos < len){
-        xmlNodePtr top_tlv = xmlNewNode(NULL,BAD_CAST "ENCAP");
+        xfbStartElement(w, "ENCAP");
+
+        //generate length attribute for top-level TLV's value field
+        curr_length = input[base_pos + 2]<<8 | input[base_pos + 3];
+        xfbAttrInt(w,"length",curr_length);
 
         //generate type child node
         type = input[base_pos + 0]<<8 | input[base_pos + 1];
@@ -1290,12 +1090,10 @@ xmlNodePtr genTunnelEncapNode(u_char* input,int len){
             default:                type_tag = "UNKNOWN";           break;
         }
 
-        xmlNodePtr type_node = xmlNewChildString(top_tlv,"TYPE",type_tag);
-        xmlNewPropInt(type_node,"value",type);
-
-        //generate length attribute for top-level TLV's value field
-        curr_length = input[base_pos + 2]<<8 | input[base_pos + 3];
-        xmlNewPropInt(top_tlv,"length",curr_length);
+        xfbStartElement(w, "TYPE");
+        xfbAttrInt(w,"value",type);
+        xfbText(w, type_tag);
+        xfbEndElement(w);
 
         //establish index for sub-TLV
         int curr_pos = base_pos + 4;
@@ -1303,165 +1101,174 @@ xmlNodePtr genTunnelEncapNode(u_char* input,int len){
         u_int8_t sub_tlv_len;
 
         do{
-            xmlNodePtr tlv_node = xmlNewNode(NULL,BAD_CAST "TLV");
+            xfbStartElement(w, "TLV");
             sub_tlv_type = (u_int8_t)input[curr_pos];       //gets 1-octet sub-TLV type field
             sub_tlv_len = (u_int8_t)input[curr_pos + 1];    //gets 1-octet sub-TLV length of value field
-            xmlNewPropInt(tlv_node,"length",sub_tlv_len);   //adds length attribute to sub-TLV node
+            xfbAttrInt(w,"length",sub_tlv_len);   //adds length attribute to sub-TLV node
             switch(sub_tlv_type){
                 case BGP_ENCAP_TLV:
                 {
-                    xmlNodePtr tlv_type_node = xmlNewChildString(tlv_node,"TYPE","ENCAP");
-                    xmlNewPropInt(tlv_type_node,"type",sub_tlv_type);
+                    xfbStartElement(w, "TYPE");
+                    xfbAttrInt(w,"type",sub_tlv_type);
+                    xfbText(w, "ENCAP");
                     switch(type){
                         case ENCAP_L2TPV3_IP:
                         {
                             u_int32_t id = input[curr_pos + 2]<<24 | input[curr_pos + 3]<<16 | input[curr_pos + 4]<<8 | input[curr_pos + 5];
-                            xmlNewChildInt(tlv_type_node,"SESSION_ID",id);
+                            xfbChildInt(w,"SESSION_ID",id);
                             if(sub_tlv_len - 4 > 0)     //cookie may not be present, but is variable-length
-                                xmlNewChildOctets(tlv_type_node,"COOKIE",input + curr_pos + 6,sub_tlv_len-4);
+                                xfbChildOctets(w,"COOKIE",input + curr_pos + 6,sub_tlv_len-4);
                             break;
                         }
                         case ENCAP_GRE:
                         {
                             u_int32_t key = input[curr_pos + 2]<<24 | input[curr_pos + 3]<<16 | input[curr_pos + 4]<<8 | input[curr_pos + 5];
-                            xmlNewChildInt(tlv_type_node,"KEY",key);
+                            xfbChildInt(w,"KEY",key);
                             break;
                         }
                         case ENCAP_IP_IN_IP:  break;
                         default:            break;
                     }
-                    xmlAddChild(tlv_node,tlv_type_node);
+                    xfbEndElement(w);
                     break;
                 }//end encapsulation sub-TLV case
                 case BGP_PROTO_TLV:
                 {
-                    xmlNodePtr tlv_type_node = xmlNewChildString(tlv_node,"TYPE","PROTO");
-                    xmlNewPropInt(tlv_type_node,"type",sub_tlv_type);
+                    xfbStartElement(w, "TYPE");
+                    xfbAttrInt(w,"type",sub_tlv_type);
+                    xfbText(w, "PROTO");
                     u_int16_t proto = input[curr_pos + 2]<<8 | input[curr_pos + 3];
                     switch(proto){
                         case 0x0800:
                         {
-                            xmlNewChildString(tlv_type_node,"PROTOCOL","IPV4");
+                            xfbChildString(w,"PROTOCOL","IPV4");
                             break;
                         }
                         case 0x86dd:
                         {
-                            xmlNewChildString(tlv_type_node,"PROTOCOL","IPV6");
+                            xfbChildString(w,"PROTOCOL","IPV6");
                             break;
                         }
                         case 0x8847:
                         {
-                            xmlNewChildString(tlv_type_node,"PROTOCOL","MPLS");
+                            xfbChildString(w,"PROTOCOL","MPLS");
                             break;
                         }
                         default:
                         {
-                            xmlNewChildString(tlv_type_node,"PROTOCOL","UNKNOWN");
+                            xfbChildString(w,"PROTOCOL","UNKNOWN");
                             break;
                         }
                     }
-                    xmlAddChild(tlv_node,tlv_type_node);
+                    xfbEndElement(w);
                     break;
                 }//end protocol sub-TLV case
                 case BGP_COLOR_TLV:
                 {
-                    xmlNodePtr tlv_type_node = xmlNewChildString(tlv_node,"TYPE","COLOR");
-                    xmlNewPropInt(tlv_type_node,"type",sub_tlv_type);
-                    xmlNodePtr color_node = genBgpExtCommunitiesNode(input + curr_pos + 2,sub_tlv_len);
-                    xmlAddChild(tlv_type_node,color_node);
-                    xmlAddChild(tlv_node,tlv_type_node);
+                    xfbStartElement(w, "TYPE");
+                    xfbAttrInt(w,"type",sub_tlv_type);
+                    xfbText(w, "COLOR");
+                    genBgpExtCommunitiesNode(w,input + curr_pos + 2,sub_tlv_len);
+                    xfbEndElement(w);
                     break;
                 }//end color sub-TLV case
                 case BGP_TUNNEL_AUTH_TLV:   //RFC 5566
                 {
-                    xmlNodePtr tlv_type_node = xmlNewChildString(tlv_node,"TYPE","IPSEC TUNNEL AUTH");
-                    xmlNewPropInt(tlv_type_node,"type",sub_tlv_type);
+                    xfbStartElement(w, "TYPE");
+                    xfbAttrInt(w,"type",sub_tlv_type);
+                    xfbText(w, "IPSEC TUNNEL AUTH");
                     u_int16_t auth_type = input[curr_pos + 2]<<8 | input[curr_pos + 3];
                     switch(auth_type){
                         case 1:     //type 1 (RFC 5566) is SHA-1 (RFC 4306)
                         {
-                            xmlNewChildString(tlv_type_node,"AUTH_TYPE","SHA-1");
+                            xfbChildString(w,"AUTH_TYPE","SHA-1");
                             break;
                         }
                         default:
                         {
-                            xmlNewChildString(tlv_type_node,"AUTH_TYPE","UNKNOWN");
+                            xfbChildString(w,"AUTH_TYPE","UNKNOWN");
                             break;
                         }
                     }
-                    xmlNewChildOctets(tlv_type_node,"KEY",input + curr_pos + 4,sub_tlv_len - 2);
-                    xmlAddChild(tlv_node,tlv_type_node);
+                    xfbChildOctets(w,"KEY",input + curr_pos + 4,sub_tlv_len - 2);
+                    xfbEndElement(w);
                     break;
                 }//end Tunnel authentication case
                 case BGP_LOAD_BAL_TLV:      //RFC 5640
                 {
-                    xmlNodePtr tlv_type_node = xmlNewChildString(tlv_node,"TYPE","LOAD BALANCING BLOCK");
-                    xmlNewPropInt(tlv_type_node,"type",sub_tlv_type);
+                    xfbStartElement(w, "TYPE");
+                    xfbAttrInt(w,"type",sub_tlv_type);
+                    xfbText(w, "LOAD BALANCING BLOCK");
                     u_int16_t value = input[curr_pos + 2]<<8 | input[curr_pos + 3];
-                    xmlNewChildInt(tlv_type_node,"VALUE",value);
-                    xmlAddChild(tlv_node,tlv_type_node);
+                    xfbChildInt(w,"VALUE",value);
+                    xfbEndElement(w);
                     break;
                 }//end Load Balancing Block sub-TLV
                 default:
                 {
-                    xmlNewChildOctets(tlv_node,"UNKNOWN",input + curr_pos + 2,sub_tlv_len);
+                    xfbChildOctets(w,"UNKNOWN",input + curr_pos + 2,sub_tlv_len);
                     break;
                 }
             }
-            //after sub-TLV is processed, add it to its owner and increment counter
-            xmlAddChild(top_tlv,tlv_node);  //adds sub-TLV to main TLV
+            //after sub-TLV is processed, close it and increment counter
+            xfbEndElement(w);
             curr_pos = curr_pos + 2 + sub_tlv_len;  //2-octet header and length of value field
         }while(curr_pos < sub_tlv_len);
-        //after sub-TLVs are processed, increment base index and add TLV
+        //after sub-TLVs are processed, increment base index and close TLV
         base_pos = base_pos + curr_length + 4;
-        xmlAddChild(encap_node,top_tlv);
+        xfbEndElement(w);
     }
-    return encap_node;
+    xfbEndElement(w);
 }
 
 /*---------------------------------------------------------------------------------------
- * Purpose: generate the TRAFFIC_ENGR node
- * input:   input - pointer to the traffic engineering attribute
- *          len - length of the attribute
- * output:  the new TRAFFIC_ENGR node
+ * Purpose: write the TRAFFIC_ENGR node
+ * input:   w     - the xml writer
+ *          input - pointer to the traffic engineering attribute
+ *          len   - length of the attribute
+ * output:  none
  * Jason Bartlett @ 18 Oct 2010
  *--------------------------------------------------------------------------------------*/
-xmlNodePtr genTrafficEngineeringNode(u_char *input,int len){
-    xmlNodePtr engr = xmlNewNode(NULL,BAD_CAST "TRAFFIC_ENGR");
+void genTrafficEngineeringNode(XFBWriter w, u_char *input,int len){
+    xfbStartElement(w, "TRAFFIC_ENGR");
     int next = 0;   //index of the next engineering block
     while(next < len){  //exits once all blocks have been handled
-        xmlNodePtr engr_node = xmlNewNode(NULL,BAD_CAST "ENGR");
+        xfbStartElement(w, "ENGR");
         //define Switching Capability (octet 0)
         switch(input[next]){
-            case LSC_PSC1:  xmlNewChildString(engr_node,"SWITCH_CAP","PSC-1");  break;
-            case LSC_PSC2:  xmlNewChildString(engr_node,"SWITCH_CAP","PSC-2");  break;
-            case LSC_PSC3:  xmlNewChildString(engr_node,"SWITCH_CAP","PSC-3");  break;
-            case LSC_PSC4:  xmlNewChildString(engr_node,"SWITCH_CAP","PSC-4");  break;
-            case LSC_L2SC:  xmlNewChildString(engr_node,"SWITCH_CAP","L2SC");  break;
-            case LSC_TDM:  xmlNewChildString(engr_node,"SWITCH_CAP","TDM");  break;
-            case LSC_LSC:  xmlNewChildString(engr_node,"SWITCH_CAP","LSC");  break;
-            case LSC_FSC:  xmlNewChildString(engr_node,"SWITCH_CAP","FSC");  break;
-            default:        xmlNewChildString(engr_node,"SWITCH_CAP","UNKNOWN");    break;
+            case LSC_PSC1:  xfbChildString(w,"SWITCH_CAP","PSC-1");  break;
+            case LSC_PSC2:  xfbChildString(w,"SWITCH_CAP","PSC-2");  break;
+            case LSC_PSC3:  xfbChildString(w,"SWITCH_CAP","PSC-3");  break;
+            case LSC_PSC4:  xfbChildString(w,"SWITCH_CAP","PSC-4");  break;
+            case LSC_L2SC:  xfbChildString(w,"SWITCH_CAP","L2SC");  break;
+            case LSC_TDM:  xfbChildString(w,"SWITCH_CAP","TDM");  break;
+            case LSC_LSC:  xfbChildString(w,"SWITCH_CAP","LSC");  break;
+            case LSC_FSC:  xfbChildString(w,"SWITCH_CAP","FSC");  break;
+            default:        xfbChildString(w,"SWITCH_CAP","UNKNOWN");    break;
         }
         //define Encoding (octet 1)
         switch(input[next + 1]){
-            case LSP_PACKET_ENC:        xmlNewChildString(engr_node,"ENCODING","PACKET");   break;
-            case LSP_ETHERNET_ENC:      xmlNewChildString(engr_node,"ENCODING","ETHERNET");   break;
-            case LSP_PDH_ENC:           xmlNewChildString(engr_node,"ENCODING","PDH");   break;
-            case LSP_G707_T1105_ENC:    xmlNewChildString(engr_node,"ENCODING","SDH ITU-T G.707/SONET ANSI T1.105");   break;
-            case LSP_DIG_WRAP_ENC:      xmlNewChildString(engr_node,"ENCODING","DIGITAL WRAPPER");   break;
-            case LSP_LAMBDA_ENC:        xmlNewChildString(engr_node,"ENCODING","LAMBDA (PHOTONIC)");   break;
-            case LSP_FIBER_ENC:         xmlNewChildString(engr_node,"ENCODING","FIBER");   break;
-            case LSP_FIBERCHANNEL_ENC:  xmlNewChildString(engr_node,"ENCODING","FIBERCHANNEL");   break;
-            default:                    xmlNewChildString(engr_node,"ENCODING","UNKNOWN");      break;
+            case LSP_PACKET_ENC:        xfbChildString(w,"ENCODING","PACKET");   break;
+            case LSP_ETHERNET_ENC:      xfbChildString(w,"ENCODING","ETHERNET");   break;
+            case LSP_PDH_ENC:           xfbChildString(w,"ENCODING","PDH");   break;
+            case LSP_G707_T1105_ENC:    xfbChildString(w,"ENCODING","SDH ITU-T G.707/SONET ANSI T1.105");   break;
+            case LSP_DIG_WRAP_ENC:      xfbChildString(w,"ENCODING","DIGITAL WRAPPER");   break;
+            case LSP_LAMBDA_ENC:        xfbChildString(w,"ENCODING","LAMBDA (PHOTONIC)");   break;
+            case LSP_FIBER_ENC:         xfbChildString(w,"ENCODING","FIBER");   break;
+            case LSP_FIBERCHANNEL_ENC:  xfbChildString(w,"ENCODING","FIBERCHANNEL");   break;
+            default:                    xfbChildString(w,"ENCODING","UNKNOWN");      break;
         }
 
         //Each Engineering Attribute defines 8 priorities
         int i;
+        char str[XML_TEMP_BUFFER_LEN];
         for(i = 0;i < 8;i++){
             u_int32_t max = input[next + 5 + (4 * i)]<<24 | input[next+ 6 + (4 * i)]<<16 | input[next + 7 + (4 * i)]<<8 | input[next + 8 + (4 * i)];
-            xmlNodePtr lsp_node = xmlNewChildInt(engr_node,"MAX_LSP_BANDWIDTH",max);
-            xmlNewPropInt(lsp_node,"priority",i);
+            snprintf(str, XML_TEMP_BUFFER_LEN, "%d", max);
+            xfbStartElement(w, "MAX_LSP_BANDWIDTH");
+            xfbAttrInt(w,"priority",i);
+            xfbText(w, str);
+            xfbEndElement(w);
         }
 
         //some Switching Capabilities indicate additional information
@@ -1473,16 +1280,16 @@ xmlNodePtr genTrafficEngineeringNode(u_char *input,int len){
             {
                 u_int32_t min_lsp_bw = input[next + 36]<<24 | input[next + 37]<<16 | input[next + 38]<<8 | input[next + 39];
                 u_int16_t int_mtu = input[next + 40]<<8 | input[next + 41];
-                xmlNewChildInt(engr_node,"MINIMUM_LSP_BANDWIDTH",min_lsp_bw);
-                xmlNewChildInt(engr_node,"INTERFACE_MTU",int_mtu);
+                xfbChildInt(w,"MINIMUM_LSP_BANDWIDTH",min_lsp_bw);
+                xfbChildInt(w,"INTERFACE_MTU",int_mtu);
                 next = next + 42;
                 break;
             }
             case LSC_TDM:
             {
                 u_int32_t min_lsp_bw = input[next + 36]<<24 | input[next + 37]<<16 | input[next + 38]<<8 | input[next + 39];
-                xmlNewChildInt(engr_node,"MINIMUM_LSP_BANDWIDTH",min_lsp_bw);
-                xmlNewChildInt(engr_node,"INDICATION",(u_int8_t)input[next + 40]);
+                xfbChildInt(w,"MINIMUM_LSP_BANDWIDTH",min_lsp_bw);
+                xfbChildInt(w,"INDICATION",(u_int8_t)input[next + 40]);
                 next = next + 41;
                 break;
             }
@@ -1495,46 +1302,46 @@ xmlNodePtr genTrafficEngineeringNode(u_char *input,int len){
                 break;
             }
         }
-        xmlAddChild(engr,engr_node);
+        xfbEndElement(w);
     }
-    return engr;
+    xfbEndElement(w);
 }
 
 /*---------------------------------------------------------------------------------------
- * purpose: generate the IPv6-Specific Extended Community node
- * input:   input - pointer to the attribute
- *          len - the length of the attribute
- * output:  the new extended community node
+ * purpose: write the IPv6-Specific Extended Community node
+ * input:   w     - the xml writer
+ *          input - pointer to the attribute
+ *          len   - the length of the attribute
+ * output:  none
  * Jason Bartlett @ 18 Oct 2010
  *--------------------------------------------------------------------------------------*/
-xmlNodePtr genIPv6ExtCommunityNode(u_char *input,int len){
-    xmlNodePtr top_node = xmlNewNode(NULL,BAD_CAST "EXTENDED_COMMUNITIES");
-    xmlNodePtr com_node;
+void genIPv6ExtCommunityNode(XFBWriter w, u_char *input,int len){
+    xfbStartElement(w, "EXTENDED_COMMUNITIES");
     int i;
     //each extended community is defined as 20 octets long
     for(i = 0;i < len;i += 20){
-        com_node = xmlNewNode(NULL,BAD_CAST "IPV6_SPECIFIC_EXT_COM");
+        xfbStartElement(w, "IPV6_SPECIFIC_EXT_COM");
         u_char type_h = input[i];   //first octet defines type (either 0x00 or 0x40)
         u_char type_l = input[i + 1];    //second octet defines subtype
 
         switch(type_h){
             case 0x00:
             {
-                xmlNewPropString(com_node,"transitive","TRUE");
+                xfbAttrString(w,"transitive","TRUE");
                 switch(type_l){
                     case 0x02:
                     {
-                        xmlNewChildString(com_node,"SUBTYPE","ROUTE_TARGET");
+                        xfbChildString(w,"SUBTYPE","ROUTE_TARGET");
                         break;
                     }
                     case 0x03:
                     {
-                        xmlNewChildString(com_node,"SUBTYPE","ROUTE_ORIGIN");
+                        xfbChildString(w,"SUBTYPE","ROUTE_ORIGIN");
                         break;
                     }
                     default:
                     {
-                        xmlNewChildString(com_node,"SUBTYPE","UNKNOWN");
+                        xfbChildString(w,"SUBTYPE","UNKNOWN");
                         break;
                     }
                     break;
@@ -1545,42 +1352,91 @@ xmlNodePtr genIPv6ExtCommunityNode(u_char *input,int len){
                 switch(type_l){
                     default:
                     {
-                        xmlNewChildString(com_node,"SUBTYPE","UNKNOWN");
+                        xfbChildString(w,"SUBTYPE","UNKNOWN");
                         break;
                     }
                 }
                 break;
             }
         }
-        xmlNewChildNetAddr(com_node,"IPV6_ADDR",input + i + 2,16);
-        xmlNewChildOctets(com_node,"LOCAL",input + i + 18,2);
-        xmlAddChild(top_node,com_node);
+        xfbChildNetAddr(w,"IPV6_ADDR",input + i + 2,16);
+        xfbChildOctets(w,"LOCAL",input + i + 18,2);
+        xfbEndElement(w);
     }
-    return top_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the PATH_ATTRIBUTES node
+ * Purpose: count the attributes in a list of path attributes
  * input:   attr - pointer to normal attribute
  *          len  - length of normal attribute
+ * Output:  the number of attributes
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+countAttributes(u_char *attr, int len)
+{
+    int i;
+    int hl;
+    int l;
+    int count = 0;
+
+    for ( i = 0; i < len; i = i + 2 + hl + l )
+    {
+        if ( (attr[i] & 0x10) > 0 )
+        {
+            hl = 2;
+            l = ntohs( *((u_int16_t *) (attr+i+2)) );
+        }
+        else
+        {
+            hl = 1;
+            l = attr[i+2];
+        }
+        count++;
+    }
+    return count;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: write the TYPE node of an attribute
+ * input:   w    - the xml writer
+ *          atag - name of the attribute
+ *          type - attribute type value
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static void
+genAttributeTypeNode(XFBWriter w, char *atag, int type)
+{
+    xfbStartElement(w, "TYPE");
+    xfbAttrInt(w, "value", type);
+    xfbText(w, atag);
+    xfbEndElement(w);
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: write the PATH_ATTRIBUTES node
+ * input:   w    - the xml writer
+ *          attr - pointer to normal attribute
+ *          len  - length of normal attribute
  *          lt   - pointer to an array of labels. it could be NULL
- * Output:  the new xml node
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 21 Sep 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genUpdateAttributesNode(BMF bmf, u_char *attr, int len, u_char **lt )
+void
+genUpdateAttributesNode(XFBWriter w, BMF bmf, u_char *attr, int len, u_char **lt )
 {
-    xmlNodePtr attributes_node = NULL;
-    attributes_node = xmlNewNode(NULL, BAD_CAST "PATH_ATTRIBUTES");
+    xfbStartElement(w, "PATH_ATTRIBUTES");
+    xfbAttrInt(w, "count", countAttributes(attr, len));
 
     int i;
     int hl;
     int l;
     int flags;
     int type;
-    int count = 0;
     u_char *value;
 
     /* Session specific setting */
@@ -1590,7 +1446,7 @@ genUpdateAttributesNode(BMF bmf, u_char *attr, int len, u_char **lt )
     /* For each attribute */
     for ( i = 0; i < len; i = i + 2 + hl + l )
     {
-        xmlNodePtr attr_node = xmlNewNode(NULL, BAD_CAST "ATTRIBUTE");
+        xfbStartElement(w, "ATTRIBUTE");
 
         /* flags */
         flags = attr[i];
@@ -1608,256 +1464,255 @@ genUpdateAttributesNode(BMF bmf, u_char *attr, int len, u_char **lt )
             l = attr[i+2];
             value = attr+i+3;
         }
-        xmlAddChild(attr_node, genAttributeFlagNode(flags));
+        xfbAttrInt(w, "length", l);
+        genAttributeFlagNode(w, flags);
 
         /* process each attribute */
-        xmlNodePtr type_node   = NULL;
-        xmlNewPropInt(attr_node,"length",l);
         switch ( type ) /* Defined in bgpmessagetypes.h */
         {
             case BGP_ATTR_ORIGIN:
             {
                 /* ORIGIN(1) */
                 char *atag = "ORIGIN";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, genBgpOriginNode(bmf, value[0]));
+                genAttributeTypeNode(w, atag, type);
+                genBgpOriginNode(w, bmf, value[0]);
                 break;
             }
             case BGP_ATTR_AS_PATH:
             {
                 /* AS PATH(2) */
                 char *atag = "AS_PATH";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, genBgpASPathNode(value, l, asn_len));
+                genAttributeTypeNode(w, atag, type);
+                genBgpASPathNode(w, value, l, asn_len);
                 break;
             }
             case BGP_ATTR_NEXT_HOP:
             {
                 /* NEXT HOP(3) */
                 char *atag = "NEXT_HOP";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, xmlNewNodeIP(atag, *((u_int32_t *) value )));
+                genAttributeTypeNode(w, atag, type);
+                xfbChildIP(w, atag, *((u_int32_t *) value ));
                 break;
             }
             case BGP_ATTR_MULTI_EXIT_DISC:
             {
                 /* MED(4) */
                 char *atag = "MULTI_EXIT_DISC";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, xmlNewNodeInt(atag, ntohl( *((u_int32_t *) value ))));
+                genAttributeTypeNode(w, atag, type);
+                xfbChildInt(w, atag, ntohl( *((u_int32_t *) value )));
                 break;
             }
             case BGP_ATTR_LOCAL_PREF:
             {
                 /* LOCAL_PREF(5) */
                 char *atag = "LOCAL_PREF";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, xmlNewNodeInt(atag, ntohl(*((u_int32_t *) value ))));
+                genAttributeTypeNode(w, atag, type);
+                xfbChildInt(w, atag, ntohl(*((u_int32_t *) value )));
                 break;
             }
             case BGP_ATTR_ATOMIC_AGGREGATE:
             {
                 /* ATOMIC_AGGREGATE(6) */
                 char *atag = "ATOMIC_AGGREGATE";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, xmlNewNode(NULL, BAD_CAST atag));
+                genAttributeTypeNode(w, atag, type);
+                xfbEmptyElement(w, atag);
                 break;
             }
             case BGP_ATTR_AGGREGATOR:
             {
                 /* AGGREGATOR(7) */
                 char *atag = "AGGREGATOR";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlNodePtr temp_node = xmlAddChild(attr_node, xmlNewNode(NULL, BAD_CAST atag));
-                xmlNewChildInt(temp_node, "AS",   ntohs( *((u_int16_t *) value ))); /* 2-byte AS */
-                xmlNewChildIP(temp_node,  "ADDR", *((u_int32_t *) value+2 ));       /* 4-byte address */
+                genAttributeTypeNode(w, atag, type);
+                xfbStartElement(w, atag);
+                xfbChildInt(w, "AS",   ntohs( *((u_int16_t *) value ))); /* 2-byte AS */
+                xfbChildIP(w,  "ADDR", *((u_int32_t *) value+2 ));       /* 4-byte address */
+                xfbEndElement(w);
                 break;
             }
             case BGP_ATTR_COMMUNITIES: // RFC 1997
             {
                 /* COMMUNITIES(8) */
                 char *atag = "COMMUNITIES";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, genBgpCommunitiesNode(bmf, value, l));
+                genAttributeTypeNode(w, atag, type);
+                genBgpCommunitiesNode(w, bmf, value, l);
                 break;
             }
             case BGP_ATTR_ORIGINATOR_ID: // RFC 2796
             {
                 /* ORIGINATOR_ID(9) */
                 char *atag = "ORIGINATOR_ID";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlNewChildIP(attr_node, atag, *((u_int32_t *) value ));
+                genAttributeTypeNode(w, atag, type);
+                xfbChildIP(w, atag, *((u_int32_t *) value ));
                 break;
             }
             case BGP_ATTR_CLUSTER_LIST: // RFC 2796
             {
                 /* CLUSTER_LIST(10) */
                 char *atag = "CLUSTER_LIST";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, genBgpClusterListNode(value, l));
+                genAttributeTypeNode(w, atag, type);
+                genBgpClusterListNode(w, value, l);
                 break;
             }
             case BGP_ATTR_DPA: // expired!!
             {
                 /* DESTINATION_PREFERENCE */
                 char *atag = "DESTINATION_PREFERENCE";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlNodePtr temp_node = xmlAddChild(attr_node, xmlNewNode(NULL, BAD_CAST atag));
+                genAttributeTypeNode(w, atag, type);
+                xfbStartElement(w, atag);
                 if ( l > 0 ) {
-                    xmlNewChildOctets(temp_node, "OCTETS", value, l);
+                    xfbChildOctets(w, "OCTETS", value, l);
                 }
+                xfbEndElement(w);
                 break;
             }
             case BGP_ATTR_ADVERTISER: // Historic!!
             {
                 /* ADVERTISER(12) */
                 char *atag = "ADVERTISER";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlNodePtr temp_node = xmlAddChild(attr_node, xmlNewNode(NULL, BAD_CAST atag));
+                genAttributeTypeNode(w, atag, type);
+                xfbStartElement(w, atag);
                 if ( l > 0 ) {
-                    xmlNewChildOctets(temp_node, "OCTETS", value, l);
+                    xfbChildOctets(w, "OCTETS", value, l);
                 }
+                xfbEndElement(w);
                 break;
             }
             case BGP_ATTR_RCID_PATH: //  Historic!!
             {
                 /* RCID_PATH(13) */
                 char *atag = "RCID_PATH";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlNodePtr temp_node = xmlAddChild(attr_node, xmlNewNode(NULL, BAD_CAST atag));
+                genAttributeTypeNode(w, atag, type);
+                xfbStartElement(w, atag);
                 if ( l > 0 ) {
-                    xmlNewChildOctets(temp_node, "OCTETS", value, l);
+                    xfbChildOctets(w, "OCTETS", value, l);
                 }
+                xfbEndElement(w);
                 break;
             }
             case BGP_ATTR_MP_REACH_NLRI: // RFC 2858
             {
                 /* MP_REACH_NLRI(14) */
                 char *atag = "MP_REACH_NLRI";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, genBgpMPReachNode(value, l, lt));
+                genAttributeTypeNode(w, atag, type);
+                genBgpMPReachNode(w, value, l, lt);
                 break;
             }
             case BGP_ATTR_MP_UNREACH_NLRI: // RFC 2858
             {
                 /* MP_UNREACH_NLRI(15) */
                 char *atag = "MP_UNREACH_NLRI";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, genBgpMPUnreachNode(value, l, lt));
+                genAttributeTypeNode(w, atag, type);
+                genBgpMPUnreachNode(w, value, l, lt);
                 break;
             }
             case BGP_ATTR_EXT_COMMUNITIES: // RFC 4360
             {
                 /* EXTENDED_COMMUNITIES(16) */
                 char *atag = "EXTENDED_COMMUNITIES";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node,genBgpExtCommunitiesNode(value,l));
+                genAttributeTypeNode(w, atag, type);
+                genBgpExtCommunitiesNode(w, value, l);
                 break;
             }
             case BGP_ATTR_AS4_PATH: // RFC 4893
             {
                 /* AS4_PATH(17) */
                 char *atag = "AS4_PATH";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node, genBgpAS4PathNode(value, l));
+                genAttributeTypeNode(w, atag, type);
+                genBgpAS4PathNode(w, value, l);
                 break;
             }
             case BGP_ATTR_AS4_AGGREGATOR: // RFC 4893
             {
                 /* AS4_AGGREGATOR(18) */
                 char *atag = "AS4_AGGREGATOR";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlNodePtr temp_node = xmlAddChild(attr_node, xmlNewNode(NULL, BAD_CAST atag));
-                xmlNewChildInt(temp_node, "AS",   ntohl( *((u_int32_t *) value ))); /* 4-byte AS */
-                xmlNewChildIP(temp_node,  "ADDR", *((u_int32_t *) value+4 ));       /* 4-byte address */
+                genAttributeTypeNode(w, atag, type);
+                xfbStartElement(w, atag);
+                xfbChildInt(w, "AS",   ntohl( *((u_int32_t *) value ))); /* 4-byte AS */
+                xfbChildIP(w,  "ADDR", *((u_int32_t *) value+4 ));       /* 4-byte address */
+                xfbEndElement(w);
                 break;
             }
 
             case BGP_ATTR_TUNNEL_ENCAP: //RFC 5512
             {
                 char *atag = "TUNNEL_ENCAPSULATION";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node,genTunnelEncapNode(value,l));
+                genAttributeTypeNode(w, atag, type);
+                genTunnelEncapNode(w, value, l);
                 break;
             }
             case BGP_ATTR_TRAFFIC_ENGR: //RFC 5543
             {
                 char *atag = "TRAFFIC_ENGINEERING";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node,genTrafficEngineeringNode(value,l));
+                genAttributeTypeNode(w, atag, type);
+                genTrafficEngineeringNode(w, value, l);
                 break;
             }
             case BGP_ATTR_IPV6_EXT_COM: //RFC 5701
             {
                 char *atag = "EXTENDED_COMMUNITIES";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlAddChild(attr_node,genIPv6ExtCommunityNode(value,l));
+                genAttributeTypeNode(w, atag, type);
+                genIPv6ExtCommunityNode(w, value, l);
                 break;
             }
             //[EXTEND] Additional attributes here
             default:
             {
                 char *atag = "OTHER";
-                type_node = xmlNewChildString(attr_node,"TYPE",atag);
-                xmlNodePtr other_node = xmlAddChild(attr_node, xmlNewNode(NULL, BAD_CAST atag));
+                genAttributeTypeNode(w, atag, type);
+                xfbStartElement(w, atag);
                 if ( l > 0 ) {
-                    xmlNewChildOctets(other_node, "OCTETS", value, l);
+                    xfbChildOctets(w, "OCTETS", value, l);
                 }
+                xfbEndElement(w);
                 break;
             }
         }
-        xmlNewPropInt(type_node, "value", type);
-        xmlAddChild(attributes_node, attr_node);
-        count++;
+        xfbEndElement(w);
     }
-    xmlNewPropInt(attributes_node, "count", count);
 
-    return attributes_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate OPEN node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write OPEN node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 14 Oct 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpOpenNode(BMF bmf)
+void
+genBgpOpenNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr bgp_node = NULL;
     PBgpOpen open = (PBgpOpen)(bmf->message + BGP_HEADER_LEN);
 
     /* BGP OPEN node */
-    bgp_node = xmlNewNode(NULL, BAD_CAST "OPEN");
+    xfbStartElement(w, "OPEN");
 
     /* Child nodes and attributes*/
-    /* VERSION     */ xmlNewChildInt(bgp_node, "VERSION",     getBGPOpenVersion(open));
-    /* SRC_AS      */ xmlNewChildInt(bgp_node, "SRC_AS",      getBGPOpenAutonomousSystem(open));
-    /* HOLD_TIME   */ xmlNewChildInt(bgp_node, "HOLD_TIME",   getBGPOpenHoldTime(open));
-    /* SRC_BGP     */ xmlNewChildIP(bgp_node,  "SRC_BGP",     getBGPOpenIdentifier(open));
-    /* OPT_PAR_LEN */ xmlNewChildInt(bgp_node, "OPT_PAR_LEN", getBGPOpenOptionalParameterLength(open));
-    /* OPT_PAR     */ xmlAddChild(bgp_node, genBgpOpenOptionalParameterNode(/* params */ open->optionalParameter,
-                                                                            /* length */ getBGPOpenOptionalParameterLength(open)));
-    return bgp_node;
+    /* VERSION     */ xfbChildInt(w, "VERSION",     getBGPOpenVersion(open));
+    /* SRC_AS      */ xfbChildInt(w, "SRC_AS",      getBGPOpenAutonomousSystem(open));
+    /* HOLD_TIME   */ xfbChildInt(w, "HOLD_TIME",   getBGPOpenHoldTime(open));
+    /* SRC_BGP     */ xfbChildIP(w,  "SRC_BGP",     getBGPOpenIdentifier(open));
+    /* OPT_PAR_LEN */ xfbChildInt(w, "OPT_PAR_LEN", getBGPOpenOptionalParameterLength(open));
+    /* OPT_PAR     */ genBgpOpenOptionalParameterNode(w, /* params */ open->optionalParameter,
+                                                         /* length */ getBGPOpenOptionalParameterLength(open));
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate UPDATE node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write UPDATE node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 15 Sep 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpUpdateNode(BMF bmf)
+void
+genBgpUpdateNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr bgp_node = NULL;
-    /* BGP Update node */
-    bgp_node = xmlNewNode(NULL, BAD_CAST "UPDATE");
-
     /* header */
     PBgpHeader hdr = NULL;
 //    u_int16_t  bgpType   = 0;
@@ -1880,22 +1735,24 @@ genBgpUpdateNode(BMF bmf)
     int alen = ntohs( *((u_int16_t *) (update+2+wlen)) );
     int nlen = len - alen - wlen - 4;                       if (nlen > real_len - 4) nlen = real_len - 4; /* prefixes are truncated */
 
+    /* BGP Update node */
+    xfbStartElement(w, "UPDATE");
+
     /* Child nodes and attributes */
-    /* WITHDRAWN_LEN  */
-    xmlNewPropInt(bgp_node,"withdrawn_len",wlen);
-    /* WITHDRAWN      */ xmlAddChild(bgp_node, genUpdateWithdrawnNode(update+2, wlen, 1, 1, lt));
-    /* ATTRIBUTES_LEN  */
-    xmlNewPropInt(bgp_node,"path_attr_len",alen);
-    /* ATTRIBUTES     */ xmlAddChild(bgp_node, genUpdateAttributesNode(bmf, update+4+wlen, alen, lt));
-    /* NLRI           */ xmlAddChild(bgp_node, genUpdateNlriNode(update+4+wlen+alen, nlen, 1, 1, lt));
-
-    return bgp_node;
+    /* WITHDRAWN_LEN  */ xfbAttrInt(w,"withdrawn_len",wlen);
+    /* ATTRIBUTES_LEN */ xfbAttrInt(w,"path_attr_len",alen);
+    /* WITHDRAWN      */ genUpdateWithdrawnNode(w, update+2, wlen, 1, 1, lt);
+    /* ATTRIBUTES     */ genUpdateAttributesNode(w, bmf, update+4+wlen, alen, lt);
+    /* NLRI           */ genUpdateNlriNode(w, update+4+wlen+alen, nlen, 1, 1, lt);
+
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate TIME node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write TIME node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 16 Sep 2010
@@ -1903,51 +1760,47 @@ genBgpUpdateNode(BMF bmf)
  * Ex:
  *  <TIME timestamp="1229905411" datetime="2008-12-22T00:23:31Z" precision_time="300"/>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr genTimeNode(BMF bmf)
+void genTimeNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr time_node = NULL;
-
     /* TIME node */
-    time_node = xmlNewNode(NULL, BAD_CAST "TIME");
+    xfbStartElement(w, "TIME");
 
     /* Attributes */
-    /* TIMESTAMP      */  xmlNewPropUnsignedInt(time_node,"timestamp",bmf->timestamp);
-    /* DATETIME       */ if (GMT_TIME_STAMP == TRUE) xmlNewPropGmtTime(time_node, "datetime", bmf->timestamp);
-    /* PRECISION_TIME */ xmlNewPropUnsignedInt(time_node, "precision_time", bmf->precisiontime);
+    /* TIMESTAMP      */ xfbAttrUnsignedInt(w, "timestamp", bmf->timestamp);
+    /* DATETIME       */ if (GMT_TIME_STAMP == TRUE) xfbAttrGmtTime(w, "datetime", bmf->timestamp);
+    /* PRECISION_TIME */ xfbAttrUnsignedInt(w, "precision_time", bmf->precisiontime);
 
-    return time_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate PEERING node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write PEERING node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 16 Sep 2010
  *
  * Ex:
  *  <PEERING as_num_len="2">
- *    <SRC_ADDR><AFI value="1">IPV4</AFI><ADDRESS>208.51.134.246</ADDRESS></SRC_ADDR>
+ *    <SRC_ADDR><ADDRESS>208.51.134.246</ADDRESS><AFI value="1">IPV4</AFI></SRC_ADDR>
  *    <SRC_PORT>0</SRC_PORT>
  *    <SRC_AS>3549</SRC_AS>
- *    <DST_ADDR><AFI value="1">IPV4</AFI><ADDRESS>128.223.51.102</ADDRESS></DST_ADDR>
+ *    <DST_ADDR><ADDRESS>128.223.51.102</ADDRESS><AFI value="1">IPV4</AFI></DST_ADDR>
  *    <DST_PORT>0</DST_PORT>
  *    <DST_AS>6447</DST_AS>
  *    <BGPID>128.223.51.102</BGPID>
  *  </PEERING>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr genPeeringNode(BMF bmf)
+void genPeeringNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr peering_node = NULL;
-    peering_node = xmlNewNode(NULL, BAD_CAST "PEERING");
-
     char *srcAddr, *dstAddr;
     u_int16_t srcPort, srcAS, dstPort, dstAS;
 
-    xmlNodePtr src_addr_node, dst_addr_node;
-
     /* PEERING NODE */
+    xfbStartElement(w, "PEERING");
+
     Session_structp sp = getSessionByID(bmf->sessionID);
 
     if (sp)
@@ -1960,52 +1813,51 @@ xmlNodePtr genPeeringNode(BMF bmf)
         dstPort = sp->configInUse.remotePort;
         dstAS   = sp->configInUse.remoteAS2;
 
-        /* SRC_ADDR */ src_addr_node = xmlNewChild(peering_node,NULL,BAD_CAST "SRC_ADDR",NULL);
-                       xmlNewChildString(src_addr_node,"ADDRESS",srcAddr);
-                       xmlNewChildAFI(src_addr_node, get_afi(srcAddr));
-        /* SRC_PORT */ xmlNewChildInt(peering_node,    "SRC_PORT", srcPort);
-        /* SRC_AS   */ xmlNewChildInt(peering_node,    "SRC_AS",   srcAS);
-        /* DST_ADDR */ dst_addr_node = xmlNewChild(peering_node, NULL,BAD_CAST "DST_ADDR",NULL);
-                       xmlNewChildString(dst_addr_node,"ADDRESS",dstAddr);
-                       xmlNewChildAFI(dst_addr_node, get_afi(dstAddr));
-        /* DST_PORT */ xmlNewChildInt(peering_node,    "DST_PORT", dstPort);
-        /* DST_AS   */ xmlNewChildInt(peering_node,    "DST_AS",   dstAS);
-        /* BGPID    */ xmlNewChildBGPID(peering_node,  "BGPID",    sp->configInUse.remoteBGPID);
-	/* AS Num Len*/xmlNewPropInt(peering_node,    "as_num_len",   sp->fsm.ASNumlen);
-
+        /* AS Num Len*/ xfbAttrInt(w,         "as_num_len", sp->fsm.ASNumlen);
+        /* SRC_ADDR */ xfbStartElement(w, "SRC_ADDR");
+                       xfbChildString(w,"ADDRESS",srcAddr);
+                       xfbChildAFI(w, get_afi(srcAddr));
+                       xfbEndElement(w);
+        /* SRC_PORT */ xfbChildInt(w,    "SRC_PORT", srcPort);
+        /* SRC_AS   */ xfbChildInt(w,    "SRC_AS",   srcAS);
+        /* DST_ADDR */ xfbStartElement(w, "DST_ADDR");
+                       xfbChildString(w,"ADDRESS",dstAddr);
+                       xfbChildAFI(w, get_afi(dstAddr));
+                       xfbEndElement(w);
+        /* DST_PORT */ xfbChildInt(w,    "DST_PORT", dstPort);
+        /* DST_AS   */ xfbChildInt(w,    "DST_AS",   dstAS);
+        /* BGPID    */ xfbChildBGPID(w,  "BGPID",    sp->configInUse.remoteBGPID);
     }
-    //printNode(peering_node);
 
-    return peering_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate NOTIFICATION node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write NOTIFICATION node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * Jason Bartlett @ 16 Sep 2010
  *
  * Ex: <NOTIFICATION>
- *          <TYPE value="1">MESSAGE HEADER ERROR</TYPE>
- *          <SUBTYPE value="3">BAD MESSAGE TYPE</SUBTYPE>
+ *          <TYPE error_code="1">MESSAGE HEADER ERROR</TYPE>
+ *          <SUBTYPE error_subcode="3">BAD MESSAGE TYPE</SUBTYPE>
  *     </NOTIFICATION>
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpNotificationNode(BMF bmf)
+void
+genBgpNotificationNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = NULL;
     PBgpNotification ntf = (PBgpNotification)(bmf->message + BGP_HEADER_LEN);
-
     char *code_str    = NULL;
     char *subcode_str = NULL;
-    
+
     switch(ntf->errorCode)
     {
         case 1:
         {
-            code_str = "MESSAGE HEADER ERROR"; 
+            code_str = "MESSAGE HEADER ERROR";
             switch(ntf->errorSubcode)
             {
                 case 1: { subcode_str = "CONNECTION NOT SYNCHRONIZED"; break; }
@@ -2017,7 +1869,7 @@ genBgpNotificationNode(BMF bmf)
         }
         case 2:
         {
-            code_str = "OPEN MESSAGE ERROR"; 
+            code_str = "OPEN MESSAGE ERROR";
             switch(ntf->errorSubcode)
             {
                 case 1: { subcode_str = "UNSUPPORTED VERSION NUMBER";         break; }
@@ -2032,7 +1884,7 @@ genBgpNotificationNode(BMF bmf)
         }
         case 3:
         {
-            code_str = "UPDATE MESSAGE ERROR"; 
+            code_str = "UPDATE MESSAGE ERROR";
             switch(ntf->errorSubcode)
             {
                 case 1:  { subcode_str = "MALFORMED ATTRIBUTE LIST";          break; }
@@ -2052,12 +1904,12 @@ genBgpNotificationNode(BMF bmf)
         }
         case 4:
         {
-            code_str = "HOLD TIMER EXPIRED"; 
+            code_str = "HOLD TIMER EXPIRED";
             break;
         }
         case 5:
         {
-            code_str = "FINITE STATE MACHINE ERROR"; 
+            code_str = "FINITE STATE MACHINE ERROR";
             break;
         }
         case 6:
@@ -2085,104 +1937,97 @@ genBgpNotificationNode(BMF bmf)
     }
 
     /* NOTIFICATION node */
-    node = xmlNewNode(NULL, BAD_CAST "NOTIFICATION");
+    xfbStartElement(w, "NOTIFICATION");
 
     /* Child nodes */
     //Modification: Put strings in children, numbers as children's attribute
 
-    xmlNodePtr code_node = xmlNewChildString(node,"TYPE",code_str);
-    xmlNewPropInt(code_node, "error_code", ntf->errorCode);
+    xfbStartElement(w, "TYPE");
+    xfbAttrInt(w, "error_code", ntf->errorCode);
+    xfbText(w, code_str);
+    xfbEndElement(w);
 
     if(ntf->errorCode == 1 || ntf->errorCode == 2 || ntf->errorCode == 3 || ntf->errorCode == 6){
-        xmlNodePtr sub_code_node = xmlNewChildString(node,"SUBTYPE", subcode_str);
-        xmlNewPropInt(sub_code_node,"error_subcode", ntf->errorSubcode);
+        xfbStartElement(w, "SUBTYPE");
+        xfbAttrInt(w, "error_subcode", ntf->errorSubcode);
+        xfbText(w, subcode_str);
+        xfbEndElement(w);
     }
 
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate KEEPALIVE node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write KEEPALIVE node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpKeepaliveNode(BMF bmf)
+void
+genBgpKeepaliveNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = NULL;
-    node = xmlNewNode(NULL, BAD_CAST "KEEPALIVE");
-    return node;
+    xfbEmptyElement(w, "KEEPALIVE");
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate ROUTE_REFRESH node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write ROUTE_REFRESH node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * Jason Bartlett @ 17 Sep 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpRouteRefreshNode(BMF bmf)
+void
+genBgpRouteRefreshNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = NULL;
     u_char *msg;
-    node = xmlNewNode(NULL, BAD_CAST "ROUTE_REFRESH");
     msg = bmf->message + BGP_HEADER_LEN;
     u_int16_t afi = msg[0]<<8 | msg[1];
     u_int8_t safi = msg[3];
-    xmlNewChildAFI(node,afi);
-    xmlNewChildSAFI(node,safi);
-    return node;
+    xfbStartElement(w, "ROUTE_REFRESH");
+    xfbChildAFI(w,afi);
+    xfbChildSAFI(w,safi);
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate STATE_CHANGE node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write STATE_CHANGE node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpStateChangeNode(BMF bmf)
+void
+genBgpStateChangeNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr state_change_node = NULL;
     StateChangeMsg *sc    = NULL;
 
     sc = (StateChangeMsg *)(bmf->message);
 
-    /* STATE_CHANGE node */ state_change_node = xmlNewNode(NULL, BAD_CAST "STATE_CHANGE");
+    /* STATE_CHANGE node */ xfbStartElement(w, "STATE_CHANGE");
 
     /* Child nodes */
-    /* OLD_STATE */ xmlNewChildInt(state_change_node, "OLD_STATE",   sc->oldState);
-    /* NEW_STATE */ xmlNewChildInt(state_change_node, "NEW_STATE",   sc->newState);
-    /* REASON    */ xmlNewChildInt(state_change_node, "REASON",      sc->reason);
+    /* OLD_STATE */ xfbChildInt(w, "OLD_STATE",   sc->oldState);
+    /* NEW_STATE */ xfbChildInt(w, "NEW_STATE",   sc->newState);
+    /* REASON    */ xfbChildInt(w, "REASON",      sc->reason);
 
-    return state_change_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate UNKNOWN node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write UNKNOWN node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpUnknownNode(BMF bmf)
+void
+genBgpUnknownNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = NULL;
-
-//    PBgpHeader hdr = NULL;
-//    u_int16_t  bgpType = 0;
-//    u_int32_t  bgpMsgLen = 0;
-
-//    hdr       = (PBgpHeader)(bmf->message);
-//    bgpType   = hdr->type;
-//    bgpMsgLen = getBGPHeaderLength(hdr);
-
-    node = xmlNewNode(NULL, BAD_CAST "UNKNOWN");
-    return node;
+    xfbEmptyElement(w, "UNKNOWN");
 }
 
 /*---------------------------------------------------------------------------------
@@ -2197,7 +2042,7 @@ char* getAsciiMsgType(u_int16_t type){
         switch ( type )
         {
             case typeOpen:
-            { 
+            {
                 result = "OPEN";
                 break;
             }
@@ -2232,17 +2077,16 @@ char* getAsciiMsgType(u_int16_t type){
 
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate ASCII_MSG node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write ASCII_MSG node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * Jason Bartlett @ 14 Oct 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genAsciiMsgNode(BMF bmf)
+void
+genAsciiMsgNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr ascii_node = NULL;
-
     if (ASCII_MESSAGES == TRUE)
     {
 
@@ -2260,12 +2104,10 @@ genAsciiMsgNode(BMF bmf)
         }
 
         /* ASCII_MSG node */
-        ascii_node = xmlNewNode(NULL, BAD_CAST "ASCII_MSG");
+        xfbStartElement(w, "ASCII_MSG");
 
-        xmlNewPropUnsignedInt(ascii_node,"length",bgpMsgLen);
-        //xmlNewChildString(ascii_node,"TYPE",getAsciiMsgType(bgpType));
-        //xmlNewPropUnsignedInt(ascii_node,"type",(u_int32_t)bgpType);
-        xmlNewChildOctets(ascii_node,"MARKER",hdr->mask,sizeof(hdr->mask));
+        xfbAttrUnsignedInt(w,"length",bgpMsgLen);
+        xfbChildOctets(w,"MARKER",hdr->mask,sizeof(hdr->mask));
 
         /* Choice of message types */
         switch ( bgpType )
@@ -2273,55 +2115,55 @@ genAsciiMsgNode(BMF bmf)
             case typeOpen:
             {
                 /* OPEN */
-                xmlAddChild(ascii_node, genBgpOpenNode(bmf));
+                genBgpOpenNode(w, bmf);
                 break;
             }
             case typeUpdate:
             {
                 /* UPDATE */
-                xmlAddChild(ascii_node, genBgpUpdateNode(bmf));
+                genBgpUpdateNode(w, bmf);
                 break;
             }
             case typeNotification:
             {
                 /* NOTIFICATION */
-                xmlAddChild(ascii_node, genBgpNotificationNode(bmf));
+                genBgpNotificationNode(w, bmf);
                 break;
             }
             case typeKeepalive:
             {
                 /* KEEPALIVE */
-                xmlAddChild(ascii_node, genBgpKeepaliveNode(bmf));
+                genBgpKeepaliveNode(w, bmf);
                 break;
             }
             case typeRouteRefresh:
             {
                 /* ROUTE_REFRESH */
-                xmlAddChild(ascii_node, genBgpRouteRefreshNode(bmf));
+                genBgpRouteRefreshNode(w, bmf);
                 break;
             }
             default:
             {
                 /* UNKNOWN */
-                xmlAddChild(ascii_node, genBgpUnknownNode(bmf));
+                genBgpUnknownNode(w, bmf);
                 break;
             }
         }
+        xfbEndElement(w);
     }
-    return ascii_node;
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate OCTET_MSG node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write OCTET_MSG node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * Jason Bartlett @ 16 Sep 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genOctetMsgNode(BMF bmf)
+void
+genOctetMsgNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr octet_node = NULL;
     PBgpHeader hdr        = NULL;
 //    u_int16_t  bgpType    = 0;
     u_int32_t  bgpMsgLen  = 0;
@@ -2332,38 +2174,39 @@ genOctetMsgNode(BMF bmf)
     bgpMsgLen = getBGPHeaderLength(hdr);
 
     /* OCTET_MSG node */
-    octet_node = xmlNewNode(NULL, BAD_CAST "OCTET_MSG");
-    xmlNewChildOctets(octet_node, "OCTETS", bmf->message, bgpMsgLen);
-
-    return octet_node;
+    xfbStartElement(w, "OCTET_MSG");
+    xfbChildOctets(w, "OCTETS", bmf->message, bgpMsgLen);
+    xfbEndElement(w);
 }
 
 /*---------------------------------------------------------------------------------------
- * purpose: generate the BGPMON_SEQ node
- * output:  the new sequence number node
+ * purpose: write the BGPMON_SEQ node, the seq_num attribute is reserved with
+ *          XML_SEQ_DIGITS zeros and stamped once the message is written out
+ * input:   w   - the xml writer
+ * output:  the position of the seq_num value in the buffer, NULL if it didn't fit
  * Jason Bartlett @ 21 Oct 2010
  *-------------------------------------------------------------------------------------*/
-xmlNodePtr genSequenceNode(){
-    xmlNodePtr seq_node = xmlNewNode(NULL, BAD_CAST "BGPMON_SEQ");
-    xmlNewPropInt(seq_node,"id",ClientControls.bgpmon_id);
-    xmlNewPropInt(seq_node,"seq_num",ClientControls.seq_num);
-
-    return seq_node;
+char *genSequenceNode(XFBWriter w){
+    char *seq_str;
+
+    xfbStartElement(w, "BGPMON_SEQ");
+    xfbAttrInt(w,"id",ClientControls.bgpmon_id);
+    seq_str = xfbAttrReserve(w,"seq_num",XML_SEQ_DIGITS);
+    xfbEndElement(w);
+    return seq_str;
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: convert the queue status message to an XML text representation
- * input:	queueName - queue name
- * Output: the position of pointer in the buffer
+ * Purpose: write the PACING node of a queue
+ * input:   w         - the xml writer
+ *          queueName - queue name
+ * Output:  none
  * He Yan @ Jun 22, 2008
  * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/ 
-xmlNodePtr
-genPacingNode(char *queueName)
+ * -------------------------------------------------------------------------------------*/
+void
+genPacingNode(XFBWriter w, char *queueName)
 {
-    xmlNodePtr node = NULL;
-    /* QUEUE node */ node = xmlNewNode(NULL, BAD_CAST "PACING");
-
     stat_data_t pc_data, wl_data;
     memset(&pc_data, 0, sizeof(stat_data_t));
     memset(&wl_data, 0, sizeof(stat_data_t));
@@ -2378,28 +2221,27 @@ genPacingNode(char *queueName)
     if (flag == TRUE) { flag_str = "1"; }
     else              { flag_str = "0"; }
 
-    xmlNewChildString(node, "FLAG",         flag_str);
-    xmlNewChildStat(node,   "COUNT",        &pc_data);
-    xmlNewChildStat(node,   "WRITE_LIMIT",  &wl_data);
-
-    return node;
+    /* PACING node */ xfbStartElement(w, "PACING");
+    xfbChildString(w, "FLAG",        flag_str);
+    xfbChildStat(w,   "COUNT",       &pc_data);
+    xfbChildStat(w,   "WRITE_LIMIT", &wl_data);
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the QUEUE node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write the QUEUE node
+ * input:   w         - the xml writer
+ *          queueName - queue name
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genQueueNode(char *queueName)
+void
+genQueueNode(XFBWriter w, char *queueName)
 {
-    xmlNodePtr queue_node = NULL;
-
-    /* QUEUE node */ 
-    queue_node = xmlNewNode(NULL, BAD_CAST "QUEUE");
+    /* QUEUE node */
+    xfbStartElement(w, "QUEUE");
 
-    xmlNewChildString(queue_node, "NAME", queueName);
+    xfbChildString(w, "NAME", queueName);
 
     // Prepare statistic data
     stat_data_t item_data, writer_data, reader_data;
@@ -2414,58 +2256,58 @@ genQueueNode(char *queueName)
     writer_data.current = getWriterCount(queueName);
     writer_data.max     = getLoggedMaxWriters(queueName);
     reader_data.current = getReaderCount(queueName);
-    reader_data.max     = getLoggedMaxReaders(queueName);	
+    reader_data.max     = getLoggedMaxReaders(queueName);
 
-    xmlNewChildStat(queue_node, "ITEM",   &item_data);
-    xmlNewChildStat(queue_node, "WRITER", &writer_data);
-    xmlNewChildStat(queue_node, "READER", &reader_data);
+    xfbChildStat(w, "ITEM",   &item_data);
+    xfbChildStat(w, "WRITER", &writer_data);
+    xfbChildStat(w, "READER", &reader_data);
 
-    xmlAddChild(queue_node, genPacingNode(queueName));
-	return queue_node;
+    genPacingNode(w, queueName);
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the QUEUE_STATUS node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write the QUEUE_STATUS node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genQueueStatusNode(BMF bmf)
+void
+genQueueStatusNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "QUEUE_STATUS");
-
-    int count = 0; 
-    count++; xmlAddChild(node, genQueueNode(PEER_QUEUE_NAME));
-    count++; xmlAddChild(node, genQueueNode(LABEL_QUEUE_NAME));
-    count++; xmlAddChild(node, genQueueNode(XML_U_QUEUE_NAME));
-    count++; xmlAddChild(node, genQueueNode(XML_R_QUEUE_NAME));
-            
-    xmlNewPropInt(node, "count", count);
-    return node;
+    xfbStartElement(w, "QUEUE_STATUS");
+    xfbAttrInt(w, "count", 4);
+
+    genQueueNode(w, PEER_QUEUE_NAME);
+    genQueueNode(w, LABEL_QUEUE_NAME);
+    genQueueNode(w, XML_U_QUEUE_NAME);
+    genQueueNode(w, XML_R_QUEUE_NAME);
+
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: convert the chain status message to an XML text representation
- * input:   chainID - chain's ID
- * Output: the position of pointer in the buffer
+ * Purpose: write the CHAIN node
+ * input:   w       - the xml writer
+ *          chainID - chain's ID
+ * Output:  none
  * He Yan @ Jun 22, 2008
  * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/ 
-xmlNodePtr
-genChainNode(int chainID)
+ * -------------------------------------------------------------------------------------*/
+void
+genChainNode(XFBWriter w, int chainID)
 {
-    xmlNodePtr chain_node = NULL;
-    /* CHAIN node */ chain_node = xmlNewNode(NULL, BAD_CAST "CHAIN");
+    /* CHAIN node */ xfbStartElement(w, "CHAIN");
 
 	/* UPDATE LISTENER */
     /* ADDR/PORT */
-	xmlNewChildString(chain_node, "UPDATE_ADDR", getChainAddress(chainID));
-	xmlNewChildInt(chain_node,    "UPDATE_PORT", getUChainPort(chainID));
+	xfbChildString(w, "UPDATE_ADDR", getChainAddress(chainID));
+	xfbChildInt(w,    "UPDATE_PORT", getUChainPort(chainID));
 
     /* STATE */
-    xmlNewChildInt(chain_node, "UPDATE_STATE", getChainConnectionState(chainID, UPDATE_STREAM_CHAIN));
-    
+    xfbChildInt(w, "UPDATE_STATE", getChainConnectionState(chainID, UPDATE_STREAM_CHAIN));
+
     /* COUNTs */
     time_data_t op_data;
     memset(&op_data,   0, sizeof(time_data_t));
@@ -2473,55 +2315,59 @@ genChainNode(int chainID)
     // Current value
 	op_data.current   = getUChainConnectedTime(chainID);
 	op_data.last_down = getULastConnectionDownTime(chainID);
-    xmlNewChildTime(chain_node, "UPDATE_UPTIME",       &op_data);
+    xfbChildTime(w, "UPDATE_UPTIME",       &op_data);
 
     stat_data_t rv_data, rs_data;
     memset(&rv_data,   0, sizeof(stat_data_t));
     memset(&rs_data,   0, sizeof(stat_data_t));
     rv_data.current   = getUChainReceivedMessages(chainID);
     rs_data.current   = getUChainConnectionResetCount(chainID);
-    xmlNewChildStat(chain_node, "UPDATE_RECV_MESSAGE", &rv_data);
-    xmlNewChildStat(chain_node, "UPDATE_RESET",        &rs_data);
+    xfbChildStat(w, "UPDATE_RECV_MESSAGE", &rv_data);
+    xfbChildStat(w, "UPDATE_RESET",        &rs_data);
 
-	return chain_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the CHAIN_STATUS node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write the CHAIN_STATUS node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genChainStatusNode(BMF bmf)
+void
+genChainStatusNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "CHAIN_STATUS");
+    xfbStartElement(w, "CHAIN_STATUS");
+    /* the count of chains has always been reported as 0 */
+    xfbAttrInt(w, "count", 0);
 
     /*chains' status message*/
-    int *chainIDs;
+    int *chainIDs = NULL;
     int len = getActiveChainsIDs(&chainIDs);
-    int count = 0; 
     int i;
     for(i=0; i<len; i++)
     {
-        xmlAddChild(node, genChainNode(chainIDs[i]));
-    }				
-    /* update the count of prefixes */
-    xmlNewPropInt(node, "count", count);
-    return node;
+        genChainNode(w, chainIDs[i]);
+    }
+    free(chainIDs);
+
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the SESSION node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write the SESSION node
+ * input:   w            - the xml writer
+ *          bmf          - our internal BMF message
+ *          sessionID    - session's ID
+ *          state_change - report the state change in bmf instead of the counters
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genSessionNode(BMF bmf, int sessionID, int state_change)
+void
+genSessionNode(XFBWriter w, BMF bmf, int sessionID, int state_change)
 {
-    xmlNodePtr session_node = NULL;
-    /* SESSION node */ session_node = xmlNewNode(NULL, BAD_CAST "SESSION");
+    /* SESSION node */ xfbStartElement(w, "SESSION");
 
     /* ADDR/PORT/AS */
     char *dstAddr = NULL;
@@ -2534,20 +2380,20 @@ genSessionNode(BMF bmf, int sessionID, int state_change)
         dstPort = sp->configInUse.remotePort;
         dstAS   = sp->configInUse.remoteAS2;
     }
-	xmlNewChildString(session_node, "ADDR", dstAddr);
-	xmlNewChildInt(session_node,    "PORT", dstPort);
-	xmlNewChildInt(session_node,    "AS",   dstAS);
+	xfbChildString(w, "ADDR", dstAddr);
+	xfbChildInt(w,    "PORT", dstPort);
+	xfbChildInt(w,    "AS",   dstAS);
 
     if (state_change>0)
     {
         /* STATE_CHANGE */
-        xmlAddChild(session_node, genBgpStateChangeNode(bmf));
+        genBgpStateChangeNode(w, bmf);
     }
     else
     {
         /* STATE */
-        xmlNewChildInt(session_node, "STATE", getSessionState(sessionID));
-        
+        xfbChildInt(w, "STATE", getSessionState(sessionID));
+
         /* COUNTs */
         time_data_t op_data;
         stat_data_t rv_data, rs_data;
@@ -2563,9 +2409,9 @@ genSessionNode(BMF bmf, int sessionID, int state_change)
         rv_data.current     = getSessionMsgCount(sessionID);
         rs_data.current     = getSessionDownCount(sessionID);
 
-        xmlNewChildTime(session_node, "UPTIME",       &op_data);
-        xmlNewChildStat(session_node, "RECV_MESSAGE", &rv_data);
-        xmlNewChildStat(session_node, "RESET",        &rs_data);
+        xfbChildTime(w, "UPTIME",       &op_data);
+        xfbChildStat(w, "RECV_MESSAGE", &rv_data);
+        xfbChildStat(w, "RESET",        &rs_data);
 
         /* COUNTs for session variables */
         stat_data_t pr_data,  // prefix
@@ -2598,81 +2444,114 @@ genSessionNode(BMF bmf, int sessionID, int state_change)
         nw_data.current = getSessionCurrentWithCount(sessionID);
         dw_data.current = getSessionCurrentDWithCount(sessionID);
 
-        xmlNewChildStat(session_node, "PREFIX",       &pr_data);
-        xmlNewChildStat(session_node, "ATTRIBUTE",    &at_data);
-        xmlNewChildStat(session_node, "MEMORY_USAGE", &mm_data);
+        xfbChildStat(w, "PREFIX",       &pr_data);
+        xfbChildStat(w, "ATTRIBUTE",    &at_data);
+        xfbChildStat(w, "MEMORY_USAGE", &mm_data);
 
-        xmlNewChildStat(session_node, "ANNOUNCEMENT",     &na_data);
-        xmlNewChildStat(session_node, "DUP_ANNOUNCEMENT", &da_data);
-        xmlNewChildStat(session_node, "SAME_PATH",        &sp_data);
-        xmlNewChildStat(session_node, "DIFF_PATH",        &dp_data);
-        xmlNewChildStat(session_node, "WITHDRAWAL",       &nw_data);
-        xmlNewChildStat(session_node, "DUP_WITHDRAWAL",   &dw_data);
+        xfbChildStat(w, "ANNOUNCEMENT",     &na_data);
+        xfbChildStat(w, "DUP_ANNOUNCEMENT", &da_data);
+        xfbChildStat(w, "SAME_PATH",        &sp_data);
+        xfbChildStat(w, "DIFF_PATH",        &dp_data);
+        xfbChildStat(w, "WITHDRAWAL",       &nw_data);
+        xfbChildStat(w, "DUP_WITHDRAWAL",   &dw_data);
 
 
     }
-	return session_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the SESSION_STATUS node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: collect the IDs of the sessions in one state, the count attribute of
+ *          the status nodes has to be written before the session nodes
+ * input:   state - the session state
+ *          ids   - pointer to the resulting array, the caller must free it
+ * Output:  the number of sessions
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+static int
+collectSessionIDs(int state, int **ids)
+{
+    int i;
+    int count = 0;
+
+    *ids = malloc(sizeof(int)*MAX_SESSION_IDS);
+    if (*ids == NULL)
+    {
+        log_err("collectSessionIDs: unable to allocate memory");
+        return 0;
+    }
+    for(i=0; i<MAX_SESSION_IDS; i++)
+    {
+        if( Sessions[i] != NULL && getSessionState(Sessions[i]->sessionID) == state )
+        {
+            (*ids)[count++] = i;
+        }
+    }
+    return count;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: write the SESSION_STATUS node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genSessionStatusNode(BMF bmf)
+void
+genSessionStatusNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "SESSION_STATUS");
+    xfbStartElement(w, "SESSION_STATUS");
 
-    int count = 0;
     int i = 0;
     switch ( bmf->type )
     {
         /* Periodic session status report */
         case BMF_TYPE_SESSION_STATUS:
         {
-            for(i=0; i<MAX_SESSION_IDS; i++)
+            int *ids = NULL;
+            int count = collectSessionIDs(stateEstablished, &ids);
+            xfbAttrInt(w, "count", count);
+            for(i=0; i<count; i++)
             {
-                if( Sessions[i] != NULL && getSessionState(Sessions[i]->sessionID) == stateEstablished  )
-                {
-                    count++;
-                    xmlAddChild(node, genSessionNode(bmf, i, 0));
-                }
+                genSessionNode(w, bmf, ids[i], 0);
             }
+            free(ids);
             break;
         }
         /* Single session state change */
         case BMF_TYPE_FSM_STATE_CHANGE:
         {
-            count++;
-            xmlAddChild(node, genSessionNode(bmf, bmf->sessionID, 1));
+            xfbAttrInt(w, "count", 1);
+            genSessionNode(w, bmf, bmf->sessionID, 1);
+            break;
+        }
+        default:
+        {
+            xfbAttrInt(w, "count", 0);
             break;
         }
     }
 
-    /* update the count of prefixes */
-    xmlNewPropInt(node, "count", count);
-
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate an individual MRT node
- * input:   none
- * Output:  the new xml node
+ * Purpose: write an individual MRT node
+ * input:   w      - the xml writer
+ *          mrt_id - MRT's ID
+ * Output:  none
  * Jason Bartlett @ 14 Feb 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genMRTNode(long mrt_id){
-    xmlNodePtr mrt_node = xmlNewNode(NULL,BAD_CAST "MRT");
+void
+genMRTNode(XFBWriter w, long mrt_id){
+    xfbStartElement(w, "MRT");
 
     //get MRT's address and port (AS is currently not included)
     char * tmp = getMrtAddress(mrt_id);
-    xmlNewChildString(mrt_node,"ADDRESS",tmp);
+    xfbChildString(w,"ADDRESS",tmp);
     free(tmp);
-    xmlNewChildInt(mrt_node,"PORT",getMrtPort(mrt_id));
-    
+    xfbChildInt(w,"PORT",getMrtPort(mrt_id));
+
     time_data_t time_info;
 
     memset(&time_info,0,sizeof(time_data_t));
@@ -2680,371 +2559,369 @@ genMRTNode(long mrt_id){
     time_info.current = getMrtConnectedTime(mrt_id);
     //MRT does not save last-down time
 
-    xmlNewChildInt(mrt_node,"UPTIME",(int)time_info.current);
-    
-    return mrt_node;
+    xfbChildInt(w,"UPTIME",(int)time_info.current);
+
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the MRT_STATUS node
- * input:   none
- * Output:  the new xml node
+ * Purpose: write the MRT_STATUS node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Jason Bartlett @ 14 Feb 2010
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genMRTStatusNode(BMF bmf){
-    xmlNodePtr mrt_root_node = xmlNewNode(NULL,BAD_CAST "MRT_STATUS");
-
-    int i,mrt_count = 0,session_count = 0;
+void
+genMRTStatusNode(XFBWriter w, BMF bmf){
+    int i;
     long* mrt_ids;
     int num_mrt_ids;
 
     num_mrt_ids = getActiveMrtsIDs(&mrt_ids);
-    if(num_mrt_ids == -1) return mrt_root_node;
-    else{
-        //add nodes for all the MRT connections
-        for( i = 0; i< num_mrt_ids; i++){
-            xmlAddChild(mrt_root_node, genMRTNode(mrt_ids[i]));
-            mrt_count++;
-        }
-        //add nodes for all the sessions connected VIA an MRT
-        for( i = 0; i < MAX_SESSION_IDS; i++ ){
-            if( Sessions[i] != NULL && getSessionState(Sessions[i]->sessionID) == stateMrtEstablished  )
-            {
-                session_count++;
-                xmlAddChild(mrt_root_node, genSessionNode(bmf, i, 0));
-            }
-        }
+    if(num_mrt_ids == -1){
+        xfbEmptyElement(w, "MRT_STATUS");
+        return;
+    }
+
+    int *session_ids = NULL;
+    int session_count = collectSessionIDs(stateMrtEstablished, &session_ids);
+
+    xfbStartElement(w, "MRT_STATUS");
+    xfbAttrInt(w,"mrt_count",num_mrt_ids);
+    xfbAttrInt(w,"session_count",session_count);
+
+    //add nodes for all the MRT connections
+    for( i = 0; i< num_mrt_ids; i++){
+        genMRTNode(w, mrt_ids[i]);
     }
-    xmlNewPropInt(mrt_root_node,"mrt_count",mrt_count);
-    xmlNewPropInt(mrt_root_node,"session_count",session_count);
+    //add nodes for all the sessions connected VIA an MRT
+    for( i = 0; i < session_count; i++ ){
+        genSessionNode(w, bmf, session_ids[i], 0);
+    }
+    xfbEndElement(w);
 
+    free(session_ids);
     free(mrt_ids);
-    return mrt_root_node;
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate BGPMON_TIME node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write BGPMON_TIME node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Jason Bartlett @ 14 Feb 2011
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr genBgpmonTimeNode(BMF bmf){
-    xmlNodePtr time_node = xmlNewNode(NULL,BAD_CAST "BGPMON_TIME");
-    xmlNewChildInt(time_node,"UPTIME",time(NULL) - bgpmon_start_time);   //bgpmon_start_time saved in bgpmon_defaults.h
-    return time_node;
+void genBgpmonTimeNode(XFBWriter w, BMF bmf){
+    xfbStartElement(w, "BGPMON_TIME");
+    xfbChildInt(w,"UPTIME",time(NULL) - bgpmon_start_time);   //bgpmon_start_time saved in bgpmon_defaults.h
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate BGPMON_START node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write BGPMON_START node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpmonStartNode(BMF bmf)
+void
+genBgpmonStartNode(XFBWriter w, BMF bmf)
 {
     /* BGPMON_START node */
-    xmlNodePtr bgpmon_node = NULL;
-    bgpmon_node = xmlNewNode(NULL, BAD_CAST "START");
-    return bgpmon_node;
+    xfbEmptyElement(w, "START");
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate BGPMON_STOP node
- * input:   bmf - pointer to BMF structure
- * Output:  the new xml node
+ * Purpose: write BGPMON_STOP node
+ * input:   w   - the xml writer
+ *          bmf - pointer to BMF structure
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * He Yan @ Jun 22, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpmonStopNode(BMF bmf)
+void
+genBgpmonStopNode(XFBWriter w, BMF bmf)
 {
     /* BGPMON_STOP node */
-    xmlNodePtr bgpmon_node = NULL;
-    bgpmon_node = xmlNewNode(NULL, BAD_CAST "STOP");
-    return bgpmon_node;
+    xfbEmptyElement(w, "STOP");
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the BGPMON_STATUS node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write the BGPMON_STATUS node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpmonStatusNode(BMF bmf)
+void
+genBgpmonStatusNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr node = xmlNewNode(NULL, BAD_CAST "BGPMON_STATUS");
+    xfbStartElement(w, "BGPMON_STATUS");
 
     switch ( bmf->type )
     {
-        case BMF_TYPE_BGPMON_START: { /* bgpmon start */ xmlAddChild(node, genBgpmonTimeNode(bmf)); break; }
-        case BMF_TYPE_BGPMON_STOP:  { /* bgpmon stop  */ xmlAddChild(node, genBgpmonTimeNode(bmf));  break; }
-        case BMF_TYPE_QUEUES_STATUS:{ /* queue status */ xmlAddChild(node, genBgpmonTimeNode(bmf)); break;  }
+        case BMF_TYPE_BGPMON_START: { /* bgpmon start */ genBgpmonTimeNode(w, bmf); break; }
+        case BMF_TYPE_BGPMON_STOP:  { /* bgpmon stop  */ genBgpmonTimeNode(w, bmf); break; }
+        case BMF_TYPE_QUEUES_STATUS:{ /* queue status */ genBgpmonTimeNode(w, bmf); break; }
     }
-    return node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the STATUS_MSG node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write the STATUS_MSG node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genStatusMsgNode(BMF bmf)
+void
+genStatusMsgNode(XFBWriter w, BMF bmf)
 {
-    xmlNodePtr status_node = NULL;
+    /* a state change of a session that is already gone is not reported */
+    if ( bmf->type == BMF_TYPE_FSM_STATE_CHANGE && getSessionByID(bmf->sessionID) == NULL ) return;
 
-    /*
-     * Creates BGP_MESSAGE node
-     */
-    status_node = xmlNewNode(NULL, BAD_CAST "STATUS_MSG");
+    xfbStartElement(w, "STATUS_MSG");
 
     switch ( bmf->type )
     {
-        /* bgpmon status  */  
+        /* bgpmon status  */
         case BMF_TYPE_BGPMON_START:
         case BMF_TYPE_BGPMON_STOP:
 		case BMF_TYPE_QUEUES_STATUS:
         {
-            xmlAddChild(status_node, genBgpmonStatusNode(bmf));
-            xmlAddChild(status_node, genQueueStatusNode(bmf));
+            genBgpmonStatusNode(w, bmf);
+            genQueueStatusNode(w, bmf);
             break;
         }
         /* chain status */
 		case BMF_TYPE_CHAINS_STATUS:
         {
-            xmlAddChild(status_node, genChainStatusNode(bmf));
+            genChainStatusNode(w, bmf);
             break;
         }
         /* session state change */
         case BMF_TYPE_FSM_STATE_CHANGE:
-        {
-            if ( getSessionByID(bmf->sessionID) == NULL ) return 0;
-            xmlAddChild(status_node, genSessionStatusNode(bmf));
-            break;
-        }
         /* session status */
         case BMF_TYPE_SESSION_STATUS:
         {
-            xmlAddChild(status_node, genSessionStatusNode(bmf));
+            genSessionStatusNode(w, bmf);
             break;
         }
         /* MRT status */
         case BMF_TYPE_MRT_STATUS:
         {
-            xmlAddChild(status_node, genMRTStatusNode(bmf));
+            genMRTStatusNode(w, bmf);
             break;
         }
     }
 
-    return status_node;
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate the TABLE_STOP node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
- * Mikhail Strizhov @ Feb 15, 2011
+ * Purpose: write a version attribute of a table transfer, the 64 bit version
+ *          is stored in the bmf message as two 32 bit values in network order
+ * input:   w      - the xml writer
+ *          bmf    - our internal BMF message
+ *          offset - position of the version in the bmf message
+ *          name   - name of the attribute
+ * Output:  none
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genTableStopNode(BMF bmf)
+static void
+genTableVersionAttr(XFBWriter w, BMF bmf, u_int32_t offset, char *name)
 {
-    xmlNodePtr node = NULL;
+    char buf[24];
+    u_int64_t version;
+
+    // messages from older senders have no version
+    if ( bmf->length < offset + 2*sizeof(u_int32_t) )
+        return;
+    version = ((u_int64_t)ntohl(*((u_int32_t *) (bmf->message + offset))) << 32)
+              | ntohl(*((u_int32_t *) (bmf->message + offset + sizeof(u_int32_t))));
+    snprintf(buf, sizeof(buf), "%llu", (unsigned long long)version);
+    xfbAttrString(w, name, buf);
+}
 
-    //Creates BGP_MESSAGE node
-    node = xmlNewNode(NULL, BAD_CAST "TABLE_STOP_MSG");
+/*----------------------------------------------------------------------------------------
+ * Purpose: write the TABLE_START node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void
+genTableStartNode(XFBWriter w, BMF bmf)
+{
+    xfbStartElement(w, "TABLE_START_MSG");
+    // Version of the rib being sent
+    genTableVersionAttr(w, bmf, 0, "version");
+    // a delta transfer only has the changes since this version
+    genTableVersionAttr(w, bmf, 2*sizeof(u_int32_t), "since");
+    xfbEndElement(w);
+}
 
+/*----------------------------------------------------------------------------------------
+ * Purpose: write the TABLE_STOP node
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ * Output:  none
+ * Mikhail Strizhov @ Feb 15, 2011
+ * -------------------------------------------------------------------------------------*/
+void
+genTableStopNode(XFBWriter w, BMF bmf)
+{
     // get value from bmf message
-    u_int32_t counter =  ntohl(*((u_int32_t *) (bmf->message))); 
-
-    // Counter 
-    xmlNewPropUnsignedInt( node, "counter", counter);
-
-    return node;
+    u_int32_t counter =  ntohl(*((u_int32_t *) (bmf->message)));
+
+    xfbStartElement(w, "TABLE_STOP_MSG");
+    // Counter
+    xfbAttrUnsignedInt(w, "counter", counter);
+    // Version of the rib that was sent
+    genTableVersionAttr(w, bmf, sizeof(u_int32_t), "version");
+    xfbEndElement(w);
 }
 
 /*----------------------------------------------------------------------------------------
- * Purpose: generate BGP_MESSAGE node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
+ * Purpose: write BGP_MESSAGE node, the length attribute is reserved with
+ *          _XML_LEN_DIGITS zeros and filled in once the message is complete
+ * input:   w   - the xml writer
+ *          bmf - our internal BMF message
+ *          seq_str - set to the position of the seq_num value, NULL if there is none
+ * Output:  the position of the length value in the buffer, NULL if it didn't fit
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpMessageNodeWithDummyLength(BMF bmf)
+char *
+genBgpMessageNode(XFBWriter w, BMF bmf, char **seq_str)
 {
-    xmlNodePtr bgp_message_node = NULL; /* node pointers */
-
-    /*
-    * Creates BGP_MESSAGE node
-    */
-    bgp_message_node = xmlNewNode(NULL, BAD_CAST "BGP_MESSAGE");
-
-    int xml_len = XML_BUFFER_LEN;
+    char *len_str;
+    int type_value;
     char *type_str;
 
-    xmlNewPropInt(bgp_message_node,    "length",  xml_len);  /* dummy length with the maximum length */
-    xmlNewPropString(bgp_message_node, "version", _VERSION); /* XFB version */
-    xmlNewPropString(bgp_message_node, "xmlns",   _XMLNS);   /* XFB namespace */
+    *seq_str = NULL;
 
-    /* Child nodes */
+    /* Type of the message, written as attributes before any child */
     switch ( bmf->type )
     {
         case BMF_TYPE_MSG_TO_PEER:
         case BMF_TYPE_MSG_FROM_PEER:
         case BMF_TYPE_MSG_LABELED:
         {
-            /* sequence num  */ xmlAddChild(bgp_message_node, genSequenceNode());
-            /* time          */ xmlAddChild(bgp_message_node, genTimeNode(bmf));
-            /* peering       */ xmlAddChild(bgp_message_node, genPeeringNode(bmf));
-            /* ascii message */ xmlAddChild(bgp_message_node, genAsciiMsgNode(bmf));
-            /* octet message */ xmlAddChild(bgp_message_node, genOctetMsgNode(bmf));
-
-            PBgpHeader hdr       = NULL;
-            u_int16_t  bgpType   = 0;
-            hdr       = (PBgpHeader)(bmf->message);
-            bgpType   = hdr->type;
-            type_str = getAsciiMsgType(bgpType);
-
-            xmlNewPropInt(bgp_message_node,    "type_value",  bgpType); /* bgpmon message type value */
-            xmlNewPropString(bgp_message_node, "type",        type_str);  /* bgpmon message type */
+            PBgpHeader hdr = (PBgpHeader)(bmf->message);
+            type_value = hdr->type;
+            type_str   = getAsciiMsgType(hdr->type);
             break;
         }
         case BMF_TYPE_TABLE_TRANSFER:
         {
-            /* sequence num  */ xmlAddChild(bgp_message_node, genSequenceNode());
-            /* time          */ xmlAddChild(bgp_message_node, genTimeNode(bmf));
-            /* peering       */ xmlAddChild(bgp_message_node, genPeeringNode(bmf));
-            /* pseudo message*/ xmlAddChild(bgp_message_node, genAsciiMsgNode(bmf));
-            /* octet message */ xmlAddChild(bgp_message_node, genOctetMsgNode(bmf));
-            type_str = "TABLE";
-
-            xmlNewPropInt(bgp_message_node,    "type_value",  bmf->type); /* bgpmon message type value */
-            xmlNewPropString(bgp_message_node, "type",        type_str);  /* bgpmon message type */
+            type_value = bmf->type;
+            type_str   = "TABLE";
             break;
         }
-	/* Table start messages */
-	case BMF_TYPE_TABLE_START:
+        case BMF_TYPE_TABLE_START:
         {
-            /* sequence num   */ xmlAddChild(bgp_message_node, genSequenceNode());
-            /* time           */ xmlAddChild(bgp_message_node, genTimeNode(bmf));
-            /* peering       */  xmlAddChild(bgp_message_node, genPeeringNode(bmf));
-            type_str = "TABLE_START";
-
-            xmlNewPropInt(bgp_message_node,    "type_value",  bmf->type); /* bgpmon message type value */
-            xmlNewPropString(bgp_message_node, "type",        type_str);  /* bgpmon message type */
+            type_value = bmf->type;
+            type_str   = "TABLE_START";
             break;
         }
-	/* Table sttop messages */
-	case BMF_TYPE_TABLE_STOP:
+        case BMF_TYPE_TABLE_STOP:
         {
-            /* sequence num   */ xmlAddChild(bgp_message_node, genSequenceNode());
-            /* time           */ xmlAddChild(bgp_message_node, genTimeNode(bmf));
-            /* peering       */  xmlAddChild(bgp_message_node, genPeeringNode(bmf));
-	    /* stop message  */  xmlAddChild(bgp_message_node, genTableStopNode(bmf));
-            type_str = "TABLE_STOP";
-
-            xmlNewPropInt(bgp_message_node,    "type_value",  bmf->type); /* bgpmon message type value */
-            xmlNewPropString(bgp_message_node, "type",        type_str);  /* bgpmon message type */
+            type_value = bmf->type;
+            type_str   = "TABLE_STOP";
             break;
         }
-        /* State change messages */
         case BMF_TYPE_FSM_STATE_CHANGE:
-        {
-            /* sequence num   */ xmlAddChild(bgp_message_node, genSequenceNode());
-            /* time           */ xmlAddChild(bgp_message_node, genTimeNode(bmf));
-            /* peering        */ xmlAddChild(bgp_message_node, genPeeringNode(bmf));
-            /* status message */ xmlAddChild(bgp_message_node, genStatusMsgNode(bmf));
-            type_str = "STATUS";
-
-            xmlNewPropInt(bgp_message_node,    "type_value",  bmf->type); /* bgpmon message type value */
-            xmlNewPropString(bgp_message_node, "type",        type_str);  /* bgpmon message type */
-            break;
-        }
-        /* Status messages */
-	case BMF_TYPE_CHAINS_STATUS:
-	case BMF_TYPE_QUEUES_STATUS:
-	case BMF_TYPE_SESSION_STATUS:
+        case BMF_TYPE_CHAINS_STATUS:
+        case BMF_TYPE_QUEUES_STATUS:
+        case BMF_TYPE_SESSION_STATUS:
         case BMF_TYPE_MRT_STATUS:
         case BMF_TYPE_BGPMON_START:
         case BMF_TYPE_BGPMON_STOP:
         {
-            /* sequence num   */ xmlAddChild(bgp_message_node, genSequenceNode());
-            /* time           */ xmlAddChild(bgp_message_node, genTimeNode(bmf));
-            /* status message */ xmlAddChild(bgp_message_node, genStatusMsgNode(bmf));
-            type_str = "STATUS";
-
-            xmlNewPropInt(bgp_message_node,    "type_value",  bmf->type); /* bgpmon message type value */
-            xmlNewPropString(bgp_message_node, "type",        type_str);  /* bgpmon message type */
+            type_value = bmf->type;
+            type_str   = "STATUS";
             break;
         }
         default:
         {
             log_err ("BMF2XML: unknown type!");
-            type_str = "UNKNOWN";
-
-            xmlNewPropInt(bgp_message_node,    "type_value",  bmf->type); /* bgpmon message type value */
-            xmlNewPropString(bgp_message_node, "type",        type_str);  /* bgpmon message type */
+            type_value = bmf->type;
+            type_str   = "UNKNOWN";
             break;
         }
     }
 
-    return bgp_message_node;
-}
-
-/*----------------------------------------------------------------------------------------
- * Purpose: generate BGP_MESSAGE node
- * input:   bmf - our internal BMF message
- * Output:  the new xml node
- * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/
-xmlNodePtr
-genBgpMessageNodeWithStr(BMF bmf, char* xml)
-{
-    xmlNodePtr bgp_message_node = NULL; /* node pointers */
-
-    /*-------------------------------------------------------
-     * Create a BGP_MESSAGE node with dummy length attribute
-     *------------------------------------------------------*/
-    bgp_message_node = genBgpMessageNodeWithDummyLength(bmf);
-
-    /*-------------------------------------------------------
-     * Steps to replace the dummy length attribute
-     * . Dump XML to a string buffer
-     * . Obtain the string length
-     * . Replace dummy length with the real length value
-     *------------------------------------------------------*/
-    xmlBufferPtr buff = xmlBufferCreate();
-    xmlNodeDump(buff, NULL, bgp_message_node, 0, 0);
-
-    static char format[XML_TEMP_BUFFER_LEN];
-    static char length_str[XML_TEMP_BUFFER_LEN];
-    static char old_length_str[XML_TEMP_BUFFER_LEN];
-    static char new_length_str[XML_TEMP_BUFFER_LEN];
-    format[0] = '\0';
-
-    /* Generate format */
-    if (_XML_LEN_DIGITS == 0) 
-        _XML_LEN_DIGITS = ceil(log10(XML_BUFFER_LEN));
-
-    sprintf(format, "%s%d.%dd", "%", _XML_LEN_DIGITS, _XML_LEN_DIGITS);
-    /* Genearte length string from format and REAL length */
-    sprintf(length_str, format, strlen((char *)buff->content));
-    strcpy(xml,  (char *)buff->content);
+    /*
+    * Creates BGP_MESSAGE node
+    */
+    xfbStartElement(w, "BGP_MESSAGE");
 
-    /* Replace length string */
-    sprintf(old_length_str, "length=\"%d\"", XML_BUFFER_LEN); /* Old length string */
-    sprintf(new_length_str, "length=\"%s\"", length_str);     /* New length string */
-    replace_str(xml, old_length_str, new_length_str);
+    len_str = xfbAttrReserve(w, "length", _XML_LEN_DIGITS);  /* filled in with the real length */
+    xfbAttrString(w, "version", _VERSION); /* XFB version */
+    xfbAttrString(w, "xmlns",   _XMLNS);   /* XFB namespace */
+    xfbAttrInt(w,    "type_value", type_value); /* bgpmon message type value */
+    xfbAttrString(w, "type",       type_str);   /* bgpmon message type */
 
-    /* Update length attribute */
-    xmlSetProp (bgp_message_node, BAD_CAST "length", BAD_CAST length_str);
-    xmlBufferFree(buff);  /* free xml buffer       */
+    /* Child nodes */
+    switch ( bmf->type )
+    {
+        case BMF_TYPE_MSG_TO_PEER:
+        case BMF_TYPE_MSG_FROM_PEER:
+        case BMF_TYPE_MSG_LABELED:
+        case BMF_TYPE_TABLE_TRANSFER:
+        {
+            /* sequence num  */ *seq_str = genSequenceNode(w);
+            /* time          */ genTimeNode(w, bmf);
+            /* peering       */ genPeeringNode(w, bmf);
+            /* ascii message */ genAsciiMsgNode(w, bmf);
+            /* octet message */ genOctetMsgNode(w, bmf);
+            break;
+        }
+        /* Table start messages */
+        case BMF_TYPE_TABLE_START:
+        {
+            /* sequence num   */ *seq_str = genSequenceNode(w);
+            /* time           */ genTimeNode(w, bmf);
+            /* peering        */ genPeeringNode(w, bmf);
+            /* start message  */ genTableStartNode(w, bmf);
+            break;
+        }
+        /* Table stop messages */
+        case BMF_TYPE_TABLE_STOP:
+        {
+            /* sequence num   */ *seq_str = genSequenceNode(w);
+            /* time           */ genTimeNode(w, bmf);
+            /* peering        */ genPeeringNode(w, bmf);
+            /* stop message   */ genTableStopNode(w, bmf);
+            break;
+        }
+        /* State change messages */
+        case BMF_TYPE_FSM_STATE_CHANGE:
+        {
+            /* sequence num   */ *seq_str = genSequenceNode(w);
+            /* time           */ genTimeNode(w, bmf);
+            /* peering        */ genPeeringNode(w, bmf);
+            /* status message */ genStatusMsgNode(w, bmf);
+            break;
+        }
+        /* Status messages */
+        case BMF_TYPE_CHAINS_STATUS:
+        case BMF_TYPE_QUEUES_STATUS:
+        case BMF_TYPE_SESSION_STATUS:
+        case BMF_TYPE_MRT_STATUS:
+        case BMF_TYPE_BGPMON_START:
+        case BMF_TYPE_BGPMON_STOP:
+        {
+            /* sequence num   */ *seq_str = genSequenceNode(w);
+            /* time           */ genTimeNode(w, bmf);
+            /* status message */ genStatusMsgNode(w, bmf);
+            break;
+        }
+    }
 
-    return bgp_message_node;
+    xfbEndElement(w);
+    return len_str;
 }
 
 
@@ -3053,29 +2930,66 @@ genBgpMessageNodeWithStr(BMF bmf, char* xml)
  * input:   bmf - our internal BMF message
  *          xml - pointer to the buffer used to store the result XML string
  *          maxlen - max length of the buffer
+ *          seqPos - set to the position of the seq_num value in xml, it is reserved 
+ *                   with XML_SEQ_DIGITS zeros and stamped with setXMLSequence
+ * Output:  the length of generated xml string, 0 if it didn't fit in the buffer
+ * Note:    the conversion keeps no state between calls, so several threads
+ *          may convert at once as long as each has its own buffer
  * Pei-chun Cheng @ Dec 20, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-int BMF2XMLDATA(BMF bmf, char *xml, int maxlen)
+int BMF2XMLDATA(BMF bmf, char *xml, int maxlen, int *seqPos)
 {
-    xmlInitParser();
+    struct XFBWriterStruct writer;
+    char *len_str;
+    char *seq_str;
+    int len;
 
-    xmlDocPtr  doc              = NULL;  /* document pointer */
-    xmlNodePtr bgp_message_node = NULL;  /* xml node pointer */
+    /* Generate format */
+    if (_XML_LEN_DIGITS == 0)
+        _XML_LEN_DIGITS = ceil(log10(XML_BUFFER_LEN));
 
     /*-------------------------------------------------------
-     * Implementation:
+     * Write the message straight into the caller's buffer,
+     * then fill in the reserved length attribute
      *------------------------------------------------------*/
-    doc = xmlNewDoc(BAD_CAST "1.0");
-    bgp_message_node = genBgpMessageNodeWithStr(bmf, xml);
-    xmlDocSetRootElement(doc, bgp_message_node);
-    strcpy(_XML, xml);
+    xfbInitWriter(&writer, xml, maxlen);
+    len_str = genBgpMessageNode(&writer, bmf, &seq_str);
+    len = xfbLength(&writer);
+    if (len < 0 || len_str == NULL)
+    {
+        log_err("BMF2XMLDATA: xml message of type %d doesn't fit in %d bytes", bmf->type, maxlen);
+        if (maxlen > 0) xml[0] = '\0';
+        return 0;
+    }
+    /* an unknown type has no sequence number and is not sent */
+    if (seq_str == NULL)
+    {
+        xml[0] = '\0';
+        return 0;
+    }
+    *seqPos = seq_str - xml;
 
-    /*-------------------------------------------------------
-     * Clean up
-     *------------------------------------------------------*/
-    xmlFreeDoc(doc);      /* Free the xml document */
+    char length_str[XML_TEMP_BUFFER_LEN];
+    snprintf(length_str, XML_TEMP_BUFFER_LEN, "%0*d", _XML_LEN_DIGITS, len);
+    memcpy(len_str, length_str, _XML_LEN_DIGITS);
+
+    return len;
+}
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Stamp the sequence number of a converted message
+ * input:   seq_str - the seq_num value reserved by BMF2XMLDATA
+ *          seq - the BGPmon sequence number
+ * output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/
+void setXMLSequence(char *seq_str, u_int32_t seq)
+{
+    char digits[XML_SEQ_DIGITS + 1];
 
-    return strlen(xml);
+    snprintf(digits, sizeof(digits), "%0*u", XML_SEQ_DIGITS, seq);
+    memcpy(seq_str, digits, XML_SEQ_DIGITS);
 }
 
 
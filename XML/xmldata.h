@@ -36,15 +36,29 @@
 #define XFB_VERSION             "0.4"                                  /* Current XFB version    */
 #define XFB_NS                  "urn:ietf:params:xml:ns:xfb-0.4"       /* Current XFB name space */
 
+/* number of characters reserved for the seq_num attribute, enough for any u_int32_t */
+#define XML_SEQ_DIGITS          10
+
 /*----------------------------------------------------------------------------------------
  * Purpose: entry fucntion which converts all types of BMF messages to XML text representations
  * input:   bmf - our internal BMF message
  *          xml - pointer to the buffer used for conversion
  *          maxlen - max length of the buffer
- * output:  the length of generated xml string
+ *          seqPos - set to the position of the seq_num value in xml, it is reserved 
+ *                   with XML_SEQ_DIGITS zeros and stamped with setXMLSequence
+ * output:  the length of generated xml string, 0 if it didn't fit in the buffer
  * Pei-chun Cheng @ Dec 20, 2008
  * -------------------------------------------------------------------------------------*/ 
-int BMF2XMLDATA(BMF bmf, char *xml, int maxlen);
+int BMF2XMLDATA(BMF bmf, char *xml, int maxlen, int *seqPos);
+
+/*----------------------------------------------------------------------------------------
+ * Purpose: Stamp the sequence number of a converted message
+ * input:   seq_str - the seq_num value reserved by BMF2XMLDATA
+ *          seq - the BGPmon sequence number
+ * output:  none
+ * agent @ Oct 17, 2026
+ * -------------------------------------------------------------------------------------*/ 
+void setXMLSequence(char *seq_str, u_int32_t seq);
 
 #endif /*XMLDATA_H_*/
 
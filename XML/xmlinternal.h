@@ -39,6 +39,8 @@
 /* constants */
 #define XML_BUFFER_LEN      10240000  /* 10M  Bytes - max size of XML buffer, for the whole XML message */
 #define XML_TEMP_BUFFER_LEN 512       /* 512 Bytes  - max size of XML temporary buffer, for a single ascii word, like '128.110.1.1' or '7013' */
+#define XML_MAX_WORKERS     64        /* max number of XML conversion threads */
+#define XML_REORDER_WINDOW  1024      /* max number of messages between the labeled queue and the XML queues */
 
 /*----------------------------------------------------------------------------------------
  * Purpose: special string concatenation routines that work in linear time 
@@ -85,70 +87,32 @@ int
 get_afi(char* addr);
 
 /*----------------------------------------------------------------------------------------
- * Purpose: Basic utiliy functions that add a property (attribute) to an existing xml node
- * input:   node  - pointer to the existing xml node
- *          name  - the attribute name
- *          value - the attribute value (with different data types)
- * Output:  the xml node
- * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/
-/* Integer */ xmlNodePtr xmlNewPropInt   (xmlNodePtr node, char *name, int   value);   
-/* Float   */ xmlNodePtr xmlNewPropFloat (xmlNodePtr node, char *name, float value);  
-/* String  */ xmlNodePtr xmlNewPropString(xmlNodePtr node, char *name, char *value );
-/* DateTime*/ xmlAttrPtr xmlNewPropGmtTime(xmlNodePtr node,char *tag, time_t timestamp);
-/* Unsigned Int */ xmlAttrPtr xmlNewPropUnsignedInt(xmlNodePtr node, char *tag, u_int32_t value);
-/* IP */      xmlNodePtr xmlNewPropIP(xmlNodePtr node, char *tag,u_int32_t ip);
-/* Octets */  xmlNodePtr xmlNewPropOctets(xmlNodePtr node,char *tag,u_char *octets,int len);
-
-/*----------------------------------------------------------------------------------------
- * Purpose: Basic utility functions that generate a plain xml node, for example: <mytag>myvalue</mytag>
- * input:   tag   - the node name
- *          value - the node value (with different data types)
- * Output:  the xml node
- * Pei-chun Cheng @ Dec 20, 2008
+ * Purpose: Entry function of xml thread
+ * Input:   arg - parameters for the XML thread
+ * Output:  none
+ * He Yan @ Jun 22, 2008
  * -------------------------------------------------------------------------------------*/
-/* Integer */ xmlNodePtr xmlNewNodeInt         (char *tag, int       value);
-/* u_int   */ xmlNodePtr xmlNewNodeUnsignedInt (char *tag, u_int32_t value);
-/* Float   */ xmlNodePtr xmlNewNodeFloat       (char *tag, float     value);
-/* String  */ xmlNodePtr xmlNewNodeString      (char *tag, char     *value);
-/* IP      */ xmlNodePtr xmlNewNodeIP          (char *tag, u_int32_t value);
-/* Time    */ xmlNodePtr xmlNewNodeGmtTime     (char *tag, time_t    value);
-/* Octet   */ xmlNodePtr xmlNewNodeOctets      (char *tag, u_char   *value, int len); /* len: octet length */
+void * 
+xmlThread( void *arg );
 
 /*----------------------------------------------------------------------------------------
- * Purpose: Basic utility functions that generate a plain xml node, 
- *          and attach it as a child to an existing xml node
- * input:   parent_node - the parent xml node
- *          tag   - the child node name
- *          value - the child node value (for different data types)
- * Output:  the newly created child node
- * Pei-chun Cheng @ Dec 20, 2008
+ * Purpose: Entry function of the xml worker threads, converts messages to XML
+ * Input:   arg - not used
+ * Output:  none
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-/* Integer */ xmlNodePtr xmlNewChildInt         (xmlNodePtr parent_node, char *tag, int       value);
-/* u_int   */ xmlNodePtr xmlNewChildUnsignedInt (xmlNodePtr parent_node, char *tag, u_int32_t value);
-/* Float   */ xmlNodePtr xmlNewChildFloat       (xmlNodePtr parent_node, char *tag, float     value);
-/* String  */ xmlNodePtr xmlNewChildString      (xmlNodePtr parent_node, char *tag, char     *value);
-/* IP      */ xmlNodePtr xmlNewChildIP          (xmlNodePtr parent_node, char *tag, u_int32_t value);
-/* Time    */ xmlNodePtr xmlNewChildGmtTime     (xmlNodePtr parent_node, char *tag, time_t    value);
-/* Octet   */ xmlNodePtr xmlNewChildOctets      (xmlNodePtr parent_node, char *tag, u_char   *value, int len); /* len: octet length */
-
-/*----------------------------------------------------------------------------------------
- * Purpose: print the xml node
- * input:   node - pointer to the xml node
- * Output:  length of printed string
- * Pei-chun Cheng @ Dec 20, 2008
- * -------------------------------------------------------------------------------------*/ 
-int
-printNode(xmlNodePtr node);
+void *
+xmlWorkerThread( void *arg );
 
 /*----------------------------------------------------------------------------------------
- * Purpose: Entry function of xml thread
- * Input:   arg - parameters for the XML thread
+ * Purpose: Entry function of the xml output thread, writes the converted messages
+ *          to the XML queues in labeled queue order
+ * Input:   arg - not used
  * Output:  none
- * He Yan @ Jun 22, 2008
+ * agent @ Oct 17, 2026
  * -------------------------------------------------------------------------------------*/
-void * 
-xmlThread( void *arg );
+void *
+xmlOutputThread( void *arg );
 
 
 
@@ -67,6 +67,7 @@
 #include "PeriodicEvents/periodic.h"
 #include "Peering/peers.h"
 #include "Peering/peersession.h"
+#include "Peering/peerengine.h"
 #include "Peering/bgpstates.h"
 #include "XML/xml.h"
 
@@ -350,6 +351,30 @@ main(int argc, char **argv)
    	debug (__FUNCTION__, "Successfully initialized queue settings.");
 #endif
 
+	// initialize the xml settings
+  	if (initXMLSettings() ) {
+           	log_fatal("Unable to initialize xml settings");
+	};
+#ifdef DEBUG
+   	debug (__FUNCTION__, "Successfully initialized xml settings.");
+#endif
+
+	// initialize the labeling settings
+  	if (initLabelingSettings() ) {
+           	log_fatal("Unable to initialize labeling settings");
+	};
+#ifdef DEBUG
+   	debug (__FUNCTION__, "Successfully initialized labeling settings.");
+#endif
+
+	// initialize the peering engine settings
+  	if (initPeeringSettings() ) {
+           	log_fatal("Unable to initialize peering settings");
+	};
+#ifdef DEBUG
+   	debug (__FUNCTION__, "Successfully initialized peering settings.");
+#endif
+
 	// initialize clients control settings
   	if (initClientsControlSettings() ) {
 		log_fatal("Unable to initialize client settings");
@@ -414,14 +439,14 @@ main(int argc, char **argv)
 	debug(__FUNCTION__, "Creating queues...");
 #endif
 	/*create the peer queue*/
-	peerQueue = createQueue(copyBMF, sizeOfBMF, PEER_QUEUE_NAME, strlen(PEER_QUEUE_NAME), FALSE);
+	peerQueue = createQueue(copyBMF, sizeOfBMF, freeBMF, PEER_QUEUE_NAME, strlen(PEER_QUEUE_NAME), FALSE);
 
 	/*create the label queue*/		  
-	labeledQueue = createQueue(copyBMF, sizeOfBMF, LABEL_QUEUE_NAME, strlen(LABEL_QUEUE_NAME), FALSE);
+	labeledQueue = createQueue(copyBMF, sizeOfBMF, freeBMF, LABEL_QUEUE_NAME, strlen(LABEL_QUEUE_NAME), FALSE);
 
 	/*create the xml queue*/
-	xmlUQueue = createQueue(copyXML, sizeOfXML, XML_U_QUEUE_NAME, strlen(XML_U_QUEUE_NAME), TRUE);
-	xmlRQueue = createQueue(copyXML, sizeOfXML, XML_R_QUEUE_NAME, strlen(XML_R_QUEUE_NAME), TRUE);	
+	xmlUQueue = createQueue(copyXML, sizeOfXML, NULL, XML_U_QUEUE_NAME, strlen(XML_U_QUEUE_NAME), TRUE);
+	xmlRQueue = createQueue(copyXML, sizeOfXML, NULL, XML_R_QUEUE_NAME, strlen(XML_R_QUEUE_NAME), TRUE);	
 #ifdef DEBUG
         debug(__FUNCTION__, "Created queues!");
 #endif